@@ -0,0 +1,99 @@
+#include <core/context.hpp>
+#include <core/target.hpp>
+#include <format>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "bench_helpers.hpp"
+
+namespace {
+constexpr int DEPTH = 200;
+
+// Frame pointer walk, returns the number of frames found
+int walk(Target& target, bool cached) {
+  u64 fp = target.getLastKnownThreadState().rbp;
+  int frames = 0;
+  while (fp != 0 && frames < DEPTH + 16) {
+    std::array<u64, 2> record{};  // saved rbp, return address
+    const auto out = std::as_writable_bytes(std::span{record});
+    const i32 res = cached ? target.readMemoryCached(fp, out)
+                           : target.readMemory(fp, out);
+    if (res != 0) break;
+    frames++;
+    // Frames grow towards higher addresses, anything else ends the chain
+    if (record[0] <= fp) break;
+    fp = record[0];
+  }
+  return frames;
+}
+}  // namespace
+
+// Walks a 200 frame stack with and without the stop-epoch page cache. Each
+// uncached frame costs a read from the target, the cached walk only pays for
+// the handful of stack pages involved
+int main(int argc, char** argv) {
+  const int iterations = argc > 1 ? std::stoi(argv[1]) : 1000;
+
+  Context::setTarget(Target::create(INFERIOR_PATH));
+  auto& target = Context::getTarget();
+
+  detail::CStringArray args{};
+  args.prepend(std::to_string(DEPTH));
+  if (target->launch(args) < 0 || target->attach() != 0) {
+    std::cerr << "Could not start " << INFERIOR_PATH << '\n';
+    return 1;
+  }
+
+  {
+    const bench::SilenceStdout silence{};
+    target->m_started = true;
+    target->setTargetState(TargetState::RUNNING);
+    target->startEventLoop();  // exec stop
+    target->resume(ResumeType::RESUME);
+    target->startEventLoop();  // int3 at the bottom of the recursion
+  }
+
+  auto& cache = target->getPageCache();
+  int frames = 0;
+  std::vector<double> uncached{};
+  std::vector<double> cold{};
+  std::vector<double> warm{};
+
+  for (int i = 0; i < iterations; i++) {
+    u64 start = bench::monotonicNs();
+    frames = walk(*target, false);
+    uncached.push_back(static_cast<double>(bench::monotonicNs() - start) /
+                       1e3);
+
+    // A new stop: the first walk misses, the next one is fully cached
+    cache.invalidate();
+    start = bench::monotonicNs();
+    walk(*target, true);
+    cold.push_back(static_cast<double>(bench::monotonicNs() - start) / 1e3);
+
+    start = bench::monotonicNs();
+    walk(*target, true);
+    warm.push_back(static_cast<double>(bench::monotonicNs() - start) / 1e3);
+  }
+
+  cache.resetStats();
+  cache.invalidate();
+  walk(*target, true);
+  const auto stats = cache.stats();
+
+  std::cerr << std::format(
+      "{} frames: {} reads uncached, {} reads cached ({} page misses, {} "
+      "hits)\n",
+      frames, frames, stats.fetches, stats.misses, stats.hits);
+  bench::report("uncached walk", bench::summarise(uncached), "us");
+  bench::report("cached walk (cold)", bench::summarise(cold), "us");
+  bench::report("cached walk (warm)", bench::summarise(warm), "us");
+
+  {
+    const bench::SilenceStdout silence{};
+    target->resume(ResumeType::RESUME);
+    target->startEventLoop();  // exit
+  }
+  return 0;
+}
@@ -0,0 +1,67 @@
+#include <core/breakpoint_table.hpp>
+#include <format>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_helpers.hpp"
+
+namespace {
+constexpr int LOOKUPS = 1'000'000;
+
+// ns per lookup for a stream of trap addresses, 3 out of 4 of them hits
+template <typename Fn>
+double nsPerLookup(const std::vector<u64>& probes, const Fn& lookup) {
+  u64 found = 0;
+  const u64 start = bench::monotonicNs();
+  for (const u64 addr : probes) found += lookup(addr) ? 1 : 0;
+  const u64 elapsed = bench::monotonicNs() - start;
+  // Keep the loop from being optimised out
+  if (found == probes.size() + 1) std::cerr << "";
+  return static_cast<double>(elapsed) / static_cast<double>(probes.size());
+}
+}  // namespace
+
+// Trap -> breakpoint record lookup cost, std::map against BreakpointTable,
+// with breakpoints spread over a text segment as function entries would be
+int main() {
+  std::mt19937_64 rng{1234};
+
+  for (const u64 count : {10ul, 10'000ul, 1'000'000ul}) {
+    std::vector<u64> addrs{};
+    addrs.reserve(count);
+    for (u64 i = 0; i < count; i++)
+      addrs.push_back(0x100000 + (i * 48) + (rng() % 16));
+
+    std::map<u64, Breakpoint> map{};
+    BreakpointTable table{};
+    table.reserve(count);
+    for (const u64 addr : addrs) {
+      map[addr] = {.orig_ins = 0x90, .enabled = true};
+      table.insert(addr, {.orig_ins = 0x90, .enabled = true});
+    }
+
+    std::vector<u64> probes{};
+    probes.reserve(LOOKUPS);
+    for (int i = 0; i < LOOKUPS; i++) {
+      const u64 addr = addrs[rng() % count];
+      probes.push_back(i % 4 == 3 ? addr + 1 : addr);
+    }
+
+    const double mapNs = nsPerLookup(probes, [&](u64 addr) {
+      auto it = map.find(addr);
+      return it != map.end() && it->second.enabled;
+    });
+    const double tableNs = nsPerLookup(probes, [&](u64 addr) {
+      const Breakpoint* bp = table.find(addr);
+      return bp != nullptr && bp->enabled;
+    });
+
+    std::cerr << std::format(
+        "{:>8} breakpoints: std::map {:>7.1f} ns  BreakpointTable {:>7.1f} "
+        "ns\n",
+        count, mapNs, tableNs);
+  }
+  return 0;
+}
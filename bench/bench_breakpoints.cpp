@@ -0,0 +1,88 @@
+#include <core/context.hpp>
+#include <core/elf/elf.hpp>
+#include <core/target.hpp>
+#include <format>
+#include <string>
+#include <vector>
+
+#include "bench_helpers.hpp"
+
+namespace {
+double timeMs(const auto& fn) {
+  const u64 start = bench::monotonicNs();
+  fn();
+  return static_cast<double>(bench::monotonicNs() - start) / 1e6;
+}
+
+bool sledIntact(Target& target, u64 start, u64 len) {
+  std::vector<std::byte> bytes(len);
+  if (target.readMemory(start, bytes) != 0) return false;
+  for (const auto b : bytes)
+    if (b != std::byte{0x90}) return false;
+  return true;
+}
+}  // namespace
+
+// Arms and disarms N breakpoints spread over a 512K nop sled, once through
+// setBreakpoint/disableBreakpoint per address and once through the batched
+// setBreakpoints/disableBreakpoints that touch every page once
+int main(int argc, char** argv) {
+  const u64 count = argc > 1 ? std::stoull(argv[1]) : 100'000;
+
+  Context::setTarget(Target::create(INFERIOR_PATH));
+  auto& target = Context::getTarget();
+  auto* elf = dynamic_cast<Elf*>(target.get());
+
+  detail::CStringArray args{};
+  if (elf == nullptr || target->launch(args) < 0 || target->attach() != 0) {
+    std::cerr << "Could not start " << INFERIOR_PATH << '\n';
+    return 1;
+  }
+
+  {
+    const bench::SilenceStdout silence{};
+    target->m_started = true;
+    target->setTargetState(TargetState::RUNNING);
+    target->startEventLoop();  // exec stop
+    target->resume(ResumeType::RESUME);
+    target->startEventLoop();  // int3 with the sled in rax/rbx
+  }
+
+  const u64 sled = target->getLastKnownThreadState().rax;
+  const u64 sledLen = target->getLastKnownThreadState().rbx;
+  const u64 stride = std::max<u64>(1, sledLen / count);
+
+  // Breakpoint addresses are unslid, like the ones given to `breakpoint set`
+  std::vector<u64> addrs{};
+  for (u64 i = 0; i < count && i * stride < sledLen; i++)
+    addrs.push_back(sled - elf->getAslrSlide() + (i * stride));
+
+  const double singleArm = timeMs([&] {
+    for (const u64 addr : addrs) target->setBreakpoint(addr);
+  });
+  const u64 armed = target->getRegisteredBreakpoints().size();
+  const double singleDisarm = timeMs([&] {
+    for (const u64 addr : addrs) target->disableBreakpoint(addr, true);
+  });
+  const bool singleOk = sledIntact(*target, sled, sledLen);
+
+  const double batchArm = timeMs([&] { target->setBreakpoints(addrs); });
+  const double batchDisarm =
+      timeMs([&] { target->disableBreakpoints(addrs, true); });
+  const bool batchOk = sledIntact(*target, sled, sledLen);
+
+  std::cerr << std::format(
+      "{} breakpoints over {} pages (sled restored: {}, {})\n", armed,
+      (sledLen + 4095) / 4096, singleOk, batchOk);
+  std::cerr << std::format("{:<24} arm {:>10.2f} ms  disarm {:>10.2f} ms\n",
+                           "one at a time", singleArm, singleDisarm);
+  std::cerr << std::format("{:<24} arm {:>10.2f} ms  disarm {:>10.2f} ms\n",
+                           "batched by page", batchArm, batchDisarm);
+
+  {
+    const bench::SilenceStdout silence{};
+    target->resume(ResumeType::RESUME);
+    target->startEventLoop();  // exit
+  }
+  return 0;
+}
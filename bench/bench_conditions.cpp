@@ -0,0 +1,84 @@
+#include <cmd/condition_compiler.hpp>
+#include <core/context.hpp>
+#include <core/elf/elf.hpp>
+#include <core/target.hpp>
+#include <format>
+#include <string>
+#include <vector>
+
+#include "bench_helpers.hpp"
+
+// A conditional breakpoint in a hot loop that only holds on the last of N
+// calls. Reports the raw evaluation rate of the compiled condition and the
+// end-to-end rate of traps filtered by the event loop without a prompt
+int main(int argc, char** argv) {
+  const long iterations = argc > 1 ? std::stol(argv[1]) : 100'000;
+
+  auto cond = ConditionCompiler::compile(
+      std::format("$rdi == {}", iterations - 1));
+  if (!cond) {
+    std::cerr << cond.error() << '\n';
+    return 1;
+  }
+
+  // Evaluation alone, against a state that never matches
+  {
+    ThreadState state{};
+    constexpr int evals = 10'000'000;
+    u64 matched = 0;
+    const u64 start = bench::monotonicNs();
+    for (int i = 0; i < evals; i++) {
+      state.rdi = static_cast<u64>(i);
+      matched += cond->evaluate(state) ? 1 : 0;
+    }
+    const double ns = static_cast<double>(bench::monotonicNs() - start);
+    std::cerr << std::format("evaluate: {:.1f} ns/eval, {:.1f}M evals/s ({})\n",
+                             ns / evals, evals / ns * 1e3, matched);
+  }
+
+  Context::setTarget(Target::create(INFERIOR_PATH));
+  auto& target = Context::getTarget();
+  auto* elf = dynamic_cast<Elf*>(target.get());
+
+  detail::CStringArray args{};
+  args.prepend(std::to_string(iterations));
+  if (elf == nullptr || target->launch(args) < 0 || target->attach() != 0) {
+    std::cerr << "Could not start " << INFERIOR_PATH << '\n';
+    return 1;
+  }
+
+  u64 elapsed = 0;
+  u64 stoppedAt = 0;
+  {
+    const bench::SilenceStdout silence{};
+    target->m_started = true;
+    target->setTargetState(TargetState::RUNNING);
+    target->startEventLoop();  // exec stop
+    target->resume(ResumeType::RESUME);
+    target->startEventLoop();  // int3 with &filter in rax
+
+    const u64 filter = target->getLastKnownThreadState().rax;
+    const u64 addr = filter - elf->getAslrSlide();
+    target->setBreakpoint(addr);
+    target->setBreakpointCondition(addr, *cond);
+
+    const u64 start = bench::monotonicNs();
+    target->resume(ResumeType::RESUME);
+    target->startEventLoop();  // only the last call reaches here
+    elapsed = bench::monotonicNs() - start;
+    stoppedAt = target->getLastKnownThreadState().rdi;
+
+    target->disableBreakpoint(addr, true);
+    target->resume(ResumeType::RESUME);
+    target->startEventLoop();  // exit
+  }
+
+  const double secs = static_cast<double>(elapsed) / 1e9;
+  std::cerr << std::format(
+      "event loop: {} traps in {:.3f}s, {:.1f}k filtered traps/s, "
+      "{:.2f} us/trap (stopped at rdi={})\n",
+      iterations, secs, static_cast<double>(iterations) / secs / 1e3,
+      static_cast<double>(elapsed) / 1e3 / static_cast<double>(iterations),
+      stoppedAt);
+  return 0;
+}
@@ -0,0 +1,75 @@
+#ifndef CAESAR_BENCH_HELPERS_HPP
+#define CAESAR_BENCH_HELPERS_HPP
+
+#include <time.h>
+
+#include <algorithm>
+#include <format>
+#include <iostream>
+#include <numeric>
+#include <streambuf>
+#include <string_view>
+#include <vector>
+
+#include "typedefs.hpp"
+
+namespace bench {
+struct Stats {
+  double min;
+  double median;
+  double p99;
+  double max;
+  double mean;
+};
+
+inline Stats summarise(std::vector<double> samples) {
+  if (samples.empty()) return {};
+  std::ranges::sort(samples);
+  const auto at = [&samples](double q) {
+    return samples[static_cast<size_t>(q * static_cast<double>(samples.size() - 1))];
+  };
+  return {.min = samples.front(),
+          .median = at(0.5),
+          .p99 = at(0.99),
+          .max = samples.back(),
+          .mean = std::accumulate(samples.begin(), samples.end(), 0.0) /
+                  static_cast<double>(samples.size())};
+}
+
+inline void report(std::string_view name, const Stats& s,
+                   std::string_view unit) {
+  std::cerr << std::format(
+      "{:<40} min {:>10.3f}  median {:>10.3f}  p99 {:>10.3f}  max {:>10.3f}  "
+      "mean {:>10.3f} {}\n",
+      name, s.min, s.median, s.p99, s.max, s.mean, unit);
+}
+
+// CLOCK_MONOTONIC in ns, the same clock the inferiors stamp their traps with
+inline u64 monotonicNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (static_cast<u64>(ts.tv_sec) * 1'000'000'000) +
+         static_cast<u64>(ts.tv_nsec);
+}
+
+// Stop events print registers to std::cout, which would dominate timings
+class SilenceStdout {
+  class NullBuf : public std::streambuf {
+   protected:
+    int overflow(int c) override { return c; }
+  };
+
+  NullBuf m_null;
+  std::streambuf* m_old;
+
+ public:
+  SilenceStdout() : m_old(std::cout.rdbuf(&m_null)) {}
+  ~SilenceStdout() { std::cout.rdbuf(m_old); }
+  SilenceStdout(const SilenceStdout&) = delete;
+  SilenceStdout& operator=(const SilenceStdout&) = delete;
+  SilenceStdout(SilenceStdout&&) = delete;
+  SilenceStdout& operator=(SilenceStdout&&) = delete;
+};
+}  // namespace bench
+
+#endif
@@ -0,0 +1,119 @@
+#include <core/context.hpp>
+#include <core/elf/elf.hpp>
+#include <core/target.hpp>
+#include <cstddef>
+#include <format>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "bench_helpers.hpp"
+
+namespace {
+constexpr u64 BUFFER_SIZE = 64ul << 20;
+
+bool verify(std::span<const std::byte> bytes, u64 offset) {
+  for (size_t i = 0; i < bytes.size(); i++)
+    if (std::to_integer<u8>(bytes[i]) != static_cast<u8>((offset + i) * 31u))
+      return false;
+  return true;
+}
+
+// Runs fn until either `iterations` samples or ~0.5s worth were collected,
+// the large sizes would otherwise take minutes through PTRACE_PEEKDATA
+bench::Stats sample(int iterations, const std::function<i32()>& fn) {
+  std::vector<double> samples{};
+  const u64 deadline = bench::monotonicNs() + 500'000'000;
+  for (int i = 0; i < iterations; i++) {
+    const u64 start = bench::monotonicNs();
+    if (fn() != 0) return {};
+    samples.push_back(static_cast<double>(bench::monotonicNs() - start) /
+                      1e3);
+    if (bench::monotonicNs() > deadline) break;
+  }
+  return bench::summarise(samples);
+}
+
+void reportThroughput(std::string_view name, u64 bytes,
+                      const bench::Stats& s) {
+  const double mbps =
+      s.median > 0 ? static_cast<double>(bytes) / s.median / 1.048576 : 0;
+  std::cerr << std::format("{:<32} median {:>12.3f} us  {:>10.1f} MB/s\n",
+                           name, s.median, mbps);
+}
+}  // namespace
+
+// Reads the inferior's buffer at sizes from 8B to 64MB through
+// process_vm_readv, /proc/pid/mem and PTRACE_PEEKDATA, plus a scattered read
+// of many small slices which is what stack walks and struct dumps look like
+int main(int argc, char** argv) {
+  const int iterations = argc > 1 ? std::stoi(argv[1]) : 50;
+
+  Context::setTarget(Target::create(INFERIOR_PATH));
+  auto& target = Context::getTarget();
+  auto* elf = dynamic_cast<Elf*>(target.get());
+
+  detail::CStringArray args{};
+  if (elf == nullptr || target->launch(args) < 0 || target->attach() != 0) {
+    std::cerr << "Could not start " << INFERIOR_PATH << '\n';
+    return 1;
+  }
+
+  {
+    const bench::SilenceStdout silence{};
+    target->m_started = true;
+    target->setTargetState(TargetState::RUNNING);
+    target->startEventLoop();  // exec stop
+    target->resume(ResumeType::RESUME);
+    target->startEventLoop();  // int3 with the buffer in rax
+  }
+
+  const u64 base = target->getLastKnownThreadState().rax;
+  std::vector<std::byte> buf(BUFFER_SIZE);
+
+  for (const u64 size : {8ul, 64ul, 512ul, 4ul << 10, 32ul << 10, 256ul << 10,
+                         2ul << 20, 16ul << 20, BUFFER_SIZE}) {
+    const std::span<std::byte> out{buf.data(), size};
+    const MemorySlice slice{.addr = base, .buf = out};
+
+    const auto vm = sample(iterations,
+                           [&] { return elf->readWithProcessVm({&slice, 1}); });
+    const bool ok = verify(out, 0);
+    const auto mem =
+        sample(iterations, [&] { return elf->readWithProcMem(base, out); });
+    const auto peek =
+        sample(iterations, [&] { return elf->readWithPeek(base, out); });
+
+    std::cerr << std::format("{} bytes{}\n", size, ok ? "" : " (MISMATCH)");
+    reportThroughput("  process_vm_readv", size, vm);
+    reportThroughput("  /proc/pid/mem", size, mem);
+    reportThroughput("  PTRACE_PEEKDATA", size, peek);
+  }
+
+  // 1024 x 64B slices one page apart, once vectored and once per slice
+  constexpr u64 SLICES = 1024;
+  constexpr u64 SLICE_SIZE = 64;
+  std::vector<MemorySlice> slices{};
+  for (u64 i = 0; i < SLICES; i++)
+    slices.push_back({.addr = base + (i * 4096),
+                      .buf = {buf.data() + (i * SLICE_SIZE), SLICE_SIZE}});
+
+  const auto vectored =
+      sample(iterations, [&] { return elf->readWithProcessVm(slices); });
+  const auto looped = sample(iterations, [&] {
+    for (const auto& s : slices)
+      if (elf->readWithProcMem(s.addr, s.buf) != 0) return -1;
+    return 0;
+  });
+  std::cerr << std::format("{} x {} byte slices\n", SLICES, SLICE_SIZE);
+  reportThroughput("  process_vm_readv (1 call)", SLICES * SLICE_SIZE,
+                   vectored);
+  reportThroughput("  /proc/pid/mem (per slice)", SLICES * SLICE_SIZE, looped);
+
+  {
+    const bench::SilenceStdout silence{};
+    target->resume(ResumeType::RESUME);
+    target->startEventLoop();  // exit
+  }
+  return 0;
+}
@@ -0,0 +1,86 @@
+#include <unistd.h>
+
+#include <core/context.hpp>
+#include <core/elf/elf.hpp>
+#include <core/target.hpp>
+#include <cstdlib>
+#include <format>
+#include <string>
+
+#include "bench_helpers.hpp"
+
+// Workers count up a shared counter while the main thread keeps trapping.
+// Each stop is held for a fixed time, standing in for someone inspecting
+// the thread. In all-stop mode the workers stall for the whole time, in
+// non-stop mode they keep counting
+namespace {
+constexpr useconds_t HOLD_US = 2000;
+
+struct Result {
+  u64 stops;
+  double held_progress;  // Worker increments per ms while a stop is held
+};
+
+u64 readProgress(Target& target, u64 addr) {
+  u64 value = 0;
+  target.readMemory(addr, {std::bit_cast<std::byte*>(&value), sizeof(value)});
+  return value;
+}
+
+Result run(long iterations, long workers, bool nonStop) {
+  Context::setTarget(Target::create(INFERIOR_PATH));
+  auto& target = Context::getTarget();
+
+  detail::CStringArray args{};
+  args.prepend(std::to_string(workers));
+  args.prepend(std::to_string(iterations));
+  if (target->launch(args) < 0 || target->attach() != 0 ||
+      target->setNonStop(nonStop) != 0) {
+    std::cerr << "Could not start " << INFERIOR_PATH << '\n';
+    std::exit(1);
+  }
+
+  const bench::SilenceStdout silence{};
+  target->m_started = true;
+  target->setTargetState(TargetState::RUNNING);
+  target->startEventLoop();  // exec stop
+  target->resume(ResumeType::RESUME);
+  target->startEventLoop();  // first trap
+
+  const u64 progress = target->getLastKnownThreadState().rax;
+  u64 stops = 0;
+  u64 counted = 0;
+  while (target->getTargetState() != TargetState::EXITED) {
+    const u64 before = readProgress(*target, progress);
+    usleep(HOLD_US);
+    counted += readProgress(*target, progress) - before;
+    stops++;
+
+    // Only the trapping thread is resumed, the workers never stopped
+    if (nonStop)
+      target->resumeThread(target->getThreads().selectedTid());
+    else
+      target->resume(ResumeType::RESUME);
+    target->startEventLoop();
+  }
+
+  return {.stops = stops,
+          .held_progress = static_cast<double>(counted) /
+                           (static_cast<double>(stops) * HOLD_US / 1e3)};
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const long iterations = argc > 1 ? std::stol(argv[1]) : 200;
+  const long workers = argc > 2 ? std::stol(argv[2]) : 4;
+
+  for (const bool nonStop : {false, true}) {
+    const Result res = run(iterations, workers, nonStop);
+    std::cerr << std::format(
+        "{:<8} {} stops held {} us each, workers made {:.0f} increments/ms "
+        "meanwhile\n",
+        nonStop ? "non-stop" : "all-stop", res.stops, HOLD_US,
+        res.held_progress);
+  }
+  return 0;
+}
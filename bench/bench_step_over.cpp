@@ -0,0 +1,65 @@
+#include <core/context.hpp>
+#include <core/elf/elf.hpp>
+#include <core/target.hpp>
+#include <cstdlib>
+#include <format>
+#include <string>
+
+#include "bench_helpers.hpp"
+
+// A breakpoint on a function called N times in a hot loop, resumed from
+// every stop. Before stepping over on resume the breakpoint fired once, now
+// every call has to stop. Compares the inline and displaced step-over
+namespace {
+struct Result {
+  u64 hits;
+  u64 ns;
+};
+
+Result run(long iterations, StepMode mode) {
+  Context::setTarget(Target::create(INFERIOR_PATH));
+  auto& target = Context::getTarget();
+  auto* elf = dynamic_cast<Elf*>(target.get());
+
+  detail::CStringArray args{};
+  args.prepend(std::to_string(iterations));
+  if (elf == nullptr || target->launch(args) < 0 || target->attach() != 0) {
+    std::cerr << "Could not start " << INFERIOR_PATH << '\n';
+    std::exit(1);
+  }
+
+  const bench::SilenceStdout silence{};
+  target->m_started = true;
+  target->setTargetState(TargetState::RUNNING);
+  target->startEventLoop();  // exec stop
+  target->resume(ResumeType::RESUME);
+  target->startEventLoop();  // int3 with &filter in rax
+
+  const u64 addr = target->getLastKnownThreadState().rax - elf->getAslrSlide();
+  target->setStepMode(mode);
+  target->setBreakpoint(addr);
+
+  const u64 start = bench::monotonicNs();
+  while (target->getTargetState() != TargetState::EXITED) {
+    target->resume(ResumeType::RESUME);
+    target->startEventLoop();
+  }
+  const u64 ns = bench::monotonicNs() - start;
+  return {.hits = target->getRegisteredBreakpoints().find(addr)->hit_count,
+          .ns = ns};
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const long iterations = argc > 1 ? std::stol(argv[1]) : 20'000;
+
+  for (const auto mode : {StepMode::INLINE, StepMode::DISPLACED}) {
+    const Result res = run(iterations, mode);
+    std::cerr << std::format(
+        "{:<9} {} of {} calls stopped, {:.2f} us per stop and resume\n",
+        mode == StepMode::INLINE ? "inline" : "displaced", res.hits,
+        iterations,
+        static_cast<double>(res.ns) / 1e3 / static_cast<double>(res.hits));
+  }
+  return 0;
+}
@@ -0,0 +1,54 @@
+#include <core/context.hpp>
+#include <core/target.hpp>
+#include <format>
+#include <string>
+#include <vector>
+
+#include "bench_helpers.hpp"
+
+// Measures the time from the inferior executing int3 to startEventLoop()
+// handing control back to the prompt, and the full resume -> stop round trip
+int main(int argc, char** argv) {
+  const int iterations = argc > 1 ? std::stoi(argv[1]) : 10000;
+
+  Context::setTarget(Target::create(INFERIOR_PATH));
+  auto& target = Context::getTarget();
+
+  detail::CStringArray args{};
+  args.prepend(std::to_string(iterations));
+  if (target->launch(args) < 0 || target->attach() != 0) {
+    std::cerr << "Could not start " << INFERIOR_PATH << '\n';
+    return 1;
+  }
+
+  std::vector<double> stopLatency{};
+  std::vector<double> roundTrip{};
+  stopLatency.reserve(iterations);
+  roundTrip.reserve(iterations);
+
+  {
+    const bench::SilenceStdout silence{};
+    target->m_started = true;
+    target->setTargetState(TargetState::RUNNING);
+    target->startEventLoop();  // exec stop
+
+    for (int i = 0; i < iterations; i++) {
+      const u64 resumedAt = bench::monotonicNs();
+      target->resume(ResumeType::RESUME);
+      target->startEventLoop();
+      const u64 promptAt = bench::monotonicNs();
+
+      const u64 trappedAt = target->getLastKnownThreadState().rax;
+      stopLatency.push_back(static_cast<double>(promptAt - trappedAt) / 1e3);
+      roundTrip.push_back(static_cast<double>(promptAt - resumedAt) / 1e3);
+    }
+
+    target->resume(ResumeType::RESUME);
+    target->startEventLoop();  // exit
+  }
+
+  std::cerr << std::format("{} stops\n", iterations);
+  bench::report("trap -> prompt", bench::summarise(stopLatency), "us");
+  bench::report("resume -> trap -> prompt", bench::summarise(roundTrip), "us");
+  return 0;
+}
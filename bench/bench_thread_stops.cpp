@@ -0,0 +1,77 @@
+#include <core/context.hpp>
+#include <core/elf/elf.hpp>
+#include <core/target.hpp>
+#include <cstdlib>
+#include <format>
+#include <string>
+
+#include "bench_helpers.hpp"
+
+// Cost of a stop and resume as the number of threads grows. Every stop
+// interrupts all threads, but registers are only fetched for the thread that
+// trapped. The eager run reads every thread's registers on each stop, the
+// way a single cached register set per thread would have to
+namespace {
+struct Result {
+  size_t threads;
+  u64 stops;
+  u64 ns;
+};
+
+Result run(long iterations, long count, bool eager) {
+  Context::setTarget(Target::create(INFERIOR_PATH));
+  auto& target = Context::getTarget();
+
+  detail::CStringArray args{};
+  args.prepend(std::to_string(count));
+  args.prepend(std::to_string(iterations));
+  if (target->launch(args) < 0 || target->attach() != 0) {
+    std::cerr << "Could not start " << INFERIOR_PATH << '\n';
+    std::exit(1);
+  }
+
+  const bench::SilenceStdout silence{};
+  target->m_started = true;
+  target->setTargetState(TargetState::RUNNING);
+  target->startEventLoop();  // exec stop
+  target->resume(ResumeType::RESUME);
+  target->startEventLoop();  // first trap, every thread exists by now
+
+  auto& threads = target->getThreads();
+  u64 stops = 0;
+  volatile u64 sink = 0;
+  const u64 start = bench::monotonicNs();
+  while (true) {
+    target->resume(ResumeType::RESUME);
+    target->startEventLoop();
+    if (target->getTargetState() == TargetState::EXITED) break;
+    stops++;
+
+    if (!eager) continue;
+    const i32 stopped = threads.selectedTid();
+    for (const i32 tid : threads.tids()) {
+      target->selectThread(tid);
+      sink = target->getLastKnownThreadState().rip;
+    }
+    target->selectThread(stopped);
+  }
+  const u64 ns = bench::monotonicNs() - start;
+  return {.threads = static_cast<size_t>(count) + 1, .stops = stops, .ns = ns};
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const long iterations = argc > 1 ? std::stol(argv[1]) : 2'000;
+
+  for (const long count : {0L, 8L, 32L}) {
+    for (const bool eager : {false, true}) {
+      const Result res = run(iterations, count, eager);
+      std::cerr << std::format(
+          "{:>2} threads {:<5} {:.2f} us per stop and resume ({} stops)\n",
+          res.threads, eager ? "eager" : "lazy",
+          static_cast<double>(res.ns) / 1e3 / static_cast<double>(res.stops),
+          res.stops);
+    }
+  }
+  return 0;
+}
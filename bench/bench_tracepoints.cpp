@@ -0,0 +1,92 @@
+#include <core/context.hpp>
+#include <core/elf/elf.hpp>
+#include <core/target.hpp>
+#include <format>
+#include <string>
+
+#include "bench_helpers.hpp"
+
+// A tracepoint on a function called N times in a hot loop, capturing its
+// argument and 32 bytes of stack. Reports the producer cost of recording,
+// the consumer cost of formatting that is kept off the trapping path, and
+// the end-to-end rate of traced hits including ring drops
+int main(int argc, char** argv) {
+  const long iterations = argc > 1 ? std::stol(argv[1]) : 100'000;
+  const std::string out = argc > 2 ? argv[2] : "/dev/null";
+
+  auto rdi = findRegEntry("rdi");
+  auto rsp = findRegEntry("rsp");
+  TraceSpec spec{};
+  spec.regs.push_back(*rdi);
+  spec.reg_names.emplace_back("rdi");
+  spec.mem_base = *rsp;
+  spec.mem_base_name = "rsp";
+  spec.mem_len = 32;
+
+  // Producer and consumer costs in isolation
+  {
+    Tracer tracer;
+    TraceRecord rec{};
+    rec.spec = tracer.addSpec(spec);
+    rec.mem_len = spec.mem_len;
+    constexpr int records = Tracer::RING_SIZE;
+
+    u64 start = bench::monotonicNs();
+    for (int i = 0; i < records; i++) {
+      rec.regs[0] = static_cast<u64>(i);
+      tracer.record(rec);
+    }
+    const double pushNs = static_cast<double>(bench::monotonicNs() - start);
+
+    tracer.setOutput("/dev/null");
+    start = bench::monotonicNs();
+    tracer.drain();
+    const double drainNs = static_cast<double>(bench::monotonicNs() - start);
+    std::cerr << std::format(
+        "record: {:.1f} ns/hit, format+write: {:.1f} ns/hit\n",
+        pushNs / records, drainNs / records);
+  }
+
+  Context::setTarget(Target::create(INFERIOR_PATH));
+  auto& target = Context::getTarget();
+  auto* elf = dynamic_cast<Elf*>(target.get());
+
+  detail::CStringArray args{};
+  args.prepend(std::to_string(iterations));
+  if (elf == nullptr || target->launch(args) < 0 || target->attach() != 0) {
+    std::cerr << "Could not start " << INFERIOR_PATH << '\n';
+    return 1;
+  }
+
+  u64 elapsed = 0;
+  {
+    const bench::SilenceStdout silence{};
+    target->m_started = true;
+    target->setTargetState(TargetState::RUNNING);
+    target->startEventLoop();  // exec stop
+    target->resume(ResumeType::RESUME);
+    target->startEventLoop();  // int3 with &filter in rax
+
+    const u64 filter = target->getLastKnownThreadState().rax;
+    const u64 addr = filter - elf->getAslrSlide();
+    target->getTracer().setOutput(out);
+    target->setBreakpoint(addr);
+    target->setTracepoint(addr, spec);
+
+    const u64 start = bench::monotonicNs();
+    target->resume(ResumeType::RESUME);
+    target->startEventLoop();  // exit, no hit ever stops
+    elapsed = bench::monotonicNs() - start;
+  }
+
+  target->getTracer().stop();
+  const TraceStats stats = target->getTracer().stats();
+  const double secs = static_cast<double>(elapsed) / 1e9;
+  std::cerr << std::format(
+      "event loop: {} hits in {:.3f}s, {:.1f}k traced hits/s, {:.2f} us/hit, "
+      "{} recorded, {} dropped, {} written\n",
+      iterations, secs, static_cast<double>(iterations) / secs / 1e3,
+      static_cast<double>(elapsed) / 1e3 / static_cast<double>(iterations),
+      stats.recorded, stats.dropped, stats.written);
+  return 0;
+}
@@ -0,0 +1,104 @@
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+
+#include <core/context.hpp>
+#include <core/elf/elf.hpp>
+#include <core/target.hpp>
+#include <csignal>
+#include <cstdlib>
+#include <format>
+#include <span>
+#include <string>
+
+#include "bench_helpers.hpp"
+
+// Catching the writes to one variable in a busy loop, once with a debug
+// register watchpoint and once by single-stepping and comparing the value
+// after every instruction, the only software alternative. Single-stepping
+// only runs for a fixed number of steps and is extrapolated from there
+namespace {
+std::unique_ptr<Target>& start(long iterations, long writes, u64& watched) {
+  Context::setTarget(Target::create(INFERIOR_PATH));
+  auto& target = Context::getTarget();
+
+  detail::CStringArray args{};
+  args.prepend(std::to_string(writes));
+  args.prepend(std::to_string(iterations));
+  if (target->launch(args) < 0 || target->attach() != 0) {
+    std::cerr << "Could not start " << INFERIOR_PATH << '\n';
+    std::exit(1);
+  }
+
+  target->m_started = true;
+  target->setTargetState(TargetState::RUNNING);
+  target->startEventLoop();  // exec stop
+  target->resume(ResumeType::RESUME);
+  target->startEventLoop();  // int3 with &watched in rax
+  watched = target->getLastKnownThreadState().rax;
+  return target;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const long iterations = argc > 1 ? std::stol(argv[1]) : 10'000'000;
+  const long writes = argc > 2 ? std::stol(argv[2]) : 10;
+  constexpr long steps = 200'000;
+
+  u64 hits = 0;
+  u64 hwNs = 0;
+  {
+    const bench::SilenceStdout silence{};
+    u64 watched = 0;
+    auto& target = start(iterations, writes, watched);
+    target->setWatchpoint(watched, sizeof(long), WatchKind::WRITE);
+
+    const u64 begin = bench::monotonicNs();
+    while (target->getTargetState() != TargetState::EXITED) {
+      target->resume(ResumeType::RESUME);
+      target->startEventLoop();
+    }
+    hwNs = bench::monotonicNs() - begin;
+    hits = target->getWatchpoints()[0].hit_count;
+  }
+
+  u64 stepNs = 0;
+  u64 changes = 0;
+  long stepped = 0;
+  {
+    const bench::SilenceStdout silence{};
+    u64 watched = 0;
+    auto& target = start(iterations, writes, watched);
+    u64 last = 0;
+    const auto buf = std::as_writable_bytes(std::span{&last, 1});
+    target->readMemory(watched, buf);
+
+    const u64 begin = bench::monotonicNs();
+    int status = 0;
+    for (; stepped < steps; stepped++) {
+      if (ptrace(PTRACE_SINGLESTEP, target->pid(), nullptr, 0) != 0 ||
+          waitpid(target->pid(), &status, __WALL) < 0 || !WIFSTOPPED(status))
+        break;
+      u64 now = 0;
+      target->readMemory(watched, std::as_writable_bytes(std::span{&now, 1}));
+      changes += now != last ? 1 : 0;
+      last = now;
+    }
+    stepNs = bench::monotonicNs() - begin;
+    kill(target->pid(), SIGKILL);
+    waitpid(target->pid(), &status, __WALL);
+  }
+
+  // The loop body is about 10 instructions
+  constexpr double insPerIteration = 10.0;
+  const double perStep =
+      static_cast<double>(stepNs) / static_cast<double>(stepped);
+  const double projected =
+      perStep * insPerIteration * static_cast<double>(iterations) / 1e9;
+  std::cerr << std::format(
+      "debug registers: {} iterations, {} hits in {:.3f}s\n"
+      "single-step: {:.2f} us/step ({} changes seen), projected {:.1f}s for "
+      "the same run ({:.0f}x slower)\n",
+      iterations, hits, static_cast<double>(hwNs) / 1e9, perStep / 1e3, changes,
+      projected, projected / (static_cast<double>(hwNs) / 1e9));
+  return 0;
+}
@@ -0,0 +1,32 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static volatile long progress;
+static volatile int done;
+
+static void* worker(void* arg) {
+  (void)arg;
+  while (!done) __atomic_fetch_add(&progress, 1, __ATOMIC_RELAXED);
+  return NULL;
+}
+
+// argv[2] threads count up `progress` while the main thread traps argv[1]
+// times, 1ms apart, with &progress in rax
+int main(int argc, char** argv) {
+  const long iterations = argc > 1 ? strtol(argv[1], NULL, 10) : 100;
+  const long count = argc > 2 ? strtol(argv[2], NULL, 10) : 4;
+  pthread_t* threads = calloc(count, sizeof(pthread_t));
+
+  for (long i = 0; i < count; i++)
+    pthread_create(&threads[i], NULL, worker, NULL);
+  for (long i = 0; i < iterations; i++) {
+    usleep(1000);
+    __asm__ volatile("int3" : : "a"(&progress));
+  }
+  done = 1;
+
+  for (long i = 0; i < count; i++) pthread_join(threads[i], NULL);
+  free(threads);
+  return 0;
+}
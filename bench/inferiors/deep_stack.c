@@ -0,0 +1,16 @@
+#include <stdlib.h>
+
+// Recurses argv[1] frames deep (frame pointers kept) and traps at the bottom
+__attribute__((noinline)) static long recurse(long depth) {
+  volatile long local = depth;
+  if (depth == 0) {
+    __asm__ volatile("int3" ::: "memory");
+    return local;
+  }
+  return recurse(depth - 1) + local;
+}
+
+int main(int argc, char** argv) {
+  const long depth = argc > 1 ? strtol(argv[1], NULL, 10) : 200;
+  return (int)(recurse(depth) & 0x7F);
+}
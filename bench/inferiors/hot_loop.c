@@ -0,0 +1,17 @@
+#include <stdlib.h>
+
+// Calls filter() argv[1] times with its loop counter, after first trapping
+// with &filter in rax so the debugger can put a breakpoint on it
+__attribute__((noinline)) long filter(long i) {
+  __asm__ volatile("" ::: "memory");
+  return i & 1;
+}
+
+int main(int argc, char** argv) {
+  const long iterations = argc > 1 ? strtol(argv[1], NULL, 10) : 100000;
+  __asm__ volatile("int3" : : "a"(filter));
+
+  long sum = 0;
+  for (long i = 0; i < iterations; i++) sum += filter(i);
+  return (int)(sum & 0x7F);
+}
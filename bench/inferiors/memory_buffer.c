@@ -0,0 +1,17 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Fills a 64MB buffer with a known pattern and traps once with its address in
+// rax, the debugger then reads it back through each transfer mechanism
+int main(void) {
+  const size_t size = 64ul << 20;
+  uint8_t* buf = malloc(size);
+  if (buf == NULL) return 1;
+
+  for (size_t i = 0; i < size; i++) buf[i] = (uint8_t)(i * 31u);
+  __asm__ volatile("int3" : : "a"(buf) : "memory");
+
+  free(buf);
+  return 0;
+}
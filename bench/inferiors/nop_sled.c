@@ -0,0 +1,17 @@
+// 512K of executable nops to arm breakpoints in, the debugger gets the start
+// of the sled in rax and its length in rbx
+extern const char sled_start[];
+extern const char sled_end[];
+__asm__(
+    ".text\n"
+    ".globl sled_start\n"
+    "sled_start:\n"
+    ".fill 524288, 1, 0x90\n"
+    ".globl sled_end\n"
+    "sled_end:\n"
+    "ret\n");
+
+int main(void) {
+  __asm__ volatile("int3" : : "a"(sled_start), "b"(sled_end - sled_start));
+  return 0;
+}
@@ -0,0 +1,29 @@
+#include <pthread.h>
+#include <stdlib.h>
+
+static pthread_mutex_t gate = PTHREAD_MUTEX_INITIALIZER;
+
+static void* worker(void* arg) {
+  (void)arg;
+  pthread_mutex_lock(&gate);
+  pthread_mutex_unlock(&gate);
+  return NULL;
+}
+
+// Starts argv[2] threads that block until the end, then traps argv[1] times
+// from the main thread with the number of threads in rax
+int main(int argc, char** argv) {
+  const long iterations = argc > 1 ? strtol(argv[1], NULL, 10) : 1000;
+  const long count = argc > 2 ? strtol(argv[2], NULL, 10) : 8;
+  pthread_t* threads = calloc(count, sizeof(pthread_t));
+
+  pthread_mutex_lock(&gate);
+  for (long i = 0; i < count; i++)
+    pthread_create(&threads[i], NULL, worker, NULL);
+  for (long i = 0; i < iterations; i++) __asm__ volatile("int3" : : "a"(count));
+  pthread_mutex_unlock(&gate);
+
+  for (long i = 0; i < count; i++) pthread_join(threads[i], NULL);
+  free(threads);
+  return 0;
+}
@@ -0,0 +1,16 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Traps argv[1] times, each time with the CLOCK_MONOTONIC timestamp of the
+// trap in rax so the debugger can compute its own stop latency
+int main(int argc, char** argv) {
+  const long iterations = argc > 1 ? strtol(argv[1], NULL, 10) : 1000;
+  for (long i = 0; i < iterations; i++) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    const uint64_t ns = (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    __asm__ volatile("int3" : : "a"(ns));
+  }
+  return 0;
+}
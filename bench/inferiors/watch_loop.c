@@ -0,0 +1,19 @@
+#include <stdlib.h>
+
+volatile long watched;
+volatile long scratch;
+
+// Traps with &watched in rax, then runs argv[1] iterations of busy work that
+// write `watched` argv[2] times, evenly spread
+int main(int argc, char** argv) {
+  const long iterations = argc > 1 ? strtol(argv[1], NULL, 10) : 10000000;
+  const long writes = argc > 2 ? strtol(argv[2], NULL, 10) : 10;
+  const long every = writes > 0 ? iterations / writes : iterations + 1;
+  __asm__ volatile("int3" : : "a"(&watched));
+
+  for (long i = 0; i < iterations; i++) {
+    scratch += i;
+    if (i % every == every - 1) watched = i;
+  }
+  return 0;
+}
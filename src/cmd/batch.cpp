@@ -0,0 +1,78 @@
+#include "batch.hpp"
+
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <variant>
+#include <vector>
+
+#include "error.hpp"
+#include "interpreter.hpp"
+#include "parser.hpp"
+#include "scanner.hpp"
+#include "stmnt.hpp"
+#include "token.hpp"
+
+void runCommand(const std::string& src) {
+  auto& cmdError = CmdError::getInstance();
+  auto s = Scanner(src);
+  const std::vector<Token> tokens = s.scanTokens();
+  if (cmdError.m_had_error) {
+    return;  // Stop if scan errors occurred
+  }
+
+  Parser p = Parser(tokens, src);
+  std::unique_ptr<Stmnt> const statement = p.parse();
+  if (cmdError.m_had_error) {
+    return;
+  }
+
+  Interpreter interpreter = Interpreter();
+  Object const result = interpreter.interpret(statement);
+  if (cmdError.m_had_error) {
+    return;
+  }
+  if (!std::holds_alternative<std::monostate>(result)) {
+    std::cout << Interpreter::stringify(result) << '\n';
+  }
+}
+
+bool runChecked(const std::string& line) {
+  auto& cmdError = CmdError::getInstance();
+  auto& coreError = CoreError::getInstance();
+  cmdError.m_had_error = false;
+  coreError.m_had_error = false;
+  runCommand(line);
+  return !cmdError.m_had_error && !coreError.m_had_error;
+}
+
+int runScript(std::istream& in, const std::string& name) {
+  std::string line{};
+  for (size_t n = 1; std::getline(in, line); n++) {
+    const size_t first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos || line[first] == '#') continue;
+    if (!runChecked(line)) {
+      std::cerr << std::format("{}:{}: {} failed\n", name, n, line);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int runBatch(std::span<const BatchStep> steps) {
+  for (const auto& step : steps) {
+    if (!step.script) {
+      if (!runChecked(step.arg)) return 1;
+      continue;
+    }
+    std::ifstream script{step.arg};
+    if (!script) {
+      std::cerr << std::format("Cannot read {}\n", step.arg);
+      return EXIT_NO_INPUT;
+    }
+    if (const int status = runScript(script, step.arg); status != 0)
+      return status;
+  }
+  return 0;
+}
@@ -0,0 +1,27 @@
+#ifndef CAESAR_BATCH_HPP
+#define CAESAR_BATCH_HPP
+
+#include <istream>
+#include <span>
+#include <string>
+
+// Exit statuses of a batch run, from sysexits(3)
+static constexpr int EXIT_USAGE = 64;
+static constexpr int EXIT_NO_INPUT = 66;
+
+// A -x script or -ex command, run in the order they were given
+struct BatchStep {
+  bool script;
+  std::string arg;
+};
+
+// Scans, parses and interprets one line, printing its result
+void runCommand(const std::string& src);
+// Same, false when the command reported an error
+bool runChecked(const std::string& line);
+// One command a line, blank lines and lines starting with # are skipped.
+// Stops at the first command that fails and returns the exit status
+int runScript(std::istream& in, const std::string& name);
+int runBatch(std::span<const BatchStep> steps);
+
+#endif
@@ -0,0 +1,156 @@
+#include "condition_compiler.hpp"
+
+#include <cmath>
+#include <format>
+#include <variant>
+
+#include "core/platform.hpp"
+#include "environment.hpp"
+#include "error.hpp"
+#include "parser.hpp"
+#include "scanner.hpp"
+
+namespace {
+Expected<u64, std::string> toOperand(const Object& value) {
+  if (const auto* d = std::get_if<double>(&value)) {
+    if (std::trunc(*d) != *d)
+      return Unexpected{std::format("{} is not an integer", *d)};
+    // Numbers are doubles, anything from 2^64 up has no u64 to become.
+    // Negative ones wrap like they would in the target
+    constexpr double twoTo63 = 9223372036854775808.0;
+    if (*d >= 2 * twoTo63 || *d < -twoTo63)
+      return Unexpected{std::format("{} does not fit in 64 bits", *d)};
+    if (*d >= twoTo63) return static_cast<u64>(*d);
+    return static_cast<u64>(static_cast<i64>(*d));
+  }
+  if (const auto* b = std::get_if<bool>(&value)) return *b ? 1 : 0;
+  return Unexpected{"Conditions can only use numbers and booleans"};
+}
+}  // namespace
+
+Expected<ConditionProgram, std::string> ConditionCompiler::compile(
+    const std::string& src) {
+  auto& cmdError = CmdError::getInstance();
+
+  Scanner scanner{src};
+  const std::vector<Token> tokens = scanner.scanTokens();
+  if (cmdError.m_had_error) return Unexpected{"Invalid condition"};
+
+  Parser parser{tokens};
+  const std::unique_ptr<Expr> expr = parser.parseExpression();
+  if (cmdError.m_had_error || !expr) return Unexpected{"Invalid condition"};
+
+  ConditionCompiler compiler{};
+  expr->accept(&compiler);
+  if (!compiler.m_error.empty()) return Unexpected{compiler.m_error};
+  if (!compiler.m_program.valid()) return Unexpected{"Condition is too complex"};
+
+  compiler.m_program.setSource(src);
+  return compiler.m_program;
+}
+
+void ConditionCompiler::fail(const std::string& msg) {
+  if (m_error.empty()) m_error = msg;
+}
+
+Object ConditionCompiler::visitBinaryExpr(const Binary& expr) {
+  expr.m_left->accept(this);
+  expr.m_right->accept(this);
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wswitch"
+  switch (expr.m_op.m_type) {
+    case TokenType::PLUS:
+      m_program.emit(CondOp::ADD);
+      break;
+    case TokenType::MINUS:
+      m_program.emit(CondOp::SUB);
+      break;
+    case TokenType::STAR:
+      m_program.emit(CondOp::MUL);
+      break;
+    case TokenType::SLASH:
+      m_program.emit(CondOp::DIV);
+      break;
+    case TokenType::EQUAL_EQUAL:
+      m_program.emit(CondOp::EQ);
+      break;
+    case TokenType::BANG_EQUAL:
+      m_program.emit(CondOp::NE);
+      break;
+    case TokenType::LESS:
+      m_program.emit(CondOp::LT);
+      break;
+    case TokenType::LESS_EQUAL:
+      m_program.emit(CondOp::LE);
+      break;
+    case TokenType::GREATER:
+      m_program.emit(CondOp::GT);
+      break;
+    case TokenType::GREATER_EQUAL:
+      m_program.emit(CondOp::GE);
+      break;
+    default:
+      fail(std::format("Unsupported operator {}", expr.m_op.m_lexeme));
+  }
+#pragma clang diagnostic pop
+
+  return std::monostate{};
+}
+
+Object ConditionCompiler::visitGroupingExpr(const Grouping& expr) {
+  return expr.m_expr->accept(this);
+}
+
+Object ConditionCompiler::visitLiteralExpr(const Literal& expr) {
+  auto operand = toOperand(expr.m_value);
+  if (!operand) {
+    fail(operand.error());
+    return std::monostate{};
+  }
+
+  m_program.emit(CondOp::PUSH, *operand);
+  return std::monostate{};
+}
+
+Object ConditionCompiler::visitUnaryExpr(const Unary& expr) {
+  expr.m_right->accept(this);
+  m_program.emit(expr.m_op.m_type == TokenType::BANG ? CondOp::NOT
+                                                      : CondOp::NEG);
+  return std::monostate{};
+}
+
+Object ConditionCompiler::visitVariableExpr(const Variable& expr) {
+  const std::string& name = expr.m_name.m_lexeme;
+
+  if (name.starts_with('$')) {
+    auto entry = findGprEntry(std::string_view{name}.substr(1));
+    if (!entry) {
+      fail(entry.error());
+      return std::monostate{};
+    }
+    m_program.emit(CondOp::LOAD_REG,
+                   static_cast<u64>(entry.value()->offset),
+                   entry.value()->size);
+    return std::monostate{};
+  }
+
+  auto values = Environment::getInstance().getAll();
+  if (!values.contains(name)) {
+    fail(std::format("Undefined variable '{}'", name));
+    return std::monostate{};
+  }
+
+  auto operand = toOperand(values.at(name));
+  if (!operand) {
+    fail(operand.error());
+    return std::monostate{};
+  }
+  m_program.emit(CondOp::PUSH, *operand);
+  return std::monostate{};
+}
+
+Object ConditionCompiler::visitAssignExpr(const Assign& expr) {
+  fail(std::format("Cannot assign to {} in a condition", expr.m_name.m_lexeme));
+  return std::monostate{};
+}
@@ -0,0 +1,32 @@
+#ifndef CAESAR_CONDITION_COMPILER_HPP
+#define CAESAR_CONDITION_COMPILER_HPP
+
+#include <string>
+
+#include "core/condition.hpp"
+#include "expected.hpp"
+#include "expr.hpp"
+
+// Lowers an expression tree into a ConditionProgram. Registers are resolved
+// to ThreadState offsets and plain variables are read once, here, so that
+// evaluation never goes back through the Environment or the Interpreter
+class ConditionCompiler : public IExprVisitor {
+ private:
+  ConditionProgram m_program;
+  std::string m_error;
+
+  void fail(const std::string& msg);
+
+ public:
+  static Expected<ConditionProgram, std::string> compile(
+      const std::string& src);
+
+  Object visitBinaryExpr(const Binary& expr) override;
+  Object visitGroupingExpr(const Grouping& expr) override;
+  Object visitLiteralExpr(const Literal& expr) override;
+  Object visitUnaryExpr(const Unary& expr) override;
+  Object visitVariableExpr(const Variable& expr) override;
+  Object visitAssignExpr(const Assign& expr) override;
+};
+
+#endif
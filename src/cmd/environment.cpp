@@ -61,18 +61,26 @@ Environment& Environment::getInstance() {
 std::map<std::string, Object> Environment::getAll() { return m_values; }
 
 Object Environment::getRegister(const Token& reg) {
-  auto& target = Context::getTarget();
-
-  std::string regName = reg.m_lexeme;
-  regName.erase(0, 1);
-
-  auto regEntry = findRegEntry(regName);
+  auto regEntry = findRegEntry(std::string_view{reg.m_lexeme}.substr(1));
   if (!regEntry) {
     CmdError::error(reg.m_type, "$ prefix can only be used to access registers",
                     CmdErrorType::RUNTIME_ERROR);
     return std::monostate{};
   }
+  return getRegister(reg, *regEntry.value());
+}
+
+Object Environment::getRegister(const Token& reg, const RegEntryT& regEntry) {
+  auto& target = Context::getTarget();
+
+  // Non-stop, registers of a running thread would only be stale
+  const ThreadInfo* thread = target->getThreads().selected();
+  if (thread != nullptr && thread->running) {
+    CmdError::error(reg.m_type,
+                    std::format("Thread {} is running", thread->tid),
+                    CmdErrorType::RUNTIME_ERROR);
+    return std::monostate{};
+  }
 
-  return static_cast<double>(
-      readRegValue(target->getLastKnownThreadState(), *regEntry.value()));
+  return static_cast<double>(target->readRegister(regEntry));
 }
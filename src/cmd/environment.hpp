@@ -4,6 +4,7 @@
 #include <map>
 #include <memory>
 
+#include "core/platform.hpp"
 #include "object.hpp"
 #include "stdlib.hpp"
 #include "token.hpp"
@@ -20,15 +21,30 @@ class Environment {
     this->define("len", std::make_shared<LenFn>(LenFn()));
     this->define("breakpoint", std::make_shared<BreakpointFn>(BreakpointFn()));
     this->define("run", std::make_shared<RunFn>(RunFn()));
+    this->define("attach", std::make_shared<AttachFn>(AttachFn()));
+    this->define("detach", std::make_shared<DetachFn>(DetachFn()));
     this->define("resume", std::make_shared<ContinueFn>(ContinueFn()));
+    this->define("interrupt", std::make_shared<InterruptFn>(InterruptFn()));
     this->define("target", std::make_shared<TargetFn>(TargetFn()));
     this->define("register", std::make_shared<RegisterFn>(RegisterFn()));
+    this->define("memory", std::make_shared<MemoryFn>(MemoryFn()));
+    this->define("trace", std::make_shared<TraceFn>(TraceFn()));
+    this->define("watch", std::make_shared<WatchFn>(WatchFn()));
+    this->define("thread", std::make_shared<ThreadFn>(ThreadFn()));
+    this->define("gcore", std::make_shared<GcoreFn>(GcoreFn()));
+    this->define("checkpoint",
+                 std::make_shared<CheckpointFn>(CheckpointFn()));
+    this->define("restore", std::make_shared<RestoreFn>(RestoreFn()));
+    this->define("syscalls", std::make_shared<SyscallsFn>(SyscallsFn()));
+    this->define("profile", std::make_shared<ProfileFn>(ProfileFn()));
+    this->define("backtrace", std::make_shared<BacktraceFn>(BacktraceFn()));
   }
 
  public:
   void define(const std::string& name, Object value);
   Object get(const Token& name);
   std::map<std::string, Object> getAll();
+  static Object getRegister(const Token& reg, const RegEntryT& regEntry);
   void assign(const Token& name, Object value);
 
   Environment(Environment& other) = delete;
@@ -5,6 +5,7 @@
 #include <memory>
 #include <utility>
 
+#include "core/platform.hpp"
 #include "formatter.hpp"
 #include "object.hpp"
 #include "token.hpp"
@@ -153,8 +154,16 @@ class Unary final : public Expr {
 class Variable final : public Expr {
  public:
   Token m_name;
-
-  explicit Variable(Token name) : m_name(std::move(std::move(name))) {}
+  // Resolved while parsing for $name, nullptr for unknown registers and
+  // plain variables
+  const RegEntryT* m_reg = nullptr;
+
+  explicit Variable(Token name) : m_name(std::move(std::move(name))) {
+    if (m_name.m_lexeme.starts_with('$')) {
+      auto entry = findRegEntry(std::string_view{m_name.m_lexeme}.substr(1));
+      if (entry) m_reg = entry.value();
+    }
+  }
 
   Object accept(IExprVisitor* visitor) const override {
     return visitor->visitVariableExpr(*this);
@@ -172,6 +172,8 @@ Object Interpreter::visitVarStmnt(const VarStmnt& stmnt) {
 }
 
 Object Interpreter::visitVariableExpr(const Variable& expr) {
+  if (expr.m_reg != nullptr)
+    return Environment::getRegister(expr.m_name, *expr.m_reg);
   return m_env.get(expr.m_name);
 }
 
@@ -9,7 +9,8 @@
 #include "stmnt.hpp"
 #include "token.hpp"
 
-Parser::Parser(std::vector<Token> tokens) : m_tokens(std::move(tokens)) {}
+Parser::Parser(std::vector<Token> tokens, std::string source)
+    : m_tokens(std::move(tokens)), m_source(std::move(source)) {}
 
 std::unique_ptr<Expr> Parser::expression() { return assignment(); }
 
@@ -151,6 +152,13 @@ std::unique_ptr<Stmnt> Parser::exprStmnt() {
 
 std::unique_ptr<Stmnt> Parser::parse() { return declaration(); }
 
+std::unique_ptr<Expr> Parser::parseExpression() {
+  std::unique_ptr<Expr> expr = expression();
+  if (!expr) return nullptr;
+  consume(TokenType::END, "Expect EOF after expression.");
+  return expr;
+}
+
 std::unique_ptr<Stmnt> Parser::declaration() {
   if (match(TokenType::VAR)) return varDeclaration();
   return statement();
@@ -192,6 +200,14 @@ std::unique_ptr<Stmnt> Parser::funStmnt() {
   std::vector<std::unique_ptr<Expr>> args = {};
 
   while (!check(TokenType::END)) {
+    // The rest of the line is a condition for the callee to compile, pass it
+    // on as source rather than evaluating it now
+    if (match(TokenType::IF)) {
+      args.emplace_back(std::make_unique<Literal>(previous().m_lexeme));
+      args.emplace_back(std::make_unique<Literal>(restAsSource()));
+      break;
+    }
+
     auto arg = expression();
     if (!arg) return nullptr;  // Don't continue if expression failed
     args.emplace_back(std::move(arg));
@@ -200,3 +216,21 @@ std::unique_ptr<Stmnt> Parser::funStmnt() {
   consume(TokenType::END, "Expect EOF after function call.");
   return std::make_unique<CallStmnt>(fnName, std::move(args));
 }
+
+std::string Parser::restAsSource() {
+  // Sliced out of the line as it was typed, spacing included
+  if (!m_source.empty() && !isAtEnd()) {
+    const size_t start = peek().m_offset;
+    while (!isAtEnd()) advance();
+    const Token last = previous();
+    return m_source.substr(start,
+                           last.m_offset + last.m_lexeme.size() - start);
+  }
+
+  std::string src{};
+  while (!isAtEnd()) {
+    if (!src.empty()) src += ' ';
+    src += advance().m_lexeme;
+  }
+  return src;
+}
@@ -2,6 +2,7 @@
 #define PARSER_HPP
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "expr.hpp"
@@ -11,6 +12,7 @@
 class Parser {
  private:
   std::vector<Token> m_tokens;
+  std::string m_source;  // What the tokens were scanned from, if known
   int m_current = 0;
 
   std::unique_ptr<Expr> expression();
@@ -42,10 +44,12 @@ class Parser {
   std::unique_ptr<Stmnt> varDeclaration();
   std::unique_ptr<Expr> assignment();
   std::unique_ptr<Stmnt> funStmnt();
+  std::string restAsSource();
 
  public:
-  explicit Parser(std::vector<Token> tokens);
+  explicit Parser(std::vector<Token> tokens, std::string source = {});
   std::unique_ptr<Stmnt> parse();
+  std::unique_ptr<Expr> parseExpression();
 };
 
 #endif  // !PARSER_HPP
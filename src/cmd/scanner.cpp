@@ -1,6 +1,7 @@
 #include "scanner.hpp"
 
 #include <string>
+#include <string_view>
 #include <utility>
 #include <variant>
 
@@ -17,7 +18,8 @@ std::vector<Token> Scanner::scanTokens() {
     scanToken();
   }
 
-  m_tokens.emplace_back(TokenType::END, "", std::monostate{});
+  m_tokens.emplace_back(TokenType::END, "", std::monostate{},
+                        m_source.length());
   return m_tokens;
 }
 
@@ -156,13 +158,10 @@ char Scanner::peekNext() const {
 void Scanner::identifier() {
   while (isalnum(peek()) != 0) advance();
 
-  const std::string text = m_source.substr(m_start, m_current - m_start);
-  TokenType type{};
-  try {
-    type = m_keywords.at(text);
-  } catch (std::out_of_range& e) {
-    type = TokenType::IDENTIFIER;
-  }
-
-  addToken(type);
+  const std::string_view text =
+      std::string_view{m_source}.substr(m_start, m_current - m_start);
+  // Most identifiers are commands, not keywords
+  const auto keyword = KEYWORDS.find(text);
+  addToken(keyword != KEYWORDS.end() ? keyword->second
+                                     : TokenType::IDENTIFIER);
 }
@@ -11,11 +11,13 @@ class Scanner {
  private:
   const std::string m_source;
   std::vector<Token> m_tokens;
-  std::map<std::string, TokenType> m_keywords = {
-      {"false", TokenType::BOOL_FALSE},
-      {"nil", TokenType::NIL},
-      {"true", TokenType::BOOL_TRUE},
-      {"var", TokenType::VAR}};
+  // Shared by every scanner, one is created for each line entered
+  static inline const std::map<std::string, TokenType, std::less<>> KEYWORDS =
+      {{"false", TokenType::BOOL_FALSE},
+       {"if", TokenType::IF},
+       {"nil", TokenType::NIL},
+       {"true", TokenType::BOOL_TRUE},
+       {"var", TokenType::VAR}};
   int m_start = 0;
   int m_current = 0;
 
@@ -27,7 +29,8 @@ class Scanner {
     requires std::constructible_from<Object, T>
   void addToken(TokenType tokenType, const T& literal) {
     const std::string text = m_source.substr(m_start, m_current - m_start);
-    m_tokens.emplace_back(tokenType, text, literal);
+    m_tokens.emplace_back(tokenType, text, literal,
+                          static_cast<size_t>(m_start));
   }
   bool match(char expected);
   [[nodiscard]] char peek() const;
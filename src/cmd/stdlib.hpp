@@ -3,13 +3,21 @@
 
 #include <sys/wait.h>
 
+#include <algorithm>
 #include <core/context.hpp>
 #include <core/util.hpp>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <optional>
+#include <span>
 #include <string>
 #include <variant>
 
 #include "callable.hpp"
+#include "cmd/condition_compiler.hpp"
 #include "cmd/object.hpp"
 #include "cmd/util.hpp"
 #include "core/platform.hpp"
@@ -80,8 +88,9 @@ class BreakpointFn : public SubcommandCallable {
     if (toggle) {
       const i32 res = target->disableBreakpoint(addr, true);
       if (res != 0) return "Error toggling breakpoint";
+      const Breakpoint* bp = bps.find(addr);
       return std::format("Toggled breakpoint at {}, now {}", addr,
-                         bps[addr].enabled);
+                         bp != nullptr && bp->enabled);
     }
 
     const i32 res = target->disableBreakpoint(addr, false);
@@ -92,30 +101,61 @@ class BreakpointFn : public SubcommandCallable {
   static inline FnPtr list =
       requiresRunningTarget([](const std::vector<Object>& args) -> Object {
 #pragma unused(args)
-        auto& breakpoints = Context::getTarget()->getRegisteredBreakpoints();
+        auto& target = Context::getTarget();
+        auto& breakpoints = target->getRegisteredBreakpoints();
         std::string retStr{};
 
-        if (breakpoints.empty()) return "No breakpoints set!";
+        // The table is unordered, list by address
+        std::vector<const BreakpointTable::Slot*> sorted{};
+        for (const auto& slot : breakpoints)
+          if (!slot.bp.has(BreakpointFlag::INTERNAL)) sorted.push_back(&slot);
+        if (sorted.empty()) return "No breakpoints set!";
+        std::ranges::sort(sorted, {}, &BreakpointTable::Slot::addr);
 
-        for (const auto& [k, v] : breakpoints) {
-          retStr += std::format("Breakpoint @ {} ({})\n", detail::toHex(k),
-                                breakpoints[k].enabled);
+        for (const auto* slot : sorted) {
+          retStr += std::format("Breakpoint {} @ {} ({}), hits: {}",
+                                slot->bp.id, detail::toHex(slot->addr),
+                                slot->bp.enabled, slot->bp.hit_count);
+          if (const auto* cond = target->getBreakpointCondition(slot->addr))
+            retStr += std::format(" if {}", cond->source());
+          if (slot->bp.has(BreakpointFlag::TRACE)) retStr += " (trace)";
+          retStr += '\n';
         }
 
         retStr.pop_back();
         return retStr;
       });
 
+  // breakpoint set <addr> [if <condition>], the parser hands the condition
+  // over as source so it is compiled once here and not re-interpreted per hit
   static inline FnPtr set =
       requiresRunningTarget([](const std::vector<Object>& args) -> Object {
         auto addr = detail::asU64(args.front());
         if (!addr) return addr.error();
 
-        const i32 bpRes = Context::getTarget()->setBreakpoint(*addr);
-        if (bpRes != 0)
+        std::optional<ConditionProgram> cond{};
+        if (args.size() > 1) {
+          auto keyword = detail::asString(args[1]);
+          if (!keyword || *keyword != "if" || args.size() != 3)
+            return "Usage: breakpoint set <addr> [if <condition>]";
+
+          auto src = detail::asString(args[2]);
+          if (!src) return src.error();
+          auto compiled = ConditionCompiler::compile(*src);
+          if (!compiled) return compiled.error();
+          cond = std::move(*compiled);
+        }
+
+        auto& target = Context::getTarget();
+        if (target->setBreakpoint(*addr) != 0)
           return "Error setting breakpoint!";
-        else
+        if (!cond)
           return std::format("Breakpoint set at: {}", detail::toHex(*addr));
+
+        const std::string condSrc = cond->source();
+        target->setBreakpointCondition(*addr, std::move(*cond));
+        return std::format("Breakpoint set at: {} if {}", detail::toHex(*addr),
+                           condSrc);
       });
 
   static inline FnPtr remove =
@@ -132,6 +172,26 @@ class BreakpointFn : public SubcommandCallable {
         return BreakpointFn::rmOrToggleBreakpoint(*addr, true);
       });
 
+  // breakpoint stepping [inline|displaced], how resume gets past a breakpoint
+  static inline FnPtr stepping = [](const std::vector<Object>& args) -> Object {
+    auto& target = Context::getTarget();
+    if (!target) return "Target not set!";
+
+    if (!args.empty()) {
+      auto mode = detail::asString(args.front());
+      if (mode && *mode == "inline")
+        target->setStepMode(StepMode::INLINE);
+      else if (mode && *mode == "displaced")
+        target->setStepMode(StepMode::DISPLACED);
+      else
+        return "Usage: breakpoint stepping [inline|displaced]";
+    }
+    return std::format("Stepping over breakpoints {}",
+                       target->getStepMode() == StepMode::INLINE
+                           ? "inline"
+                           : "displaced");
+  };
+
  public:
   [[nodiscard]] int arity() const override { return 1; }
   [[nodiscard]] std::string str() const override {
@@ -142,10 +202,20 @@ class BreakpointFn : public SubcommandCallable {
       : SubcommandCallable({{{sv("list"), list},
                              {sv("set"), set},
                              {sv("remove"), remove},
-                             {sv("toggle"), toggle}},
+                             {sv("toggle"), toggle},
+                             {sv("stepping"), stepping}},
                             "breakpoint"}) {}
 };
 
+// The interactive REPL takes commands while the target runs, anything else
+// waits for it to stop
+inline void waitForTarget(Target& target) {
+  if (Context::isAsync())
+    target.startBackground();
+  else
+    target.startEventLoop();
+}
+
 class RunFn : public Callable {
  private:
   static detail::CStringArray concatElems(const std::vector<Object>& v) {
@@ -196,6 +266,9 @@ class RunFn : public Callable {
       CmdError::getInstance().m_had_error = true;
       return std::monostate{};
     }
+    if (m_target->m_started &&
+        m_target->getTargetState() == TargetState::RUNNING)
+      return "Target is already running!";
 
     i32 pid = m_target->launch(argList);
     if (pid >= 0)
@@ -208,30 +281,105 @@ class RunFn : public Callable {
     m_target->setTargetState(TargetState::RUNNING);
     // TODO: Reset this when target exits
     m_target->m_started = true;
-    m_target->startEventLoop();
+    waitForTarget(*m_target);
 
     return std::monostate{};
   }
 };
 
+// `attach <pid>` takes over a running process, stopped with every thread
+class AttachFn : public Callable {
+ public:
+  [[nodiscard]] int arity() const override { return 1; }
+  [[nodiscard]] std::string str() const override {
+    return "<native fn: attach>";
+  }
+
+  Object call(std::vector<Object> args) override {
+    if (m_target != nullptr && m_target->m_started)
+      return "Detach from the current target first!";
+    auto pid = detail::asU64(args.front());
+    if (!pid) return pid.error();
+
+    const auto start = std::chrono::steady_clock::now();
+    auto target = Target::createAttached(static_cast<i32>(*pid));
+    const std::chrono::duration<double, std::milli> took =
+        std::chrono::steady_clock::now() - start;
+    if (target == nullptr) return std::format("Could not attach to {}", *pid);
+
+    const size_t threads = target->getThreads().size();
+    Context::setTarget(std::move(target));
+    return std::format("Attached to {}, {} threads stopped in {:.2f} ms",
+                       *pid, threads, took.count());
+  }
+};
+
+class DetachFn : public Callable {
+ public:
+  [[nodiscard]] int arity() const override { return 0; }
+  [[nodiscard]] std::string str() const override {
+    return "<native fn: detach>";
+  }
+
+  Object call(std::vector<Object> args) override {
+#pragma unused(args)
+    if (m_target == nullptr || !m_target->m_started)
+      return "Target is not running!";
+    if (m_target->getTargetState() != TargetState::STOPPED)
+      return "Target has to be stopped!";
+
+    const i32 pid = m_target->pid();
+    if (m_target->detach() != 0)
+      return std::format("Could not cleanly detach from {}", pid);
+    return std::format("Detached from {}", pid);
+  }
+};
+
 class ContinueFn : public Callable {
  public:
   [[nodiscard]] int arity() const override { return 0; }
   [[nodiscard]] std::string str() const override {
     return "<native fn: continue>";
   }
+  // `resume` continues every stopped thread, `resume <tid>` only that one
   Object call(std::vector<Object> args) override {
-#pragma unused(args)
+    if (m_target == nullptr) return "Target is not running!";
     if (m_target->getTargetState() != TargetState::STOPPED) {
       std::cout << "Target still seems to think its running?\n";
       return std::monostate{};
     }
-    m_target->resume(ResumeType::RESUME);
-    m_target->startEventLoop();
+
+    if (args.empty()) {
+      m_target->resume(ResumeType::RESUME);
+    } else {
+      auto tid = detail::asU64(args.front());
+      if (!tid) return tid.error();
+      if (m_target->resumeThread(static_cast<i32>(*tid)) != 0)
+        return std::format("Could not resume thread {}", *tid);
+    }
+    waitForTarget(*m_target);
     return std::monostate{};
   }
 };
 
+// `interrupt` stops a target running in the background, like Ctrl-C
+class InterruptFn : public Callable {
+ public:
+  [[nodiscard]] int arity() const override { return 0; }
+  [[nodiscard]] std::string str() const override {
+    return "<native fn: interrupt>";
+  }
+
+  Object call(std::vector<Object> args) override {
+#pragma unused(args)
+    if (m_target == nullptr || !m_target->m_started)
+      return "Target is not running!";
+    if (m_target->interrupt() != 0) return "Could not interrupt the target";
+    return std::format("Interrupted, thread {} selected",
+                       m_target->getThreads().selectedTid());
+  }
+};
+
 class TargetFn : public SubcommandCallable {
  private:
   static inline FnPtr info = [](const std::vector<Object>& args) -> Object {
@@ -269,22 +417,51 @@ class TargetFn : public SubcommandCallable {
 
 class RegisterFn : public SubcommandCallable {
  private:
+  // Runs fn on the thread given at args[index], or on the selected thread
+  // when there is no such argument. The selection is left as it was
+  static Object onThread(const std::vector<Object>& args, size_t index,
+                         const std::function<Object()>& fn) {
+    auto& target = Context::getTarget();
+    auto& threads = target->getThreads();
+    const i32 selected = threads.selectedTid();
+    i32 tid = selected;
+    if (args.size() > index) {
+      auto arg = detail::asU64(args[index]);
+      if (!arg) return arg.error();
+      tid = static_cast<i32>(*arg);
+    }
+
+    const ThreadInfo* thread = threads.find(tid);
+    if (thread == nullptr && tid != selected)
+      return std::format("No thread {}", tid);
+    if (thread != nullptr && thread->running)
+      return std::format("Thread {} is running", tid);
+
+    target->selectThread(tid);
+    Object res = fn();
+    target->selectThread(selected);
+    return res;
+  }
+
   static inline FnPtr view =
       requiresRunningTarget([](const std::vector<Object>& args) -> Object {
         auto& target = Context::getTarget();
 
         auto reg = detail::asString(args.front());
         if (*reg == "all")
-          return target->formatRegisterOutput(
-              &target->getLastKnownThreadState());
+          return onThread(args, 1, [&target]() -> Object {
+            return target->formatRegisterOutput(
+                &target->getLastKnownThreadState());
+          });
 
         auto entry = findRegEntry(*reg);
         if (!entry) return entry.error();
 
-        return std::format(
-            "{}: {}", *reg,
-            detail::toHex(readRegValue(target->getLastKnownThreadState(),
-                                       *entry.value())));
+        return onThread(args, 1, [&target, &reg, &entry]() -> Object {
+          return std::format(
+              "{}: {}", *reg,
+              detail::toHex(target->readRegister(*entry.value())));
+        });
       });
 
   static inline FnPtr write =
@@ -300,10 +477,11 @@ class RegisterFn : public SubcommandCallable {
         auto val = detail::asU64(args[1]);
         if (!val) return val.error();
 
-        if (target->writeRegValue(*entry.value(), *val) != 0)
-          return "Error writing to register!";
-
-        return std::format("{}: {}", *regName, detail::toHex(*val));
+        return onThread(args, 2, [&]() -> Object {
+          if (target->writeRegValue(*entry.value(), *val) != 0)
+            return "Error writing to register!";
+          return std::format("{}: {}", *regName, detail::toHex(*val));
+        });
       });
 
  public:
@@ -317,4 +495,685 @@ class RegisterFn : public SubcommandCallable {
             {{{sv("view"), view}, {sv("write"), write}}, "register"}) {}
 };
 
+class MemoryFn : public SubcommandCallable {
+ private:
+  // Upper bound for a single `memory read`, the dump is printed in one go
+  static constexpr u64 MAX_READ = 1 << 20;
+
+  static std::string hexdump(u64 addr, std::span<const std::byte> bytes) {
+    std::string retStr{};
+    for (size_t line = 0; line < bytes.size(); line += 16) {
+      const auto row =
+          bytes.subspan(line, std::min<size_t>(16, bytes.size() - line));
+      std::string ascii{};
+      retStr += std::format("{}:", detail::toHex(addr + line));
+      for (size_t i = 0; i < 16; i++) {
+        if (i < row.size()) {
+          const auto b = std::to_integer<u8>(row[i]);
+          retStr += std::format(" {:02x}", b);
+          ascii += std::isprint(b) != 0 ? static_cast<char>(b) : '.';
+        } else {
+          retStr += "   ";
+        }
+      }
+      retStr += std::format("  {}\n", ascii);
+    }
+
+    if (!retStr.empty()) retStr.pop_back();
+    return retStr;
+  }
+
+  static inline FnPtr read =
+      requiresRunningTarget([](const std::vector<Object>& args) -> Object {
+        if (args.size() < 2) return "Usage: memory read <addr> <len>";
+        auto addr = detail::asU64(args.front());
+        if (!addr) return addr.error();
+
+        auto len = detail::asU64(args[1]);
+        if (!len) return len.error();
+        if (*len == 0 || *len > MAX_READ)
+          return std::format("Length must be between 1 and {}", MAX_READ);
+
+        std::vector<std::byte> buf(*len);
+        if (Context::getTarget()->readMemoryCached(*addr, buf) != 0)
+          return "Error reading memory!";
+        return MemoryFn::hexdump(*addr, buf);
+      });
+
+  static inline FnPtr write =
+      requiresRunningTarget([](const std::vector<Object>& args) -> Object {
+        if (args.size() < 2) return "Usage: memory write <addr> <value> [size]";
+        auto addr = detail::asU64(args.front());
+        if (!addr) return addr.error();
+
+        auto val = detail::asU64(args[1]);
+        if (!val) return val.error();
+
+        u64 size = sizeof(u64);
+        if (args.size() > 2) {
+          auto sizeArg = detail::asU64(args[2]);
+          if (!sizeArg) return sizeArg.error();
+          size = *sizeArg;
+        }
+        if (size != 1 && size != 2 && size != 4 && size != 8)
+          return "Size must be 1, 2, 4 or 8";
+
+        // Little endian, the low `size` bytes of the value are written
+        const auto bytes = std::as_bytes(std::span{&*val, 1}).first(size);
+        if (Context::getTarget()->writeMemory(*addr, bytes) != 0)
+          return "Error writing memory!";
+        return std::format("Wrote {} bytes at {}", size, detail::toHex(*addr));
+      });
+
+  static inline FnPtr cache =
+      requiresRunningTarget([](const std::vector<Object>& args) -> Object {
+#pragma unused(args)
+        const auto& pageCache = Context::getTarget()->getPageCache();
+        const auto& stats = pageCache.stats();
+        return std::format("Epoch {}: {} hits, {} misses, {} reads",
+                           pageCache.epoch(), stats.hits, stats.misses,
+                           stats.fetches);
+      });
+
+ public:
+  [[nodiscard]] int arity() const override { return 1; }
+  [[nodiscard]] std::string str() const override {
+    return "<native fn: memory>";
+  }
+
+  MemoryFn()
+      : SubcommandCallable(
+            {{{sv("read"), read}, {sv("write"), write}, {sv("cache"), cache}},
+             "memory"}) {}
+};
+
+class TraceFn : public SubcommandCallable {
+ private:
+  static Expected<i64, std::string> asOffset(const Object& obj) {
+    if (const auto* d = std::get_if<double>(&obj)) return static_cast<i64>(*d);
+    auto val = detail::asU64(obj);
+    if (!val) return Unexpected{val.error()};
+    return static_cast<i64>(*val);
+  }
+
+  static Expected<u32, std::string> asCaptureLen(const Object& obj) {
+    auto len = detail::asU64(obj);
+    if (!len) return Unexpected{len.error()};
+    if (*len == 0 || *len > TraceSpec::MAX_BYTES)
+      return Unexpected{
+          std::format("Length must be between 1 and {}", TraceSpec::MAX_BYTES)};
+    return static_cast<u32>(*len);
+  }
+
+  // <reg>... [mem <reg> <offset> <len> | stack <len>]
+  static Expected<TraceSpec, std::string> parseSpec(
+      std::span<const Object> args) {
+    TraceSpec spec{};
+    for (size_t i = 0; i < args.size(); i++) {
+      auto word = detail::asString(args[i]);
+      if (!word) return Unexpected{word.error()};
+
+      if (*word == "mem" || *word == "stack") {
+        const bool stack = *word == "stack";
+        const size_t rest = stack ? 1 : 3;
+        if (spec.mem_len != 0 || args.size() - i - 1 != rest)
+          return Unexpected{std::string{"Memory capture must come last"}};
+
+        spec.mem_base_name = "sp";
+        if (!stack) {
+          auto base = detail::asString(args[i + 1]);
+          if (!base) return Unexpected{base.error()};
+          spec.mem_base_name = *base;
+          auto off = asOffset(args[i + 2]);
+          if (!off) return Unexpected{off.error()};
+          spec.mem_offset = *off;
+        }
+        auto entry = findGprEntry(spec.mem_base_name);
+        if (!entry) return Unexpected{entry.error()};
+        spec.mem_base = *entry;
+
+        auto len = asCaptureLen(args.back());
+        if (!len) return Unexpected{len.error()};
+        spec.mem_len = *len;
+        break;
+      }
+
+      if (spec.regs.size() == TraceSpec::MAX_REGS)
+        return Unexpected{
+            std::format("At most {} registers", TraceSpec::MAX_REGS)};
+      auto entry = findGprEntry(*word);
+      if (!entry) return Unexpected{entry.error()};
+      spec.regs.push_back(*entry);
+      spec.reg_names.push_back(*word);
+    }
+    return spec;
+  }
+
+  static inline FnPtr set =
+      requiresRunningTarget([](const std::vector<Object>& args) -> Object {
+        constexpr std::string_view usage =
+            "Usage: trace set <addr> [reg...] [mem <reg> <offset> <len> | "
+            "stack <len>]";
+        if (args.empty()) return std::string{usage};
+        auto addr = detail::asU64(args.front());
+        if (!addr) return addr.error();
+
+        auto spec = TraceFn::parseSpec(std::span{args}.subspan(1));
+        if (!spec) return spec.error();
+
+        auto& target = Context::getTarget();
+        const bool existed =
+            target->getRegisteredBreakpoints().contains(*addr);
+        if (target->setBreakpoint(*addr) != 0)
+          return "Error setting tracepoint!";
+        if (target->setTracepoint(*addr, std::move(*spec)) != 0) {
+          // Left armed it would stop where nobody asked to
+          if (!existed) target->disableBreakpoint(*addr, true);
+          return "Error setting tracepoint!";
+        }
+        return std::format("Tracepoint set at: {}", detail::toHex(*addr));
+      });
+
+  static inline FnPtr list =
+      requiresRunningTarget([](const std::vector<Object>& args) -> Object {
+#pragma unused(args)
+        auto& target = Context::getTarget();
+        std::vector<const BreakpointTable::Slot*> sorted{};
+        for (const auto& slot : target->getRegisteredBreakpoints())
+          if (slot.bp.has(BreakpointFlag::TRACE)) sorted.push_back(&slot);
+        if (sorted.empty()) return "No tracepoints set!";
+        std::ranges::sort(sorted, {}, &BreakpointTable::Slot::addr);
+
+        std::string retStr{};
+        for (const auto* slot : sorted) {
+          const TraceSpec* spec = target->getTracepoint(slot->addr);
+          retStr += std::format("Tracepoint {} @ {}, hits: {}", slot->bp.id,
+                                detail::toHex(slot->addr), slot->bp.hit_count);
+          for (const auto& name : spec->reg_names) retStr += ' ' + name;
+          if (spec->mem_len != 0)
+            retStr += std::format(" [{}{:+}]:{}", spec->mem_base_name,
+                                  spec->mem_offset, spec->mem_len);
+          retStr += '\n';
+        }
+
+        retStr.pop_back();
+        return retStr;
+      });
+
+  static inline FnPtr output = [](const std::vector<Object>& args) -> Object {
+    auto& target = Context::getTarget();
+    if (!target) return "Target not set!";
+
+    std::string path{};
+    if (!args.empty()) {
+      auto arg = detail::asString(args.front());
+      if (!arg) return arg.error();
+      if (*arg != "stdout") path = *arg;
+    }
+    if (target->getTracer().setOutput(path) != 0)
+      return std::format("Could not open {}", path);
+    return std::format("Tracing to {}", target->getTracer().outputName());
+  };
+
+  static inline FnPtr stats = [](const std::vector<Object>& args) -> Object {
+#pragma unused(args)
+    auto& target = Context::getTarget();
+    if (!target) return "Target not set!";
+
+    const auto& tracer = target->getTracer();
+    const TraceStats s = tracer.stats();
+    return std::format("{} recorded, {} dropped, {} written, {} queued",
+                       s.recorded, s.dropped, s.written, tracer.pending());
+  };
+
+ public:
+  [[nodiscard]] int arity() const override { return 1; }
+  [[nodiscard]] std::string str() const override {
+    return "<native fn: trace>";
+  }
+
+  TraceFn()
+      : SubcommandCallable({{{sv("set"), set},
+                             {sv("list"), list},
+                             {sv("output"), output},
+                             {sv("stats"), stats}},
+                            "trace"}) {}
+};
+
+class WatchFn : public SubcommandCallable {
+ private:
+  static inline FnPtr set =
+      requiresRunningTarget([](const std::vector<Object>& args) -> Object {
+        constexpr std::string_view usage = "Usage: watch <addr> <len> [r|w|rw]";
+        if (args.size() < 2) return std::string{usage};
+        auto addr = detail::asU64(args.front());
+        if (!addr) return addr.error();
+        auto len = detail::asU64(args[1]);
+        if (!len) return len.error();
+
+        WatchKind kind = WatchKind::WRITE;
+        if (args.size() > 2) {
+          auto kindArg = detail::asString(args[2]);
+          if (!kindArg) return std::string{usage};
+          if (*kindArg == "r")
+            kind = WatchKind::READ;
+          else if (*kindArg == "rw")
+            kind = WatchKind::READ_WRITE;
+          else if (*kindArg != "w")
+            return std::string{usage};
+        }
+
+        const i32 id = Context::getTarget()->setWatchpoint(
+            *addr, static_cast<u8>(*len), kind);
+        if (id < 0) return "Error setting watchpoint!";
+        return std::format("Watchpoint {} set at: {} ({} bytes, {})", id,
+                           detail::toHex(*addr), *len, watchKindName(kind));
+      });
+
+  static inline FnPtr list =
+      requiresRunningTarget([](const std::vector<Object>& args) -> Object {
+#pragma unused(args)
+        std::string retStr{};
+        for (const auto& wp : Context::getTarget()->getWatchpoints()) {
+          if (!wp.active()) continue;
+          retStr += std::format(
+              "Watchpoint {} @ {} ({} bytes, {}), hits: {}, value: {:#x}\n",
+              wp.id, detail::toHex(wp.addr), wp.len, watchKindName(wp.kind),
+              wp.hit_count, wp.old_value);
+        }
+        if (retStr.empty()) return "No watchpoints set!";
+
+        retStr.pop_back();
+        return retStr;
+      });
+
+  static inline FnPtr remove =
+      requiresRunningTarget([](const std::vector<Object>& args) -> Object {
+        auto id = detail::asU64(args.front());
+        if (!id) return id.error();
+        if (Context::getTarget()->removeWatchpoint(static_cast<u32>(*id)) != 0)
+          return std::format("No watchpoint {}", *id);
+        return std::format("Removed watchpoint {}", *id);
+      });
+
+ public:
+  [[nodiscard]] int arity() const override { return 1; }
+  [[nodiscard]] std::string str() const override {
+    return "<native fn: watch>";
+  }
+
+  // `watch <addr> <len> [kind]` is shorthand for `watch set ...`
+  Object call(std::vector<Object> args) override {
+    const auto* first =
+        args.empty() ? nullptr : std::get_if<std::string>(&args.front());
+    if (!args.empty() &&
+        (first == nullptr ||
+         (*first != "set" && *first != "list" && *first != "remove")))
+      args.insert(args.begin(), std::string{"set"});
+    return SubcommandCallable::call(std::move(args));
+  }
+
+  WatchFn()
+      : SubcommandCallable(
+            {{{sv("set"), set}, {sv("list"), list}, {sv("remove"), remove}},
+             "watch"}) {}
+};
+
+
+class ThreadFn : public SubcommandCallable {
+ private:
+  static inline FnPtr list =
+      requiresRunningTarget([](const std::vector<Object>& args) -> Object {
+#pragma unused(args)
+        auto& threads = Context::getTarget()->getThreads();
+        if (threads.empty()) return "No threads!";
+
+        // Only registers fetched during this stop are shown, listing never
+        // reads the registers of every thread
+        const auto pc = findRegEntry("pc");
+        std::string retStr{};
+        for (const i32 tid : threads.tids()) {
+          const ThreadInfo& thread = *threads.find(tid);
+          retStr += std::format(
+              "{} Thread {}: {}", tid == threads.selectedTid() ? '*' : ' ',
+              tid,
+              thread.running ? "running"
+              : thread.stop_reason.empty()
+                  ? "stopped"
+                  : std::format("stopped, {}", thread.stop_reason));
+          if (thread.has(RegGroup::GPR) && pc)
+            retStr += std::format(
+                " pc: {}",
+                detail::toHex(readRegValue(thread.regs, *pc.value())));
+          retStr += '\n';
+        }
+
+        retStr.pop_back();
+        return retStr;
+      });
+
+  static inline FnPtr select =
+      requiresRunningTarget([](const std::vector<Object>& args) -> Object {
+        auto tid = detail::asU64(args.front());
+        if (!tid) return tid.error();
+
+        auto& target = Context::getTarget();
+        if (!target->selectThread(static_cast<i32>(*tid)))
+          return std::format("No thread {}", *tid);
+
+        const auto pc = findRegEntry("pc");
+        if (!pc || target->getThreads().selected()->running)
+          return std::format("Selected thread {}", *tid);
+        return std::format("Selected thread {} @ {}", *tid,
+                           detail::toHex(target->readRegister(*pc.value())));
+      });
+
+  // `thread mode nonstop` only halts the thread that stops, `allstop`
+  // halts all of them. No argument shows the current mode
+  static inline FnPtr mode =
+      requiresRunningTarget([](const std::vector<Object>& args) -> Object {
+        auto& target = Context::getTarget();
+        if (!args.empty()) {
+          auto arg = detail::asString(args.front());
+          if (!arg || (*arg != "allstop" && *arg != "nonstop"))
+            return "Usage: thread mode [allstop|nonstop]";
+          if (target->setNonStop(*arg == "nonstop") != 0)
+            return "Could not change the thread mode!";
+        }
+        return std::format("Thread mode: {}",
+                           target->isNonStop() ? "nonstop" : "allstop");
+      });
+
+ public:
+  [[nodiscard]] int arity() const override { return 1; }
+  [[nodiscard]] std::string str() const override {
+    return "<native fn: thread>";
+  }
+
+  ThreadFn()
+      : SubcommandCallable({{{sv("list"), list},
+                             {sv("select"), select},
+                             {sv("mode"), mode}},
+                            "thread"}) {}
+};
+
+// `gcore <file> [refs]` writes an ELF core of the stopped target, refs only
+// names read-only file mappings instead of copying them
+class GcoreFn : public Callable {
+ public:
+  [[nodiscard]] int arity() const override { return 1; }
+  [[nodiscard]] std::string str() const override {
+    return "<native fn: gcore>";
+  }
+
+  Object call(std::vector<Object> args) override {
+    constexpr std::string_view usage = "Usage: gcore <file> [refs]";
+    if (m_target == nullptr || !m_target->m_started)
+      return "Target is not running!";
+    if (m_target->getTargetState() != TargetState::STOPPED)
+      return "Target has to be stopped!";
+    if (args.empty()) return std::string{usage};
+
+    auto path = detail::asString(args.front());
+    if (!path) return path.error();
+    bool refs = false;
+    if (args.size() > 1) {
+      auto flag = detail::asString(args[1]);
+      if (!flag || *flag != "refs") return std::string{usage};
+      refs = true;
+    }
+
+    CoreDumpStats stats{};
+    if (m_target->generateCore(*path, refs, stats) != 0)
+      return std::format("Could not write core to {}", *path);
+
+    constexpr double mib = 1 << 20;
+    const double mbps = stats.pause_ms > 0
+                            ? static_cast<double>(stats.read) / mib /
+                                  (stats.pause_ms / 1e3)
+                            : 0;
+    return std::format(
+        "Saved core to {}: {:.1f} MB mapped, {:.1f} MB read, {:.1f} MB "
+        "written, {:.1f} MB referenced\n{:.1f} MB/s, target paused {:.1f} "
+        "ms, {:.1f} ms total",
+        *path, static_cast<double>(stats.mapped) / mib,
+        static_cast<double>(stats.read) / mib,
+        static_cast<double>(stats.written) / mib,
+        static_cast<double>(stats.referenced) / mib, mbps, stats.pause_ms,
+        stats.total_ms);
+  }
+};
+
+// `checkpoint` saves a copy-on-write copy of the stopped target,
+// `checkpoint list` shows the saved ones
+class CheckpointFn : public Callable {
+ public:
+  [[nodiscard]] int arity() const override { return 0; }
+  [[nodiscard]] std::string str() const override {
+    return "<native fn: checkpoint>";
+  }
+
+  Object call(std::vector<Object> args) override {
+    if (m_target == nullptr || !m_target->m_started)
+      return "Target is not running!";
+
+    if (!args.empty()) {
+      auto sub = detail::asString(args.front());
+      if (!sub || *sub != "list") return "Usage: checkpoint [list]";
+      const auto& checkpoints = m_target->getCheckpoints();
+      if (checkpoints.empty()) return "No checkpoints!";
+
+      const auto pc = findRegEntry("pc");
+      std::string retStr{};
+      for (const auto& cp : checkpoints) {
+        retStr += std::format("Checkpoint {} (pid {})", cp.id, cp.pid);
+        if (pc)
+          retStr += std::format(
+              " @ {}", detail::toHex(readRegValue(cp.regs, *pc.value())));
+        retStr += '\n';
+      }
+      retStr.pop_back();
+      return retStr;
+    }
+
+    if (m_target->getTargetState() != TargetState::STOPPED)
+      return "Target has to be stopped!";
+    const auto start = std::chrono::steady_clock::now();
+    const i32 id = m_target->checkpoint();
+    if (id < 0) return "Could not save a checkpoint!";
+    const std::chrono::duration<double, std::micro> took =
+        std::chrono::steady_clock::now() - start;
+    return std::format("Checkpoint {} saved in {:.0f} us", id,
+                       took.count());
+  }
+};
+
+// `restore <n>` makes a fresh copy of checkpoint n the target, the current
+// process is killed
+class RestoreFn : public Callable {
+ public:
+  [[nodiscard]] int arity() const override { return 1; }
+  [[nodiscard]] std::string str() const override {
+    return "<native fn: restore>";
+  }
+
+  Object call(std::vector<Object> args) override {
+    if (m_target == nullptr || !m_target->m_started)
+      return "Target is not running!";
+    if (args.empty()) return "Usage: restore <checkpoint>";
+    auto id = detail::asU64(args.front());
+    if (!id) return id.error();
+
+    if (m_target->restoreCheckpoint(static_cast<u32>(*id)) != 0)
+      return std::format("Could not restore checkpoint {}", *id);
+    return std::format("Restored checkpoint {}, target is now pid {}", *id,
+                       m_target->pid());
+  }
+};
+
+// `syscalls log [names...]` (or `trace`) reports every call to names as it
+// returns, `syscalls count [names...]` only keeps the statistics
+// `syscalls stats` prints. No names means every syscall
+class SyscallsFn : public SubcommandCallable {
+ private:
+  static Object start(const std::vector<Object>& args, bool print) {
+    auto& target = Context::getTarget();
+    if (target->getTargetState() != TargetState::STOPPED)
+      return "Target has to be stopped!";
+
+    std::vector<std::string> names{};
+    std::string listed{};
+    for (const auto& arg : args) {
+      auto name = detail::asString(arg);
+      if (!name) return name.error();
+      listed += listed.empty() ? *name : std::format(", {}", *name);
+      names.push_back(*name);
+    }
+    if (target->traceSyscalls(names, print) != 0)
+      return "Could not trace syscalls!";
+    return std::format("{} {}", print ? "Tracing" : "Counting",
+                       names.empty() ? "every syscall" : listed);
+  }
+
+  static inline FnPtr log =
+      requiresRunningTarget([](const std::vector<Object>& args) -> Object {
+        return SyscallsFn::start(args, true);
+      });
+
+  static inline FnPtr count =
+      requiresRunningTarget([](const std::vector<Object>& args) -> Object {
+        return SyscallsFn::start(args, false);
+      });
+
+  static inline FnPtr stats =
+      requiresRunningTarget([](const std::vector<Object>& args) -> Object {
+#pragma unused(args)
+        return Context::getTarget()->syscallSummary();
+      });
+
+  static inline FnPtr stop =
+      requiresRunningTarget([](const std::vector<Object>& args) -> Object {
+#pragma unused(args)
+        if (Context::getTarget()->stopSyscallTrace() != 0)
+          return "Could not stop tracing syscalls!";
+        return "Stopped tracing syscalls";
+      });
+
+ public:
+  [[nodiscard]] int arity() const override { return 1; }
+  [[nodiscard]] std::string str() const override {
+    return "<native fn: syscalls>";
+  }
+
+  SyscallsFn()
+      : SubcommandCallable({{{sv("log"), log},
+                             {sv("trace"), log},
+                             {sv("count"), count},
+                             {sv("stats"), stats},
+                             {sv("stop"), stop}},
+                            "syscalls"}) {}
+};
+
+// `profile [cpu] <seconds> <hz> [file]` runs the target while sampling where
+// its threads are. By default every thread is stopped for each sample,
+// blocked ones included, `cpu` samples running threads through perf events
+// without stopping anything. The folded stacks go to file, or are printed
+// after the table of the busiest functions
+class ProfileFn : public Callable {
+ public:
+  static constexpr size_t TOP_FUNCTIONS = 20;
+
+  [[nodiscard]] int arity() const override { return 2; }
+  [[nodiscard]] std::string str() const override {
+    return "<native fn: profile>";
+  }
+
+  Object call(std::vector<Object> args) override {
+    constexpr std::string_view usage =
+        "Usage: profile [cpu] <seconds> <hz> [file]";
+    if (m_target == nullptr || !m_target->m_started)
+      return "Target is not running!";
+    if (m_target->getTargetState() != TargetState::STOPPED)
+      return "Target has to be stopped!";
+    if (args.empty()) return std::string{usage};
+
+    ProfileMode mode = ProfileMode::WALL;
+    if (const auto* first = std::get_if<std::string>(&args.front())) {
+      if (*first != "cpu") return std::string{usage};
+      mode = ProfileMode::CPU;
+      args.erase(args.begin());
+    }
+    if (args.size() < 2) return std::string{usage};
+
+    const auto* seconds = std::get_if<double>(&args.front());
+    if (seconds == nullptr) return std::string{usage};
+    auto hz = detail::asU64(args[1]);
+    if (!hz) return hz.error();
+    std::optional<std::string> path{};
+    if (args.size() > 2) {
+      auto arg = detail::asString(args[2]);
+      if (!arg) return arg.error();
+      path = *arg;
+    }
+
+    Profile profile{};
+    const auto rate = static_cast<u32>(*hz);
+    if (m_target->profile(mode, *seconds, rate, profile) != 0)
+      return "Could not profile the target!";
+
+    std::string retStr =
+        mode == ProfileMode::CPU
+            ? std::format("{} samples, {} lost\n", profile.samples(),
+                          profile.lost())
+            : std::format(
+                  "{} samples over {} ticks, target paused {:.1f} us on "
+                  "average and {:.1f} us at most\n",
+                  profile.samples(), profile.ticks(),
+                  profile.avgPauseNs() / 1e3,
+                  static_cast<double>(profile.maxPauseNs()) / 1e3);
+    retStr += profile.top(TOP_FUNCTIONS);
+    if (!path) return std::format("{}\n\n{}", retStr, profile.folded());
+
+    std::ofstream out{*path};
+    out << profile.folded() << '\n';
+    if (!out) return std::format("{}\nCould not write {}", retStr, *path);
+    return std::format("{}\nFolded stacks written to {}", retStr, *path);
+  }
+};
+
+// `backtrace [depth]` lists the frames of the selected thread, innermost
+// first
+class BacktraceFn : public Callable {
+ public:
+  static constexpr size_t DEFAULT_DEPTH = 1024;
+
+  [[nodiscard]] int arity() const override { return 0; }
+  [[nodiscard]] std::string str() const override {
+    return "<native fn: backtrace>";
+  }
+
+  Object call(std::vector<Object> args) override {
+    if (m_target == nullptr || !m_target->m_started)
+      return "Target is not running!";
+
+    size_t depth = DEFAULT_DEPTH;
+    if (!args.empty()) {
+      auto arg = detail::asU64(args.front());
+      if (!arg) return arg.error();
+      depth = *arg;
+    }
+
+    std::vector<StackFrame> frames{};
+    if (m_target->backtrace(depth, frames) != 0)
+      return "Could not unwind the stack!";
+
+    std::string retStr{};
+    for (size_t i = 0; i < frames.size(); i++)
+      retStr += std::format("#{:<3} {:#018x} in {}\n", i, frames[i].pc,
+                            frames[i].function);
+    if (!retStr.empty()) retStr.pop_back();
+    return retStr;
+  }
+};
+
 #endif
@@ -1,5 +1,6 @@
 #ifndef TOKEN_H
 #define TOKEN_H
+#include <cstddef>
 #include <string>
 
 #include "object.hpp"
@@ -10,13 +11,15 @@ class Token {
   const TokenType m_type;
   const std::string m_lexeme;
   const Object m_literal;
+  const size_t m_offset;  // Where the lexeme starts in the scanned source
 
   template <typename T>
     requires std::constructible_from<Object, T>
-  Token(TokenType type, std::string lexeme, T&& literal)
+  Token(TokenType type, std::string lexeme, T&& literal, size_t offset = 0)
       : m_type(type),
         m_lexeme(std::move(lexeme)),
-        m_literal(std::forward<T>(literal)) {}
+        m_literal(std::forward<T>(literal)),
+        m_offset(offset) {}
   [[nodiscard]] std::string toString() const;
 };
 
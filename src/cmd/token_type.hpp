@@ -27,6 +27,7 @@ enum class TokenType : u8 {
   BOOL_TRUE,
   BOOL_FALSE,
   VAR,
+  IF,
   END,
 };
 
@@ -0,0 +1,89 @@
+#include "breakpoint_table.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+size_t BreakpointTable::home(u64 addr) const {
+  // Fibonacci hashing, breakpoints are often a few bytes apart so the low
+  // bits alone would cluster
+  constexpr u64 golden = 0x9E3779B97F4A7C15;
+  return static_cast<size_t>((addr * golden) >> 32) & mask();
+}
+
+// Index of addr's slot, or of the empty slot where it would go
+size_t BreakpointTable::probe(u64 addr) const {
+  size_t i = home(addr);
+  while (m_slots[i].bp.id != 0 && m_slots[i].addr != addr) i = (i + 1) & mask();
+  return i;
+}
+
+Breakpoint* BreakpointTable::find(u64 addr) {
+  Slot& slot = m_slots[probe(addr)];
+  return slot.bp.id != 0 ? &slot.bp : nullptr;
+}
+
+const Breakpoint* BreakpointTable::find(u64 addr) const {
+  const Slot& slot = m_slots[probe(addr)];
+  return slot.bp.id != 0 ? &slot.bp : nullptr;
+}
+
+Breakpoint* BreakpointTable::findById(u32 id) {
+  if (id == 0) return nullptr;
+  for (auto& slot : m_slots)
+    if (slot.bp.id == id) return &slot.bp;
+  return nullptr;
+}
+
+Breakpoint& BreakpointTable::insert(u64 addr, Breakpoint bp) {
+  // Keep the load factor at or below one half
+  if ((m_size + 1) * 2 > m_slots.size()) rehash(m_slots.size() * 2);
+
+  Slot& slot = m_slots[probe(addr)];
+  if (slot.bp.id != 0) {
+    bp.id = slot.bp.id;
+    bp.hit_count = slot.bp.hit_count;
+  } else {
+    bp.id = m_next_id++;
+    m_size++;
+  }
+
+  slot = {.addr = addr, .bp = bp};
+  return slot.bp;
+}
+
+bool BreakpointTable::erase(u64 addr) {
+  size_t i = probe(addr);
+  if (m_slots[i].bp.id == 0) return false;
+
+  // Backward shift: move later entries of the cluster into the hole unless
+  // that would put them before their home slot
+  for (size_t j = (i + 1) & mask(); m_slots[j].bp.id != 0;
+       j = (j + 1) & mask()) {
+    const size_t k = home(m_slots[j].addr);
+    if (((j - k) & mask()) >= ((j - i) & mask())) {
+      m_slots[i] = m_slots[j];
+      i = j;
+    }
+  }
+
+  m_slots[i] = {};
+  m_size--;
+  return true;
+}
+
+void BreakpointTable::clear() {
+  m_slots.assign(MIN_CAPACITY, {});
+  m_size = 0;
+}
+
+void BreakpointTable::reserve(size_t n) {
+  const size_t capacity = std::bit_ceil(std::max(n * 2, MIN_CAPACITY));
+  if (capacity > m_slots.size()) rehash(capacity);
+}
+
+void BreakpointTable::rehash(size_t capacity) {
+  std::vector<Slot> old = std::exchange(m_slots, std::vector<Slot>(capacity));
+  for (const auto& slot : old)
+    if (slot.bp.id != 0) m_slots[probe(slot.addr)] = slot;
+}
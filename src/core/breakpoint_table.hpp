@@ -0,0 +1,116 @@
+#ifndef CAESAR_BREAKPOINT_TABLE_HPP
+#define CAESAR_BREAKPOINT_TABLE_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#include "typedefs.hpp"
+
+enum class BreakpointFlag : u8 {
+  NONE = 0,
+  ONE_SHOT = 1 << 0,  // Removed by the first hit that counts
+  INTERNAL = 1 << 1,  // Set by the debugger itself, hidden from listings
+  CONDITIONAL = 1 << 2,
+  TRACE = 1 << 3,  // Records into the tracer and resumes, never stops
+};
+
+struct Breakpoint {
+  u32 orig_ins;
+  bool enabled;
+  u8 flags = 0;
+  u32 id = 0;  // Assigned by BreakpointTable, 0 marks an empty slot
+  u64 hit_count = 0;
+
+  [[nodiscard]] bool has(BreakpointFlag f) const {
+    return (flags & static_cast<u8>(f)) != 0;
+  }
+};
+
+// Open addressing table keyed by unslid address, linear probing over one
+// contiguous array so a trap lookup touches one or two cache lines.
+// Lookups never insert, removal shifts the following entries back instead
+// of leaving tombstones
+class BreakpointTable {
+ public:
+  struct Slot {
+    u64 addr;
+    Breakpoint bp;
+  };
+
+  template <bool Const>
+  class Iterator {
+    using SlotPtr = std::conditional_t<Const, const Slot*, Slot*>;
+    SlotPtr m_pos;
+    SlotPtr m_end;
+
+    void skipEmpty() {
+      while (m_pos != m_end && m_pos->bp.id == 0) m_pos++;
+    }
+
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Slot;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::conditional_t<Const, const Slot&, Slot&>;
+
+    Iterator(SlotPtr pos, SlotPtr end) : m_pos(pos), m_end(end) {
+      skipEmpty();
+    }
+    reference operator*() const { return *m_pos; }
+    SlotPtr operator->() const { return m_pos; }
+    Iterator& operator++() {
+      m_pos++;
+      skipEmpty();
+      return *this;
+    }
+    bool operator==(const Iterator& other) const {
+      return m_pos == other.m_pos;
+    }
+  };
+
+  BreakpointTable() { m_slots.resize(MIN_CAPACITY); }
+
+  Breakpoint* find(u64 addr);
+  [[nodiscard]] const Breakpoint* find(u64 addr) const;
+  [[nodiscard]] bool contains(u64 addr) const { return find(addr) != nullptr; }
+  Breakpoint* findById(u32 id);
+
+  // Inserts or replaces, a replaced entry keeps its id and hit count
+  Breakpoint& insert(u64 addr, Breakpoint bp);
+  bool erase(u64 addr);
+  void clear();
+  void reserve(size_t n);
+
+  [[nodiscard]] size_t size() const { return m_size; }
+  [[nodiscard]] bool empty() const { return m_size == 0; }
+  [[nodiscard]] size_t capacity() const { return m_slots.size(); }
+
+  Iterator<false> begin() {
+    return {m_slots.data(), m_slots.data() + m_slots.size()};
+  }
+  Iterator<false> end() {
+    return {m_slots.data() + m_slots.size(), m_slots.data() + m_slots.size()};
+  }
+  [[nodiscard]] Iterator<true> begin() const {
+    return {m_slots.data(), m_slots.data() + m_slots.size()};
+  }
+  [[nodiscard]] Iterator<true> end() const {
+    return {m_slots.data() + m_slots.size(), m_slots.data() + m_slots.size()};
+  }
+
+ private:
+  static constexpr size_t MIN_CAPACITY = 16;
+
+  std::vector<Slot> m_slots;
+  size_t m_size = 0;
+  u32 m_next_id = 1;
+
+  [[nodiscard]] size_t mask() const { return m_slots.size() - 1; }
+  [[nodiscard]] size_t home(u64 addr) const;
+  [[nodiscard]] size_t probe(u64 addr) const;
+  void rehash(size_t capacity);
+};
+
+#endif
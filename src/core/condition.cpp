@@ -0,0 +1,109 @@
+#include "condition.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+void ConditionProgram::emit(CondOp op, u64 operand, u8 size) {
+  m_code.push_back({.op = op, .size = size, .operand = operand});
+
+  switch (op) {
+    case CondOp::PUSH:
+    case CondOp::LOAD_REG:
+      m_depth++;
+      break;
+    case CondOp::NEG:
+    case CondOp::NOT:
+      break;
+    default:
+      m_depth--;
+      break;
+  }
+  m_max_depth = std::max(m_max_depth, m_depth);
+}
+
+bool ConditionProgram::evaluate(const ThreadState& state) const {
+  // Left uninitialised, valid() guarantees every slot is written before use
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init)
+  std::array<u64, MAX_STACK> stack;
+  size_t sp = 0;
+  const auto* regs = reinterpret_cast<const u8*>(&state);
+
+  for (const auto& ins : m_code) {
+    switch (ins.op) {
+      case CondOp::PUSH:
+        stack[sp++] = ins.operand;
+        continue;
+      case CondOp::LOAD_REG: {
+        // Fixed size copies, a variable length memcpy dominates otherwise
+        if (ins.size == sizeof(u64)) {
+          u64 val = 0;
+          memcpy(&val, regs + ins.operand, sizeof(u64));
+          stack[sp++] = val;
+        } else {
+          u32 val = 0;
+          memcpy(&val, regs + ins.operand, sizeof(u32));
+          stack[sp++] = val;
+        }
+        continue;
+      }
+      case CondOp::NEG:
+        stack[sp - 1] = -stack[sp - 1];
+        continue;
+      case CondOp::NOT:
+        stack[sp - 1] = stack[sp - 1] == 0 ? 1 : 0;
+        continue;
+      default:
+        break;
+    }
+
+    const u64 rhs = stack[--sp];
+    const u64 lhs = stack[sp - 1];
+    const auto slhs = static_cast<i64>(lhs);
+    const auto srhs = static_cast<i64>(rhs);
+    u64& out = stack[sp - 1];
+
+    switch (ins.op) {
+      case CondOp::ADD:
+        out = lhs + rhs;
+        break;
+      case CondOp::SUB:
+        out = lhs - rhs;
+        break;
+      case CondOp::MUL:
+        out = lhs * rhs;
+        break;
+      case CondOp::DIV:
+        // A condition has no way to report errors, dividing by zero is false
+        if (srhs == 0)
+          out = 0;
+        else if (srhs == -1)
+          out = -lhs;  // INT64_MIN / -1 overflows
+        else
+          out = static_cast<u64>(slhs / srhs);
+        break;
+      case CondOp::EQ:
+        out = lhs == rhs ? 1 : 0;
+        break;
+      case CondOp::NE:
+        out = lhs != rhs ? 1 : 0;
+        break;
+      case CondOp::LT:
+        out = slhs < srhs ? 1 : 0;
+        break;
+      case CondOp::LE:
+        out = slhs <= srhs ? 1 : 0;
+        break;
+      case CondOp::GT:
+        out = slhs > srhs ? 1 : 0;
+        break;
+      case CondOp::GE:
+        out = slhs >= srhs ? 1 : 0;
+        break;
+      default:
+        break;
+    }
+  }
+
+  return sp == 1 && stack[0] != 0;
+}
@@ -0,0 +1,57 @@
+#ifndef CAESAR_CONDITION_HPP
+#define CAESAR_CONDITION_HPP
+
+#include <string>
+#include <vector>
+
+#include "core/platform.hpp"
+#include "typedefs.hpp"
+
+enum class CondOp : u8 {
+  PUSH,      // operand is the constant
+  LOAD_REG,  // operand is the offset into ThreadState, size is the width
+  NEG,
+  NOT,
+  ADD,
+  SUB,
+  MUL,
+  DIV,
+  EQ,
+  NE,
+  LT,
+  LE,
+  GT,
+  GE,
+};
+
+struct CondInstr {
+  CondOp op;
+  u8 size;
+  u64 operand;
+};
+
+// Breakpoint condition compiled to a small stack program, evaluated straight
+// against the trapped thread state by the event loop. Values are 64-bit
+// integers, comparisons are signed like registers are in the interpreter
+class ConditionProgram {
+ public:
+  static constexpr size_t MAX_STACK = 32;
+
+  void emit(CondOp op, u64 operand = 0, u8 size = 0);
+  [[nodiscard]] bool evaluate(const ThreadState& state) const;
+
+  [[nodiscard]] bool valid() const {
+    return !m_code.empty() && m_depth == 1 && m_max_depth <= MAX_STACK;
+  }
+  [[nodiscard]] size_t size() const { return m_code.size(); }
+  [[nodiscard]] const std::string& source() const { return m_source; }
+  void setSource(std::string source) { m_source = std::move(source); }
+
+ private:
+  std::vector<CondInstr> m_code;
+  std::string m_source;
+  size_t m_depth = 0;
+  size_t m_max_depth = 0;
+};
+
+#endif
@@ -11,6 +11,7 @@ class Context {
  private:
   Context() = default;
   inline static std::unique_ptr<Target> mTarget;
+  inline static bool mAsync = false;
 
  public:
   Context(const Context&) = delete;
@@ -27,6 +28,10 @@ class Context {
   static void setTarget(std::unique_ptr<Target> ptr) {
     mTarget = std::move(ptr);
   }
+  // Set by the interactive REPL, run and resume then return as soon as the
+  // target runs and its stops are reported whenever they happen
+  static bool isAsync() { return mAsync; }
+  static void setAsync(bool async) { mAsync = async; }
 };
 
 #endif
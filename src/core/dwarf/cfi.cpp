@@ -0,0 +1,825 @@
+#include "cfi.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+// Call frame instructions, DWARF 5 section 6.4.2. The first three keep an
+// operand in their low six bits
+enum : u8 {
+  CFA_ADVANCE_LOC = 0x40,
+  CFA_OFFSET = 0x80,
+  CFA_RESTORE = 0xc0,
+  CFA_NOP = 0x00,
+  CFA_SET_LOC = 0x01,
+  CFA_ADVANCE_LOC1 = 0x02,
+  CFA_ADVANCE_LOC2 = 0x03,
+  CFA_ADVANCE_LOC4 = 0x04,
+  CFA_OFFSET_EXTENDED = 0x05,
+  CFA_RESTORE_EXTENDED = 0x06,
+  CFA_UNDEFINED = 0x07,
+  CFA_SAME_VALUE = 0x08,
+  CFA_REGISTER = 0x09,
+  CFA_REMEMBER_STATE = 0x0a,
+  CFA_RESTORE_STATE = 0x0b,
+  CFA_DEF_CFA = 0x0c,
+  CFA_DEF_CFA_REGISTER = 0x0d,
+  CFA_DEF_CFA_OFFSET = 0x0e,
+  CFA_DEF_CFA_EXPRESSION = 0x0f,
+  CFA_EXPRESSION = 0x10,
+  CFA_OFFSET_EXTENDED_SF = 0x11,
+  CFA_DEF_CFA_SF = 0x12,
+  CFA_DEF_CFA_OFFSET_SF = 0x13,
+  CFA_VAL_OFFSET = 0x14,
+  CFA_VAL_OFFSET_SF = 0x15,
+  CFA_VAL_EXPRESSION = 0x16,
+  CFA_GNU_ARGS_SIZE = 0x2e,
+  CFA_GNU_NEGATIVE_OFFSET_EXTENDED = 0x2f,
+};
+
+// Pointer encodings of .eh_frame, the format in the low nibble and what it
+// is relative to above it
+enum : u8 {
+  PE_ABSPTR = 0x00,
+  PE_ULEB128 = 0x01,
+  PE_UDATA2 = 0x02,
+  PE_UDATA4 = 0x03,
+  PE_UDATA8 = 0x04,
+  PE_SLEB128 = 0x09,
+  PE_SDATA2 = 0x0a,
+  PE_SDATA4 = 0x0b,
+  PE_SDATA8 = 0x0c,
+  PE_FORMAT = 0x0f,
+  PE_PCREL = 0x10,
+  PE_APPLICATION = 0x70,
+  PE_INDIRECT = 0x80,
+};
+
+// The expression operations CFI has use for, DWARF 5 section 2.5
+enum : u8 {
+  OP_ADDR = 0x03,
+  OP_DEREF = 0x06,
+  OP_CONST1U = 0x08,
+  OP_CONST1S = 0x09,
+  OP_CONST2U = 0x0a,
+  OP_CONST2S = 0x0b,
+  OP_CONST4U = 0x0c,
+  OP_CONST4S = 0x0d,
+  OP_CONST8U = 0x0e,
+  OP_CONST8S = 0x0f,
+  OP_CONSTU = 0x10,
+  OP_CONSTS = 0x11,
+  OP_DUP = 0x12,
+  OP_DROP = 0x13,
+  OP_OVER = 0x14,
+  OP_PICK = 0x15,
+  OP_SWAP = 0x16,
+  OP_ROT = 0x17,
+  OP_ABS = 0x19,
+  OP_AND = 0x1a,
+  OP_DIV = 0x1b,
+  OP_MINUS = 0x1c,
+  OP_MOD = 0x1d,
+  OP_MUL = 0x1e,
+  OP_NEG = 0x1f,
+  OP_NOT = 0x20,
+  OP_OR = 0x21,
+  OP_PLUS = 0x22,
+  OP_PLUS_UCONST = 0x23,
+  OP_SHL = 0x24,
+  OP_SHR = 0x25,
+  OP_SHRA = 0x26,
+  OP_XOR = 0x27,
+  OP_BRA = 0x28,
+  OP_EQ = 0x29,
+  OP_GE = 0x2a,
+  OP_GT = 0x2b,
+  OP_LE = 0x2c,
+  OP_LT = 0x2d,
+  OP_NE = 0x2e,
+  OP_SKIP = 0x2f,
+  OP_LIT0 = 0x30,
+  OP_LIT31 = 0x4f,
+  OP_BREG0 = 0x70,
+  OP_BREG31 = 0x8f,
+  OP_BREGX = 0x92,
+  OP_NOP = 0x96,
+};
+
+constexpr size_t MAX_EXPR_STACK = 64;
+// Branches can loop, an expression gets this many operations
+constexpr size_t MAX_EXPR_OPS = 1024;
+constexpr u32 NO_CIE = std::numeric_limits<u32>::max();
+
+// Reads [pos, end) of a section front to back. A failed read sticks and
+// moves to the end, so checks can wait until a whole entry is read
+class Cursor {
+ public:
+  Cursor(std::span<const std::byte> bytes, size_t pos, size_t end)
+      : m_bytes(bytes.first(std::min(end, bytes.size()))),
+        m_pos(std::min(pos, m_bytes.size())) {}
+
+  template <typename T>
+  T read() {
+    T out{};
+    if (m_bytes.size() - m_pos < sizeof(T)) {
+      fail();
+      return out;
+    }
+    std::memcpy(&out, m_bytes.data() + m_pos, sizeof(T));
+    m_pos += sizeof(T);
+    return out;
+  }
+
+  u64 uleb() {
+    u64 out = 0;
+    for (u32 shift = 0;; shift += 7) {
+      if (m_pos == m_bytes.size()) {
+        fail();
+        return 0;
+      }
+      const auto byte = static_cast<u8>(m_bytes[m_pos++]);
+      if (shift < 64) out |= u64{byte & 0x7fU} << shift;
+      if ((byte & 0x80) == 0) return out;
+    }
+  }
+
+  i64 sleb() {
+    u64 out = 0;
+    u32 shift = 0;
+    u8 byte = 0;
+    do {
+      if (m_pos == m_bytes.size()) {
+        fail();
+        return 0;
+      }
+      byte = static_cast<u8>(m_bytes[m_pos++]);
+      if (shift < 64) out |= u64{byte & 0x7fU} << shift;
+      shift += 7;
+    } while ((byte & 0x80) != 0);
+    if (shift < 64 && (byte & 0x40) != 0) out |= ~u64{0} << shift;
+    return static_cast<i64>(out);
+  }
+
+  // vaddr is the link-time address of the section, for pc-relative ones
+  u64 pointer(u8 encoding, u64 vaddr) {
+    const u64 at = vaddr + m_pos;
+    u64 value = 0;
+    switch (encoding & PE_FORMAT) {
+      case PE_ABSPTR:
+      case PE_UDATA8:
+      case PE_SDATA8:
+        value = read<u64>();
+        break;
+      case PE_ULEB128:
+        value = uleb();
+        break;
+      case PE_UDATA2:
+        value = read<u16>();
+        break;
+      case PE_UDATA4:
+        value = read<u32>();
+        break;
+      case PE_SLEB128:
+        value = static_cast<u64>(sleb());
+        break;
+      case PE_SDATA2:
+        value = static_cast<u64>(i64{read<std::int16_t>()});
+        break;
+      case PE_SDATA4:
+        value = static_cast<u64>(i64{read<i32>()});
+        break;
+      default:
+        fail();
+        return 0;
+    }
+    // Indirect pointers would need the target's memory
+    if ((encoding & PE_INDIRECT) != 0) fail();
+    switch (encoding & PE_APPLICATION) {
+      case 0:
+        return value;
+      case PE_PCREL:
+        return value + at;
+      default:
+        fail();
+        return 0;
+    }
+  }
+
+  std::string_view string() {
+    const auto* start = std::bit_cast<const char*>(m_bytes.data() + m_pos);
+    const size_t len = strnlen(start, m_bytes.size() - m_pos);
+    if (len == m_bytes.size() - m_pos) {
+      fail();
+      return {};
+    }
+    m_pos += len + 1;
+    return {start, len};
+  }
+
+  void skip(u64 n) {
+    if (m_bytes.size() - m_pos < n)
+      fail();
+    else
+      m_pos += n;
+  }
+
+  void seek(size_t pos) {
+    if (pos > m_bytes.size())
+      fail();
+    else
+      m_pos = pos;
+  }
+
+  [[nodiscard]] bool ok() const { return m_ok; }
+  [[nodiscard]] bool more() const { return m_ok && m_pos < m_bytes.size(); }
+  [[nodiscard]] size_t pos() const { return m_pos; }
+
+ private:
+  std::span<const std::byte> m_bytes;
+  size_t m_pos;
+  bool m_ok = true;
+
+  void fail() {
+    m_ok = false;
+    m_pos = m_bytes.size();
+  }
+};
+
+// Rule at offset from the CFA, undefined when it does not fit a row
+CfiRule offsetRule(CfiRuleKind kind, i64 offset) {
+  if (offset < std::numeric_limits<i32>::min() ||
+      offset > std::numeric_limits<i32>::max())
+    return {.kind = CfiRuleKind::UNDEFINED};
+  return {.kind = kind, .offset = static_cast<i32>(offset)};
+}
+}  // namespace
+
+i32 CallFrameInfo::load(std::span<const std::byte> section, u64 vaddr,
+                        bool ehFrame) {
+  if (section.size() > std::numeric_limits<u32>::max()) return -1;
+  m_section = section;
+  m_vaddr = vaddr;
+  m_cies.clear();
+  m_fdes.clear();
+  m_rows.clear();
+
+  // Section offset of every CIE an FDE named to its index, NO_CIE if it
+  // could not be parsed
+  std::unordered_map<u64, u32> cies{};
+  const u64 cieId = ehFrame ? 0 : std::numeric_limits<u32>::max();
+  size_t pos = 0;
+  while (section.size() - pos >= sizeof(u32)) {
+    Cursor entry{section, pos, section.size()};
+    u64 length = entry.read<u32>();
+    if (length == 0) {
+      // The terminator of .eh_frame, padding in .debug_frame
+      if (ehFrame) break;
+      pos += sizeof(u32);
+      continue;
+    }
+    const bool wide = length == std::numeric_limits<u32>::max();
+    if (wide) length = entry.read<u64>();
+    if (!entry.ok() || length > section.size() - entry.pos()) break;
+    const size_t end = entry.pos() + length;
+    pos = end;
+
+    Cursor c{section, entry.pos(), end};
+    const size_t idPos = c.pos();
+    const u64 id = wide ? c.read<u64>() : c.read<u32>();
+    // CIEs are parsed once the first FDE refers to them
+    if (!c.ok() || id == (wide && !ehFrame ? ~u64{0} : cieId)) continue;
+    // Relative to the field in .eh_frame, a section offset otherwise
+    if (ehFrame && id > idPos) continue;
+    const u64 ciePos = ehFrame ? idPos - id : id;
+
+    auto [known, fresh] = cies.try_emplace(ciePos, NO_CIE);
+    if (fresh)
+      if (auto cie = parseCie(ciePos)) {
+        known->second = static_cast<u32>(m_cies.size());
+        m_cies.push_back(*cie);
+      }
+    if (known->second == NO_CIE) continue;
+    const Cie& cie = m_cies[known->second];
+
+    const u64 begin = c.pointer(cie.encoding, vaddr);
+    const u64 range = c.pointer(cie.encoding & PE_FORMAT, vaddr);
+    if (cie.augmented) c.skip(c.uleb());
+    if (!c.ok() || begin == 0 || range == 0) continue;
+    m_fdes.push_back({.begin = begin,
+                      .end = begin + range,
+                      .instructions = static_cast<u32>(c.pos()),
+                      .size = static_cast<u32>(end - c.pos()),
+                      .cie = known->second});
+  }
+
+  std::ranges::sort(m_fdes, {}, &Fde::begin);
+  return 0;
+}
+
+std::optional<CallFrameInfo::Cie> CallFrameInfo::parseCie(size_t pos) const {
+  Cursor entry{m_section, pos, m_section.size()};
+  u64 length = entry.read<u32>();
+  const bool wide = length == std::numeric_limits<u32>::max();
+  if (wide) length = entry.read<u64>();
+  if (!entry.ok() || length > m_section.size() - entry.pos())
+    return std::nullopt;
+
+  Cursor c{m_section, entry.pos(), entry.pos() + length};
+  c.skip(wide ? sizeof(u64) : sizeof(u32));
+  const u8 version = c.read<u8>();
+  const std::string_view augmentation = c.string();
+  // "eh" is the layout of GCC before 3.0
+  if ((version != 1 && version != 3 && version != 4) ||
+      augmentation.find("eh") != std::string_view::npos)
+    return std::nullopt;
+  if (version == 4) {
+    const u8 addressSize = c.read<u8>();
+    const u8 segmentSize = c.read<u8>();
+    if (addressSize != sizeof(u64) || segmentSize != 0) return std::nullopt;
+  }
+
+  Cie cie{};
+  cie.codeAlign = c.uleb();
+  cie.dataAlign = c.sleb();
+  // Rows keep the return address where x86-64 has it
+  if ((version == 1 ? c.read<u8>() : c.uleb()) != UnwindRegs::RIP)
+    return std::nullopt;
+  cie.encoding = PE_ABSPTR;
+  if (augmentation.starts_with('z')) {
+    cie.augmented = true;
+    const u64 size = c.uleb();
+    const size_t end = c.pos() + size;
+    for (const char ch : augmentation.substr(1)) {
+      if (ch == 'R') {
+        cie.encoding = c.read<u8>();
+      } else if (ch == 'L') {
+        c.read<u8>();
+      } else if (ch == 'P') {
+        // The personality routine, only skipped
+        const u8 encoding = c.read<u8>();
+        c.pointer(encoding & ~PE_INDIRECT, m_vaddr);
+      } else if (ch == 'S') {
+        cie.signal = true;
+      } else if (ch != 'B' && ch != 'G') {
+        // The size covers whatever data the rest of them have
+        break;
+      }
+    }
+    c.seek(end);
+  } else if (!augmentation.empty()) {
+    return std::nullopt;
+  }
+  if (!c.ok()) return std::nullopt;
+
+  cie.instructions = static_cast<u32>(c.pos());
+  cie.size = static_cast<u32>(entry.pos() + length - c.pos());
+  return cie;
+}
+
+const UnwindRow* CallFrameInfo::find(u64 pc) {
+  auto fde = std::ranges::upper_bound(m_fdes, pc, {}, &Fde::begin);
+  if (fde == m_fdes.begin()) return nullptr;
+  --fde;
+  if (pc >= fde->end) return nullptr;
+  if (!fde->compiled) compile(*fde);
+
+  const auto rows = std::span{m_rows}.subspan(fde->firstRow, fde->rows);
+  auto row = std::ranges::upper_bound(rows, pc, {}, &UnwindRow::pc);
+  if (row == rows.begin()) return nullptr;
+  return &*std::prev(row);
+}
+
+std::span<const std::byte> CallFrameInfo::expression(
+    const CfiRule& rule) const {
+  return m_section.subspan(rule.expr, rule.exprSize);
+}
+
+void CallFrameInfo::compile(Fde& fde) {
+  const Cie& cie = m_cies[fde.cie];
+  UnwindRow row{.pc = fde.begin,
+                .cfa = {.kind = CfiRuleKind::UNDEFINED},
+                .regs = {},
+                .signal = cie.signal};
+  execute(cie, cie.instructions, cie.size, row, nullptr, fde.end);
+  const UnwindRow initial = row;
+
+  fde.compiled = true;
+  fde.firstRow = static_cast<u32>(m_rows.size());
+  execute(cie, fde.instructions, fde.size, row, &initial, fde.end);
+  if (m_rows.size() > fde.firstRow && m_rows.back().pc == row.pc)
+    m_rows.back() = row;
+  else
+    m_rows.push_back(row);
+  fde.rows = static_cast<u32>(m_rows.size() - fde.firstRow);
+}
+
+void CallFrameInfo::execute(const Cie& cie, u32 offset, u32 size,
+                            UnwindRow& row, const UnwindRow* initial,
+                            u64 end) {
+  Cursor c{m_section, offset, size_t{offset} + size};
+  const size_t first = m_rows.size();
+  std::vector<UnwindRow> saved{};
+
+  // Ends the current row at pc, false once pc leaves the FDE. The CIE's
+  // instructions only set up the first row
+  const auto moveTo = [&](u64 pc) {
+    if (initial == nullptr) return true;
+    if (pc >= end) return false;
+    if (pc <= row.pc) return true;
+    if (m_rows.size() > first && m_rows.back().pc == row.pc)
+      m_rows.back() = row;
+    else
+      m_rows.push_back(row);
+    row.pc = pc;
+    return true;
+  };
+  // Registers past the return address, vector ones and such, are not kept
+  const auto set = [&row](u64 reg, CfiRule rule) {
+    if (reg < row.regs.size()) row.regs[reg] = rule;
+  };
+  const auto factored = [&cie](u64 n) {
+    return static_cast<i64>(n) * cie.dataAlign;
+  };
+  const auto block = [&c](CfiRuleKind kind) {
+    const u64 len = c.uleb();
+    const size_t at = c.pos();
+    c.skip(len);
+    if (!c.ok() || len > std::numeric_limits<u16>::max())
+      return CfiRule{.kind = CfiRuleKind::UNDEFINED};
+    return CfiRule{.kind = kind,
+                   .exprSize = static_cast<u16>(len),
+                   .expr = static_cast<u32>(at)};
+  };
+  const auto defCfa = [&row](u64 reg, i64 offset) {
+    row.cfa = offsetRule(CfiRuleKind::REGISTER, offset);
+    if (reg < row.regs.size())
+      row.cfa.reg = static_cast<u8>(reg);
+    else
+      row.cfa.kind = CfiRuleKind::UNDEFINED;
+  };
+  const auto restore = [&row, initial](u64 reg) {
+    if (reg < row.regs.size())
+      row.regs[reg] = initial != nullptr ? initial->regs[reg] : CfiRule{};
+  };
+
+  while (c.more()) {
+    const u8 op = c.read<u8>();
+    const u8 low = op & 0x3f;
+    switch (op & 0xc0) {
+      case CFA_ADVANCE_LOC:
+        if (!moveTo(row.pc + (low * cie.codeAlign))) return;
+        continue;
+      case CFA_OFFSET:
+        set(low, offsetRule(CfiRuleKind::OFFSET, factored(c.uleb())));
+        continue;
+      case CFA_RESTORE:
+        restore(low);
+        continue;
+      default:
+        break;
+    }
+
+    switch (op) {
+      case CFA_NOP:
+        break;
+      case CFA_SET_LOC:
+        if (!moveTo(c.pointer(cie.encoding, m_vaddr))) return;
+        break;
+      case CFA_ADVANCE_LOC1:
+        if (!moveTo(row.pc + (c.read<u8>() * cie.codeAlign))) return;
+        break;
+      case CFA_ADVANCE_LOC2:
+        if (!moveTo(row.pc + (c.read<u16>() * cie.codeAlign))) return;
+        break;
+      case CFA_ADVANCE_LOC4:
+        if (!moveTo(row.pc + (c.read<u32>() * cie.codeAlign))) return;
+        break;
+      case CFA_OFFSET_EXTENDED: {
+        const u64 reg = c.uleb();
+        set(reg, offsetRule(CfiRuleKind::OFFSET, factored(c.uleb())));
+        break;
+      }
+      case CFA_OFFSET_EXTENDED_SF: {
+        const u64 reg = c.uleb();
+        set(reg, offsetRule(CfiRuleKind::OFFSET, c.sleb() * cie.dataAlign));
+        break;
+      }
+      case CFA_GNU_NEGATIVE_OFFSET_EXTENDED: {
+        const u64 reg = c.uleb();
+        set(reg, offsetRule(CfiRuleKind::OFFSET, -factored(c.uleb())));
+        break;
+      }
+      case CFA_VAL_OFFSET: {
+        const u64 reg = c.uleb();
+        set(reg, offsetRule(CfiRuleKind::VAL_OFFSET, factored(c.uleb())));
+        break;
+      }
+      case CFA_VAL_OFFSET_SF: {
+        const u64 reg = c.uleb();
+        set(reg,
+            offsetRule(CfiRuleKind::VAL_OFFSET, c.sleb() * cie.dataAlign));
+        break;
+      }
+      case CFA_RESTORE_EXTENDED:
+        restore(c.uleb());
+        break;
+      case CFA_UNDEFINED:
+        set(c.uleb(), {.kind = CfiRuleKind::UNDEFINED});
+        break;
+      case CFA_SAME_VALUE:
+        set(c.uleb(), {});
+        break;
+      case CFA_REGISTER: {
+        const u64 reg = c.uleb();
+        const u64 from = c.uleb();
+        set(reg, from < row.regs.size()
+                     ? CfiRule{.kind = CfiRuleKind::REGISTER,
+                               .reg = static_cast<u8>(from)}
+                     : CfiRule{.kind = CfiRuleKind::UNDEFINED});
+        break;
+      }
+      case CFA_REMEMBER_STATE:
+        saved.push_back(row);
+        break;
+      case CFA_RESTORE_STATE:
+        if (!saved.empty()) {
+          const u64 pc = row.pc;
+          row = saved.back();
+          row.pc = pc;
+          saved.pop_back();
+        }
+        break;
+      case CFA_DEF_CFA: {
+        const u64 reg = c.uleb();
+        defCfa(reg, static_cast<i64>(c.uleb()));
+        break;
+      }
+      case CFA_DEF_CFA_SF: {
+        const u64 reg = c.uleb();
+        defCfa(reg, c.sleb() * cie.dataAlign);
+        break;
+      }
+      case CFA_DEF_CFA_REGISTER:
+        defCfa(c.uleb(), row.cfa.kind == CfiRuleKind::REGISTER
+                             ? row.cfa.offset
+                             : 0);
+        break;
+      case CFA_DEF_CFA_OFFSET:
+        if (row.cfa.kind == CfiRuleKind::REGISTER)
+          defCfa(row.cfa.reg, static_cast<i64>(c.uleb()));
+        else
+          c.uleb();
+        break;
+      case CFA_DEF_CFA_OFFSET_SF:
+        if (row.cfa.kind == CfiRuleKind::REGISTER)
+          defCfa(row.cfa.reg, c.sleb() * cie.dataAlign);
+        else
+          c.sleb();
+        break;
+      case CFA_DEF_CFA_EXPRESSION:
+        row.cfa = block(CfiRuleKind::VAL_EXPRESSION);
+        break;
+      case CFA_EXPRESSION: {
+        const u64 reg = c.uleb();
+        set(reg, block(CfiRuleKind::EXPRESSION));
+        break;
+      }
+      case CFA_VAL_EXPRESSION: {
+        const u64 reg = c.uleb();
+        set(reg, block(CfiRuleKind::VAL_EXPRESSION));
+        break;
+      }
+      case CFA_GNU_ARGS_SIZE:
+        c.uleb();
+        break;
+      default:
+        // Unknown operands cannot be skipped, the rows so far still hold
+        return;
+    }
+  }
+}
+
+std::optional<u64> evalCfiExpression(std::span<const std::byte> expr,
+                                     const UnwindRegs& regs,
+                                     const StackSnapshot& stack,
+                                     std::optional<u64> push) {
+  std::array<u64, MAX_EXPR_STACK> values{};
+  size_t depth = 0;
+  if (push) values[depth++] = *push;
+
+  Cursor c{expr, 0, expr.size()};
+  for (size_t ops = 0; c.more(); ops++) {
+    if (ops == MAX_EXPR_OPS || depth == values.size()) return std::nullopt;
+    const u8 op = c.read<u8>();
+    if (op >= OP_LIT0 && op <= OP_LIT31) {
+      values[depth++] = op - OP_LIT0;
+      continue;
+    }
+    if ((op >= OP_BREG0 && op <= OP_BREG31) || op == OP_BREGX) {
+      const u64 reg = op == OP_BREGX ? c.uleb() : op - OP_BREG0;
+      const i64 offset = c.sleb();
+      if (!regs.has(reg)) return std::nullopt;
+      values[depth++] = regs.values[reg] + static_cast<u64>(offset);
+      continue;
+    }
+
+    // Operations taking one operand or two, the result replaces them
+    const size_t needs = [op] {
+      switch (op) {
+        case OP_DEREF:
+        case OP_DUP:
+        case OP_DROP:
+        case OP_ABS:
+        case OP_NEG:
+        case OP_NOT:
+        case OP_PLUS_UCONST:
+        case OP_BRA:
+          return 1;
+        case OP_OVER:
+        case OP_SWAP:
+        case OP_AND:
+        case OP_DIV:
+        case OP_MINUS:
+        case OP_MOD:
+        case OP_MUL:
+        case OP_OR:
+        case OP_PLUS:
+        case OP_SHL:
+        case OP_SHR:
+        case OP_SHRA:
+        case OP_XOR:
+        case OP_EQ:
+        case OP_GE:
+        case OP_GT:
+        case OP_LE:
+        case OP_LT:
+        case OP_NE:
+          return 2;
+        case OP_ROT:
+          return 3;
+        default:
+          return 0;
+      }
+    }();
+    if (depth < needs) return std::nullopt;
+    const u64 b = depth >= 1 ? values[depth - 1] : 0;
+    const u64 a = depth >= 2 ? values[depth - 2] : 0;
+    const auto replace = [&values, depth](u64 result) {
+      values[depth - 1] = result;
+    };
+    const auto binary = [&values, &depth](u64 result) {
+      values[depth - 2] = result;
+      depth--;
+    };
+
+    switch (op) {
+      case OP_ADDR:
+      case OP_CONST8U:
+      case OP_CONST8S:
+        values[depth++] = c.read<u64>();
+        break;
+      case OP_CONST1U:
+        values[depth++] = c.read<u8>();
+        break;
+      case OP_CONST1S:
+        values[depth++] = static_cast<u64>(i64{c.read<std::int8_t>()});
+        break;
+      case OP_CONST2U:
+        values[depth++] = c.read<u16>();
+        break;
+      case OP_CONST2S:
+        values[depth++] = static_cast<u64>(i64{c.read<std::int16_t>()});
+        break;
+      case OP_CONST4U:
+        values[depth++] = c.read<u32>();
+        break;
+      case OP_CONST4S:
+        values[depth++] = static_cast<u64>(i64{c.read<i32>()});
+        break;
+      case OP_CONSTU:
+        values[depth++] = c.uleb();
+        break;
+      case OP_CONSTS:
+        values[depth++] = static_cast<u64>(c.sleb());
+        break;
+      case OP_DEREF: {
+        u64 word = 0;
+        if (!stack.read(b, word)) return std::nullopt;
+        replace(word);
+        break;
+      }
+      case OP_DUP:
+        values[depth++] = b;
+        break;
+      case OP_DROP:
+        depth--;
+        break;
+      case OP_OVER:
+        values[depth++] = a;
+        break;
+      case OP_PICK: {
+        const u8 index = c.read<u8>();
+        if (index >= depth) return std::nullopt;
+        values[depth] = values[depth - 1 - index];
+        depth++;
+        break;
+      }
+      case OP_SWAP:
+        values[depth - 2] = b;
+        replace(a);
+        break;
+      case OP_ROT:
+        // The top goes third, the other two move up
+        values[depth - 1] = a;
+        values[depth - 2] = values[depth - 3];
+        values[depth - 3] = b;
+        break;
+      case OP_ABS:
+        replace(static_cast<i64>(b) < 0 ? -b : b);
+        break;
+      case OP_NEG:
+        replace(-b);
+        break;
+      case OP_NOT:
+        replace(~b);
+        break;
+      case OP_PLUS_UCONST:
+        replace(b + c.uleb());
+        break;
+      case OP_AND:
+        binary(a & b);
+        break;
+      case OP_OR:
+        binary(a | b);
+        break;
+      case OP_XOR:
+        binary(a ^ b);
+        break;
+      case OP_PLUS:
+        binary(a + b);
+        break;
+      case OP_MINUS:
+        binary(a - b);
+        break;
+      case OP_MUL:
+        binary(a * b);
+        break;
+      case OP_DIV:
+        if (b == 0) return std::nullopt;
+        binary(static_cast<u64>(static_cast<i64>(a) / static_cast<i64>(b)));
+        break;
+      case OP_MOD:
+        if (b == 0) return std::nullopt;
+        binary(a % b);
+        break;
+      case OP_SHL:
+        binary(b < 64 ? a << b : 0);
+        break;
+      case OP_SHR:
+        binary(b < 64 ? a >> b : 0);
+        break;
+      case OP_SHRA:
+        binary(static_cast<u64>(static_cast<i64>(a) >> std::min<u64>(b, 63)));
+        break;
+      // Comparisons are signed
+      case OP_EQ:
+        binary(u64{a == b});
+        break;
+      case OP_NE:
+        binary(u64{a != b});
+        break;
+      case OP_GE:
+        binary(u64{static_cast<i64>(a) >= static_cast<i64>(b)});
+        break;
+      case OP_GT:
+        binary(u64{static_cast<i64>(a) > static_cast<i64>(b)});
+        break;
+      case OP_LE:
+        binary(u64{static_cast<i64>(a) <= static_cast<i64>(b)});
+        break;
+      case OP_LT:
+        binary(u64{static_cast<i64>(a) < static_cast<i64>(b)});
+        break;
+      case OP_SKIP:
+      case OP_BRA: {
+        const auto offset = c.read<std::int16_t>();
+        if (op == OP_BRA && values[--depth] == 0) break;
+        c.seek(c.pos() + offset);
+        break;
+      }
+      case OP_NOP:
+        break;
+      default:
+        return std::nullopt;
+    }
+  }
+
+  if (!c.ok() || depth == 0) return std::nullopt;
+  return values[depth - 1];
+}
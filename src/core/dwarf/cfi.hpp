@@ -0,0 +1,99 @@
+#ifndef CAESAR_DWARF_CFI_HPP
+#define CAESAR_DWARF_CFI_HPP
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "core/unwind.hpp"
+#include "typedefs.hpp"
+
+// How a value of the caller's frame is recovered, DWARF 5 section 6.4.1
+enum class CfiRuleKind : u8 {
+  SAME,            // Unchanged
+  UNDEFINED,       // Lost, on the return address it marks the outermost frame
+  OFFSET,          // Saved at CFA + offset
+  VAL_OFFSET,      // Is CFA + offset
+  REGISTER,        // In register reg, for the CFA reg + offset
+  EXPRESSION,      // Saved at the address the expression computes
+  VAL_EXPRESSION,  // Is what the expression computes
+};
+
+struct CfiRule {
+  CfiRuleKind kind = CfiRuleKind::SAME;
+  u8 reg = 0;
+  u16 exprSize = 0;
+  i32 offset = 0;
+  u32 expr = 0;  // Offset of the expression in the section
+};
+
+// Rules for every address from pc up to the next row of the same FDE
+struct UnwindRow {
+  u64 pc;  // Link-time address
+  CfiRule cfa;
+  std::array<CfiRule, UnwindRegs::COUNT> regs;
+  bool signal;  // Frame of a signal trampoline, its pc is not a return address
+};
+
+// Call frame information of one ELF file, from .eh_frame or .debug_frame.
+// load only indexes the FDEs, an FDE's instructions are compiled into rows
+// the first time an address in it is looked up and kept for every later one
+class CallFrameInfo {
+ public:
+  // The section as mapped from the file, vaddr its link-time address that
+  // pc-relative pointers are resolved against
+  i32 load(std::span<const std::byte> section, u64 vaddr, bool ehFrame);
+
+  // Row covering the link-time address pc, nullptr without CFI there. Valid
+  // until the next lookup
+  const UnwindRow* find(u64 pc);
+  [[nodiscard]] std::span<const std::byte> expression(
+      const CfiRule& rule) const;
+  [[nodiscard]] size_t fdes() const { return m_fdes.size(); }
+
+ private:
+  struct Cie {
+    u64 codeAlign;
+    i64 dataAlign;
+    u32 instructions;  // Offset and size in the section
+    u32 size;
+    u8 encoding;     // Of the FDE addresses
+    bool augmented;  // FDEs carry augmentation data
+    bool signal;
+  };
+  struct Fde {
+    u64 begin;
+    u64 end;
+    u32 instructions;
+    u32 size;
+    u32 cie;  // Index into m_cies
+    u32 firstRow = 0;
+    u32 rows = 0;
+    bool compiled = false;
+  };
+
+  std::span<const std::byte> m_section;
+  u64 m_vaddr = 0;
+  std::vector<Cie> m_cies;
+  std::vector<Fde> m_fdes;        // Sorted by begin
+  std::vector<UnwindRow> m_rows;  // Of every compiled FDE, each in one run
+
+  [[nodiscard]] std::optional<Cie> parseCie(size_t pos) const;
+  void compile(Fde& fde);
+  // Runs one block of instructions, rows are only emitted for an FDE's
+  // instructions, where initial holds the state the CIE left
+  void execute(const Cie& cie, u32 offset, u32 size, UnwindRow& row,
+               const UnwindRow* initial, u64 end);
+};
+
+// Runs the DWARF expression of a CFI rule. push goes onto the stack first,
+// the CFA for EXPRESSION and VAL_EXPRESSION rules. nullopt when it needs an
+// unknown register, memory outside the snapshot or an unsupported operation
+std::optional<u64> evalCfiExpression(std::span<const std::byte> expr,
+                                     const UnwindRegs& regs,
+                                     const StackSnapshot& stack,
+                                     std::optional<u64> push);
+
+#endif  // CAESAR_DWARF_CFI_HPP
@@ -0,0 +1,424 @@
+#include "core_dump.hpp"
+
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/procfs.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <error.hpp>
+#include <format>
+#include <fstream>
+#include <iterator>
+
+namespace {
+constexpr std::string_view NOTE_NAME = "CORE";
+constexpr u32 NOTE_ALIGN = 4;
+
+// Mappings the kernel backs with something process_vm_readv cannot read
+constexpr std::array<std::string_view, 3> UNDUMPABLE = {
+    "[vvar]", "[vvar_vclock]", "[vsyscall]"};
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+u64 alignUp(u64 value, u64 align) {
+  return (value + align - 1) & ~(align - 1);
+}
+
+std::string_view nextField(std::string_view& line) {
+  const size_t start = line.find_first_not_of(' ');
+  if (start == std::string_view::npos) {
+    line = {};
+    return {};
+  }
+  line.remove_prefix(start);
+  const size_t end = std::min(line.find(' '), line.size());
+  const std::string_view field = line.substr(0, end);
+  line.remove_prefix(end);
+  return field;
+}
+
+bool parseHex(std::string_view s, u64& out) {
+  const auto [ptr, ec] =
+      std::from_chars(s.data(), s.data() + s.size(), out, 16);
+  return ec == std::errc{} && ptr == s.data() + s.size() && !s.empty();
+}
+
+bool isZero(std::span<const std::byte> bytes) {
+  // Word at a time without early exits, which the compiler vectorises
+  u64 acc = 0;
+  size_t i = 0;
+  for (; i + sizeof(u64) <= bytes.size(); i += sizeof(u64)) {
+    u64 word = 0;
+    memcpy(&word, bytes.data() + i, sizeof(u64));
+    acc |= word;
+  }
+  for (; i < bytes.size(); i++) acc |= std::to_integer<u64>(bytes[i]);
+  return acc == 0;
+}
+
+std::vector<std::byte> readProcFile(pid_t pid, std::string_view name) {
+  std::ifstream file{std::format("/proc/{}/{}", pid, name), std::ios::binary};
+  const std::string contents{std::istreambuf_iterator<char>{file}, {}};
+  const auto bytes = std::as_bytes(std::span{contents});
+  return {bytes.begin(), bytes.end()};
+}
+
+template <typename T>
+std::span<const std::byte> bytesOf(const T& value) {
+  return std::as_bytes(std::span{&value, 1});
+}
+
+void append(std::vector<std::byte>& out, std::span<const std::byte> bytes) {
+  out.insert(out.end(), bytes.begin(), bytes.end());
+  out.resize(alignUp(out.size(), NOTE_ALIGN));
+}
+
+void appendNote(std::vector<std::byte>& out, u32 type,
+                std::span<const std::byte> desc) {
+  const Elf64_Nhdr header{.n_namesz = NOTE_NAME.size() + 1,
+                          .n_descsz = static_cast<Elf64_Word>(desc.size()),
+                          .n_type = type};
+  append(out, bytesOf(header));
+  // Includes the terminating NUL
+  append(out,
+         std::as_bytes(std::span{NOTE_NAME.data(), NOTE_NAME.size() + 1}));
+  append(out, desc);
+}
+
+i32 writeAll(int fd, std::span<const std::byte> bytes, u64 offset) {
+  while (!bytes.empty()) {
+    const ssize_t n = pwrite(fd, bytes.data(), bytes.size(),
+                             static_cast<off_t>(offset));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return -1;
+    bytes = bytes.subspan(static_cast<size_t>(n));
+    offset += static_cast<u64>(n);
+  }
+  return 0;
+}
+}  // namespace
+
+std::optional<MemoryMapping> parseMapsLine(std::string_view line) {
+  while (!line.empty() && (line.back() == '\n' || line.back() == ' '))
+    line.remove_suffix(1);
+
+  MemoryMapping mapping{};
+  const std::string_view range = nextField(line);
+  const size_t dash = range.find('-');
+  if (dash == std::string_view::npos ||
+      !parseHex(range.substr(0, dash), mapping.start) ||
+      !parseHex(range.substr(dash + 1), mapping.end) ||
+      mapping.end < mapping.start)
+    return std::nullopt;
+
+  const std::string_view perms = nextField(line);
+  if (perms.size() != 4) return std::nullopt;
+  mapping.read = perms[0] == 'r';
+  mapping.write = perms[1] == 'w';
+  mapping.exec = perms[2] == 'x';
+  mapping.shared = perms[3] == 's';
+
+  if (!parseHex(nextField(line), mapping.offset)) return std::nullopt;
+  nextField(line);  // Device
+  if (nextField(line).empty()) return std::nullopt;  // Inode
+
+  // Paths may contain spaces, everything after the inode is the path
+  const size_t path = line.find_first_not_of(' ');
+  if (path != std::string_view::npos) mapping.path = line.substr(path);
+  return mapping;
+}
+
+std::vector<MemoryMapping> readMappings(pid_t pid) {
+  std::ifstream maps{std::format("/proc/{}/maps", pid)};
+  std::vector<MemoryMapping> mappings{};
+  std::string line{};
+  while (std::getline(maps, line))
+    if (auto mapping = parseMapsLine(line)) mappings.push_back(*mapping);
+  return mappings;
+}
+
+std::vector<std::pair<size_t, size_t>> nonZeroRuns(
+    std::span<const std::byte> buf, size_t pageSize) {
+  std::vector<std::pair<size_t, size_t>> runs{};
+  for (size_t off = 0; off < buf.size(); off += pageSize) {
+    const size_t len = std::min(pageSize, buf.size() - off);
+    if (isZero(buf.subspan(off, len))) continue;
+    if (!runs.empty() && runs.back().first + runs.back().second == off)
+      runs.back().second += len;
+    else
+      runs.emplace_back(off, len);
+  }
+  return runs;
+}
+
+u64 CoreDump::dumpedSize(const MemoryMapping& mapping) const {
+  if (!mapping.read || std::ranges::find(UNDUMPABLE, mapping.path) !=
+                           UNDUMPABLE.end())
+    return 0;
+  if (m_reference_files && mapping.fileBacked() && !mapping.write) {
+    // The first page keeps the ELF header, debuggers find the build id there
+    return mapping.offset == 0 ? std::min<u64>(PAGE, mapping.size()) : 0;
+  }
+  return mapping.size();
+}
+
+std::vector<std::byte> CoreDump::buildNotes(
+    const std::vector<MemoryMapping>& mappings) const {
+  std::vector<std::byte> notes{};
+
+  prpsinfo_t psinfo{};
+  psinfo.pr_sname = 't';
+  psinfo.pr_pid = m_pid;
+  const auto comm = readProcFile(m_pid, "comm");
+  memcpy(psinfo.pr_fname, comm.data(),
+         std::min(comm.empty() ? 0 : comm.size() - 1,
+                  sizeof(psinfo.pr_fname) - 1));
+  auto cmdline = readProcFile(m_pid, "cmdline");
+  cmdline.resize(std::min(cmdline.size(), sizeof(psinfo.pr_psargs) - 1));
+  std::ranges::replace(cmdline, std::byte{0}, std::byte{' '});
+  memcpy(psinfo.pr_psargs, cmdline.data(), cmdline.size());
+
+  // NT_FILE, a count and the page size, a start, end and page offset for
+  // every file mapping, then their paths
+  std::vector<u64> ranges{0, PAGE};
+  std::string paths{};
+  for (const auto& mapping : mappings) {
+    if (!mapping.fileBacked()) continue;
+    ranges[0]++;
+    ranges.insert(ranges.end(),
+                  {mapping.start, mapping.end, mapping.offset / PAGE});
+    paths += mapping.path;
+    paths += '\0';
+  }
+  std::vector<std::byte> files{};
+  append(files, std::as_bytes(std::span{ranges}));
+  append(files, std::as_bytes(std::span{paths}));
+
+  // Same order as the kernel, the process wide notes follow the first
+  // thread's NT_PRSTATUS and each thread's NT_PRFPREG comes after its state
+  for (size_t i = 0; i < m_threads.size(); i++) {
+    const CoreThread& thread = m_threads[i];
+    prstatus_t status{};
+    status.pr_info.si_signo = thread.signal;
+    status.pr_cursig = static_cast<short>(thread.signal);
+    status.pr_pid = thread.tid;
+    static_assert(sizeof(status.pr_reg) == sizeof(thread.regs));
+    memcpy(&status.pr_reg, &thread.regs, sizeof(thread.regs));
+    status.pr_fpvalid = 1;
+    appendNote(notes, NT_PRSTATUS, bytesOf(status));
+
+    if (i == 0) {
+      appendNote(notes, NT_PRPSINFO, bytesOf(psinfo));
+      appendNote(notes, NT_AUXV, readProcFile(m_pid, "auxv"));
+      appendNote(notes, NT_FILE, files);
+    }
+    appendNote(notes, NT_PRFPREG, bytesOf(thread.fp_regs));
+  }
+  return notes;
+}
+
+i32 CoreDump::write(const std::string& path) {
+  const auto start = Clock::now();
+  m_stats = {};
+
+  const std::vector<MemoryMapping> mappings = readMappings(m_pid);
+  if (mappings.empty()) {
+    CoreError::error(std::format("Could not read /proc/{}/maps", m_pid));
+    return -1;
+  }
+  if (mappings.size() + 1 >= PN_XNUM) {
+    CoreError::error(std::format("{} mappings are too many for a core file",
+                                 mappings.size()));
+    return -1;
+  }
+  const std::vector<std::byte> notes = buildNotes(mappings);
+
+  const size_t phnum = mappings.size() + 1;
+  const u64 notesOffset = sizeof(Elf64_Ehdr) + (phnum * sizeof(Elf64_Phdr));
+  u64 offset = alignUp(notesOffset + notes.size(), PAGE);
+
+  std::vector<Elf64_Phdr> phdrs{};
+  phdrs.reserve(phnum);
+  phdrs.push_back({.p_type = PT_NOTE,
+                   .p_offset = notesOffset,
+                   .p_filesz = notes.size(),
+                   .p_align = NOTE_ALIGN});
+  for (const auto& mapping : mappings) {
+    const u64 dumped = dumpedSize(mapping);
+    phdrs.push_back({.p_type = PT_LOAD,
+                     .p_flags = (mapping.read ? PF_R : 0U) |
+                                (mapping.write ? PF_W : 0U) |
+                                (mapping.exec ? PF_X : 0U),
+                     .p_offset = offset,
+                     .p_vaddr = mapping.start,
+                     .p_filesz = dumped,
+                     .p_memsz = mapping.size(),
+                     .p_align = PAGE});
+    m_stats.mapped += mapping.size();
+    if (m_reference_files && mapping.fileBacked() && !mapping.write)
+      m_stats.referenced += mapping.size() - dumped;
+    offset += dumped;
+  }
+
+  m_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (m_fd < 0) {
+    CoreError::error(
+        std::format("Could not open {}: {}", path, strerror(errno)));
+    return -1;
+  }
+
+  m_buf.resize(BATCH_BYTES);
+  i32 res = 0;
+  for (size_t i = 0; i < mappings.size() && res == 0; i++) {
+    const Elf64_Phdr& phdr = phdrs[i + 1];
+    res = queue(phdr.p_vaddr, phdr.p_filesz, phdr.p_offset);
+  }
+  if (res == 0) res = flush();
+  m_stats.pause_ms = msSince(start);
+
+  Elf64_Ehdr header{};
+  memcpy(header.e_ident, ELFMAG, SELFMAG);
+  header.e_ident[EI_CLASS] = ELFCLASS64;
+  header.e_ident[EI_DATA] = ELFDATA2LSB;
+  header.e_ident[EI_VERSION] = EV_CURRENT;
+  header.e_ident[EI_OSABI] = ELFOSABI_NONE;
+  header.e_type = ET_CORE;
+  header.e_machine = EM_X86_64;
+  header.e_version = EV_CURRENT;
+  header.e_phoff = sizeof(Elf64_Ehdr);
+  header.e_ehsize = sizeof(Elf64_Ehdr);
+  header.e_phentsize = sizeof(Elf64_Phdr);
+  header.e_phnum = static_cast<Elf64_Half>(phnum);
+
+  if (res == 0 &&
+      (writeAll(m_fd, bytesOf(header), 0) != 0 ||
+       writeAll(m_fd, std::as_bytes(std::span{phdrs}), header.e_phoff) != 0 ||
+       writeAll(m_fd, notes, notesOffset) != 0 ||
+       // Trailing holes only exist once the file is extended past them
+       ftruncate(m_fd, static_cast<off_t>(offset)) != 0)) {
+    CoreError::error(
+        std::format("Could not write {}: {}", path, strerror(errno)));
+    res = -1;
+  }
+
+  close(m_fd);
+  m_fd = -1;
+  m_buf = {};
+  m_stats.total_ms = msSince(start);
+  return res;
+}
+
+i32 CoreDump::queue(u64 addr, u64 len, u64 fileOffset) {
+  while (len > 0) {
+    if (m_filled == m_buf.size() || m_pieces.size() == IOV_MAX) {
+      if (flush() != 0) return -1;
+    }
+    const size_t take = std::min<u64>(len, m_buf.size() - m_filled);
+    m_pieces.push_back({.addr = addr,
+                        .len = take,
+                        .file_offset = fileOffset,
+                        .buf_offset = m_filled});
+    m_filled += take;
+    addr += take;
+    fileOffset += take;
+    len -= take;
+  }
+  return 0;
+}
+
+i32 CoreDump::flush() {
+  if (m_pieces.empty()) return 0;
+  if (readPieces() != 0) return -1;
+
+  for (const Piece& piece : m_pieces) {
+    const std::span<std::byte> bytes{m_buf.data() + piece.buf_offset,
+                                     piece.len};
+    for (const auto& [addr, orig] : m_patches)
+      if (addr >= piece.addr && addr < piece.addr + piece.len)
+        bytes[addr - piece.addr] = orig;
+
+    for (const auto& [off, len] : nonZeroRuns(bytes, PAGE)) {
+      if (writeAll(m_fd, bytes.subspan(off, len), piece.file_offset + off) !=
+          0) {
+        CoreError::error(
+            std::format("Could not write core: {}", strerror(errno)));
+        return -1;
+      }
+      m_stats.written += len;
+    }
+    m_stats.read += piece.len;
+  }
+
+  m_pieces.clear();
+  m_filled = 0;
+  return 0;
+}
+
+i32 CoreDump::readPieces() {
+  std::vector<iovec> local{};
+  std::vector<iovec> remote{};
+  size_t first = 0;  // Piece the next read starts in
+  size_t done = 0;   // Bytes of it already read or given up on
+
+  while (first < m_pieces.size()) {
+    local.clear();
+    remote.clear();
+    size_t expected = 0;
+    for (size_t i = first; i < m_pieces.size(); i++) {
+      const Piece& piece = m_pieces[i];
+      const size_t skip = i == first ? done : 0;
+      local.push_back({.iov_base = m_buf.data() + piece.buf_offset + skip,
+                       .iov_len = piece.len - skip});
+      remote.push_back({.iov_base = std::bit_cast<void*>(piece.addr + skip),
+                        .iov_len = piece.len - skip});
+      expected += piece.len - skip;
+    }
+
+    const ssize_t n = process_vm_readv(m_pid, local.data(), local.size(),
+                                       remote.data(), remote.size(), 0);
+    if (n < 0 && errno != EFAULT) {
+      CoreError::error(std::format("process_vm_readv failed: {}",
+                                   strerror(errno)));
+      return -1;
+    }
+    if (static_cast<size_t>(std::max<ssize_t>(n, 0)) == expected) return 0;
+
+    // A short read stops at the first page that could not be read
+    for (size_t got = std::max<ssize_t>(n, 0); got > 0;) {
+      const size_t left = m_pieces[first].len - done;
+      const size_t take = std::min(got, left);
+      done += take;
+      got -= take;
+      if (done == m_pieces[first].len) {
+        first++;
+        done = 0;
+      }
+    }
+    if (first == m_pieces.size()) return 0;
+
+    // Leave that page as a hole and carry on after it
+    const Piece& piece = m_pieces[first];
+    const size_t hole =
+        std::min(PAGE - ((piece.addr + done) % PAGE), piece.len - done);
+    std::fill_n(m_buf.data() + piece.buf_offset + done, hole, std::byte{0});
+    done += hole;
+    if (done == piece.len) {
+      first++;
+      done = 0;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,98 @@
+#ifndef CAESAR_CORE_DUMP_HPP
+#define CAESAR_CORE_DUMP_HPP
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "core/elf/types.hpp"
+#include "core/target.hpp"
+#include "typedefs.hpp"
+
+// One line of /proc/pid/maps
+struct MemoryMapping {
+  u64 start;
+  u64 end;
+  u64 offset;  // Into the backing file
+  bool read;
+  bool write;
+  bool exec;
+  bool shared;
+  std::string path;  // Empty when anonymous, [heap], [stack] and such
+
+  [[nodiscard]] u64 size() const { return end - start; }
+  [[nodiscard]] bool fileBacked() const { return path.starts_with('/'); }
+};
+
+// nullopt for lines that do not look like a mapping
+std::optional<MemoryMapping> parseMapsLine(std::string_view line);
+std::vector<MemoryMapping> readMappings(pid_t pid);
+
+// Offset and length of every run of pages in buf that are not all zero
+std::vector<std::pair<size_t, size_t>> nonZeroRuns(
+    std::span<const std::byte> buf, size_t pageSize);
+
+struct CoreThread {
+  pid_t tid;
+  int signal;
+  LinuxX86ThreadState64T regs;
+  X86FloatState64T fp_regs;
+};
+
+// Writes an ELF core of a stopped process. Registers come from the debugger
+// since it may hold changes not written back yet, memory is streamed from
+// the process in large process_vm_readv batches. Zero and unreadable pages
+// are left as holes in a sparse file
+class CoreDump {
+ public:
+  static constexpr size_t PAGE = 4096;
+  static constexpr size_t BATCH_BYTES = 8UL << 20;
+
+  CoreDump(pid_t pid, bool referenceFiles)
+      : m_pid(pid), m_reference_files(referenceFiles) {}
+
+  // The first thread added is the one debuggers show as current
+  void addThread(const CoreThread& thread) { m_threads.push_back(thread); }
+  // Byte to write instead of what memory holds, for breakpoint traps
+  void addPatch(u64 addr, std::byte orig) {
+    m_patches.emplace_back(addr, orig);
+  }
+  i32 write(const std::string& path);
+  [[nodiscard]] const CoreDumpStats& stats() const { return m_stats; }
+
+ private:
+  // Part of a PT_LOAD segment still to be read
+  struct Piece {
+    u64 addr;
+    size_t len;
+    u64 file_offset;
+    size_t buf_offset;
+  };
+
+  pid_t m_pid;
+  bool m_reference_files;
+  int m_fd = -1;
+  std::vector<CoreThread> m_threads;
+  std::vector<std::pair<u64, std::byte>> m_patches;
+  std::vector<std::byte> m_buf;
+  std::vector<Piece> m_pieces;
+  size_t m_filled = 0;
+  CoreDumpStats m_stats{};
+
+  // Bytes of a mapping copied into the core, the rest is only described
+  [[nodiscard]] u64 dumpedSize(const MemoryMapping& mapping) const;
+  std::vector<std::byte> buildNotes(
+      const std::vector<MemoryMapping>& mappings) const;
+  i32 queue(u64 addr, u64 len, u64 fileOffset);
+  i32 flush();
+  // Reads every queued piece, pages that cannot be read are zeroed
+  i32 readPieces();
+};
+
+#endif  // CAESAR_CORE_DUMP_HPP
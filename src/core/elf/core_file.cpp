@@ -0,0 +1,376 @@
+#include "core_file.hpp"
+
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/procfs.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <error.hpp>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <string_view>
+#include <utility>
+
+#include "elf.hpp"
+
+namespace {
+constexpr std::string_view NOTE_NAME = "CORE";
+constexpr u64 NOTE_ALIGN = 4;
+
+u64 alignUp(u64 value, u64 align) {
+  return (value + align - 1) & ~(align - 1);
+}
+
+template <typename T>
+bool readStruct(std::span<const std::byte> bytes, u64 offset, T& out) {
+  if (offset > bytes.size() || bytes.size() - offset < sizeof(T))
+    return false;
+  memcpy(&out, bytes.data() + offset, sizeof(T));
+  return true;
+}
+
+bool sameFile(const std::string& lhs, const std::string& rhs) {
+  std::error_code ec{};
+  if (std::filesystem::equivalent(lhs, rhs, ec)) return true;
+  // The core may come from another machine or a since moved binary
+  return std::filesystem::path(lhs).filename() ==
+         std::filesystem::path(rhs).filename();
+}
+}  // namespace
+
+MappedFile::~MappedFile() {
+  if (!m_bytes.empty())
+    munmap(const_cast<std::byte*>(m_bytes.data()), m_bytes.size());
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_bytes(std::exchange(other.m_bytes, {})) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  std::swap(m_bytes, other.m_bytes);
+  return *this;
+}
+
+i32 MappedFile::open(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return -1;
+
+  struct stat st {};
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    return -1;
+  }
+  const auto size = static_cast<size_t>(st.st_size);
+  void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) return -1;
+
+  *this = MappedFile{};
+  m_bytes = {static_cast<const std::byte*>(addr), size};
+  return 0;
+}
+
+CoreFile::CoreFile(std::ifstream f, std::string filePath)
+    : Target(std::move(f), std::move(filePath)) {
+  is64();
+}
+
+i32 CoreFile::load(const std::string& corePath) {
+  if (m_core.open(corePath) != 0) {
+    CoreError::error(
+        std::format("Could not map {}: {}", corePath, strerror(errno)));
+    return -1;
+  }
+
+  const auto core = m_core.bytes();
+  Elf64_Ehdr header{};
+  if (!readStruct(core, 0, header) ||
+      memcmp(header.e_ident, ELFMAG, SELFMAG) != 0 ||
+      header.e_ident[EI_CLASS] != ELFCLASS64 || header.e_type != ET_CORE) {
+    CoreError::error(std::format("{} is not an ELF64 core file", corePath));
+    return -1;
+  }
+
+  for (u32 i = 0; i < header.e_phnum; i++) {
+    Elf64_Phdr phdr{};
+    if (!readStruct(core, header.e_phoff + (u64{i} * header.e_phentsize),
+                    phdr)) {
+      CoreError::error(std::format("{} is truncated", corePath));
+      return -1;
+    }
+
+    // A truncated core still serves whatever it has
+    const u64 available =
+        phdr.p_offset < core.size() ? core.size() - phdr.p_offset : 0;
+    const auto data = core.subspan(std::min<u64>(phdr.p_offset, core.size()),
+                                   std::min(phdr.p_filesz, available));
+    if (phdr.p_type == PT_LOAD) {
+      m_segments.push_back({.vaddr = phdr.p_vaddr,
+                            .memsz = phdr.p_memsz,
+                            .filesz = data.size(),
+                            .data = data});
+    } else if (phdr.p_type == PT_NOTE && parseNotes(data) != 0) {
+      return -1;
+    }
+  }
+  std::ranges::sort(m_segments, {}, &Segment::vaddr);
+
+  if (m_threads.empty()) {
+    CoreError::error(std::format("{} has no thread state", corePath));
+    return -1;
+  }
+  mapFiles();
+
+  m_started = true;
+  setTargetState(TargetState::STOPPED);
+  return 0;
+}
+
+i32 CoreFile::parseNotes(std::span<const std::byte> notes) {
+  ThreadInfo* last = nullptr;
+  u64 offset = 0;
+  Elf64_Nhdr note{};
+  while (readStruct(notes, offset, note)) {
+    const u64 nameOffset = offset + sizeof(note);
+    const u64 descOffset = nameOffset + alignUp(note.n_namesz, NOTE_ALIGN);
+    offset = descOffset + alignUp(note.n_descsz, NOTE_ALIGN);
+    if (offset > notes.size()) break;
+
+    const auto name = std::string_view{
+        std::bit_cast<const char*>(notes.data() + nameOffset),
+        note.n_namesz > 0 ? note.n_namesz - 1 : 0};
+    if (name != NOTE_NAME) continue;
+    const auto desc = notes.subspan(descOffset, note.n_descsz);
+
+    if (note.n_type == NT_PRSTATUS) {
+      prstatus_t status{};
+      if (!readStruct(desc, 0, status)) continue;
+      static_assert(sizeof(status.pr_reg) == sizeof(ThreadState));
+
+      // The kernel writes the thread that crashed first
+      if (m_threads.empty()) m_pid = status.pr_pid;
+      last = &m_threads.add(status.pr_pid);
+      memcpy(&last->regs, &status.pr_reg, sizeof(ThreadState));
+      last->valid |= groupBit(RegGroup::GPR);
+      const std::string reason =
+          status.pr_cursig == 0
+              ? "no signal\n"
+              : Elf::stopReason(W_STOPCODE(status.pr_cursig));
+      last->stop_reason = reason.substr(0, reason.size() - 1);
+      if (m_threads.size() == 1) m_threads.select(status.pr_pid);
+    } else if (note.n_type == NT_PRFPREG && last != nullptr) {
+      if (!readStruct(desc, 0, last->fp_regs)) continue;
+      last->valid |= groupBit(RegGroup::FP);
+    } else if (note.n_type == NT_PRPSINFO) {
+      prpsinfo_t info{};
+      if (readStruct(desc, 0, info)) m_pid = info.pr_pid;
+    } else if (note.n_type == NT_AUXV) {
+      Elf64_Ehdr binary{};
+      m_file.seekg(0, std::ios::beg);
+      m_file.read(std::bit_cast<char*>(&binary), sizeof(binary));
+      for (u64 i = 0; i + sizeof(Elf64_auxv_t) <= desc.size();
+           i += sizeof(Elf64_auxv_t)) {
+        Elf64_auxv_t entry{};
+        readStruct(desc, i, entry);
+        if (entry.a_type != AT_ENTRY) continue;
+        m_aslr_slide = entry.a_un.a_val - binary.e_entry;
+        break;
+      }
+    } else if (note.n_type == NT_FILE) {
+      parseFileNote(desc);
+    }
+  }
+  return 0;
+}
+
+void CoreFile::parseFileNote(std::span<const std::byte> desc) {
+  // A count and the page size, a start, end and page offset per mapping,
+  // then as many NUL terminated paths
+  u64 count = 0;
+  u64 pageSize = 0;
+  if (!readStruct(desc, 0, count) ||
+      !readStruct(desc, sizeof(u64), pageSize))
+    return;
+
+  const u64 pathsOffset = (2 + (count * 3)) * sizeof(u64);
+  if (pathsOffset > desc.size()) return;
+  std::string_view paths{std::bit_cast<const char*>(desc.data()) + pathsOffset,
+                         desc.size() - pathsOffset};
+
+  for (u64 i = 0; i < count && !paths.empty(); i++) {
+    std::array<u64, 3> range{};
+    readStruct(desc, (2 + (i * 3)) * sizeof(u64), range);
+    const size_t end = std::min(paths.find('\0'), paths.size());
+    m_file_ranges.push_back({.start = range[0],
+                             .end = range[1],
+                             .offset = range[2] * pageSize,
+                             .path = std::string{paths.substr(0, end)}});
+    paths.remove_prefix(std::min(end + 1, paths.size()));
+  }
+}
+
+void CoreFile::mapFiles() {
+  for (const auto& range : m_file_ranges) {
+    if (m_mapped_files.contains(range.path)) continue;
+
+    MappedFile file{};
+    const std::string& source =
+        sameFile(range.path, m_file_path) ? m_file_path : range.path;
+    // Files that are gone leave their ranges unreadable unless the core
+    // has a copy
+    if (file.open(source) == 0)
+      m_mapped_files.emplace(range.path, std::move(file));
+  }
+}
+
+std::span<const std::byte> CoreFile::viewAt(u64 addr, bool& omitted) const {
+  omitted = false;
+  u64 limit = UINT64_MAX;
+
+  auto it = std::ranges::upper_bound(m_segments, addr, {}, &Segment::vaddr);
+  if (it != m_segments.begin()) {
+    const Segment& segment = *std::prev(it);
+    const u64 offset = addr - segment.vaddr;
+    if (offset < segment.filesz) return segment.data.subspan(offset);
+    if (offset < segment.memsz) {
+      omitted = true;
+      limit = segment.memsz - offset;
+    }
+  }
+
+  for (const auto& range : m_file_ranges) {
+    if (addr < range.start || addr >= range.end) continue;
+    auto file = m_mapped_files.find(range.path);
+    if (file == m_mapped_files.end()) return {};
+
+    const auto bytes = file->second.bytes();
+    const u64 offset = range.offset + (addr - range.start);
+    if (offset >= bytes.size()) return {};
+    return bytes.subspan(
+        offset, std::min({limit, range.end - addr, bytes.size() - offset}));
+  }
+  return {};
+}
+
+std::span<const std::byte> CoreFile::memoryView(u64 addr, size_t len) const {
+  bool omitted = false;
+  const auto view = viewAt(addr, omitted);
+  if (view.size() < len) return {};
+  return view.first(len);
+}
+
+i32 CoreFile::readMemory(u64 addr, std::span<std::byte> out) {
+  while (!out.empty()) {
+    bool omitted = false;
+    const auto view = viewAt(addr, omitted);
+    if (view.empty()) {
+      CoreError::error(std::format("Memory at {} is {}",
+                                   detail::toHex(addr),
+                                   omitted ? "not included in the core"
+                                           : "not mapped in the core"));
+      return -1;
+    }
+
+    const size_t len = std::min(view.size(), out.size());
+    memcpy(out.data(), view.data(), len);
+    out = out.subspan(len);
+    addr += len;
+  }
+  return 0;
+}
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+i32 CoreFile::writeMemory(u64 addr, std::span<const std::byte> in) {
+#pragma unused(addr, in)
+  CoreError::error("Core files are read-only");
+  return -1;
+}
+
+void CoreFile::dumpHeader(int offset) {
+#pragma unused(offset)
+  for (const auto& segment : m_segments) {
+    std::cout << std::format(
+                     "type: 0x{:<10x} vaddr: 0x{:<18x} filesz: 0x{:<12x} "
+                     "memsz: 0x{:x}",
+                     PT_LOAD, segment.vaddr, segment.filesz, segment.memsz)
+              << '\n';
+  }
+}
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+i32 CoreFile::attach() {
+  CoreError::error("A core file cannot be attached to");
+  return -1;
+}
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+i32 CoreFile::launch(detail::CStringArray& argList) {
+#pragma unused(argList)
+  CoreError::error("A core file cannot be run");
+  return -1;
+}
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+i32 CoreFile::detach() {
+  CoreError::error("A core file cannot be detached from");
+  return -1;
+}
+
+void CoreFile::resume(ResumeType cond) {
+#pragma unused(cond)
+  CoreError::error("A core file cannot be resumed");
+}
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+i32 CoreFile::resumeThread(i32 tid) {
+#pragma unused(tid)
+  CoreError::error("A core file cannot be resumed");
+  return -1;
+}
+
+i32 CoreFile::setBreakpoint(u64 addr) { return setBreakpoints({&addr, 1}); }
+
+i32 CoreFile::setBreakpoints(std::span<const u64> addrs) {
+  // Recorded like on a live target so listings and later commands see them,
+  // but never armed
+  for (const u64 addr : addrs) {
+    if (m_breakpoints.contains(addr)) continue;
+
+    Breakpoint bp{.orig_ins = 0, .enabled = false};
+    if (readMemory(addr + m_aslr_slide,
+                   std::as_writable_bytes(std::span{&bp.orig_ins, 1})
+                       .first(trapIns.size())) != 0)
+      return -1;
+    m_breakpoints.insert(addr, bp);
+  }
+  return 0;
+}
+
+i32 CoreFile::disableBreakpoint(u64 addr, bool remove) {
+  return disableBreakpoints({&addr, 1}, remove) == 0 ? 0 : 1;
+}
+
+void CoreFile::setThreadState(ThreadState* state) {
+  ThreadInfo* thread = m_threads.selected();
+  if (thread == nullptr) return;
+  memcpy(&thread->regs, state, sizeof(ThreadState));
+}
+
+ThreadState& CoreFile::getLastKnownThreadState() {
+  ThreadInfo* thread = m_threads.selected();
+  return thread != nullptr ? thread->regs : m_no_thread;
+}
+
+std::span<std::byte> CoreFile::registerGroup(RegGroup group) {
+  ThreadInfo* thread = m_threads.selected();
+  if (thread == nullptr || !thread->has(group)) return {};
+  return thread->group(group);
+}
@@ -0,0 +1,102 @@
+#ifndef CAESAR_CORE_FILE_HPP
+#define CAESAR_CORE_FILE_HPP
+
+#include <cstddef>
+#include <fstream>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/target.hpp"
+#include "typedefs.hpp"
+
+// Read-only mmap of a whole file, unmapped on destruction
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  i32 open(const std::string& path);
+  [[nodiscard]] std::span<const std::byte> bytes() const { return m_bytes; }
+
+ private:
+  std::span<const std::byte> m_bytes;
+};
+
+// Post-mortem target over an ELF core. The core is mapped once and memory
+// reads are served straight from its PT_LOAD segments, parts the core leaves
+// out are read from the mapped files NT_FILE names, the binary given on the
+// command line standing in for the one the core was taken of. Nothing ever
+// runs, breakpoints can be set but stay disabled
+class CoreFile final : public Target {
+ public:
+  explicit CoreFile(std::ifstream f, std::string filePath);
+
+  // Maps and parses the core, the target counts as started and stopped
+  // afterwards
+  i32 load(const std::string& corePath);
+
+  void dumpHeader(int offset) override;
+  i32 attach() override;
+  i32 setBreakpoint(u64 addr) override;
+  i32 setBreakpoints(std::span<const u64> addrs) override;
+  i32 disableBreakpoint(u64 addr, bool remove) override;
+  i32 launch(detail::CStringArray& argList) override;
+  i32 detach() override;
+  void eventLoop() override {}
+  void startEventLoop() override {}
+  void resume(ResumeType cond) override;
+  i32 resumeThread(i32 tid) override;
+  void setThreadState(ThreadState* state) override;
+  ThreadState& getLastKnownThreadState() override;
+  // Register writes only change the debugger's copy
+  std::span<std::byte> registerGroup(RegGroup group) override;
+  i32 readMemory(u64 addr, std::span<std::byte> out) override;
+  i32 writeMemory(u64 addr, std::span<const std::byte> in) override;
+
+  // Zero-copy view of [addr, addr + len), empty unless all of it lies in one
+  // segment or one mapped file
+  [[nodiscard]] std::span<const std::byte> memoryView(u64 addr,
+                                                      size_t len) const;
+  [[nodiscard]] u64 getAslrSlide() const { return m_aslr_slide; }
+
+ private:
+  struct Segment {
+    u64 vaddr;
+    u64 memsz;
+    u64 filesz;
+    std::span<const std::byte> data;  // filesz bytes of the core
+  };
+  // File mapping from NT_FILE
+  struct FileRange {
+    u64 start;
+    u64 end;
+    u64 offset;
+    std::string path;
+  };
+
+  MappedFile m_core;
+  std::vector<Segment> m_segments;  // Sorted by vaddr
+  std::vector<FileRange> m_file_ranges;
+  // Files named by NT_FILE that could be opened, keyed by that path
+  std::unordered_map<std::string, MappedFile> m_mapped_files;
+  ThreadState m_no_thread{};
+
+  void readMagic() override {}
+  void is64() override { m_is_64 = true; }
+
+  i32 parseNotes(std::span<const std::byte> notes);
+  void parseFileNote(std::span<const std::byte> desc);
+  void mapFiles();
+  // Longest view starting at addr, empty if the core has nothing there.
+  // Sets omitted when addr is in a segment but left out of the core
+  [[nodiscard]] std::span<const std::byte> viewAt(u64 addr,
+                                                  bool& omitted) const;
+};
+
+#endif  // CAESAR_CORE_FILE_HPP
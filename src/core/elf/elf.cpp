@@ -0,0 +1,1891 @@
+#include "elf.hpp"
+
+#include <dirent.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <linux/seccomp.h>
+#include <sys/auxv.h>
+#include <sys/prctl.h>
+#include <sys/ptrace.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/user.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <climits>
+
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstring>
+#include <error.hpp>
+#include <iostream>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "core/reactor.hpp"
+#include "core/unwind.hpp"
+#include "core_dump.hpp"
+#include "perf_sampler.hpp"
+#include "platform.hpp"
+#include "symbols.hpp"
+#include "target.hpp"
+
+namespace {
+// Length of an instruction that behaves the same at any address, 0 for
+// branches, anything that may be rip-relative and whatever is not decoded
+// here. Covers the usual function entry instructions
+size_t displacedLength(std::span<const std::byte> ins) {
+  const auto at = [&ins](size_t i) { return std::to_integer<u8>(ins[i]); };
+  // endbr64
+  if (at(0) == 0xF3 && at(1) == 0x0F && at(2) == 0x1E && at(3) == 0xFA)
+    return 4;
+
+  const bool rex = (at(0) & 0xF0) == 0x40;
+  const bool rexW = rex && (at(0) & 0x08) != 0;
+  const size_t i = rex ? 1 : 0;
+  const u8 op = at(i);
+  // Only register to register forms, a memory operand may be rip-relative
+  const bool regForm = (at(i + 1) & 0xC0) == 0xC0;
+
+  if (op >= 0x50 && op <= 0x5F) return i + 1;  // push, pop
+  if (op == 0x90) return i + 1;                // nop
+  if (op >= 0xB8 && op <= 0xBF) return i + 1 + (rexW ? 8 : 4);  // mov imm
+
+  switch (op) {
+    case 0x01:  // add
+    case 0x03:
+    case 0x09:  // or
+    case 0x0B:
+    case 0x21:  // and
+    case 0x23:
+    case 0x29:  // sub
+    case 0x2B:
+    case 0x31:  // xor
+    case 0x33:
+    case 0x39:  // cmp
+    case 0x3B:
+    case 0x85:  // test
+    case 0x89:  // mov
+    case 0x8B:
+      return regForm ? i + 2 : 0;
+    case 0x83:  // Group 1 with imm8
+      return regForm ? i + 3 : 0;
+    case 0x81:  // Group 1 with imm32
+    case 0xC7:  // mov imm32
+      return regForm ? i + 6 : 0;
+    default:
+      return 0;
+  }
+}
+
+static_assert(sizeof(ThreadState) == sizeof(user_regs_struct));
+static_assert(sizeof(FloatState) == sizeof(user_fpregs_struct));
+
+void* regsetNote(RegGroup group) {
+  return std::bit_cast<void*>(
+      static_cast<uintptr_t>(group == RegGroup::FP ? NT_PRFPREG : NT_PRSTATUS));
+}
+
+// Straight from the kernel, bypassing the thread table's cache
+i32 readGprs(pid_t tid, ThreadState& regs) {
+  iovec iov{.iov_base = &regs, .iov_len = sizeof(regs)};
+  return ptrace(PTRACE_GETREGSET, tid, regsetNote(RegGroup::GPR), &iov) == 0
+             ? 0
+             : -1;
+}
+
+void* debugRegOffset(size_t reg) {
+  return std::bit_cast<void*>(offsetof(user, u_debugreg) +
+                              (reg * sizeof(user::u_debugreg[0])));
+}
+
+// DWARF numbering, see UnwindRegs
+UnwindRegs unwindRegs(const ThreadState& regs) {
+  UnwindRegs out{};
+  const std::array<u64, UnwindRegs::COUNT> values{
+      regs.rax, regs.rdx, regs.rcx, regs.rbx, regs.rsi, regs.rdi,
+      regs.rbp, regs.rsp, regs.r8,  regs.r9,  regs.r10, regs.r11,
+      regs.r12, regs.r13, regs.r14, regs.r15, regs.rip};
+  for (size_t i = 0; i < values.size(); i++) out.set(i, values[i]);
+  return out;
+}
+
+// Threads of pid as listed in /proc, empty if it cannot be read
+std::vector<pid_t> listThreads(pid_t pid) {
+  std::vector<pid_t> tids{};
+  DIR* dir = opendir(std::format("/proc/{}/task", pid).c_str());
+  if (dir == nullptr) return tids;
+  while (const dirent* entry = readdir(dir)) {
+    const std::string_view name{entry->d_name};
+    pid_t tid = 0;
+    if (std::from_chars(name.data(), name.data() + name.size(), tid).ec ==
+        std::errc{})
+      tids.push_back(tid);
+  }
+  closedir(dir);
+  return tids;
+}
+
+std::string signalName(int sig) {
+  const char* abbrev = sigabbrev_np(sig);
+  if (abbrev == nullptr) return std::format("signal {}", sig);
+  return std::format("SIG{}", abbrev);
+}
+}  // namespace
+
+void Elf::readMagic() {
+  m_file.seekg(0, std::ios::beg);
+  m_file.read(std::bit_cast<char*>(m_ident.data()), EI_NIDENT);
+}
+
+void Elf::is64() {
+  if (m_ident[EI_CLASS] == ELFCLASS64) m_is_64 = true;
+}
+
+Elf::Elf(std::ifstream f, std::string filePath)
+    : Target(std::move(f), std::move(filePath)) {
+  readMagic();
+  is64();
+  if (m_is_64) m_entry = loadBytes<Elf64_Ehdr>(0).e_entry;
+  // Stops of a target running in the background are handled right here
+  m_child_fd = Reactor::getInstance().addSignal(SIGCHLD, [this] {
+    if (m_state == TargetState::RUNNING) drainEvents();
+  });
+  // Printed here rather than by the tracer thread, std::cout keeps the
+  // prompt intact
+  m_trace_fd = Reactor::getInstance().addWakeup(
+      [this] { std::cout << m_tracer.takeStdout() << std::flush; });
+  if (m_trace_fd >= 0)
+    m_tracer.setStdoutNotify([fd = m_trace_fd] { Reactor::wake(fd); });
+}
+
+Elf::~Elf() {
+  if (m_attached && m_state != TargetState::RUNNING) detach();
+  if (m_mem_fd >= 0) close(m_mem_fd);
+  m_tracer.stop();
+  m_tracer.setStdoutNotify(nullptr);
+  std::cout << m_tracer.takeStdout() << std::flush;
+  Reactor::getInstance().remove(m_trace_fd);
+  Reactor::getInstance().remove(m_exit_fd);
+  Reactor::getInstance().remove(m_child_fd);
+  for (const auto& cp : m_checkpoints) {
+    kill(cp.pid, SIGKILL);
+    waitpid(cp.pid, nullptr, __WALL);
+  }
+}
+
+void Elf::dumpHeader(int offset) {
+  if (!m_is_64) {
+    CoreError::error("Only ELF64 headers are supported!");
+    return;
+  }
+
+  const auto header = loadBytes<Elf64_Ehdr>(offset);
+  dumpProgramHeaders(header);
+  dumpSections(header);
+}
+
+void Elf::dumpProgramHeaders(const Elf64_Ehdr& header) {
+  for (u32 i = 0; i < header.e_phnum; i++) {
+    const auto phdr = loadBytes<Elf64_Phdr>(header.e_phoff +
+                                            (u64{i} * header.e_phentsize));
+    std::cout << std::format(
+                     "type: 0x{:<10x} offset: 0x{:<12x} vaddr: 0x{:<18x} "
+                     "memsz: 0x{:x}",
+                     phdr.p_type, phdr.p_offset, phdr.p_vaddr, phdr.p_memsz)
+              << '\n';
+  }
+}
+
+void Elf::dumpSections(const Elf64_Ehdr& header) {
+  if (header.e_shstrndx == SHN_UNDEF) return;
+
+  const auto strtab = loadBytes<Elf64_Shdr>(
+      header.e_shoff + (u64{header.e_shstrndx} * header.e_shentsize));
+  std::vector<char> names(strtab.sh_size);
+  m_file.seekg(static_cast<std::streamoff>(strtab.sh_offset), std::ios::beg);
+  m_file.read(names.data(), static_cast<std::streamsize>(names.size()));
+
+  for (u32 i = 0; i < header.e_shnum; i++) {
+    const auto section = loadBytes<Elf64_Shdr>(header.e_shoff +
+                                               (u64{i} * header.e_shentsize));
+    const char* name =
+        section.sh_name < names.size() ? &names[section.sh_name] : "";
+    std::cout << std::format("Section: {}; Address: 0x{:x}", name,
+                             section.sh_addr)
+              << '\n';
+  }
+}
+
+i32 Elf::launch(detail::CStringArray& argList) {
+  // The child blocks on this pipe until it has been seized, so the tracer
+  // never misses the exec stop
+  std::array<int, 2> gate{};
+  if (pipe2(gate.data(), O_CLOEXEC) != 0) return -1;
+
+  argList.prepend(m_file_path);
+
+  const pid_t pid = fork();
+  if (pid < 0) {
+    close(gate[0]);
+    close(gate[1]);
+    return -1;
+  }
+
+  if (pid == 0) {
+    close(gate[1]);
+    char go = 0;
+    if (read(gate[0], &go, 1) != 1) _exit(127);
+    // Signals the reactor blocked in the debugger would survive the exec.
+    // The target stays in the terminal's foreground group, so it can still
+    // read from and configure the terminal
+    sigset_t none{};
+    sigemptyset(&none);
+    sigprocmask(SIG_SETMASK, &none, nullptr);
+    execv(m_file_path.c_str(), argList.data());
+    _exit(127);
+  }
+
+  close(gate[0]);
+  m_pid = pid;
+
+  if (ptrace(PTRACE_SEIZE, pid, nullptr, TRACE_OPTIONS) != 0) {
+    CoreError::error(std::format("PTRACE_SEIZE failed: {}", strerror(errno)));
+    kill(pid, SIGKILL);
+    close(gate[1]);
+    waitpid(pid, nullptr, 0);
+    return -1;
+  }
+
+  const char go = 1;
+  const bool released = write(gate[1], &go, 1) == 1;
+  close(gate[1]);
+  if (!released) return -1;
+
+  int status = 0;
+  while (true) {
+    if (waitpid(pid, &status, __WALL) < 0) return -1;
+    if (!WIFSTOPPED(status)) return -1;  // exec failed, child is gone
+    if (status >> 8 == (SIGTRAP | (PTRACE_EVENT_EXEC << 8))) break;
+    ptrace(PTRACE_CONT, pid, nullptr, 0);
+  }
+
+  // Reported by the first eventLoop() iteration, like Mach's initial stop
+  m_threads.clear();
+  m_threads.add(pid).pending_status = status;
+  return pid;
+}
+
+i32 Elf::attach() {
+  // Options were already applied by launch() or seize()
+  this->readAslrSlide();
+  this->openMemory();
+  watchExit();
+  m_symbols = ProcessSymbols{m_pid};
+  m_tid = m_pid;
+  return fetchRegisters(currentThread());
+}
+
+i32 Elf::seize(pid_t pid) {
+  m_pid = pid;
+  m_threads.clear();
+  m_starting.clear();
+
+  // Seized without following clones, threads started meanwhile show up in
+  // the next listing instead. Once a listing has nothing new while every
+  // known thread is stopped, no more can appear
+  while (true) {
+    size_t added = 0;
+    for (const pid_t tid : listThreads(pid)) {
+      if (m_threads.contains(tid)) continue;
+      if (ptrace(PTRACE_SEIZE, tid, nullptr, 0) == 0) {
+        m_threads.add(tid).running = true;
+        added++;
+        continue;
+      }
+      // Exited since the listing
+      if (errno == ESRCH && tid != pid) continue;
+
+      CoreError::error(std::format(
+          "PTRACE_SEIZE of {} failed: {}{}", tid, strerror(errno),
+          errno == EPERM ? ", see /proc/sys/kernel/yama/ptrace_scope" : ""));
+      detach();
+      return -1;
+    }
+    if (added == 0) break;
+    // Interrupts all of them before waiting for any
+    stopOtherThreads(0);
+  }
+
+  if (!m_threads.contains(pid)) {
+    CoreError::error(std::format("No process {}", pid));
+    detach();
+    return -1;
+  }
+  for (const auto& [tid, thread] : m_threads) {
+    if (ptrace(PTRACE_SETOPTIONS, tid, nullptr, ATTACH_OPTIONS) != 0 &&
+        tid == pid) {
+      CoreError::error(std::format("PTRACE_SETOPTIONS failed: {}",
+                                   strerror(errno)));
+      detach();
+      return -1;
+    }
+  }
+
+  m_attached = true;
+  m_threads.select(pid);
+  return 0;
+}
+
+void Elf::openMemory() {
+  if (m_mem_fd >= 0) close(m_mem_fd);
+  // Opened after the exec stop, an fd from before exec would still point at
+  // the old address space
+  m_mem_fd = open(std::format("/proc/{}/mem", m_pid).c_str(),
+                  O_RDWR | O_CLOEXEC);
+  if (m_mem_fd < 0)
+    CoreError::error(std::format("Could not open /proc/{}/mem: {}", m_pid,
+                                 strerror(errno)));
+}
+
+void Elf::watchExit() {
+  Reactor& reactor = Reactor::getInstance();
+  reactor.remove(m_exit_fd);
+  // Exits are seen even when their SIGCHLD went to a thread that had it
+  // unblocked
+  m_exit_fd = reactor.addProcess(m_pid, [this] { m_exit_fd = -1; });
+}
+
+void Elf::readAslrSlide() {
+  std::ifstream auxv{std::format("/proc/{}/auxv", m_pid), std::ios::binary};
+  if (!auxv) {
+    CoreError::error("Could not open auxiliary vector!");
+    return;
+  }
+
+  const auto header = loadBytes<Elf64_Ehdr>(0);
+  std::array<u64, 2> entry{};
+  while (auxv.read(std::bit_cast<char*>(entry.data()), sizeof(entry))) {
+    if (entry[0] == AT_NULL) break;
+    if (entry[0] == AT_ENTRY) {
+      m_aslr_slide = entry[1] - header.e_entry;
+      return;
+    }
+  }
+
+  CoreError::error("Could not determine ASLR slide!");
+}
+
+u64& Elf::getAslrSlide() { return m_aslr_slide; }
+
+i32 Elf::setBreakpoint(u64 addr) { return setBreakpoints({&addr, 1}); }
+
+i32 Elf::restorePrevIns(u64 k) {
+  const Breakpoint* bp = m_breakpoints.find(k);
+  if (bp == nullptr) return -1;
+
+  const auto orig = static_cast<std::byte>(bp->orig_ins & 0xFF);
+  return writeMemory(k + m_aslr_slide, {&orig, 1});
+}
+
+i32 Elf::disableBreakpoint(u64 addr, bool remove) {
+  return disableBreakpoints({&addr, 1}, remove) == 0 ? 0 : 1;
+}
+
+i32 Elf::detach() {
+  if (m_state == TargetState::RUNNING) {
+    CoreError::error("Target must be stopped to detach!");
+    return -1;
+  }
+
+  // Non-stop leaves threads running, ptrace only detaches stopped ones
+  stopOtherThreads(0);
+
+  for (auto& [tid, thread] : m_threads) {
+    if (!thread.pending_status) continue;
+    const int status = *thread.pending_status;
+    // Queued stops are never reported, a signal goes along with the detach
+    // and a trap that was hit moves rip back onto the original instruction
+    if (!WIFSTOPPED(status) || status >> 16 != 0 ||
+        WSTOPSIG(status) == (SIGTRAP | 0x80))
+      continue;
+    if (WSTOPSIG(status) != SIGTRAP) {
+      thread.pending_signal = WSTOPSIG(status);
+      continue;
+    }
+    ThreadState& regs = threadRegs(thread);
+    if (m_breakpoints.contains(regs.rip - 1 - m_aslr_slide)) {
+      regs.rip--;
+      thread.markDirty(RegGroup::GPR);
+    }
+  }
+
+  std::vector<u64> addrs{};
+  addrs.reserve(m_breakpoints.size());
+  for (const auto& [addr, bp] : m_breakpoints) addrs.push_back(addr);
+  disableBreakpoints(addrs, true);
+  m_breakpoints.clear();
+  if (std::ranges::any_of(m_watchpoints, &Watchpoint::active)) {
+    m_watchpoints = {};
+    writeAllDebugRegisters();
+  }
+  if (m_syscalls.filtering())
+    std::cout << "The syscall filter stays installed, traced syscalls fail "
+                 "with ENOSYS from now on\n";
+
+  i32 res = 0;
+  for (auto& [tid, thread] : m_threads) {
+    if (thread.pending_status && !WIFSTOPPED(*thread.pending_status))
+      continue;
+    if (storeRegisters(thread) != 0 ||
+        ptrace(PTRACE_DETACH, tid, nullptr, thread.pending_signal) != 0) {
+      CoreError::error(
+          std::format("PTRACE_DETACH of {} failed: {}", tid, strerror(errno)));
+      res = -1;
+    }
+  }
+
+  m_threads.clear();
+  m_starting.clear();
+  m_started = false;
+  m_attached = false;
+  return res;
+}
+
+// ptrace requests are only honoured when issued by the thread that seized the
+// tracee, so instead of handing off to a waiter thread the loop runs here
+void Elf::startEventLoop() { eventLoop(); }
+
+void Elf::startBackground() { drainEvents(); }
+
+void Elf::eventLoop() {
+  // Sleeps until the SIGCHLD of the next stop, whose handler drains it
+  while (drainEvents()) {
+    if (Reactor::getInstance().poll() < 0) {
+      setTargetState(TargetState::EXITED);
+      break;
+    }
+  }
+}
+
+i32 Elf::interrupt() {
+  if (m_state != TargetState::RUNNING &&
+      std::ranges::none_of(m_threads, [](const auto& entry) {
+        return entry.second.running;
+      })) {
+    CoreError::error("Target is not running!");
+    return -1;
+  }
+  // Stops that were already on their way are reported on the next resume
+  stopOtherThreads(0);
+  if (m_threads.contains(m_pid)) m_threads.select(m_pid);
+  m_tid = m_threads.selectedTid();
+  setTargetState(TargetState::STOPPED);
+  return 0;
+}
+
+pid_t Elf::takePendingStatus(int& status) {
+  for (auto& [tid, thread] : m_threads) {
+    if (!thread.pending_status) continue;
+    status = *std::exchange(thread.pending_status, std::nullopt);
+    return tid;
+  }
+  return 0;
+}
+
+bool Elf::handleThreadEvent(pid_t tid, int status) {
+  // Only the thread goes away, the process keeps running
+  if ((WIFEXITED(status) || WIFSIGNALED(status)) && tid != m_pid) {
+    m_threads.remove(tid);
+    m_starting.erase(tid);
+    m_syscalls.forget(tid);
+    return true;
+  }
+  if (!WIFSTOPPED(status)) return false;
+  if (handleSyscallStop(tid, status, true)) return true;
+
+  const int event = status >> 16;
+  if (event == PTRACE_EVENT_CLONE) {
+    unsigned long child = 0;
+    ptrace(PTRACE_GETEVENTMSG, tid, nullptr, &child);
+    // Its attach stop may have been collected before this event
+    const auto newTid = static_cast<pid_t>(child);
+    if (!m_threads.contains(newTid)) {
+      m_threads.add(newTid).running = true;
+      m_starting.insert(newTid);
+    }
+    ptrace(PTRACE_CONT, tid, nullptr, 0);
+    return true;
+  }
+
+  // Attach stop of a new thread, it inherits the watchpoints and carries on
+  if (event == PTRACE_EVENT_STOP &&
+      (m_starting.erase(tid) != 0 || !m_threads.contains(tid))) {
+    writeDebugRegisters(tid);
+    m_threads.add(tid).running = true;
+    ptrace(PTRACE_CONT, tid, nullptr, 0);
+    return true;
+  }
+  return false;
+}
+
+void Elf::handleStatus(pid_t tid, int status) {
+  if (handleThreadEvent(tid, status)) return;
+
+  if (WIFEXITED(status)) {
+    m_threads.clear();
+    m_starting.clear();
+    setTargetState(TargetState::EXITED);
+    std::cout << "Target exited with code " << WEXITSTATUS(status) << '\n';
+    return;
+  }
+
+  if (WIFSIGNALED(status)) {
+    m_threads.clear();
+    m_starting.clear();
+    setTargetState(TargetState::EXITED);
+    std::cout << "Target killed with signal " << WTERMSIG(status) << '\n';
+    return;
+  }
+
+  m_tid = tid;
+  ThreadInfo& thread = currentThread();
+  thread.running = false;
+  // Changed while a queued stop was still outstanding
+  if (thread.dirty != 0) storeRegisters(thread);
+  thread.valid = 0;
+  const int sig = WSTOPSIG(status);
+  const int event = status >> 16;
+
+  // Group-stops of a seized tracee and interrupts that landed after the
+  // thread had already stopped for something else carry nothing new
+  if (event == PTRACE_EVENT_STOP) {
+    thread.running = true;
+    ptrace(resumeRequest(tid), tid, nullptr, 0);
+    return;
+  }
+
+  if (fetchRegisters(thread) != 0) {
+    setTargetState(TargetState::STOPPED);
+    return;
+  }
+
+  // Conditions and tracepoints read the registers of the selected thread
+  m_threads.select(tid);
+  const i32 watchSlot =
+      sig == SIGTRAP && event == 0 ? firedWatchpoint() : -1;
+  if (watchSlot >= 0) {
+    // Data breakpoints trap after the access, rip is already past it
+    reportWatchpoint(static_cast<size_t>(watchSlot));
+  } else if (sig == SIGTRAP && event == 0) {
+    // int3 leaves rip one past the trap
+    const u64 pc = thread.regs.rip - 1;
+    const u64 addr = pc - m_aslr_slide;
+    if (m_breakpoints.contains(addr)) {
+      // Written back by the step over or on resume, conditions and
+      // tracepoints only read the cached copy
+      thread.regs.rip = pc;
+      thread.markDirty(RegGroup::GPR);
+
+      // False condition or tracepoint, keep going without reaching the prompt
+      if (!breakpointHit(addr)) {
+        if (stepOverBreakpoint(addr)) {
+          currentThread().running = true;
+          ptrace(PTRACE_CONT, tid, nullptr, 0);
+        }
+        return;
+      }
+      // The trap stays in place, resume steps over it
+      thread.step_over = addr;
+    }
+  } else if (sig != SIGTRAP && event == 0) {
+    // Signal-delivery stop, forward it when the target is resumed. SIGINT
+    // comes from Ctrl-C, which only interrupts the target
+    if (sig != SIGINT) thread.pending_signal = sig;
+  }
+
+  std::string reason = Elf::stopReason(status);
+  thread.stop_reason = reason.substr(0, reason.size() - 1);
+  if (!m_non_stop) stopOtherThreads(tid);
+
+  ThreadInfo& stopped = currentThread();
+  if (m_threads.size() > 1) std::cout << std::format("Thread {} ", tid);
+  std::cout << reason;
+  std::cout << formatRegisterOutput(&stopped.regs);
+  setTargetState(TargetState::STOPPED);
+}
+
+void Elf::stopOtherThreads(pid_t tid) {
+  std::vector<pid_t> waiting{};
+  for (const auto& [other, thread] : m_threads) {
+    if (other == tid || !thread.running) continue;
+    // New threads stop on their own, interrupting them as well would leave a
+    // second stop behind
+    if (!m_starting.contains(other))
+      ptrace(PTRACE_INTERRUPT, other, nullptr, nullptr);
+    waiting.push_back(other);
+  }
+
+  for (const pid_t other : waiting) {
+    int status = 0;
+    if (waitpid(other, &status, __WALL) < 0) {
+      m_threads.remove(other);
+      m_starting.erase(other);
+      continue;
+    }
+
+    ThreadInfo& thread = m_threads.add(other);
+    thread.running = false;
+    // Recorded and left stopped, the interrupt still comes later. Ctrl-C
+    // reaches the debugger and the target together, its SIGINT is the same
+    // interrupt
+    if ((WIFSTOPPED(status) && status >> 16 == PTRACE_EVENT_STOP) ||
+        (WIFSTOPPED(status) && WSTOPSIG(status) == SIGINT &&
+         status >> 16 == 0) ||
+        handleSyscallStop(other, status, false)) {
+      if (m_starting.erase(other) != 0) writeDebugRegisters(other);
+      thread.stop_reason = "interrupted";
+      continue;
+    }
+
+    // Stopped or exited for its own reasons before the interrupt arrived,
+    // reported on the next resume instead of this stop
+    thread.pending_status = status;
+    thread.stop_reason = "event pending";
+  }
+}
+
+bool Elf::stepOverBreakpoint(u64 addr) {
+  // Removed while stopped on it, only the rewound rip has to be written back
+  if (!m_breakpoints.contains(addr))
+    return storeRegisters(currentThread()) == 0;
+
+  // With other threads running, restoring the original instruction would let
+  // them run past the breakpoint unnoticed. That is the case in non-stop
+  // mode, and in all-stop mode for false conditions and tracepoints, which
+  // are stepped over before anything else is stopped
+  std::vector<pid_t> held{};
+  for (const auto& [tid, thread] : m_threads)
+    if (tid != m_tid && thread.running) held.push_back(tid);
+  if (m_step_mode == StepMode::DISPLACED || !held.empty())
+    if (const auto res = displacedStep(addr)) return *res;
+
+  // Not relocatable, the other threads are held until the trap is back in
+  // place
+  if (!held.empty()) stopOtherThreads(m_tid);
+  // Ones that stopped for their own reasons keep their event for later
+  const auto release = [this, &held] {
+    for (const pid_t tid : held) {
+      ThreadInfo* thread = m_threads.find(tid);
+      if (thread != nullptr && !thread->running && !thread->pending_status)
+        continueThread(*thread);
+    }
+  };
+
+  if (storeRegisters(currentThread()) != 0 || restorePrevIns(addr) != 0) {
+    CoreError::error(std::format("Could not step over breakpoint at {}: {}",
+                                 detail::toHex(addr), strerror(errno)));
+    setTargetState(TargetState::STOPPED);
+    return false;
+  }
+
+  int status = 0;
+  if (singleStep(m_tid, status) != 0) {
+    CoreError::error(std::format("Could not step over breakpoint at {}: {}",
+                                 detail::toHex(addr), strerror(errno)));
+    setTargetState(TargetState::STOPPED);
+    return false;
+  }
+
+  if (WIFSTOPPED(status))
+    writeMemory(addr + m_aslr_slide,
+                {trapIns.data(), trapIns.size()});
+  release();
+  return finishStep(status);
+}
+
+std::optional<bool> Elf::displacedStep(u64 addr) {
+  const Breakpoint* bp = m_breakpoints.find(addr);
+  if (bp == nullptr) return std::nullopt;
+
+  const u64 actual = addr + m_aslr_slide;
+  std::array<std::byte, MAX_INS_LEN> ins{};
+  if (readMemory(actual, ins) != 0) return std::nullopt;
+  memcpy(ins.data(), &bp->orig_ins, trapIns.size());
+  const size_t len = displacedLength(ins);
+  if (len == 0) return std::nullopt;
+
+  // _start has run long before any breakpoint can be hit
+  const u64 scratch = m_entry + m_aslr_slide;
+  std::array<std::byte, MAX_INS_LEN> saved{};
+  const std::span<std::byte> savedIns{saved.data(), len};
+  if (readMemory(scratch, savedIns) != 0 ||
+      writeMemory(scratch, {ins.data(), len}) != 0)
+    return std::nullopt;
+
+  ThreadInfo& thread = currentThread();
+  threadRegs(thread).rip = scratch;
+  thread.markDirty(RegGroup::GPR);
+  int status = 0;
+  const bool stepped =
+      storeRegisters(thread) == 0 && singleStep(m_tid, status) == 0;
+  writeMemory(scratch, savedIns);
+  if (!stepped) {
+    CoreError::error(std::format("Could not step over breakpoint at {}: {}",
+                                 detail::toHex(addr), strerror(errno)));
+    thread.regs.rip = actual;
+    thread.markDirty(RegGroup::GPR);
+    storeRegisters(thread);
+    setTargetState(TargetState::STOPPED);
+    return false;
+  }
+
+  // Whitelisted instructions always fall through, move rip back into line
+  if (WIFSTOPPED(status) && fetchRegisters(thread) == 0 &&
+      thread.regs.rip == scratch + len) {
+    thread.regs.rip = actual + len;
+    thread.markDirty(RegGroup::GPR);
+    storeRegisters(thread);
+  }
+  return finishStep(status);
+}
+
+i32 Elf::singleStep(pid_t tid, int& status) {
+  // Interrupts left over from stopping the other threads, when this one
+  // had stopped for a trap first, come before the step and carry nothing
+  do {
+    if (ptrace(PTRACE_SINGLESTEP, tid, nullptr, 0) != 0 ||
+        waitpid(tid, &status, __WALL) < 0)
+      return -1;
+  } while (WIFSTOPPED(status) && status >> 16 == PTRACE_EVENT_STOP);
+  return 0;
+}
+
+bool Elf::finishStep(int status) {
+  currentThread().valid = 0;
+  // The stepped instruction may itself have hit a watchpoint
+  if (WIFSTOPPED(status) && WSTOPSIG(status) == SIGTRAP && status >> 16 == 0 &&
+      firedWatchpoint() < 0)
+    return true;
+
+  // Exited or stopped for another reason during the step
+  handleStatus(m_tid, status);
+  return false;
+}
+
+u64 Elf::debugControl(const WatchpointSlots& slots) {
+  u64 dr7 = 0;
+  for (size_t i = 0; i < slots.size(); i++) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+    const Watchpoint& wp = slots[i];
+    if (!wp.active()) continue;
+
+    // R/W 01 breaks on writes, 11 on reads and writes, there is no read-only
+    const u64 rw = wp.kind == WatchKind::WRITE ? 0b01 : 0b11;
+    // LEN 00, 01, 11 and 10 encode 1, 2, 4 and 8 bytes
+    u64 len = 0b00;
+    if (wp.len == 2) len = 0b01;
+    if (wp.len == 4) len = 0b11;
+    if (wp.len == 8) len = 0b10;
+
+    dr7 |= u64{1} << (i * 2);  // Local enable
+    dr7 |= ((len << 2) | rw) << (16 + (i * 4));
+  }
+  return dr7;
+}
+
+i32 Elf::writeDebugRegisters(pid_t tid) {
+  // Addresses first, the kernel validates them once DR7 enables the slot
+  for (size_t i = 0; i < m_watchpoints.size(); i++) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+    const Watchpoint& wp = m_watchpoints[i];
+    if (wp.active() &&
+        ptrace(PTRACE_POKEUSER, tid, debugRegOffset(i), wp.addr) != 0)
+      return -1;
+  }
+  if (ptrace(PTRACE_POKEUSER, tid, debugRegOffset(DR_CONTROL),
+             debugControl(m_watchpoints)) != 0)
+    return -1;
+
+  if (ThreadInfo* thread = m_threads.find(tid))
+    thread->valid &= ~groupBit(RegGroup::DEBUG);
+  return 0;
+}
+
+i32 Elf::writeAllDebugRegisters() {
+  // Debug registers are per thread, threads not stopped yet get them from
+  // handleThreadEvent
+  for (auto& [tid, thread] : m_threads) {
+    if (m_starting.contains(tid)) continue;
+    if (!thread.running) {
+      if (writeDebugRegisters(tid) != 0) return -1;
+      continue;
+    }
+
+    // Non-stop, running threads are briefly interrupted for the write
+    int status = 0;
+    if (ptrace(PTRACE_INTERRUPT, tid, nullptr, nullptr) != 0 ||
+        waitpid(tid, &status, __WALL) < 0)
+      return -1;
+    if (!WIFSTOPPED(status) || status >> 16 != PTRACE_EVENT_STOP) {
+      // Stopped for its own reasons first, reported on the next resume
+      thread.running = false;
+      thread.pending_status = status;
+      if (!WIFSTOPPED(status)) continue;
+    }
+    if (writeDebugRegisters(tid) != 0) return -1;
+    if (thread.running) ptrace(PTRACE_CONT, tid, nullptr, 0);
+  }
+  return 0;
+}
+
+i32 Elf::setWatchpoint(u64 addr, u8 len, WatchKind kind) {
+  if ((len != 1 && len != 2 && len != 4 && len != 8) || addr % len != 0) {
+    CoreError::error("Watchpoints must be 1, 2, 4 or 8 bytes and aligned");
+    return -1;
+  }
+
+  auto slot = std::ranges::find_if(
+      m_watchpoints, [](const Watchpoint& wp) { return !wp.active(); });
+  if (slot == m_watchpoints.end()) {
+    CoreError::error(std::format("All {} debug registers are in use",
+                                 MAX_WATCHPOINTS));
+    return -1;
+  }
+
+  Watchpoint wp{.addr = addr, .len = len, .kind = kind};
+  if (readMemory(addr, {std::bit_cast<std::byte*>(&wp.old_value), len}) !=
+      0) {
+    CoreError::error(
+        std::format("Cannot watch {}, not readable", detail::toHex(addr)));
+    return -1;
+  }
+
+  wp.id = m_next_watch_id++;
+  *slot = wp;
+  if (writeAllDebugRegisters() != 0) {
+    CoreError::error(
+        std::format("Could not write debug registers: {}", strerror(errno)));
+    *slot = {};
+    writeAllDebugRegisters();
+    return -1;
+  }
+  return static_cast<i32>(wp.id);
+}
+
+i32 Elf::removeWatchpoint(u32 id) {
+  auto slot = std::ranges::find(m_watchpoints, id, &Watchpoint::id);
+  if (id == 0 || slot == m_watchpoints.end()) return -1;
+
+  *slot = {};
+  if (writeAllDebugRegisters() != 0) {
+    CoreError::error(
+        std::format("Could not write debug registers: {}", strerror(errno)));
+    return -1;
+  }
+  return 0;
+}
+
+i32 Elf::generateCore(const std::string& path, bool referenceFiles,
+                      CoreDumpStats& stats) {
+  if (m_pid == 0 || m_threads.empty()) {
+    CoreError::error("Target is not running!");
+    return -1;
+  }
+
+  CoreDump dump{m_pid, referenceFiles};
+  // Running threads would change memory under the dump
+  std::vector<i32> tids = m_threads.tids();
+  for (const i32 tid : tids) {
+    if (!m_threads.find(tid)->running) continue;
+    CoreError::error(std::format("Thread {} is running, stop it first", tid));
+    return -1;
+  }
+  std::ranges::stable_partition(
+      tids, [this](i32 tid) { return tid == m_threads.selectedTid(); });
+
+  for (const i32 tid : tids) {
+    ThreadInfo& thread = *m_threads.find(tid);
+    if (!thread.has(RegGroup::FP) &&
+        fetchRegisters(thread, RegGroup::FP) != 0)
+      return -1;
+    dump.addThread({.tid = tid,
+                    .signal = thread.pending_signal,
+                    .regs = threadRegs(thread),
+                    .fp_regs = thread.fp_regs});
+  }
+  // The core shows the original instructions, not the traps
+  for (const auto& slot : m_breakpoints)
+    if (slot.bp.enabled)
+      dump.addPatch(slot.addr + m_aslr_slide,
+                    static_cast<std::byte>(slot.bp.orig_ins & 0xFF));
+
+  const i32 res = dump.write(path);
+  stats = dump.stats();
+  return res;
+}
+
+i32 Elf::checkpoint() {
+  if (!m_started || m_state != TargetState::STOPPED || m_threads.empty()) {
+    CoreError::error("Target has to be stopped!");
+    return -1;
+  }
+  // fork() only copies the thread that calls it
+  if (m_threads.size() > 1) {
+    CoreError::error("Checkpoints need a single threaded target");
+    return -1;
+  }
+
+  ThreadInfo& thread = m_threads.begin()->second;
+  const ThreadState regs = threadRegs(thread);
+  if (storeRegisters(thread) != 0) return -1;
+
+  // The copy keeps the original text and the syscall, restoring puts back
+  // whatever the target has at that point
+  const u64 scratch = m_entry + m_aslr_slide;
+  const std::vector<u64> armed = armedBreakpoints();
+  if (patchBreakpoints(armed, false) != 0) return -1;
+  pid_t child = -1;
+  if (readMemory(scratch, m_entry_ins) == 0 &&
+      writeMemory(scratch, SYSCALL_INS) == 0) {
+    child = injectFork(thread.tid, thread.pending_signal);
+    writeMemory(scratch, m_entry_ins);
+  }
+
+  thread.regs = regs;
+  thread.valid |= groupBit(RegGroup::GPR);
+  thread.markDirty(RegGroup::GPR);
+  if (patchBreakpoints(armed, true) != 0 || storeRegisters(thread) != 0 ||
+      child < 0)
+    return -1;
+
+  m_checkpoints.push_back(
+      {.id = m_next_checkpoint_id, .pid = child, .regs = regs});
+  return static_cast<i32>(m_next_checkpoint_id++);
+}
+
+i32 Elf::restoreCheckpoint(u32 id) {
+  const auto cp = std::ranges::find(m_checkpoints, id, &Checkpoint::id);
+  if (cp == m_checkpoints.end()) {
+    CoreError::error(std::format("No checkpoint {}", id));
+    return -1;
+  }
+  if (m_state == TargetState::RUNNING) {
+    CoreError::error("Target has to be stopped!");
+    return -1;
+  }
+
+  // The checkpoint stays parked, a fork of it becomes the target. Signals
+  // it gets, like SIGCHLD from copies exiting, are never delivered
+  int ignored = 0;
+  const pid_t copy = injectFork(cp->pid, ignored);
+  if (copy < 0) return -1;
+  if (m_state != TargetState::EXITED) killProcess();
+
+  m_pid = copy;
+  m_tid = copy;
+  m_threads.clear();
+  m_starting.clear();
+  openMemory();
+  watchExit();
+  m_symbols = ProcessSymbols{copy};
+  ThreadInfo& thread = m_threads.add(copy);
+  m_threads.select(copy);
+  thread.regs = cp->regs;
+  thread.valid |= groupBit(RegGroup::GPR);
+  thread.markDirty(RegGroup::GPR);
+  thread.stop_reason = std::format("checkpoint {}", id);
+
+  // Debug registers are not inherited across fork
+  if (writeMemory(m_entry + m_aslr_slide, m_entry_ins) != 0 ||
+      patchBreakpoints(armedBreakpoints(), true) != 0 ||
+      writeDebugRegisters(copy) != 0 || storeRegisters(thread) != 0)
+    return -1;
+
+  const u64 addr = thread.regs.rip - m_aslr_slide;
+  if (const Breakpoint* bp = m_breakpoints.find(addr);
+      bp != nullptr && bp->enabled)
+    thread.step_over = addr;
+  m_started = true;
+  setTargetState(TargetState::STOPPED);
+  return 0;
+}
+
+std::optional<u64> Elf::injectSyscall(pid_t tid, u64 nr,
+                                      std::initializer_list<u64> args,
+                                      int& deferred) {
+  ThreadState regs{};
+  if (readGprs(tid, regs) != 0) {
+    CoreError::error(
+        std::format("PTRACE_GETREGSET failed: {}", strerror(errno)));
+    return std::nullopt;
+  }
+  regs.rip = m_entry + m_aslr_slide;
+  regs.rax = nr;
+  // Not in a syscall, nothing to restart when it resumes
+  regs.orig_rax = static_cast<u64>(-1);
+  const std::array<u64*, 6> argRegs = {&regs.rdi, &regs.rsi, &regs.rdx,
+                                       &regs.r10, &regs.r8,  &regs.r9};
+  size_t i = 0;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+  for (const u64 arg : args) *argRegs[i++] = arg;
+
+  iovec iov{.iov_base = &regs, .iov_len = sizeof(regs)};
+  if (ptrace(PTRACE_SETREGSET, tid, regsetNote(RegGroup::GPR), &iov) != 0) {
+    CoreError::error(
+        std::format("PTRACE_SETREGSET failed: {}", strerror(errno)));
+    return std::nullopt;
+  }
+
+  // A fork event or a seccomp stop of the call itself come before the step
+  // finishes, signals arriving meanwhile are held back for the caller
+  int status = 0;
+  while (true) {
+    if (ptrace(PTRACE_SINGLESTEP, tid, nullptr, 0) != 0 ||
+        waitpid(tid, &status, __WALL) != tid) {
+      CoreError::error(std::format("Could not step process {}: {}", tid,
+                                   strerror(errno)));
+      return std::nullopt;
+    }
+    if (!WIFSTOPPED(status)) break;
+
+    const int event = status >> 16;
+    if (event == PTRACE_EVENT_FORK || event == PTRACE_EVENT_SECCOMP) continue;
+    if (event == 0 && WSTOPSIG(status) != SIGTRAP) {
+      deferred = WSTOPSIG(status);
+      continue;
+    }
+    if (event == 0 && readGprs(tid, regs) == 0) return regs.rax;
+    break;
+  }
+
+  CoreError::error(std::format("Injected syscall in {} ended with {}", tid,
+                               Elf::stopReason(status)));
+  return std::nullopt;
+}
+
+pid_t Elf::injectFork(pid_t pid, int& deferred) {
+  // The child is attached as it is created and starts out stopped
+  if (ptrace(PTRACE_SETOPTIONS, pid, nullptr,
+             TRACE_OPTIONS | PTRACE_O_TRACEFORK) != 0) {
+    CoreError::error(
+        std::format("PTRACE_SETOPTIONS failed: {}", strerror(errno)));
+    return -1;
+  }
+  const auto res = injectSyscall(pid, SYS_fork, {}, deferred);
+  ptrace(PTRACE_SETOPTIONS, pid, nullptr, TRACE_OPTIONS);
+  if (!res) return -1;
+
+  const auto child = static_cast<pid_t>(*res);
+  int status = 0;
+  if (child <= 0 || waitpid(child, &status, __WALL) != child) {
+    CoreError::error(std::format(
+        "Could not fork process {}: {}", pid,
+        child < 0 ? strerror(-child) : strerror(errno)));
+    return -1;
+  }
+  ptrace(PTRACE_SETOPTIONS, child, nullptr, TRACE_OPTIONS);
+  return child;
+}
+
+std::vector<u64> Elf::armedBreakpoints() const {
+  std::vector<u64> armed{};
+  for (const auto& slot : m_breakpoints)
+    if (slot.bp.enabled) armed.push_back(slot.addr);
+  std::ranges::sort(armed);
+  return armed;
+}
+
+void Elf::killProcess() {
+  kill(m_pid, SIGKILL);
+  // The leader is only reported once every other thread is reaped
+  for (const i32 tid : m_threads.tids())
+    if (tid != m_pid) waitpid(tid, nullptr, __WALL);
+  waitpid(m_pid, nullptr, __WALL);
+}
+
+i32 Elf::traceSyscalls(const std::vector<std::string>& names, bool print) {
+  std::vector<u32> nrs{};
+  for (const auto& name : names) {
+    const SyscallDesc* desc = findSyscall(name);
+    if (desc == nullptr) {
+      CoreError::error(std::format("Unknown syscall {}", name));
+      return -1;
+    }
+    nrs.push_back(desc->nr);
+  }
+  std::ranges::sort(nrs);
+
+  if (!m_syscalls.covered(nrs) && installSyscallFilter(nrs) != 0) return -1;
+  m_syscalls.start(std::move(nrs), print);
+  return 0;
+}
+
+i32 Elf::stopSyscallTrace() {
+  // The filters stay, their stops are only continued from now on
+  m_syscalls.stop();
+  return 0;
+}
+
+std::string Elf::syscallSummary() { return m_syscalls.summary(); }
+
+i32 Elf::installSyscallFilter(std::span<const u32> nrs) {
+  if (!m_started || m_state != TargetState::STOPPED || m_threads.empty() ||
+      std::ranges::any_of(m_threads, [](const auto& entry) {
+        return entry.second.running;
+      })) {
+    CoreError::error("Every thread has to be stopped!");
+    return -1;
+  }
+
+  ThreadInfo* selected = m_threads.selected();
+  ThreadInfo& thread =
+      selected != nullptr ? *selected : m_threads.begin()->second;
+  const ThreadState regs = threadRegs(thread);
+  if (storeRegisters(thread) != 0) return -1;
+
+  // The program and its header go on the stack below the red zone
+  const std::vector<sock_filter> filter =
+      buildSyscallFilter(nrs, SECCOMP_RET_TRACE);
+  const auto program = std::as_bytes(std::span{filter});
+  const u64 programAddr = (regs.rsp - RED_ZONE - program.size()) & ~u64{15};
+  const sock_fprog header{
+      .len = static_cast<u16>(filter.size()),
+      .filter = std::bit_cast<sock_filter*>(programAddr)};
+  const u64 headerAddr = (programAddr - sizeof(header)) & ~u64{15};
+
+  const u64 scratch = m_entry + m_aslr_slide;
+  if (writeMemory(programAddr, program) != 0 ||
+      writeMemory(headerAddr, std::as_bytes(std::span{&header, 1})) != 0 ||
+      readMemory(scratch, m_entry_ins) != 0 ||
+      writeMemory(scratch, SYSCALL_INS) != 0)
+    return -1;
+
+  // Without CAP_SYS_ADMIN a filter needs no_new_privs. TSYNC applies it to
+  // every thread at once
+  std::optional<u64> res = injectSyscall(
+      thread.tid, SYS_prctl, {PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0},
+      thread.pending_signal);
+  if (res && *res == 0)
+    res = injectSyscall(thread.tid, SYS_seccomp,
+                        {SECCOMP_SET_MODE_FILTER, SECCOMP_FILTER_FLAG_TSYNC,
+                         headerAddr},
+                        thread.pending_signal);
+  writeMemory(scratch, m_entry_ins);
+
+  thread.regs = regs;
+  thread.valid |= groupBit(RegGroup::GPR);
+  thread.markDirty(RegGroup::GPR);
+  if (storeRegisters(thread) != 0) return -1;
+  if (!res || *res != 0) {
+    CoreError::error(std::format(
+        "Could not install the seccomp filter: {}",
+        res && static_cast<i64>(*res) < 0
+            ? strerror(static_cast<int>(-static_cast<i64>(*res)))
+            : "thread out of sync"));
+    return -1;
+  }
+
+  m_syscalls.installed(nrs);
+  return 0;
+}
+
+bool Elf::handleSyscallStop(pid_t tid, int status, bool resume) {
+  const int event = status >> 16;
+  const bool entry = event == PTRACE_EVENT_SECCOMP;
+  // PTRACE_O_TRACESYSGOOD marks syscall stops
+  const bool exit = event == 0 && WSTOPSIG(status) == (SIGTRAP | 0x80);
+  if (!WIFSTOPPED(status) || (!entry && !exit)) return false;
+
+  ThreadState regs{};
+  readGprs(tid, regs);
+  if (entry) {
+    const auto nr = static_cast<u32>(regs.orig_rax);
+    // Earlier filters may still trap on calls no longer traced
+    if (m_syscalls.active() && m_syscalls.selected(nr)) {
+      const SyscallDesc* desc = findSyscall(nr);
+      m_syscalls.enter(
+          tid, nr,
+          desc != nullptr
+              ? syscallArgs(*desc, regs)
+              : std::format("{:#x}, {:#x}, {:#x}, {:#x}, {:#x}, {:#x}",
+                            regs.rdi, regs.rsi, regs.rdx, regs.r10, regs.r8,
+                            regs.r9));
+    }
+  } else if (auto line = m_syscalls.exit(tid, static_cast<i64>(regs.rax))) {
+    if (m_threads.size() > 1) std::cout << std::format("[{}] ", tid);
+    std::cout << *line << '\n';
+  }
+
+  if (resume) {
+    if (ThreadInfo* thread = m_threads.find(tid)) thread->running = true;
+    ptrace(resumeRequest(tid), tid, nullptr, 0);
+  }
+  return true;
+}
+
+std::string Elf::syscallArgs(const SyscallDesc& desc,
+                             const ThreadState& regs) {
+  constexpr size_t maxString = 64;
+  const std::array<u64, 6> args = {regs.rdi, regs.rsi, regs.rdx,
+                                   regs.r10, regs.r8,  regs.r9};
+
+  // Escaped like a C literal, cut off at maxString
+  const auto quote = [this, maxString](u64 addr, size_t len, bool untilNul) {
+    std::string raw(std::min(len, maxString), '\0');
+    size_t got = 0;
+    // Page by page, the string may end right before an unmapped one
+    while (got < raw.size()) {
+      const size_t pageLeft =
+          PageCache::PAGE_BYTES - ((addr + got) % PageCache::PAGE_BYTES);
+      const size_t chunk = std::min(raw.size() - got, pageLeft);
+      if (readWithProcMem(addr + got,
+                          std::as_writable_bytes(std::span{raw})
+                              .subspan(got, chunk)) != 0)
+        break;
+      got += chunk;
+      if (untilNul && raw.find('\0') < got) break;
+    }
+    if (got == 0) return detail::toHex(addr);
+    raw.resize(untilNul ? std::min(raw.find('\0'), got) : got);
+
+    std::string res = "\"";
+    for (const char c : raw) {
+      if (c == '\n') res += "\\n";
+      else if (c == '"' || c == '\\') res += std::format("\\{}", c);
+      else if (std::isprint(static_cast<unsigned char>(c)) != 0) res += c;
+      else res += std::format("\\x{:02x}", static_cast<u8>(c));
+    }
+    res += '"';
+    if (untilNul ? got == maxString && raw.size() == maxString
+                 : len > maxString)
+      res += "...";
+    return res;
+  };
+
+  std::string res{};
+  for (size_t i = 0; i < desc.argc; i++) {
+    if (i != 0) res += ", ";
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index)
+    switch (desc.args[i]) {
+      case ArgKind::INT:
+        res += std::format("{}", static_cast<i32>(args[i]));
+        break;
+      case ArgKind::LONG:
+        res += std::format("{}", static_cast<i64>(args[i]));
+        break;
+      case ArgKind::HEX:
+        res += std::format("{:#x}", args[i]);
+        break;
+      case ArgKind::STR:
+        res += args[i] == 0 ? "NULL" : quote(args[i], maxString, true);
+        break;
+      case ArgKind::BUF:
+        res += quote(args[i], i + 1 < args.size() ? args[i + 1] : 0, false);
+        break;
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index)
+  }
+  return res;
+}
+
+__ptrace_request Elf::resumeRequest(pid_t tid) const {
+  return m_syscalls.inFlight(tid) ? PTRACE_SYSCALL : PTRACE_CONT;
+}
+
+i32 Elf::profile(ProfileMode mode, double seconds, u32 hz, Profile& out) {
+  if (!m_started || m_state != TargetState::STOPPED) {
+    CoreError::error("Target has to be stopped!");
+    return -1;
+  }
+  if (hz == 0 || hz > MAX_PROFILE_HZ || !(seconds > 0)) {
+    CoreError::error(std::format(
+        "Profiling needs a duration and between 1 and {} samples a second",
+        MAX_PROFILE_HZ));
+    return -1;
+  }
+  // On-CPU samples pile up in the kernel, the loop only collects them
+  const auto period =
+      mode == ProfileMode::CPU
+          ? std::chrono::duration_cast<std::chrono::nanoseconds>(
+                PERF_DRAIN_INTERVAL)
+          : std::chrono::nanoseconds(1'000'000'000 / hz);
+  const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::duration<double>(seconds));
+
+  // Files are named after the mappings as they were when sampling started
+  m_symbols.refresh();
+  std::vector<std::byte> scratch{};
+  PerfSampler sampler{hz};
+  if (mode == ProfileMode::CPU && sampler.follow(m_threads.tids()) != 0)
+    return -1;
+
+  // Between ticks the loop sleeps in the reactor, stops of the target wake
+  // it through SIGCHLD. Ticks missed during a long pause are merged into
+  // one, not bunched up
+  Reactor& reactor = Reactor::getInstance();
+  bool due = false;
+  bool expired = false;
+  const int tick = reactor.addTimer(period, period, [&due] { due = true; });
+  const int deadline = reactor.addTimer(duration, std::chrono::nanoseconds{0},
+                                        [&expired] { expired = true; });
+  if (tick < 0 || deadline < 0) {
+    reactor.remove(tick);
+    reactor.remove(deadline);
+    return -1;
+  }
+
+  resume(ResumeType::RESUME);
+  while (m_state == TargetState::RUNNING && drainEvents() && !expired) {
+    if (due) {
+      due = false;
+      if (mode == ProfileMode::CPU) {
+        // Threads created since the last round
+        sampler.follow(m_threads.tids());
+        sampler.drain(out, m_symbols);
+      } else {
+        sampleThreads(out, scratch);
+      }
+      continue;
+    }
+    if (reactor.poll() < 0) break;
+  }
+  reactor.remove(tick);
+  reactor.remove(deadline);
+  sampler.disable();
+  sampler.drain(out, m_symbols);
+  out.addLost(sampler.lost());
+
+  // Stopped like at a breakpoint, with nothing to report
+  if (m_state == TargetState::RUNNING) interrupt();
+
+  for (const u64 pc : out.frames()) out.nameFrame(pc, m_symbols.function(pc));
+  for (const i32 nr : out.syscalls())
+    if (const SyscallDesc* desc = findSyscall(static_cast<u32>(nr)))
+      out.nameSyscall(nr, std::string{desc->name});
+  return 0;
+}
+
+i32 Elf::backtrace(size_t maxDepth, std::vector<StackFrame>& out) {
+  ThreadInfo* thread = m_threads.selected();
+  if (!m_started || m_state == TargetState::EXITED || thread == nullptr ||
+      thread->running) {
+    CoreError::error("Thread has to be stopped!");
+    return -1;
+  }
+  const ThreadState& regs = threadRegs(*thread);
+  m_symbols.refresh();
+
+  // Unwound again from a larger copy while frames are saved past its end,
+  // the rows stay cached so only the reads add up
+  std::vector<std::byte> stack(BACKTRACE_STACK_BYTES);
+  std::vector<u64> pcs{};
+  while (true) {
+    const MemorySlice slice{.addr = regs.rsp, .buf = stack};
+    size_t length = 0;
+    readStacks({&slice, 1}, {&length, 1});
+    const StackSnapshot snapshot{.base = regs.rsp,
+                                 .bytes = std::span{stack}.first(length)};
+    const UnwindStop stop =
+        walkCallFrames(unwindRegs(regs), snapshot, m_symbols, maxDepth, pcs);
+    if (stop != UnwindStop::STACK_END || length < stack.size() ||
+        stack.size() >= MAX_BACKTRACE_STACK_BYTES)
+      break;
+    stack.resize(stack.size() * 4);
+  }
+
+  out.clear();
+  out.reserve(pcs.size());
+  for (size_t i = 0; i < pcs.size(); i++)
+    // Named after the call, the return address can be in the next function
+    out.push_back({.pc = pcs[i],
+                   .function = m_symbols.function(i == 0 ? pcs[i]
+                                                         : pcs[i] - 1)});
+  return 0;
+}
+
+bool Elf::drainEvents() {
+  while (m_state == TargetState::RUNNING) {
+    int status = 0;
+    pid_t tid = takePendingStatus(status);
+    if (tid == 0) tid = waitpid(-1, &status, __WALL | WNOHANG);
+    if (tid == 0) return true;
+    if (tid < 0) {
+      if (errno == EINTR) continue;
+      CoreError::error(std::format("waitpid failed: {}", strerror(errno)));
+      setTargetState(TargetState::EXITED);
+      return false;
+    }
+    handleStatus(tid, status);
+  }
+  return false;
+}
+
+void Elf::sampleThreads(Profile& out, std::vector<std::byte>& scratch) {
+  const auto start = std::chrono::steady_clock::now();
+
+  std::vector<pid_t> waiting{};
+  for (const auto& [tid, thread] : m_threads) {
+    if (!thread.running || m_starting.contains(tid)) continue;
+    ptrace(PTRACE_INTERRUPT, tid, nullptr, nullptr);
+    waiting.push_back(tid);
+  }
+
+  std::vector<pid_t> stopped{};
+  std::vector<ThreadState> regs{};
+  for (const pid_t tid : waiting) {
+    int status = 0;
+    if (waitpid(tid, &status, __WALL) < 0) {
+      m_threads.remove(tid);
+      continue;
+    }
+    ThreadInfo& thread = m_threads.add(tid);
+    thread.running = false;
+    // A traced syscall stopping first is sampled there, anything else is
+    // handled once the tick is over
+    if (!(WIFSTOPPED(status) && status >> 16 == PTRACE_EVENT_STOP) &&
+        !handleSyscallStop(tid, status, false)) {
+      thread.pending_status = status;
+      continue;
+    }
+    ThreadState state{};
+    if (readGprs(tid, state) != 0) {
+      continueThread(thread);
+      continue;
+    }
+    stopped.push_back(tid);
+    regs.push_back(state);
+  }
+
+  // The top of every stack in one go
+  scratch.resize(stopped.size() * PROFILE_STACK_BYTES);
+  std::vector<MemorySlice> slices{};
+  slices.reserve(stopped.size());
+  for (size_t i = 0; i < stopped.size(); i++)
+    slices.push_back(
+        {.addr = regs[i].rsp,
+         .buf = std::span{scratch}.subspan(i * PROFILE_STACK_BYTES,
+                                           PROFILE_STACK_BYTES)});
+  std::vector<size_t> lengths(slices.size());
+  readStacks(slices, lengths);
+
+  // Resumed as soon as everything is copied, unwinding works from the
+  // snapshots and stays out of the pause
+  for (const pid_t tid : stopped) continueThread(m_threads.add(tid));
+  out.addPause(static_cast<u64>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count()));
+
+  for (size_t i = 0; i < stopped.size(); i++) {
+    const StackSnapshot stack{.base = regs[i].rsp,
+                              .bytes = slices[i].buf.first(lengths[i])};
+    std::vector<u64> pcs{};
+    walkCallFrames(unwindRegs(regs[i]), stack, m_symbols, PROFILE_MAX_DEPTH,
+                   pcs);
+    // Return addresses point past the call, into the next line
+    for (size_t j = 1; j < pcs.size(); j++) pcs[j]--;
+    // Interrupted inside a syscall, like a thread blocked in read()
+    const auto nr = static_cast<i64>(regs[i].orig_rax);
+    out.addSample(std::move(pcs), nr >= 0 ? static_cast<i32>(nr) : -1);
+  }
+}
+
+void Elf::readStacks(std::span<const MemorySlice> slices,
+                     std::span<size_t> lengths) const {
+  std::vector<iovec> local{};
+  std::vector<iovec> remote{};
+  size_t next = 0;
+  while (next < slices.size()) {
+    const size_t end = std::min<size_t>(next + IOV_MAX, slices.size());
+    local.clear();
+    remote.clear();
+    for (size_t i = next; i < end; i++) {
+      local.push_back({.iov_base = slices[i].buf.data(),
+                       .iov_len = slices[i].buf.size()});
+      remote.push_back({.iov_base = std::bit_cast<void*>(slices[i].addr),
+                        .iov_len = slices[i].buf.size()});
+    }
+
+    // Transfers stop at the first slice with an unmapped page in it
+    const ssize_t n = process_vm_readv(m_pid, local.data(), local.size(),
+                                       remote.data(), remote.size(), 0);
+    auto left = static_cast<size_t>(std::max<ssize_t>(n, 0));
+    while (next < end && left >= slices[next].buf.size()) {
+      lengths[next] = slices[next].buf.size();
+      left -= slices[next].buf.size();
+      next++;
+    }
+    if (next == end) continue;
+
+    // Near the top of a stack the window runs past its mapping, a single
+    // pread returns what comes before that
+    const MemorySlice& cut = slices[next];
+    const ssize_t got =
+        m_mem_fd < 0 ? -1
+                     : pread(m_mem_fd, cut.buf.data(), cut.buf.size(),
+                             static_cast<off_t>(cut.addr));
+    lengths[next] = static_cast<size_t>(std::max<ssize_t>(got, 0));
+    next++;
+  }
+}
+
+i32 Elf::firedWatchpoint() {
+  // Skips the extra PEEKUSER on every breakpoint trap while nothing is watched
+  if (std::ranges::none_of(m_watchpoints, &Watchpoint::active)) return -1;
+
+  const auto dr6Offset = debugRegOffset(DR_STATUS);
+  errno = 0;
+  const auto dr6 =
+      static_cast<u64>(ptrace(PTRACE_PEEKUSER, m_tid, dr6Offset, nullptr));
+  if (errno != 0) return -1;
+
+  for (size_t i = 0; i < m_watchpoints.size(); i++) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+    if ((dr6 & (u64{1} << i)) == 0 || !m_watchpoints[i].active()) continue;
+    // Older kernels accumulate DR6 across traps
+    ptrace(PTRACE_POKEUSER, m_tid, dr6Offset, 0);
+    currentThread().valid &= ~groupBit(RegGroup::DEBUG);
+    return static_cast<i32>(i);
+  }
+  return -1;
+}
+
+void Elf::reportWatchpoint(size_t slot) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+  Watchpoint& wp = m_watchpoints[slot];
+  wp.hit_count++;
+
+  u64 value = 0;
+  if (readMemory(wp.addr, {std::bit_cast<std::byte*>(&value), wp.len}) != 0) {
+    std::cout << std::format("Watchpoint {} @ {} hit, value unreadable\n",
+                             wp.id, detail::toHex(wp.addr));
+    return;
+  }
+
+  std::cout << std::format("Watchpoint {} ({}) @ {}: {:#x} -> {:#x}\n", wp.id,
+                           watchKindName(wp.kind), detail::toHex(wp.addr),
+                           wp.old_value, value);
+  wp.old_value = value;
+}
+
+std::string Elf::stopReason(int status) {
+  switch (status >> 16) {
+    case 0:
+      return std::format("signal {}\n", signalName(WSTOPSIG(status)));
+    case PTRACE_EVENT_EXEC:
+      return "reason PTRACE_EVENT_EXEC\n";
+    case PTRACE_EVENT_STOP:
+      return "reason PTRACE_EVENT_STOP\n";
+    default:
+      return std::format("reason ptrace event {}\n", status >> 16);
+  }
+}
+
+void Elf::resume(ResumeType cond) {
+  if (!m_started) {
+    std::cerr << "Target is not running!\n";
+    return;
+  }
+  m_page_cache.invalidate();
+
+  // A stop collected while the others were being interrupted is reported
+  // before anything runs again
+  if (std::ranges::any_of(m_threads, [](const auto& entry) {
+        return entry.second.pending_status.has_value();
+      })) {
+    this->setTargetState(TargetState::RUNNING);
+    return;
+  }
+
+  // Every thread is off its trap before any of them runs. Stepping can report
+  // a stop of its own, so the table is walked by tid
+  for (const i32 tid : m_threads.tids()) {
+    ThreadInfo* thread = m_threads.find(tid);
+    if (thread != nullptr && !thread->running && !prepareResume(*thread))
+      return;
+  }
+
+  switch (cond) {
+    case ResumeType::RESUME:
+      for (auto& [tid, thread] : m_threads)
+        if (!thread.running && continueThread(thread) != 0) return;
+      this->setTargetState(TargetState::RUNNING);
+      break;
+  }
+}
+
+i32 Elf::resumeThread(i32 tid) {
+  if (!m_started) {
+    CoreError::error("Target is not running!");
+    return -1;
+  }
+  ThreadInfo* thread = m_threads.find(tid);
+  if (thread == nullptr || thread->running) {
+    CoreError::error(std::format("Thread {} is not stopped", tid));
+    return -1;
+  }
+  m_page_cache.invalidate();
+
+  if (!thread->pending_status) {
+    if (!prepareResume(*thread)) return 0;
+    if (continueThread(*thread) != 0) return -1;
+  }
+  // Whatever is reported next comes from the event loop
+  this->setTargetState(TargetState::RUNNING);
+  return 0;
+}
+
+bool Elf::prepareResume(ThreadInfo& thread) {
+  if (thread.dirty && storeRegisters(thread) != 0) return false;
+
+  // Still sitting on the trap of the last stop, unless rip was moved
+  const auto addr = std::exchange(thread.step_over, std::nullopt);
+  if (!addr) return true;
+
+  m_tid = thread.tid;
+  const Breakpoint* bp = m_breakpoints.find(*addr);
+  return bp == nullptr || !bp->enabled ||
+         threadRegs(thread).rip != *addr + m_aslr_slide ||
+         stepOverBreakpoint(*addr);
+}
+
+i32 Elf::continueThread(ThreadInfo& thread) {
+  if (ptrace(resumeRequest(thread.tid), thread.tid, nullptr,
+             thread.pending_signal) != 0) {
+    CoreError::error(std::format("Continuing {} failed: {}", thread.tid,
+                                 strerror(errno)));
+    return -1;
+  }
+  thread.pending_signal = 0;
+  thread.running = true;
+  thread.valid = 0;
+  return 0;
+}
+
+i32 Elf::fetchRegisters(ThreadInfo& thread, RegGroup group) {
+  if (group == RegGroup::DEBUG) {
+    // There is no regset for the debug registers on x86
+    for (size_t i = 0; i < thread.debug_regs.dr.size(); i++) {
+      errno = 0;
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+      thread.debug_regs.dr[i] = static_cast<u64>(
+          ptrace(PTRACE_PEEKUSER, thread.tid, debugRegOffset(i), nullptr));
+      if (errno != 0) {
+        CoreError::error(
+            std::format("PTRACE_PEEKUSER failed: {}", strerror(errno)));
+        return -1;
+      }
+    }
+  } else {
+    const auto buf = thread.group(group);
+    iovec iov{.iov_base = buf.data(), .iov_len = buf.size()};
+    if (ptrace(PTRACE_GETREGSET, thread.tid, regsetNote(group), &iov) != 0) {
+      CoreError::error(
+          std::format("PTRACE_GETREGSET failed: {}", strerror(errno)));
+      return -1;
+    }
+  }
+
+  thread.valid |= groupBit(group);
+  return 0;
+}
+
+i32 Elf::storeRegisters(ThreadInfo& thread) {
+  for (const auto group : {RegGroup::GPR, RegGroup::FP, RegGroup::DEBUG}) {
+    if (!thread.isDirty(group)) continue;
+
+    if (group == RegGroup::DEBUG) {
+      // DR4 and DR5 are reserved, DR7 goes last so the addresses it enables
+      // are already in place
+      for (const size_t i : {0, 1, 2, 3, 6, 7}) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+        if (ptrace(PTRACE_POKEUSER, thread.tid, debugRegOffset(i),
+                   thread.debug_regs.dr[i]) != 0) {
+          CoreError::error(
+              std::format("PTRACE_POKEUSER failed: {}", strerror(errno)));
+          return -1;
+        }
+      }
+    } else {
+      const auto buf = thread.group(group);
+      iovec iov{.iov_base = buf.data(), .iov_len = buf.size()};
+      if (ptrace(PTRACE_SETREGSET, thread.tid, regsetNote(group), &iov) !=
+          0) {
+        CoreError::error(
+            std::format("PTRACE_SETREGSET failed: {}", strerror(errno)));
+        return -1;
+      }
+    }
+    thread.dirty &= ~groupBit(group);
+  }
+  return 0;
+}
+
+ThreadState& Elf::threadRegs(ThreadInfo& thread) {
+  // Running threads have nothing to read, they keep what was cached
+  if (!thread.has(RegGroup::GPR) && !thread.running) fetchRegisters(thread);
+  return thread.regs;
+}
+
+std::span<std::byte> Elf::registerGroup(RegGroup group) {
+  ThreadInfo* thread = m_threads.selected();
+  if (thread == nullptr) return {};
+  if (!thread->has(group) &&
+      (thread->running || fetchRegisters(*thread, group) != 0))
+    return {};
+  return thread->group(group);
+}
+
+void Elf::setThreadState(ThreadState* state) {
+  ThreadInfo* thread = m_threads.selected();
+  if (thread == nullptr) return;
+  memcpy(&thread->regs, state, sizeof(ThreadState));
+  thread->valid |= groupBit(RegGroup::GPR);
+  thread->markDirty(RegGroup::GPR);
+}
+
+ThreadState& Elf::getLastKnownThreadState() {
+  ThreadInfo* thread = m_threads.selected();
+  return thread != nullptr ? threadRegs(*thread) : m_no_thread;
+}
+
+i32 Elf::readMemory(u64 addr, std::span<std::byte> out) {
+  // A single pread has less setup than process_vm_readv and wins up to
+  // around a page (see bench_memory)
+  if (out.size() <= SMALL_READ && readWithProcMem(addr, out) == 0) return 0;
+
+  const MemorySlice slice{.addr = addr, .buf = out};
+  return readMemoryv({&slice, 1});
+}
+
+i32 Elf::readMemoryv(std::span<const MemorySlice> slices) {
+  // One process_vm_readv covers everything unless some page is unreadable
+  // (e.g. PROT_NONE or text without read permission), in which case the
+  // slices are retried through /proc/pid/mem, which ignores protections
+  if (readWithProcessVm(slices) == 0) return 0;
+
+  for (const auto& slice : slices) {
+    if (readWithProcMem(slice.addr, slice.buf) == 0) continue;
+    if (readWithPeek(slice.addr, slice.buf) == 0) continue;
+    CoreError::error(std::format("Error reading {} bytes at {}: {}!",
+                                 slice.buf.size(), detail::toHex(slice.addr),
+                                 strerror(errno)));
+    return -1;
+  }
+  return 0;
+}
+
+i32 Elf::writeMemory(u64 addr, std::span<const std::byte> in) {
+  // Covers breakpoint insertion and removal too
+  m_page_cache.invalidate();
+  // process_vm_writev honours page protections, so patching text has to go
+  // through /proc/pid/mem, which writes through read-only mappings like
+  // PTRACE_POKEDATA does but for any length in a single call
+  if (writeWithProcMem(addr, in) == 0) return 0;
+  if (writeWithPoke(addr, in) == 0) return 0;
+  CoreError::error(std::format("Error writing {} bytes at {}: {}!", in.size(),
+                               detail::toHex(addr), strerror(errno)));
+  return -1;
+}
+
+i32 Elf::readWithProcessVm(std::span<const MemorySlice> slices) const {
+  std::vector<iovec> local{};
+  std::vector<iovec> remote{};
+  local.reserve(std::min<size_t>(slices.size(), IOV_MAX));
+  remote.reserve(std::min<size_t>(slices.size(), IOV_MAX));
+
+  for (size_t start = 0; start < slices.size(); start += IOV_MAX) {
+    const size_t end = std::min<size_t>(start + IOV_MAX, slices.size());
+    local.clear();
+    remote.clear();
+    size_t expected = 0;
+
+    for (size_t i = start; i < end; i++) {
+      local.push_back({.iov_base = slices[i].buf.data(),
+                       .iov_len = slices[i].buf.size()});
+      remote.push_back({.iov_base = std::bit_cast<void*>(slices[i].addr),
+                        .iov_len = slices[i].buf.size()});
+      expected += slices[i].buf.size();
+    }
+
+    const ssize_t n = process_vm_readv(m_pid, local.data(), local.size(),
+                                       remote.data(), remote.size(), 0);
+    if (n < 0 || static_cast<size_t>(n) != expected) return -1;
+  }
+  return 0;
+}
+
+i32 Elf::readWithProcMem(u64 addr, std::span<std::byte> out) const {
+  if (m_mem_fd < 0) return -1;
+
+  size_t done = 0;
+  while (done < out.size()) {
+    const ssize_t n = pread(m_mem_fd, out.data() + done, out.size() - done,
+                            static_cast<off_t>(addr + done));
+    if (n <= 0) return -1;
+    done += static_cast<size_t>(n);
+  }
+  return 0;
+}
+
+i32 Elf::readWithPeek(u64 addr, std::span<std::byte> out) const {
+  // Word-aligned peeks, copying out only the requested bytes
+  const u64 first = addr & ~u64{7};
+  for (u64 word = first; word < addr + out.size(); word += sizeof(u64)) {
+    errno = 0;
+    const long data = ptrace(PTRACE_PEEKDATA, m_pid, word, nullptr);
+    if (errno != 0) return -1;
+
+    const u64 from = std::max(word, addr);
+    const u64 to = std::min(word + sizeof(u64), addr + out.size());
+    memcpy(out.data() + (from - addr),
+           reinterpret_cast<const std::byte*>(&data) + (from - word), to - from);
+  }
+  return 0;
+}
+
+i32 Elf::writeWithProcMem(u64 addr, std::span<const std::byte> in) const {
+  if (m_mem_fd < 0) return -1;
+
+  size_t done = 0;
+  while (done < in.size()) {
+    const ssize_t n = pwrite(m_mem_fd, in.data() + done, in.size() - done,
+                             static_cast<off_t>(addr + done));
+    if (n <= 0) return -1;
+    done += static_cast<size_t>(n);
+  }
+  return 0;
+}
+
+i32 Elf::writeWithPoke(u64 addr, std::span<const std::byte> in) const {
+  const u64 first = addr & ~u64{7};
+  for (u64 word = first; word < addr + in.size(); word += sizeof(u64)) {
+    const u64 from = std::max(word, addr);
+    const u64 to = std::min(word + sizeof(u64), addr + in.size());
+
+    errno = 0;
+    long data = 0;
+    // Partial words keep the bytes around the write
+    if (to - from != sizeof(u64)) {
+      data = ptrace(PTRACE_PEEKDATA, m_pid, word, nullptr);
+      if (errno != 0) return -1;
+    }
+
+    memcpy(reinterpret_cast<std::byte*>(&data) + (from - word),
+           in.data() + (from - addr), to - from);
+    if (ptrace(PTRACE_POKEDATA, m_pid, word, data) != 0) return -1;
+  }
+  return 0;
+}
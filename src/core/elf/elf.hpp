@@ -0,0 +1,206 @@
+#ifndef CAESAR_ELF_HPP
+#define CAESAR_ELF_HPP
+
+#include <elf.h>
+#include <sys/ptrace.h>
+#include <sys/user.h>
+
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "core/elf/symbols.hpp"
+#include "core/elf/syscalls.hpp"
+#include "core/platform.hpp"
+#include "core/target.hpp"
+#include "core/util.hpp"
+
+class Elf final : public Target {
+ public:
+  explicit Elf(std::ifstream f, std::string filePath);
+  ~Elf() override;
+  Elf(const Elf&) = delete;
+  Elf& operator=(const Elf&) = delete;
+  Elf(Elf&&) = delete;
+  Elf& operator=(Elf&&) = delete;
+
+  static constexpr long TRACE_OPTIONS =
+      PTRACE_O_TRACEEXEC | PTRACE_O_EXITKILL | PTRACE_O_TRACECLONE |
+      PTRACE_O_TRACESECCOMP | PTRACE_O_TRACESYSGOOD;
+  // A process the debugger did not start outlives it
+  static constexpr long ATTACH_OPTIONS = TRACE_OPTIONS & ~PTRACE_O_EXITKILL;
+  // Below rsp the ABI leaves alone, injected data goes under it
+  static constexpr u64 RED_ZONE = 128;
+  static constexpr u64 SMALL_READ = 4096;
+  static constexpr size_t DR_STATUS = 6;
+  static constexpr size_t DR_CONTROL = 7;
+  static constexpr size_t MAX_INS_LEN = 15;
+  // Copied from each thread's stack per profiler sample, bounding the pause
+  static constexpr size_t PROFILE_STACK_BYTES = 8192;
+  static constexpr size_t PROFILE_MAX_DEPTH = 128;
+  static constexpr u32 MAX_PROFILE_HZ = 1000;
+  // Stack read for a backtrace, four times more while frames are left
+  static constexpr size_t BACKTRACE_STACK_BYTES = 64 * 1024;
+  static constexpr size_t MAX_BACKTRACE_STACK_BYTES = 16 * 1024 * 1024;
+  // How often the perf ring buffers are emptied in ProfileMode::CPU
+  static constexpr auto PERF_DRAIN_INTERVAL = std::chrono::milliseconds(10);
+  static constexpr std::array<std::byte, 2> SYSCALL_INS{std::byte{0x0F},
+                                                        std::byte{0x05}};
+
+  void dumpHeader(int offset) override;
+  i32 attach() override;
+  i32 setBreakpoint(u64 addr) override;
+  i32 disableBreakpoint(u64 addr, bool remove) override;
+  i32 launch(detail::CStringArray& argList) override;
+  i32 detach() override;
+  void eventLoop() override;
+  void startEventLoop() override;
+  void startBackground() override;
+  i32 interrupt() override;
+  void resume(ResumeType cond) override;
+  i32 resumeThread(i32 tid) override;
+  i32 setNonStop(bool enable) override {
+    m_non_stop = enable;
+    return 0;
+  }
+  void setThreadState(ThreadState* state) override;
+  ThreadState& getLastKnownThreadState() override;
+  std::span<std::byte> registerGroup(RegGroup group) override;
+  i32 readMemory(u64 addr, std::span<std::byte> out) override;
+  i32 writeMemory(u64 addr, std::span<const std::byte> in) override;
+  i32 readMemoryv(std::span<const MemorySlice> slices) override;
+  i32 setWatchpoint(u64 addr, u8 len, WatchKind kind) override;
+  i32 removeWatchpoint(u32 id) override;
+  i32 generateCore(const std::string& path, bool referenceFiles,
+                   CoreDumpStats& stats) override;
+  i32 checkpoint() override;
+  i32 restoreCheckpoint(u32 id) override;
+  i32 traceSyscalls(const std::vector<std::string>& names,
+                    bool print) override;
+  i32 stopSyscallTrace() override;
+  std::string syscallSummary() override;
+  i32 profile(ProfileMode mode, double seconds, u32 hz,
+              Profile& out) override;
+  i32 backtrace(size_t maxDepth, std::vector<StackFrame>& out) override;
+  // Seizes every thread of the running process pid and stops them without
+  // any signal, attach() finishes the setup. Released again on failure
+  i32 seize(pid_t pid);
+
+  // Individual transfer mechanisms, readMemory/writeMemory pick between them
+  i32 readWithProcessVm(std::span<const MemorySlice> slices) const;
+  i32 readWithProcMem(u64 addr, std::span<std::byte> out) const;
+  i32 readWithPeek(u64 addr, std::span<std::byte> out) const;
+  i32 writeWithProcMem(u64 addr, std::span<const std::byte> in) const;
+  i32 writeWithPoke(u64 addr, std::span<const std::byte> in) const;
+
+  static std::string stopReason(int status);
+  // DR7 value enabling every active slot
+  static u64 debugControl(const WatchpointSlots& slots);
+  void readAslrSlide();
+  // Wakes the reactor once the current target process exits
+  void watchExit();
+  u64& getAslrSlide();
+  i32 restorePrevIns(u64 k);
+
+ private:
+  std::array<unsigned char, EI_NIDENT> m_ident{};
+  ThreadState m_no_thread{};  // Handed out before launch and after exit
+  pid_t m_tid = 0;            // Thread whose stop is being handled
+  // Announced by a clone event but not through their attach stop yet
+  std::unordered_set<pid_t> m_starting;
+  int m_mem_fd = -1;
+  int m_child_fd = -1;  // SIGCHLD signalfd, wakes the reactor on every stop
+  int m_exit_fd = -1;   // pidfd of the target until it has exited
+  int m_trace_fd = -1;  // Woken when tracepoint output is due on stdout
+  u64 m_entry = 0;  // Unslid e_entry, scratch space for displaced steps
+  // What the injected syscall of a checkpoint replaces at the entry point
+  std::array<std::byte, SYSCALL_INS.size()> m_entry_ins{};
+  SyscallTracer m_syscalls;
+  bool m_attached = false;  // By seize(), released when the target goes away
+  // Symbols and unwind rows of the mapped files, kept across stops
+  ProcessSymbols m_symbols;
+
+  void readMagic() override;
+  void is64() override;
+
+  template <typename T>
+  T loadBytes(u64 offset) {
+    T buf{};
+    m_file.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+    m_file.read(std::bit_cast<char*>(&buf), sizeof(T));
+    return buf;
+  }
+
+  void dumpProgramHeaders(const Elf64_Ehdr& header);
+  void dumpSections(const Elf64_Ehdr& header);
+  void handleStatus(pid_t tid, int status);
+  // Handles thread creation and exit, true when nothing is left to report
+  bool handleThreadEvent(pid_t tid, int status);
+  // All-stop, interrupts every other running thread and queues whatever they
+  // report instead of the interrupt stop
+  void stopOtherThreads(pid_t tid);
+  // Thread with a queued status from stopOtherThreads, 0 if there is none
+  pid_t takePendingStatus(int& status);
+  // Writes back changed registers and steps the thread off the breakpoint it
+  // stopped on, false when that step ended in a reported stop
+  bool prepareResume(ThreadInfo& thread);
+  i32 continueThread(ThreadInfo& thread);
+  ThreadInfo& currentThread() { return m_threads.add(m_tid); }
+  // Executes the original instruction under addr in the current thread and
+  // re-arms the trap, false when the step ended in some other stop, which is
+  // then already handled
+  bool stepOverBreakpoint(u64 addr);
+  // Out of line variant using the entry point as scratch space, nullopt when
+  // the instruction is not known to be position independent
+  std::optional<bool> displacedStep(u64 addr);
+  // Steps tid by one instruction, status is where it stopped next
+  i32 singleStep(pid_t tid, int& status);
+  bool finishStep(int status);
+  i32 writeDebugRegisters(pid_t tid);
+  i32 writeAllDebugRegisters();
+  // Slot whose DR6 bit is set by the last SIGTRAP, -1 if no watchpoint fired
+  i32 firedWatchpoint();
+  void reportWatchpoint(size_t slot);
+  i32 fetchRegisters(ThreadInfo& thread, RegGroup group = RegGroup::GPR);
+  // Writes back every dirty group, one request each
+  i32 storeRegisters(ThreadInfo& thread);
+  ThreadState& threadRegs(ThreadInfo& thread);
+  void openMemory();
+  // Makes the stopped thread tid run syscall nr from the syscall instruction
+  // that has to be at the entry point already. Its registers are left
+  // changed for the caller to restore, a signal it got meanwhile is stored
+  // in deferred. Returns the result, nullopt if the thread did not get back
+  std::optional<u64> injectSyscall(pid_t tid, u64 nr,
+                                   std::initializer_list<u64> args,
+                                   int& deferred);
+  // Returns the child, stopped and traced, or -1
+  pid_t injectFork(pid_t pid, int& deferred);
+  // Stacks a seccomp filter trapping on nrs onto every thread of the target
+  i32 installSyscallFilter(std::span<const u32> nrs);
+  // Seccomp and syscall-exit stops of traced syscalls, false for anything
+  // else. With resume the thread is continued right away
+  bool handleSyscallStop(pid_t tid, int status, bool resume);
+  std::string syscallArgs(const SyscallDesc& desc, const ThreadState& regs);
+  // PTRACE_SYSCALL while a traced syscall has yet to return
+  [[nodiscard]] __ptrace_request resumeRequest(pid_t tid) const;
+  // Handles whatever the threads reported without waiting, false once the
+  // target is no longer running
+  bool drainEvents();
+  // Interrupts every running thread, records their stacks and lets them go
+  // again
+  void sampleThreads(Profile& out, std::vector<std::byte>& scratch);
+  // Reads as much of each slice as is mapped, lengths gets the bytes read
+  void readStacks(std::span<const MemorySlice> slices,
+                  std::span<size_t> lengths) const;
+  // Sorted addresses of the breakpoints with a trap in memory
+  std::vector<u64> armedBreakpoints() const;
+  // Kills the current process and reaps every thread of it
+  void killProcess();
+};
+
+#endif  // CAESAR_ELF_HPP
@@ -0,0 +1,185 @@
+#include "perf_sampler.hpp"
+
+#include <asm/perf_regs.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <error.hpp>
+#include <format>
+
+#include "core/unwind.hpp"
+
+namespace {
+constexpr size_t MAX_DEPTH = 128;
+// The registers of UnwindRegs in their DWARF order. The kernel writes them
+// by ascending bit instead
+constexpr std::array<u8, UnwindRegs::COUNT> SAMPLED_REGS{
+    PERF_REG_X86_AX,  PERF_REG_X86_DX,  PERF_REG_X86_CX,  PERF_REG_X86_BX,
+    PERF_REG_X86_SI,  PERF_REG_X86_DI,  PERF_REG_X86_BP,  PERF_REG_X86_SP,
+    PERF_REG_X86_R8,  PERF_REG_X86_R9,  PERF_REG_X86_R10, PERF_REG_X86_R11,
+    PERF_REG_X86_R12, PERF_REG_X86_R13, PERF_REG_X86_R14, PERF_REG_X86_R15,
+    PERF_REG_X86_IP};
+constexpr u64 REGS_MASK = [] {
+  u64 mask = 0;
+  for (const u8 reg : SAMPLED_REGS) mask |= u64{1} << reg;
+  return mask;
+}();
+
+template <typename T>
+bool take(std::span<const std::byte> record, size_t& offset, T& out) {
+  if (offset > record.size() || record.size() - offset < sizeof(T))
+    return false;
+  std::memcpy(&out, record.data() + offset, sizeof(T));
+  offset += sizeof(T);
+  return true;
+}
+}  // namespace
+
+PerfSampler::~PerfSampler() {
+  for (const auto& ring : m_rings) {
+    munmap(ring.base, ring.size);
+    close(ring.fd);
+  }
+}
+
+i32 PerfSampler::follow(std::span<const pid_t> tids) {
+  perf_event_attr attr{};
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_SOFTWARE;
+  attr.config = PERF_COUNT_SW_CPU_CLOCK;
+  attr.freq = 1;
+  attr.sample_freq = m_hz;
+  attr.sample_type = PERF_SAMPLE_IP | PERF_SAMPLE_TID |
+                     PERF_SAMPLE_REGS_USER | PERF_SAMPLE_STACK_USER;
+  attr.sample_regs_user = REGS_MASK;
+  attr.sample_stack_user = STACK_BYTES;
+  // Only time spent in the target's own code counts
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+
+  const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const size_t size = (RING_PAGES + 1) * page;
+  for (const pid_t tid : tids) {
+    if (std::ranges::find(m_rings, tid, &Ring::tid) != m_rings.end())
+      continue;
+
+    const auto fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, tid,
+                                             -1, -1, PERF_FLAG_FD_CLOEXEC));
+    if (fd < 0) {
+      CoreError::error(std::format(
+          "perf_event_open for thread {} failed: {}{}", tid, strerror(errno),
+          errno == EACCES || errno == EPERM
+              ? ", see /proc/sys/kernel/perf_event_paranoid"
+              : ""));
+      return -1;
+    }
+
+    void* base =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+      CoreError::error(std::format(
+          "Could not map the samples of thread {}: {}", tid, strerror(errno)));
+      close(fd);
+      return -1;
+    }
+    m_rings.push_back({.tid = tid,
+                       .fd = fd,
+                       .base = static_cast<std::byte*>(base),
+                       .size = size});
+  }
+  return 0;
+}
+
+void PerfSampler::disable() {
+  for (const auto& ring : m_rings) ioctl(ring.fd, PERF_EVENT_IOC_DISABLE, 0);
+}
+
+void PerfSampler::drain(Profile& out, FrameSource& frames) {
+  for (auto& ring : m_rings) drainRing(ring, out, frames);
+}
+
+void PerfSampler::drainRing(Ring& ring, Profile& out, FrameSource& frames) {
+  auto* meta = std::bit_cast<perf_event_mmap_page*>(ring.base);
+  // Pairs with the kernel's write barrier before it moves data_head
+  const u64 head = __atomic_load_n(&meta->data_head, __ATOMIC_ACQUIRE);
+  u64 tail = meta->data_tail;
+  const std::span<const std::byte> data{ring.base + meta->data_offset,
+                                        meta->data_size};
+
+  while (tail < head) {
+    const size_t start = tail % data.size();
+    perf_event_header header{};
+    // Records are 8 byte aligned, a header never wraps
+    std::memcpy(&header, data.data() + start, sizeof(header));
+    if (header.size < sizeof(header)) break;
+
+    std::span<const std::byte> record = data.subspan(
+        start, std::min<size_t>(header.size, data.size() - start));
+    if (record.size() < header.size) {
+      m_record.assign(record.begin(), record.end());
+      m_record.insert(m_record.end(), data.begin(),
+                      data.begin() + (header.size - record.size()));
+      record = m_record;
+    }
+
+    if (header.type == PERF_RECORD_SAMPLE) {
+      addSample(record, out, frames);
+    } else if (header.type == PERF_RECORD_LOST) {
+      // Header, event id, then the count
+      size_t offset = sizeof(header) + sizeof(u64);
+      u64 lost = 0;
+      if (take(record, offset, lost)) m_lost += lost;
+    }
+    tail += header.size;
+  }
+
+  // Hands the space back to the kernel once everything is copied out
+  __atomic_store_n(&meta->data_tail, tail, __ATOMIC_RELEASE);
+}
+
+void PerfSampler::addSample(std::span<const std::byte> record, Profile& out,
+                            FrameSource& frames) {
+  size_t offset = sizeof(perf_event_header);
+  u64 ip = 0;
+  u32 pid = 0;
+  u32 tid = 0;
+  u64 abi = 0;
+  if (!take(record, offset, ip) || !take(record, offset, pid) ||
+      !take(record, offset, tid) || !take(record, offset, abi))
+    return;
+
+  // No user registers when the sample hit a kernel thread
+  std::array<u64, std::popcount(REGS_MASK)> sampled{};
+  if (abi != PERF_SAMPLE_REGS_ABI_NONE)
+    for (u64& reg : sampled)
+      if (!take(record, offset, reg)) return;
+  UnwindRegs regs{};
+  for (size_t i = 0; i < SAMPLED_REGS.size(); i++) {
+    const u64 below = REGS_MASK & ((u64{1} << SAMPLED_REGS[i]) - 1);
+    regs.set(i, sampled[std::popcount(below)]);
+  }
+  regs.set(UnwindRegs::RIP, ip);
+
+  u64 size = 0;
+  if (!take(record, offset, size) || record.size() - offset < size) return;
+  const auto stackBytes = record.subspan(offset, size);
+  offset += size;
+  u64 dynSize = 0;
+  if (size != 0 && !take(record, offset, dynSize)) return;
+
+  const StackSnapshot stack{.base = regs.values[UnwindRegs::RSP],
+                            .bytes = stackBytes.first(std::min(dynSize, size))};
+  std::vector<u64> pcs{};
+  walkCallFrames(regs, stack, frames, MAX_DEPTH, pcs);
+  // Return addresses point past the call, into the next line
+  for (size_t i = 1; i < pcs.size(); i++) pcs[i]--;
+  out.addSample(std::move(pcs));
+}
@@ -0,0 +1,59 @@
+#ifndef CAESAR_PERF_SAMPLER_HPP
+#define CAESAR_PERF_SAMPLER_HPP
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "core/profile.hpp"
+#include "core/unwind.hpp"
+#include "typedefs.hpp"
+
+// On-CPU sampling through perf_event_open. Each thread gets a software
+// cpu-clock event, so no PMU is needed, that copies the user registers and
+// the top of the user stack into a ring buffer the debugger maps. The target
+// never stops for a sample, stacks are unwound when the buffers are drained
+class PerfSampler {
+ public:
+  static constexpr u32 STACK_BYTES = 8192;
+  static constexpr size_t RING_PAGES = 32;  // Data pages, a power of two
+
+  explicit PerfSampler(u32 hz) : m_hz(hz) {}
+  ~PerfSampler();
+  PerfSampler(const PerfSampler&) = delete;
+  PerfSampler& operator=(const PerfSampler&) = delete;
+  PerfSampler(PerfSampler&&) = delete;
+  PerfSampler& operator=(PerfSampler&&) = delete;
+
+  // Starts sampling the threads in tids that are not sampled yet. The kernel
+  // does not map inherited per-thread events, new threads are added here as
+  // they show up
+  i32 follow(std::span<const pid_t> tids);
+  void disable();
+  // Moves every complete sample out of the ring buffers into out, unwinding
+  // their stacks with the CFI from frames
+  void drain(Profile& out, FrameSource& frames);
+
+  [[nodiscard]] u64 lost() const { return m_lost; }
+
+ private:
+  struct Ring {
+    pid_t tid;
+    int fd;
+    std::byte* base;  // Metadata page followed by the data pages
+    size_t size;
+  };
+
+  u32 m_hz;
+  std::vector<Ring> m_rings;
+  std::vector<std::byte> m_record;  // Records wrapping around the end
+  u64 m_lost = 0;
+
+  void drainRing(Ring& ring, Profile& out, FrameSource& frames);
+  static void addSample(std::span<const std::byte> record, Profile& out,
+                        FrameSource& frames);
+};
+
+#endif  // CAESAR_PERF_SAMPLER_HPP
@@ -0,0 +1,199 @@
+#include "symbols.hpp"
+
+#include <cxxabi.h>
+#include <elf.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <memory>
+
+namespace {
+template <typename T>
+bool readStruct(std::span<const std::byte> bytes, u64 offset, T& out) {
+  if (offset > bytes.size() || bytes.size() - offset < sizeof(T))
+    return false;
+  std::memcpy(&out, bytes.data() + offset, sizeof(T));
+  return true;
+}
+
+std::string demangle(std::string_view name) {
+  const std::string mangled{name};
+  int status = 0;
+  const std::unique_ptr<char, decltype(&std::free)> res{
+      abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status),
+      &std::free};
+  return status == 0 && res ? std::string{res.get()} : mangled;
+}
+}  // namespace
+
+i32 SymbolTable::load(const std::string& path) {
+  if (m_file.open(path) != 0) return -1;
+  const auto bytes = m_file.bytes();
+
+  Elf64_Ehdr header{};
+  if (!readStruct(bytes, 0, header) ||
+      std::memcmp(header.e_ident, ELFMAG, SELFMAG) != 0 ||
+      header.e_ident[EI_CLASS] != ELFCLASS64)
+    return -1;
+
+  for (u64 i = 0; i < header.e_phnum; i++) {
+    Elf64_Phdr phdr{};
+    if (!readStruct(bytes, header.e_phoff + (i * header.e_phentsize), phdr))
+      return -1;
+    if (phdr.p_type == PT_LOAD)
+      m_segments.push_back({.offset = phdr.p_offset,
+                            .vaddr = phdr.p_vaddr,
+                            .filesz = phdr.p_filesz});
+  }
+
+  std::vector<Elf64_Shdr> sections(header.e_shnum);
+  for (u64 i = 0; i < sections.size(); i++)
+    if (!readStruct(bytes, header.e_shoff + (i * header.e_shentsize),
+                    sections[i]))
+      return -1;
+
+  if (header.e_shstrndx < sections.size()) {
+    const Elf64_Shdr& names = sections[header.e_shstrndx];
+    for (const auto& shdr : sections) {
+      if (shdr.sh_type == SHT_NOBITS || shdr.sh_name >= names.sh_size ||
+          names.sh_offset > bytes.size() ||
+          bytes.size() - names.sh_offset < names.sh_size ||
+          shdr.sh_offset > bytes.size() ||
+          bytes.size() - shdr.sh_offset < shdr.sh_size)
+        continue;
+      const auto* name = std::bit_cast<const char*>(
+          bytes.data() + names.sh_offset + shdr.sh_name);
+      m_sections.push_back(
+          {.name = {name, strnlen(name, names.sh_size - shdr.sh_name)},
+           .vaddr = shdr.sh_addr,
+           .bytes = bytes.subspan(shdr.sh_offset, shdr.sh_size)});
+    }
+  }
+
+  // The full table if it was not stripped, the dynamic one otherwise
+  const auto table = [&sections](u32 type) {
+    return std::ranges::find(sections, type, &Elf64_Shdr::sh_type);
+  };
+  auto symtab = table(SHT_SYMTAB);
+  if (symtab == sections.end()) symtab = table(SHT_DYNSYM);
+  if (symtab == sections.end() || symtab->sh_link >= sections.size())
+    return 0;
+  const Elf64_Shdr& strtab = sections[symtab->sh_link];
+  if (strtab.sh_offset > bytes.size() ||
+      bytes.size() - strtab.sh_offset < strtab.sh_size)
+    return -1;
+
+  for (u64 off = 0; off + sizeof(Elf64_Sym) <= symtab->sh_size;
+       off += sizeof(Elf64_Sym)) {
+    Elf64_Sym sym{};
+    if (!readStruct(bytes, symtab->sh_offset + off, sym)) break;
+    const u8 type = ELF64_ST_TYPE(sym.st_info);
+    if ((type != STT_FUNC && type != STT_GNU_IFUNC) || sym.st_value == 0 ||
+        sym.st_shndx == SHN_UNDEF || sym.st_name >= strtab.sh_size)
+      continue;
+
+    const auto* name = std::bit_cast<const char*>(
+        bytes.data() + strtab.sh_offset + sym.st_name);
+    const size_t len = strnlen(name, strtab.sh_size - sym.st_name);
+    m_symbols.push_back(
+        {.addr = sym.st_value, .size = sym.st_size, .name = {name, len}});
+  }
+
+  // Aliases share an address, the first one of them is kept
+  std::ranges::stable_sort(m_symbols, {}, &Symbol::addr);
+  const auto [first, last] = std::ranges::unique(m_symbols, {}, &Symbol::addr);
+  m_symbols.erase(first, last);
+  return 0;
+}
+
+const Symbol* SymbolTable::find(u64 addr) const {
+  auto it = std::ranges::upper_bound(m_symbols, addr, {}, &Symbol::addr);
+  if (it == m_symbols.begin()) return nullptr;
+  --it;
+  // Hand written assembly often comes without a size
+  if (it->size != 0 && addr - it->addr >= it->size) return nullptr;
+  return &*it;
+}
+
+std::optional<u64> SymbolTable::fileToVaddr(u64 offset) const {
+  for (const auto& seg : m_segments)
+    if (offset >= seg.offset && offset - seg.offset < seg.filesz)
+      return seg.vaddr + (offset - seg.offset);
+  return std::nullopt;
+}
+
+const Section* SymbolTable::section(std::string_view name) const {
+  const auto it = std::ranges::find(m_sections, name, &Section::name);
+  return it != m_sections.end() ? &*it : nullptr;
+}
+
+ProcessSymbols::ProcessSymbols(pid_t pid) : m_pid(pid) { refresh(); }
+
+void ProcessSymbols::refresh() {
+  m_mappings.clear();
+  for (auto& mapping : readMappings(m_pid))
+    if (mapping.exec) m_mappings.push_back(std::move(mapping));
+  std::ranges::sort(m_mappings, {}, &MemoryMapping::start);
+  m_mapping_modules.assign(m_mappings.size(), nullptr);
+}
+
+std::optional<ProcessSymbols::Location> ProcessSymbols::locate(u64 addr) {
+  const auto it = std::ranges::upper_bound(m_mappings, addr, {},
+                                           &MemoryMapping::start);
+  if (it == m_mappings.begin() || addr >= std::prev(it)->end ||
+      !std::prev(it)->fileBacked())
+    return std::nullopt;
+  const auto index =
+      static_cast<size_t>(std::distance(m_mappings.begin(), it) - 1);
+  const MemoryMapping& mapping = m_mappings[index];
+
+  Module*& module = m_mapping_modules[index];
+  if (module == nullptr) {
+    auto [entry, inserted] = m_modules.try_emplace(mapping.path);
+    if (inserted) entry->second.symbols.load(mapping.path);
+    module = &entry->second;
+  }
+  return Location{.module = module,
+                  .mapping = &mapping,
+                  .vaddr = module->symbols.fileToVaddr(
+                      mapping.offset + (addr - mapping.start))};
+}
+
+std::string ProcessSymbols::function(u64 addr) {
+  const auto loc = locate(addr);
+  if (!loc) return std::format("{:#x}", addr);
+
+  const Symbol* sym =
+      loc->vaddr ? loc->module->symbols.find(*loc->vaddr) : nullptr;
+  if (sym == nullptr)
+    return std::format(
+        "{}+{:#x}",
+        std::filesystem::path(loc->mapping->path).filename().string(),
+        loc->mapping->offset + (addr - loc->mapping->start));
+
+  auto [name, fresh] = m_demangled.try_emplace(sym->name);
+  if (fresh) name->second = demangle(sym->name);
+  return name->second;
+}
+
+const UnwindRow* ProcessSymbols::unwindRow(u64 pc,
+                                           const CallFrameInfo*& cfi) {
+  const auto loc = locate(pc);
+  if (!loc || !loc->vaddr) return nullptr;
+
+  Module& module = *loc->module;
+  if (!module.framesLoaded) {
+    module.framesLoaded = true;
+    if (const Section* eh = module.symbols.section(".eh_frame"))
+      module.frames.load(eh->bytes, eh->vaddr, true);
+    else if (const Section* debug = module.symbols.section(".debug_frame"))
+      module.frames.load(debug->bytes, debug->vaddr, false);
+  }
+
+  cfi = &module.frames;
+  return module.frames.find(*loc->vaddr);
+}
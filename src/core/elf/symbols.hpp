@@ -0,0 +1,101 @@
+#ifndef CAESAR_SYMBOLS_HPP
+#define CAESAR_SYMBOLS_HPP
+
+#include <sys/types.h>
+
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "core/dwarf/cfi.hpp"
+#include "core/elf/core_dump.hpp"
+#include "core/elf/core_file.hpp"
+#include "core/unwind.hpp"
+#include "typedefs.hpp"
+
+struct Symbol {
+  u64 addr;  // Link-time address
+  u64 size;
+  std::string_view name;  // Mangled, points into the mapped file
+};
+
+struct Section {
+  std::string_view name;
+  u64 vaddr;  // Link-time address, 0 for sections that are not loaded
+  std::span<const std::byte> bytes;
+};
+
+// Function symbols of one ELF file, from .symtab or .dynsym when the file is
+// stripped
+class SymbolTable {
+ public:
+  i32 load(const std::string& path);
+
+  // Function covering the link-time address addr, nullptr if there is none
+  [[nodiscard]] const Symbol* find(u64 addr) const;
+  // Link-time address of the byte at offset in the file, nullopt outside
+  // every PT_LOAD segment
+  [[nodiscard]] std::optional<u64> fileToVaddr(u64 offset) const;
+  [[nodiscard]] size_t size() const { return m_symbols.size(); }
+  // Section called name with contents in the file, nullptr if there is none
+  [[nodiscard]] const Section* section(std::string_view name) const;
+
+ private:
+  struct Segment {
+    u64 offset;
+    u64 vaddr;
+    u64 filesz;
+  };
+
+  MappedFile m_file;
+  std::vector<Symbol> m_symbols;  // Sorted by address, one per address
+  std::vector<Segment> m_segments;
+  std::vector<Section> m_sections;
+};
+
+// Names addresses of a live process through the symbol tables of the files it
+// maps, and finds the call frame information to unwind them. Each file is
+// read once, on the first address that falls into it, and stays cached when
+// the mappings are read again
+class ProcessSymbols final : public FrameSource {
+ public:
+  ProcessSymbols() = default;
+  explicit ProcessSymbols(pid_t pid);
+
+  // Reads the mappings again, the target may have loaded or unloaded files
+  void refresh();
+  // Demangled function name, "file+0x1f0" without a symbol there and the bare
+  // address outside every file mapping
+  std::string function(u64 addr);
+  // From .eh_frame, or .debug_frame for files without one
+  const UnwindRow* unwindRow(u64 pc, const CallFrameInfo*& cfi) override;
+
+ private:
+  struct Module {
+    SymbolTable symbols;
+    CallFrameInfo frames;
+    bool framesLoaded = false;
+  };
+
+  pid_t m_pid = 0;
+  std::vector<MemoryMapping> m_mappings;  // Executable ones, sorted
+  // Of each mapping, resolved on first use
+  std::vector<Module*> m_mapping_modules;
+  // Keyed by path, files that failed to load stay as empty tables
+  std::unordered_map<std::string, Module> m_modules;
+  std::unordered_map<std::string_view, std::string> m_demangled;
+
+  struct Location {
+    Module* module;
+    const MemoryMapping* mapping;
+    std::optional<u64> vaddr;  // Link-time address in the module
+  };
+
+  // nullopt outside every file mapping
+  std::optional<Location> locate(u64 addr);
+};
+
+#endif  // CAESAR_SYMBOLS_HPP
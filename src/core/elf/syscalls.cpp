@@ -0,0 +1,250 @@
+#include "syscalls.hpp"
+
+#include <linux/audit.h>
+#include <linux/seccomp.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <format>
+
+namespace {
+constexpr ArgKind I = ArgKind::INT;
+constexpr ArgKind L = ArgKind::LONG;
+constexpr ArgKind H = ArgKind::HEX;
+constexpr ArgKind S = ArgKind::STR;
+constexpr ArgKind B = ArgKind::BUF;
+
+// The calls that usually matter when looking at a process, anything else can
+// still be traced by leaving the list empty
+constexpr std::array SYSCALLS = std::to_array<SyscallDesc>({
+    {"read", SYS_read, 3, {I, H, L}},
+    {"write", SYS_write, 3, {I, B, L}},
+    {"open", SYS_open, 3, {S, H, H}},
+    {"close", SYS_close, 1, {I}},
+    {"stat", SYS_stat, 2, {S, H}},
+    {"fstat", SYS_fstat, 2, {I, H}},
+    {"lstat", SYS_lstat, 2, {S, H}},
+    {"poll", SYS_poll, 3, {H, I, I}},
+    {"lseek", SYS_lseek, 3, {I, L, I}},
+    {"mmap", SYS_mmap, 6, {H, L, H, H, I, L}},
+    {"mprotect", SYS_mprotect, 3, {H, L, H}},
+    {"munmap", SYS_munmap, 2, {H, L}},
+    {"brk", SYS_brk, 1, {H}},
+    {"rt_sigaction", SYS_rt_sigaction, 4, {I, H, H, I}},
+    {"rt_sigprocmask", SYS_rt_sigprocmask, 4, {I, H, H, I}},
+    {"ioctl", SYS_ioctl, 3, {I, H, H}},
+    {"pread64", SYS_pread64, 4, {I, H, L, L}},
+    {"pwrite64", SYS_pwrite64, 4, {I, B, L, L}},
+    {"access", SYS_access, 2, {S, H}},
+    {"pipe", SYS_pipe, 1, {H}},
+    {"select", SYS_select, 5, {I, H, H, H, H}},
+    {"sched_yield", SYS_sched_yield, 0, {}},
+    {"madvise", SYS_madvise, 3, {H, L, I}},
+    {"dup", SYS_dup, 1, {I}},
+    {"dup2", SYS_dup2, 2, {I, I}},
+    {"nanosleep", SYS_nanosleep, 2, {H, H}},
+    {"getpid", SYS_getpid, 0, {}},
+    {"getppid", SYS_getppid, 0, {}},
+    {"socket", SYS_socket, 3, {I, I, I}},
+    {"connect", SYS_connect, 3, {I, H, I}},
+    {"accept", SYS_accept, 3, {I, H, H}},
+    {"sendto", SYS_sendto, 6, {I, B, L, H, H, I}},
+    {"recvfrom", SYS_recvfrom, 6, {I, H, L, H, H, H}},
+    {"bind", SYS_bind, 3, {I, H, I}},
+    {"listen", SYS_listen, 2, {I, I}},
+    {"clone", SYS_clone, 5, {H, H, H, H, H}},
+    {"fork", SYS_fork, 0, {}},
+    {"execve", SYS_execve, 3, {S, H, H}},
+    {"exit", SYS_exit, 1, {I}},
+    {"wait4", SYS_wait4, 4, {I, H, H, H}},
+    {"kill", SYS_kill, 2, {I, I}},
+    {"fcntl", SYS_fcntl, 3, {I, I, H}},
+    {"getcwd", SYS_getcwd, 2, {H, L}},
+    {"chdir", SYS_chdir, 1, {S}},
+    {"rename", SYS_rename, 2, {S, S}},
+    {"mkdir", SYS_mkdir, 2, {S, H}},
+    {"unlink", SYS_unlink, 1, {S}},
+    {"readlink", SYS_readlink, 3, {S, H, L}},
+    {"prctl", SYS_prctl, 5, {I, H, H, H, H}},
+    {"gettid", SYS_gettid, 0, {}},
+    {"futex", SYS_futex, 6, {H, I, I, H, H, I}},
+    {"getdents64", SYS_getdents64, 3, {I, H, L}},
+    {"clock_gettime", SYS_clock_gettime, 2, {I, H}},
+    {"clock_nanosleep", SYS_clock_nanosleep, 4, {I, I, H, H}},
+    {"restart_syscall", SYS_restart_syscall, 0, {}},
+    {"exit_group", SYS_exit_group, 1, {I}},
+    {"epoll_wait", SYS_epoll_wait, 4, {I, H, I, I}},
+    {"epoll_ctl", SYS_epoll_ctl, 4, {I, I, I, H}},
+    {"openat", SYS_openat, 4, {I, S, H, H}},
+    {"newfstatat", SYS_newfstatat, 4, {I, S, H, H}},
+    {"unlinkat", SYS_unlinkat, 3, {I, S, H}},
+    {"accept4", SYS_accept4, 4, {I, H, H, H}},
+    {"epoll_pwait", SYS_epoll_pwait, 5, {I, H, I, I, H}},
+    {"dup3", SYS_dup3, 3, {I, I, H}},
+    {"pipe2", SYS_pipe2, 2, {H, H}},
+    {"seccomp", SYS_seccomp, 3, {I, H, H}},
+    {"getrandom", SYS_getrandom, 3, {H, L, H}},
+    {"statx", SYS_statx, 5, {I, S, H, H, H}},
+});
+
+// Calls returning an address rather than a count
+constexpr std::array<u32, 2> RETURNS_POINTER = {SYS_mmap, SYS_brk};
+
+sock_filter stmt(u16 code, u32 k) { return {code, 0, 0, k}; }
+
+sock_filter jump(u16 code, u32 k, u8 jt, u8 jf) { return {code, jt, jf, k}; }
+}  // namespace
+
+std::span<const SyscallDesc> syscallTable() { return SYSCALLS; }
+
+const SyscallDesc* findSyscall(std::string_view name) {
+  const auto it = std::ranges::find(SYSCALLS, name, &SyscallDesc::name);
+  return it != SYSCALLS.end() ? &*it : nullptr;
+}
+
+const SyscallDesc* findSyscall(u32 nr) {
+  const auto it = std::ranges::find(SYSCALLS, nr, &SyscallDesc::nr);
+  return it != SYSCALLS.end() ? &*it : nullptr;
+}
+
+std::vector<sock_filter> buildSyscallFilter(std::span<const u32> nrs,
+                                            u32 action) {
+  std::vector<sock_filter> prog{};
+  // Numbers only mean something for the native ABI
+  prog.push_back(stmt(BPF_LD | BPF_W | BPF_ABS,
+                      offsetof(struct seccomp_data, arch)));
+  prog.push_back(jump(BPF_JMP | BPF_JEQ | BPF_K, AUDIT_ARCH_X86_64, 1, 0));
+  prog.push_back(stmt(BPF_RET | BPF_K, SECCOMP_RET_ALLOW));
+
+  // Jump offsets are a byte, longer lists trap on everything
+  if (nrs.empty() || nrs.size() > UINT8_MAX) {
+    prog.push_back(stmt(BPF_RET | BPF_K, action));
+    return prog;
+  }
+
+  // One compare per number, a match skips the rest and the allow
+  prog.push_back(stmt(BPF_LD | BPF_W | BPF_ABS,
+                      offsetof(struct seccomp_data, nr)));
+  for (size_t i = 0; i < nrs.size(); i++)
+    prog.push_back(jump(BPF_JMP | BPF_JEQ | BPF_K, nrs[i],
+                        static_cast<u8>(nrs.size() - i), 0));
+  prog.push_back(stmt(BPF_RET | BPF_K, SECCOMP_RET_ALLOW));
+  prog.push_back(stmt(BPF_RET | BPF_K, action));
+  return prog;
+}
+
+void SyscallStats::add(u64 ns, bool failed) {
+  count++;
+  if (failed) errors++;
+  total_ns += ns;
+  max_ns = std::max(max_ns, ns);
+  const u64 us = ns / 1000;
+  // Bucket 0 is below 1us, bucket i covers [2^(i-1), 2^i) us
+  const size_t bucket = us == 0 ? 0 : std::bit_width(us);
+  histogram[std::min(bucket, BUCKETS - 1)]++;
+}
+
+void SyscallTracer::start(std::vector<u32> nrs, bool print) {
+  std::ranges::sort(nrs);
+  const auto [first, last] = std::ranges::unique(nrs);
+  nrs.erase(first, last);
+  m_selected = std::move(nrs);
+  m_print = print;
+  m_active = true;
+  m_stats.clear();
+}
+
+bool SyscallTracer::selected(u32 nr) const {
+  return m_selected.empty() || std::ranges::binary_search(m_selected, nr);
+}
+
+bool SyscallTracer::covered(std::span<const u32> nrs) const {
+  if (m_all_installed) return true;
+  if (nrs.empty()) return false;
+  return std::ranges::all_of(nrs, [this](u32 nr) {
+    return std::ranges::binary_search(m_installed, nr);
+  });
+}
+
+void SyscallTracer::installed(std::span<const u32> nrs) {
+  if (nrs.empty()) m_all_installed = true;
+  m_installed.insert(m_installed.end(), nrs.begin(), nrs.end());
+  std::ranges::sort(m_installed);
+  const auto [first, last] = std::ranges::unique(m_installed);
+  m_installed.erase(first, last);
+}
+
+void SyscallTracer::enter(i32 tid, u32 nr, std::string args) {
+  m_in_flight.insert_or_assign(
+      tid, Call{.nr = nr, .args = std::move(args), .start = Clock::now()});
+}
+
+std::optional<std::string> SyscallTracer::exit(i32 tid, i64 ret) {
+  const auto it = m_in_flight.find(tid);
+  if (it == m_in_flight.end()) return std::nullopt;
+  const Call call = std::move(it->second);
+  m_in_flight.erase(it);
+
+  const auto ns = static_cast<u64>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                           call.start)
+          .count());
+  m_stats[call.nr].add(ns, ret < 0 && ret >= -4095);
+  if (!m_print) return std::nullopt;
+
+  const SyscallDesc* desc = findSyscall(call.nr);
+  const std::string name =
+      desc != nullptr ? std::string{desc->name}
+                      : std::format("syscall_{}", call.nr);
+  return std::format("{}({}) {} <{:.6f}>", name, call.args,
+                     formatReturn(desc, ret), static_cast<double>(ns) / 1e9);
+}
+
+std::string SyscallTracer::summary() const {
+  if (m_stats.empty()) return "No syscalls recorded";
+
+  std::string res = std::format("{:<18} {:>9} {:>7} {:>12} {:>10} {:>10}\n",
+                                "syscall", "calls", "errors", "total us",
+                                "avg us", "max us");
+  for (const auto& [nr, stats] : m_stats) {
+    const SyscallDesc* desc = findSyscall(nr);
+    const std::string name =
+        desc != nullptr ? std::string{desc->name}
+                        : std::format("syscall_{}", nr);
+    res += std::format(
+        "{:<18} {:>9} {:>7} {:>12.1f} {:>10.1f} {:>10.1f}\n", name,
+        stats.count, stats.errors, static_cast<double>(stats.total_ns) / 1e3,
+        static_cast<double>(stats.total_ns) / 1e3 /
+            static_cast<double>(stats.count),
+        static_cast<double>(stats.max_ns) / 1e3);
+
+    // Only the buckets that were hit, labelled with their upper bound
+    res += "  ";
+    for (size_t i = 0; i < stats.histogram.size(); i++) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+      if (stats.histogram[i] == 0) continue;
+      const std::string bound = i + 1 == SyscallStats::BUCKETS
+                                    ? "inf"
+                                    : std::format("{}us", u64{1} << i);
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+      res += std::format(" <{}: {}", bound, stats.histogram[i]);
+    }
+    res += '\n';
+  }
+  res.pop_back();
+  return res;
+}
+
+std::string formatReturn(const SyscallDesc* desc, i64 ret) {
+  if (ret < 0 && ret >= -4095) {
+    const char* name = strerrorname_np(static_cast<int>(-ret));
+    return std::format("= -1 {}", name != nullptr ? name : "E?");
+  }
+  if (desc != nullptr && std::ranges::find(RETURNS_POINTER, desc->nr) !=
+                             RETURNS_POINTER.end())
+    return std::format("= {:#x}", static_cast<u64>(ret));
+  return std::format("= {}", ret);
+}
@@ -0,0 +1,103 @@
+#ifndef CAESAR_SYSCALLS_HPP
+#define CAESAR_SYSCALLS_HPP
+
+#include <linux/filter.h>
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "typedefs.hpp"
+
+// How an argument is shown, INT is a C int and LONG a 64-bit count or
+// offset. STR is read from the target as a C string and BUF as a byte string
+// whose length is the next argument
+enum class ArgKind : u8 { INT, LONG, HEX, STR, BUF };
+
+struct SyscallDesc {
+  std::string_view name;
+  u32 nr;
+  u8 argc;
+  std::array<ArgKind, 6> args;
+};
+
+// Syscalls known by name, x86-64 numbering
+std::span<const SyscallDesc> syscallTable();
+const SyscallDesc* findSyscall(std::string_view name);
+const SyscallDesc* findSyscall(u32 nr);
+
+// Seccomp program returning action for every syscall in nrs and allowing
+// everything else. Empty nrs matches every syscall
+std::vector<sock_filter> buildSyscallFilter(std::span<const u32> nrs,
+                                            u32 action);
+
+// Counts and latency of one syscall, the histogram is in power of two
+// microsecond buckets, the last one taking everything longer
+struct SyscallStats {
+  static constexpr size_t BUCKETS = 24;
+
+  u64 count = 0;
+  u64 errors = 0;
+  u64 total_ns = 0;
+  u64 max_ns = 0;
+  std::array<u64, BUCKETS> histogram{};
+
+  void add(u64 ns, bool failed);
+};
+
+// Pairs the entry and exit stops of traced syscalls per thread and keeps
+// the statistics. Seccomp filters cannot be removed, so the numbers every
+// installed filter traps on are remembered and stopping only ignores them
+class SyscallTracer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // Empty nrs traces every syscall, print reports each call as it returns
+  void start(std::vector<u32> nrs, bool print);
+  void stop() { m_active = false; }
+  [[nodiscard]] bool active() const { return m_active; }
+  [[nodiscard]] bool selected(u32 nr) const;
+  // Whether a filter trapping on all of nrs is already in place
+  [[nodiscard]] bool covered(std::span<const u32> nrs) const;
+  void installed(std::span<const u32> nrs);
+  // Whether a filter was ever installed, they cannot be removed again
+  [[nodiscard]] bool filtering() const {
+    return m_all_installed || !m_installed.empty();
+  }
+
+  // Entry of a selected syscall, args already formatted
+  void enter(i32 tid, u32 nr, std::string args);
+  // Exit of the call tid entered, the line to print or nullopt
+  std::optional<std::string> exit(i32 tid, i64 ret);
+  [[nodiscard]] bool inFlight(i32 tid) const {
+    return m_in_flight.contains(tid);
+  }
+  void forget(i32 tid) { m_in_flight.erase(tid); }
+  [[nodiscard]] std::string summary() const;
+
+ private:
+  struct Call {
+    u32 nr;
+    std::string args;
+    Clock::time_point start;
+  };
+
+  bool m_active = false;
+  bool m_print = false;
+  std::vector<u32> m_selected;  // Sorted, empty for every syscall
+  bool m_all_installed = false;
+  std::vector<u32> m_installed;  // Sorted
+  std::unordered_map<i32, Call> m_in_flight;
+  std::map<u32, SyscallStats> m_stats;
+};
+
+// "= 3", "= -1 ENOENT" or a pointer for mmap like calls
+std::string formatReturn(const SyscallDesc* desc, i64 ret);
+
+#endif  // CAESAR_SYSCALLS_HPP
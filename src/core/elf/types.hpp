@@ -0,0 +1,69 @@
+#ifndef CAESAR_ELF_TYPES_H
+#define CAESAR_ELF_TYPES_H
+
+#include <array>
+
+#include "typedefs.hpp"
+
+// Layout of user_regs_struct, NT_PRSTATUS is read straight into it
+struct LinuxX86ThreadState64T {
+  u64 r15;
+  u64 r14;
+  u64 r13;
+  u64 r12;
+  u64 rbp;
+  u64 rbx;
+  u64 r11;
+  u64 r10;
+  u64 r9;
+  u64 r8;
+  u64 rax;
+  u64 rcx;
+  u64 rdx;
+  u64 rsi;
+  u64 rdi;
+  u64 orig_rax;
+  u64 rip;
+  u64 cs;
+  u64 rflags;
+  u64 rsp;
+  u64 ss;
+  u64 fs_base;
+  u64 gs_base;
+  u64 ds;
+  u64 es;
+  u64 fs;
+  u64 gs;
+};
+
+// Layout of user_pt_regs, with x29, x30 and pstate named like the Mach state
+struct LinuxArmThreadState64T {
+  std::array<u64, 29> x;
+  u64 fp;
+  u64 lr;
+  u64 sp;
+  u64 pc;
+  u64 cpsr;
+};
+
+// FXSAVE area, the layout of user_fpregs_struct and NT_PRFPREG
+struct X86FloatState64T {
+  u16 fcw;
+  u16 fsw;
+  u16 ftw;
+  u16 fop;
+  u64 fip;
+  u64 fdp;
+  u32 mxcsr;
+  u32 mxcsr_mask;
+  std::array<u64, 16> st;   // st0-st7, 16 bytes each
+  std::array<u64, 32> xmm;  // xmm0-xmm15, 16 bytes each
+  std::array<u32, 24> pad;
+};
+
+// DR0-DR7, DR4 and DR5 are reserved
+struct X86DebugState64T {
+  std::array<u64, 8> dr;
+};
+
+#endif
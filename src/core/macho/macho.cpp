@@ -21,6 +21,7 @@
 #include <mach/machine.h>
 #include <mach/message.h>
 #include <mach/mig_errors.h>
+#include <mach/notify.h>
 #include <mach/port.h>
 #include <mach/task.h>
 #include <mach/task_info.h>
@@ -39,6 +40,7 @@
 #include <unistd.h>
 
 #include <cassert>
+#include <cerrno>
 #include <core/context.hpp>
 #include <core/util.hpp>
 #include <csignal>
@@ -46,7 +48,8 @@
 #include <error.hpp>
 #include <iostream>
 #include <macho/ports.hpp>
-#include <stdexcept>
+#include <unordered_set>
+#include <utility>
 
 #include "platform.hpp"
 #include "target.hpp"
@@ -55,6 +58,36 @@ extern "C" {
 #include "mach_excServer.h"
 }
 
+namespace {
+// ARM64 instructions whose result depends on where they execute
+bool isPcRelative(u32 ins) {
+  return (ins & 0x7C000000) == 0x14000000 ||  // B, BL
+         (ins & 0xFF000010) == 0x54000000 ||  // B.cond
+         (ins & 0x7E000000) == 0x34000000 ||  // CBZ, CBNZ
+         (ins & 0x7E000000) == 0x36000000 ||  // TBZ, TBNZ
+         (ins & 0x1F000000) == 0x10000000 ||  // ADR, ADRP
+         (ins & 0x3B000000) == 0x18000000 ||  // LDR (literal)
+         (ins & 0xFE000000) == 0xD6000000;    // BR, BLR, RET
+}
+
+struct StateFlavour {
+  thread_state_flavor_t flavour;
+  mach_msg_type_number_t count;
+};
+
+StateFlavour stateFlavour(RegGroup group) {
+  switch (group) {
+    case RegGroup::FP:
+      return {Macho::FLOAT_FLAVOUR, Macho::FLOAT_STATE_COUNT};
+    case RegGroup::DEBUG:
+      return {Macho::DEBUG_FLAVOUR, Macho::DEBUG_STATE_COUNT};
+    default:
+      return {Macho::THREAD_FLAVOUR, Macho::THREAD_STATE_COUNT};
+  }
+}
+
+}  // namespace
+
 // Adapted from https://lowlevelbits.org/parsing-mach-o-files/
 
 void Macho::readMagic() {
@@ -172,54 +205,40 @@ i32 Macho::attach() {
 };
 
 // TODO: Make an overload with u32 for 32bit systems
-i32 Macho::setBreakpoint(u64 addr) {
-  const u64 actual = addr + m_aslr_slide;
-  auto sz = static_cast<mach_msg_type_number_t>(sizeof(u32));
-  vm_offset_t origBuf = 0;
-  kern_return_t kr = mach_vm_read(m_task, actual, sizeof(u32), &origBuf, &sz);
-  if (kr != KERN_SUCCESS) {
-    CoreError::error(
-        std::format("Error reading memory: {}!\n", mach_error_string(kr)));
-    return -1;
-  }
+// TODO: brk #0, switch to brk #1, #2... to distinguish different breakpoints
+i32 Macho::setBreakpoint(u64 addr) { return setBreakpoints({&addr, 1}); }
 
-  const u32 origIns = *reinterpret_cast<u32*>(origBuf);
-  mach_vm_deallocate(mach_task_self(), origBuf, sizeof(u32));
-  m_breakpoints[addr] = {.orig_ins = origIns, .enabled = true};
-
-  // TODO: This is arm64 only
-  // TODO: brk #0, switch to brk #1, #2... to distinguish different breakpoints
-  u32 brk = 0xD4200000;
-
-  kr = mach_vm_protect(m_task, actual, sizeof(u32), FALSE,
-                       VM_PROT_READ | VM_PROT_WRITE | VM_PROT_COPY);
-  if (kr != KERN_SUCCESS) {
-    CoreError::error(std::format("Error changing memory protection: {}!\n",
-                                 mach_error_string(kr)));
-    return -1;
-  }
-
-  kr = mach_vm_write(m_task, actual, reinterpret_cast<vm_offset_t>(&brk),
-                     sizeof(u32));
-  if (kr != KERN_SUCCESS) {
-    CoreError::error(
-        std::format("Error writing memory: {}!\n", mach_error_string(kr)));
+i32 Macho::detach() {
+  if (m_state == TargetState::RUNNING) {
+    CoreError::error("Target must be stopped to detach!");
     return -1;
   }
 
-  kr = mach_vm_protect(m_task, actual, sizeof(u32), FALSE,
-                       VM_PROT_READ | VM_PROT_EXECUTE);
-  if (kr != KERN_SUCCESS) {
-    CoreError::error(std::format("Error re-protecting memory: {}!\n",
-                                 mach_error_string(kr)));
+  std::vector<u64> addrs{};
+  addrs.reserve(m_breakpoints.size());
+  for (const auto& [addr, bp] : m_breakpoints) addrs.push_back(addr);
+  disableBreakpoints(addrs, true);
+  m_breakpoints.clear();
+  // Nothing is stepped over anymore, the pc was already moved back onto the
+  // original instruction when the trap was reported
+  m_pending_step.reset();
+  for (auto& [tid, thread] : m_threads) storeRegisters(thread);
+
+  if (ptrace(PT_DETACH, m_pid, reinterpret_cast<caddr_t>(1), 0) != 0) {
+    CoreError::error(std::format("PT_DETACH failed: {}", strerror(errno)));
     return -1;
   }
-
+  // Exceptions go back to the default handlers once the port is gone
+  mach_port_mod_refs(mach_task_self(), m_exc_port, MACH_PORT_RIGHT_RECEIVE,
+                     -1);
+  m_exc_port = 0;
+  task_resume(m_task);
+
+  m_threads.clear();
+  m_started = false;
   return 0;
 }
 
-void Macho::detach() { throw std::runtime_error("unimplemented"); }
-
 i32 Macho::setupExceptionPorts() {
   i32 res = 0;
   MachExcPorts savedPorts{};
@@ -262,6 +281,18 @@ i32 Macho::setupExceptionPorts() {
     res = -1;
   }
 
+  // Have the kernel tell the exception port when the task dies, so exits are
+  // noticed without polling waitpid
+  mach_port_t prevNotify = MACH_PORT_NULL;
+  kr = mach_port_request_notification(mach_task_self(), m_task,
+                                      MACH_NOTIFY_DEAD_NAME, 0, m_exc_port,
+                                      MACH_MSG_TYPE_MAKE_SEND_ONCE, &prevNotify);
+
+  if (kr != KERN_SUCCESS) {
+    CoreError::error(mach_error_string(kr));
+    res = -1;
+  }
+
   return res;
 }
 
@@ -273,23 +304,28 @@ void Macho::eventLoop() {
   auto* msg = reinterpret_cast<mach_msg_header_t*>(&msgBuf);
   auto* rpl = reinterpret_cast<mach_msg_header_t*>(&rplBuf);
 
+  // Blocks until either an exception or the task's dead-name notification
+  // (requested in setupExceptionPorts) arrives, so there is nothing to poll
   while (m_state == TargetState::RUNNING) {
-    ret = mach_msg(msg, MACH_RCV_MSG | MACH_RCV_TIMEOUT, 0,
-                   sizeof(__RequestUnion__mach_exc_subsystem), m_exc_port, 100,
-                   MACH_PORT_NULL);
-    if (ret == MACH_RCV_TIMED_OUT) {
+    ret = mach_msg(msg, MACH_RCV_MSG, 0,
+                   sizeof(__RequestUnion__mach_exc_subsystem), m_exc_port,
+                   MACH_MSG_TIMEOUT_NONE, MACH_PORT_NULL);
+    assert(ret == MACH_MSG_SUCCESS && "Did not receive mach message");
+
+    if (msg->msgh_id == MACH_NOTIFY_DEAD_NAME) {
+      const auto* notification =
+          reinterpret_cast<mach_dead_name_notification_t*>(msg);
+      mach_port_deallocate(mach_task_self(), notification->not_port);
+
       int status = 0;
-      if (waitpid(m_pid, &status, WNOHANG) > 0) {
-        m_state = TargetState::EXITED;
-        if (WIFEXITED(status))
-          std::cout << "Target exited with code " << WEXITSTATUS(status)
-                    << '\n';
-        else if (WIFSIGNALED(status))
-          std::cout << "Target killed with signal " << WTERMSIG(status) << '\n';
-      }
+      waitpid(m_pid, &status, 0);
+      if (WIFEXITED(status))
+        std::cout << "Target exited with code " << WEXITSTATUS(status) << '\n';
+      else if (WIFSIGNALED(status))
+        std::cout << "Target killed with signal " << WTERMSIG(status) << '\n';
+      setTargetState(TargetState::EXITED);
       continue;
     }
-    assert(ret == MACH_MSG_SUCCESS && "Did not receive mach message");
 
     mach_exc_server(msg, rpl);
 
@@ -351,49 +387,131 @@ kern_return_t catch_mach_exception_raise_state_identity(
 #pragma unused(newStateCnt)
 #pragma unused(flavour)
   auto& target = Context::getTarget();
-  target->setTargetState(TargetState::STOPPED);
-
-  task_suspend(task);
-
   auto* macho = dynamic_cast<Macho*>(Context::getTarget().get());
   auto* oldArmState = reinterpret_cast<ThreadState*>(oldState);
   auto* newArmState = reinterpret_cast<ThreadState*>(newState);
 
   memcpy(newArmState, oldArmState, sizeof(ThreadState));
+  *newStateCnt = oldStateCnt;
 
-  std::cout << Macho::exceptionReason(exc, codeCnt, code);
-  std::cout << macho->formatRegisterOutput(oldArmState);
-
-  if (macho->getThreadPort() == 0) macho->setThreadPort(thread);
+  // A step-over always re-arms its trap, only its own step exception is
+  // swallowed
+  if (macho->finishStepOver(thread, *newArmState) && exc == EXC_BREAKPOINT)
+    return KERN_SUCCESS;
 
+  // Conditions and tracepoints are handled here, before anything is printed
+  // or suspended, and step over the trap without stopping
   if (exc == EXC_BREAKPOINT) {
-    macho->restorePrevIns(oldArmState->pc - macho->getAslrSlide());
+    const u64 addr = oldArmState->pc - macho->getAslrSlide();
+    macho->threadStopped(thread, *oldArmState, false);
+    if (!macho->breakpointHit(addr)) {
+      macho->beginStepOver(thread, addr, *newArmState);
+      return KERN_SUCCESS;
+    }
   }
 
-  macho->setThreadState(newArmState);
-  *newStateCnt = oldStateCnt;
+  target->setTargetState(TargetState::STOPPED);
+  task_suspend(task);
+
+  macho->threadStopped(thread, *oldArmState, true);
+  std::string reason = Macho::exceptionReason(exc, codeCnt, code);
+  macho->getThreads().find(static_cast<i32>(thread))->stop_reason =
+      reason.substr(0, reason.find('\n'));
+  if (macho->getThreads().size() > 1)
+    std::cout << std::format("Thread {} ", thread);
+  std::cout << reason;
+  std::cout << macho->formatRegisterOutput(oldArmState);
+
+  if (exc == EXC_BREAKPOINT)
+    macho->setPendingStepOver(thread,
+                              oldArmState->pc - macho->getAslrSlide());
   return KERN_SUCCESS;
 }
 
 }  // extern "C"
 
-mach_port_t Macho::threadSelect() const {
-  std::cout << "TASK: " << m_task << '\n';
+void Macho::threadStopped(mach_port_t thread, const ThreadState& state,
+                          bool refresh) {
+  m_exc_thread = thread;
+  if (refresh) refreshThreads();
+  ThreadInfo& info = m_threads.add(static_cast<i32>(thread));
+  m_threads.select(info.tid);
+  info.regs = state;
+  info.valid = groupBit(RegGroup::GPR);
+  info.dirty = 0;
+}
+
+void Macho::refreshThreads() {
   thread_act_array_t acts{};
   mach_msg_type_number_t numThreads = 0;
-
   const kern_return_t kr = task_threads(m_task, &acts, &numThreads);
-
   if (kr != KERN_SUCCESS) {
-    std::cout << "task_threads fail!\n";
     CoreError::error(mach_error_string(kr));
+    return;
   }
 
-  const thread_act_t mainThread = acts[0];  // Cleanup
+  std::unordered_set<i32> alive{};
+  for (mach_msg_type_number_t i = 0; i < numThreads; i++) {
+    const auto tid = static_cast<i32>(acts[i]);
+    alive.insert(tid);
+    // One send right per known thread is enough
+    if (m_threads.contains(tid))
+      mach_port_deallocate(mach_task_self(), acts[i]);
+    ThreadInfo& thread = m_threads.add(tid);
+    thread.running = false;
+    thread.valid = 0;
+  }
   vm_deallocate(mach_task_self(), reinterpret_cast<vm_address_t>(acts),
                 numThreads * sizeof(thread_act_t));
 
-  return mainThread;
+  for (const i32 tid : m_threads.tids()) {
+    if (alive.contains(tid)) continue;
+    mach_port_deallocate(mach_task_self(), static_cast<mach_port_t>(tid));
+    m_threads.remove(tid);
+  }
+}
+
+i32 Macho::fetchRegisters(ThreadInfo& thread, RegGroup group) {
+  const auto [flavour, stateCount] = stateFlavour(group);
+  mach_msg_type_number_t count = stateCount;
+  const kern_return_t kr = thread_get_state(
+      static_cast<mach_port_t>(thread.tid), flavour,
+      reinterpret_cast<thread_state_t>(thread.group(group).data()), &count);
+  if (kr != KERN_SUCCESS) {
+    CoreError::error(mach_error_string(kr));
+    return -1;
+  }
+  thread.valid |= groupBit(group);
+  return 0;
+}
+
+i32 Macho::storeRegisters(ThreadInfo& thread) {
+  for (size_t i = 0; i < REG_GROUPS; i++) {
+    const auto group = static_cast<RegGroup>(i);
+    if (!thread.isDirty(group)) continue;
+    const auto [flavour, count] = stateFlavour(group);
+    const kern_return_t kr = thread_set_state(
+        static_cast<mach_port_t>(thread.tid), flavour,
+        reinterpret_cast<thread_state_t>(thread.group(group).data()), count);
+    if (kr != KERN_SUCCESS) {
+      CoreError::error(mach_error_string(kr));
+      return -1;
+    }
+  }
+  thread.dirty = 0;
+  return 0;
+}
+
+ThreadState& Macho::threadRegs(ThreadInfo& thread) {
+  if (!thread.has(RegGroup::GPR) && !thread.running) fetchRegisters(thread);
+  return thread.regs;
+}
+
+std::span<std::byte> Macho::registerGroup(RegGroup group) {
+  ThreadInfo* thread = m_threads.selected();
+  if (thread == nullptr || thread->running) return {};
+  if (!thread->has(group) && fetchRegisters(*thread, group) != 0) return {};
+  return thread->group(group);
 }
 
 void Macho::resume(ResumeType cond) {
@@ -401,11 +519,26 @@ void Macho::resume(ResumeType cond) {
     std::cerr << "Target is not running!\n";
     return;
   }
+  m_page_cache.invalidate();
+
+  // Still sitting on the trap of the last stop, unless pc was moved
+  ThreadInfo* stepping = m_threads.find(static_cast<i32>(m_pending_thread));
+  if (const auto addr = std::exchange(m_pending_step, std::nullopt);
+      addr && stepping != nullptr &&
+      threadRegs(*stepping).pc == *addr + m_aslr_slide) {
+    ThreadState& state = stepping->regs;
+    const u64 pc = state.pc;
+    if (beginStepOver(m_pending_thread, *addr, state) == 0 && state.pc != pc)
+      stepping->markDirty(RegGroup::GPR);
+  }
+  for (auto& [tid, thread] : m_threads) storeRegisters(thread);
 
   switch (cond) {
     case ResumeType::RESUME:
+      for (auto& [tid, thread] : m_threads) thread.running = true;
+      m_threads.invalidate();
       ptrace(PT_THUPDATE, m_pid,
-             reinterpret_cast<caddr_t>(static_cast<uintptr_t>(m_thread_port)),
+             reinterpret_cast<caddr_t>(static_cast<uintptr_t>(m_exc_thread)),
              0);
       ptrace(PT_CONTINUE, m_pid, reinterpret_cast<caddr_t>(1), 0);
       task_resume(m_task);
@@ -569,81 +702,172 @@ void Macho::readAslrSlideFromRegions() {
 u64& Macho::getAslrSlide() { return m_aslr_slide; }
 
 i32 Macho::restorePrevIns(u64 k) {
-  const u64 addr = k + m_aslr_slide;
+  const Breakpoint* bp = m_breakpoints.find(k);
+  if (bp == nullptr) return -1;
 
-  kern_return_t kr =
-      mach_vm_protect(m_task, addr, sizeof(u32), FALSE,
-                      VM_PROT_READ | VM_PROT_WRITE | VM_PROT_COPY);
-  if (kr != KERN_SUCCESS) {
-    CoreError::error(std::format("Error changing memory protection: {}!\n",
-                                 mach_error_string(kr)));
-    return -1;
-  }
+  return writeMemory(k + m_aslr_slide,
+                     std::as_bytes(std::span{&bp->orig_ins, 1}));
+}
 
-  kr = mach_vm_write(m_task, addr,
-                     reinterpret_cast<vm_offset_t>(&m_breakpoints[k].orig_ins),
-                     sizeof(u32));
+void Macho::setPendingStepOver(mach_port_t thread, u64 addr) {
+  if (!m_breakpoints.contains(addr)) return;
+  m_pending_step = addr;
+  m_pending_thread = thread;
+}
 
-  if (kr != KERN_SUCCESS) {
-    CoreError::error(
-        std::format("mach_vm_write error in Macho::restorePrevIns(): {}\n",
-                    mach_error_string(kr)));
-    return -1;
+i32 Macho::setSingleStep(mach_port_t thread, bool enable) {
+  arm_debug_state64_t dbg{};
+  mach_msg_type_number_t count = ARM_DEBUG_STATE64_COUNT;
+  kern_return_t kr =
+      thread_get_state(thread, ARM_DEBUG_STATE64,
+                       reinterpret_cast<thread_state_t>(&dbg), &count);
+  if (kr == KERN_SUCCESS) {
+    // MDSCR_EL1.SS, the thread traps again after one instruction
+    if (enable)
+      dbg.__mdscr_el1 |= 1;
+    else
+      dbg.__mdscr_el1 &= ~u64{1};
+    kr = thread_set_state(thread, ARM_DEBUG_STATE64,
+                          reinterpret_cast<thread_state_t>(&dbg),
+                          ARM_DEBUG_STATE64_COUNT);
   }
 
-  kr = mach_vm_protect(m_task, addr, sizeof(u32), FALSE,
-                       VM_PROT_READ | VM_PROT_EXECUTE);
   if (kr != KERN_SUCCESS) {
-    CoreError::error(std::format("Error re-protecting memory: {}!\n",
+    CoreError::error(std::format("Could not set single-step: {}",
                                  mach_error_string(kr)));
     return -1;
   }
   return 0;
 }
 
-i32 Macho::disableBreakpoint(u64 addr, bool remove) {
-  auto& bp = m_breakpoints[addr];
+i32 Macho::prepareScratch(u32 ins) {
+  if (m_scratch == 0) {
+    kern_return_t kr = mach_vm_allocate(m_task, &m_scratch, vm_page_size,
+                                        VM_FLAGS_ANYWHERE);
+    if (kr == KERN_SUCCESS)
+      kr = mach_vm_protect(m_task, m_scratch, vm_page_size, FALSE,
+                           VM_PROT_READ | VM_PROT_EXECUTE);
+    if (kr != KERN_SUCCESS) {
+      CoreError::error(std::format("Could not map displaced step page: {}",
+                                   mach_error_string(kr)));
+      m_scratch = 0;
+      return -1;
+    }
+  }
+  return writeMemory(m_scratch, std::as_bytes(std::span{&ins, 1}));
+}
 
-  if (!bp.enabled) return 0;
+i32 Macho::beginStepOver(mach_port_t thread, u64 addr, ThreadState& state) {
+  const Breakpoint* bp = m_breakpoints.find(addr);
+  if (bp == nullptr || !bp->enabled) return 0;
 
-  const i32 res = this->restorePrevIns(addr);
-  if (res != 0) return 1;
+  // Anything reading pc has to run in place, everything else runs from the
+  // scratch page and the trap never leaves the text
+  m_step_displaced = m_step_mode == StepMode::DISPLACED &&
+                     !isPcRelative(bp->orig_ins) &&
+                     prepareScratch(bp->orig_ins) == 0;
+  if (!m_step_displaced && restorePrevIns(addr) != 0) return -1;
 
-  if (remove)
-    m_breakpoints.erase(addr);
-  else
-    bp.enabled = false;
+  if (setSingleStep(thread, true) != 0) {
+    if (!m_step_displaced)
+      writeMemory(addr + m_aslr_slide, {trapIns.data(), trapIns.size()});
+    return -1;
+  }
 
+  if (m_step_displaced) state.pc = m_scratch;
+  m_step_over = addr;
+  m_step_thread = thread;
   return 0;
 }
 
-void Macho::setThreadState(ThreadState* state) {
-  memcpy(&m_last_thread_state, state, sizeof(ThreadState));
+bool Macho::finishStepOver(mach_port_t thread, ThreadState& state) {
+  if (!m_step_over || thread != m_step_thread) return false;
+  const u64 addr = *std::exchange(m_step_over, std::nullopt);
+  setSingleStep(thread, false);
+
+  if (m_step_displaced) {
+    // Fixed width and never a branch, so the step always lands right after
+    if (state.pc == m_scratch + sizeof(u32))
+      state.pc = addr + m_aslr_slide + sizeof(u32);
+    return true;
+  }
+
+  const Breakpoint* bp = m_breakpoints.find(addr);
+  if (bp != nullptr && bp->enabled)
+    writeMemory(addr + m_aslr_slide, {trapIns.data(), trapIns.size()});
+  return true;
 }
 
-ThreadState& Macho::getLastKnownThreadState() { return m_last_thread_state; }
+i32 Macho::disableBreakpoint(u64 addr, bool remove) {
+  return disableBreakpoints({&addr, 1}, remove) == 0 ? 0 : 1;
+}
 
-u64 Macho::writeRegValue(const RegEntryT& regEntry, u64 val) {
-  auto* ptr = reinterpret_cast<u8*>(&m_last_thread_state) + regEntry.offset;
+void Macho::setThreadState(ThreadState* state) {
+  ThreadInfo* thread = m_threads.selected();
+  if (thread == nullptr) return;
+  memcpy(&thread->regs, state, sizeof(ThreadState));
+  thread->valid |= groupBit(RegGroup::GPR);
+  thread->markDirty(RegGroup::GPR);
+}
 
-  if (regEntry.size == 8) {
-    auto* reg = reinterpret_cast<u64*>(ptr);
-    *reg = val;
-  } else {
-    auto* reg = reinterpret_cast<u32*>(ptr);
-    *reg = val;
+ThreadState& Macho::getLastKnownThreadState() {
+  ThreadInfo* thread = m_threads.selected();
+  return thread != nullptr ? threadRegs(*thread) : m_no_thread;
+}
+
+i32 Macho::readMemory(u64 addr, std::span<std::byte> out) {
+  // Reads straight into the caller's buffer instead of a vm_allocate'd copy
+  mach_vm_size_t outSize = 0;
+  const kern_return_t kr = mach_vm_read_overwrite(
+      m_task, addr, out.size(), reinterpret_cast<mach_vm_address_t>(out.data()),
+      &outSize);
+  if (kr != KERN_SUCCESS || outSize != out.size()) {
+    CoreError::error(std::format("Error reading {} bytes at {}: {}!",
+                                 out.size(), detail::toHex(addr),
+                                 mach_error_string(kr)));
+    return -1;
   }
+  return 0;
+}
 
-  const kern_return_t kr =
-      thread_set_state(m_thread_port, Macho::THREAD_FLAVOUR,
-                       reinterpret_cast<thread_state_t>(&m_last_thread_state),
-                       Macho::THREAD_STATE_COUNT);
+i32 Macho::writeMemory(u64 addr, std::span<const std::byte> in) {
+  m_page_cache.invalidate();
+  const auto data = reinterpret_cast<vm_offset_t>(in.data());
+  const auto size = static_cast<mach_msg_type_number_t>(in.size());
+  if (mach_vm_write(m_task, addr, data, size) == KERN_SUCCESS) return 0;
+
+  // Read-only mapping (text), make a writable copy and put the original
+  // protection back afterwards
+  mach_vm_address_t regionAddr = addr;
+  mach_vm_size_t regionSize = 0;
+  vm_region_basic_info_data_64_t info{};
+  mach_msg_type_number_t infoCount = VM_REGION_BASIC_INFO_COUNT_64;
+  mach_port_t objectName = MACH_PORT_NULL;
+  kern_return_t kr = mach_vm_region(
+      m_task, &regionAddr, &regionSize, VM_REGION_BASIC_INFO_64,
+      reinterpret_cast<vm_region_info_t>(&info), &infoCount, &objectName);
+  if (kr != KERN_SUCCESS) {
+    CoreError::error(std::format("Error querying region at {}: {}!",
+                                 detail::toHex(addr), mach_error_string(kr)));
+    return -1;
+  }
 
+  kr = mach_vm_protect(m_task, addr, in.size(), FALSE,
+                       VM_PROT_READ | VM_PROT_WRITE | VM_PROT_COPY);
   if (kr != KERN_SUCCESS) {
-    std::cout << "thread_set_state fail!\n";
-    CoreError::error(mach_error_string(kr));
+    CoreError::error(std::format("Error changing memory protection: {}!",
+                                 mach_error_string(kr)));
     return -1;
   }
 
+  kr = mach_vm_write(m_task, addr, data, size);
+  const kern_return_t restore =
+      mach_vm_protect(m_task, addr, in.size(), FALSE, info.protection);
+  if (kr != KERN_SUCCESS || restore != KERN_SUCCESS) {
+    CoreError::error(std::format(
+        "Error writing {} bytes at {}: {}!", in.size(), detail::toHex(addr),
+        mach_error_string(kr != KERN_SUCCESS ? kr : restore)));
+    return -1;
+  }
   return 0;
 }
@@ -12,6 +12,7 @@
 #include <mach/thread_status.h>
 
 #include <fstream>
+#include <optional>
 #include <string>
 
 #include "core/platform.hpp"
@@ -31,12 +32,24 @@ class Macho final : public Target {
   static constexpr thread_state_flavor_t THREAD_FLAVOUR = ARM_THREAD_STATE64;
   static constexpr mach_msg_type_number_t THREAD_STATE_COUNT =
       ARM_THREAD_STATE64_COUNT;
+  static constexpr thread_state_flavor_t FLOAT_FLAVOUR = ARM_NEON_STATE64;
+  static constexpr mach_msg_type_number_t FLOAT_STATE_COUNT =
+      ARM_NEON_STATE64_COUNT;
+  static constexpr thread_state_flavor_t DEBUG_FLAVOUR = ARM_DEBUG_STATE64;
+  static constexpr mach_msg_type_number_t DEBUG_STATE_COUNT =
+      ARM_DEBUG_STATE64_COUNT;
 #endif
 
-#ifdef __i386__
+#ifdef __x86_64__
   static constexpr thread_state_flavor_t THREAD_FLAVOUR = X86_THREAD_STATE64;
   static constexpr mach_msg_type_number_t THREAD_STATE_COUNT =
       X86_THREAD_STATE64_COUNT;
+  static constexpr thread_state_flavor_t FLOAT_FLAVOUR = X86_FLOAT_STATE64;
+  static constexpr mach_msg_type_number_t FLOAT_STATE_COUNT =
+      X86_FLOAT_STATE64_COUNT;
+  static constexpr thread_state_flavor_t DEBUG_FLAVOUR = X86_DEBUG_STATE64;
+  static constexpr mach_msg_type_number_t DEBUG_STATE_COUNT =
+      X86_DEBUG_STATE64_COUNT;
 #endif
 
   void dumpHeader(int offset) override;
@@ -44,30 +57,46 @@ class Macho final : public Target {
   i32 setBreakpoint(u64 addr) override;
   i32 disableBreakpoint(u64 addr, bool remove) override;
   i32 launch(detail::CStringArray& argList) override;
-  void detach() override;
+  i32 detach() override;
   void eventLoop() override;
   void resume(ResumeType cond) override;
   void setThreadState(ThreadState* state) override;
   ThreadState& getLastKnownThreadState() override;
-  u64 writeRegValue(const RegEntryT& regEntry, u64 val) override;
+  std::span<std::byte> registerGroup(RegGroup group) override;
+  i32 readMemory(u64 addr, std::span<std::byte> out) override;
+  i32 writeMemory(u64 addr, std::span<const std::byte> in) override;
 
   static std::string exceptionReason(exception_type_t exc,
                                      mach_msg_type_number_t codeCnt,
                                      mach_exception_data_t code);
-  void setThreadPort(mach_port_t thread) { m_thread_port = thread; }
-  mach_port_t& getThreadPort() { return m_thread_port; }
+  // Makes thread the selected one with the state its exception carried.
+  // refresh re-reads the thread list, skipped for stops that are not shown
+  void threadStopped(mach_port_t thread, const ThreadState& state,
+                     bool refresh);
   void readAslrSlide();
   u64& getAslrSlide();
   i32 restorePrevIns(u64 k);
+  // Starts stepping thread over the breakpoint at addr, state is updated with
+  // the pc to resume at. The trap is re-armed by finishStepOver
+  i32 beginStepOver(mach_port_t thread, u64 addr, ThreadState& state);
+  // True when the exception is the single-step of a step-over
+  bool finishStepOver(mach_port_t thread, ThreadState& state);
+  // Remembers the breakpoint a reported stop happened on for the next resume
+  void setPendingStepOver(mach_port_t thread, u64 addr);
 
  private:
   task_t m_task = 0;
-  u64 m_aslr_slide = 0;
   u32 m_magic = 0;
   mach_port_t m_exc_port = 0;
-  mach_port_t m_thread_port = 0;
+  mach_port_t m_exc_thread = 0;  // Took the last exception
   bool m_is_swap = false;
-  ThreadState m_last_thread_state{};
+  ThreadState m_no_thread{};  // Handed out before launch
+  std::optional<u64> m_pending_step;  // Stopped on this breakpoint
+  mach_port_t m_pending_thread = 0;
+  std::optional<u64> m_step_over;  // Currently being stepped over
+  mach_port_t m_step_thread = 0;
+  bool m_step_displaced = false;
+  mach_vm_address_t m_scratch = 0;  // Executable page for displaced steps
   static constexpr std::array<CpuTypeNames, 4> CPU_TYPE_NAMES = {
       {{.cpu_type = CPU_TYPE_I386, .cpu_name = "i386"},
        {.cpu_type = CPU_TYPE_X86_64, .cpu_name = "x86_64"},
@@ -93,7 +122,14 @@ class Macho final : public Target {
   void dumpSections(u32 offset, u32 end);
   i32 setupExceptionPorts();
   void readAslrSlideFromRegions();
-  mach_port_t threadSelect() const;  // TODO: doesn't work (yet)
+  // Syncs m_threads with task_threads, new threads start without registers
+  void refreshThreads();
+  i32 fetchRegisters(ThreadInfo& thread, RegGroup group = RegGroup::GPR);
+  // Writes back every dirty group, one thread_set_state each
+  i32 storeRegisters(ThreadInfo& thread);
+  ThreadState& threadRegs(ThreadInfo& thread);
+  static i32 setSingleStep(mach_port_t thread, bool enable);
+  i32 prepareScratch(u32 ins);
 };
 
 #endif  // CAESAR_MACHO_HPP
@@ -1,6 +1,8 @@
 #ifndef CAESAR_MACHO_TYPES_H
 #define CAESAR_MACHO_TYPES_H
 
+#include <array>
+
 #include "typedefs.hpp"
 
 struct X86ThreadState64T {
@@ -27,6 +29,28 @@ struct X86ThreadState64T {
   u64 gs;
 };
 
+// x86_float_state64_t, the FXSAVE area between reserved words
+struct MachX86FloatState64T {
+  std::array<u32, 2> reserved;
+  u16 fcw;
+  u16 fsw;
+  u8 ftw;
+  u8 rsrv1;
+  u16 fop;
+  u32 ip;
+  u16 cs;
+  u16 rsrv2;
+  u32 dp;
+  u16 ds;
+  u16 rsrv3;
+  u32 mxcsr;
+  u32 mxcsr_mask;
+  std::array<u64, 16> st;   // stmm0-stmm7, 16 bytes each
+  std::array<u64, 32> xmm;  // xmm0-xmm15, 16 bytes each
+  std::array<u8, 96> rsrv4;
+  u32 reserved1;
+};
+
 struct ArmThreadState64T {
   std::array<u64, 29> x;
   u64 fp;
@@ -37,4 +61,20 @@ struct ArmThreadState64T {
   u32 pad;
 };
 
+// arm_neon_state64_t, v holds 32 128-bit registers
+struct alignas(16) ArmNeonState64T {
+  std::array<u64, 64> v;
+  u32 fpsr;
+  u32 fpcr;
+};
+
+// arm_debug_state64_t
+struct ArmDebugState64T {
+  std::array<u64, 16> bvr;
+  std::array<u64, 16> bcr;
+  std::array<u64, 16> wvr;
+  std::array<u64, 16> wcr;
+  u64 mdscr_el1;
+};
+
 #endif
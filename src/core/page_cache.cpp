@@ -0,0 +1,78 @@
+#include "page_cache.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+PageCache::Page& PageCache::slot(u64 page) {
+  auto& entry = m_pages[page];
+  if (!entry) entry = std::make_unique<Page>(Page{.epoch = 0, .bytes = {}});
+  return *entry;
+}
+
+void PageCache::invalidate() {
+  m_epoch++;
+  // Stale pages are reused in place, only drop them once the working set of
+  // earlier stops has grown too large
+  if (m_pages.size() > MAX_PAGES) m_pages.clear();
+}
+
+i32 PageCache::read(std::span<const MemorySlice> slices,
+                    const FetchFn& fetch) {
+  m_missing.clear();
+  m_missing_pages.clear();
+
+  for (const auto& slice : slices) {
+    if (slice.buf.empty() || slice.buf.size() > MAX_CACHED_READ) continue;
+
+    const u64 first = slice.addr & ~(PAGE_BYTES - 1);
+    const u64 end = slice.addr + slice.buf.size();
+    for (u64 page = first; page < end; page += PAGE_BYTES) {
+      Page& p = slot(page);
+      if (p.epoch == m_epoch) {
+        m_stats.hits++;
+        continue;
+      }
+
+      // Mark it as pending so a page shared by several slices is fetched once
+      if (p.epoch == m_epoch + 1) continue;
+      p.epoch = m_epoch + 1;
+      m_stats.misses++;
+      m_missing.push_back({.addr = page, .buf = p.bytes});
+      m_missing_pages.push_back(&p);
+    }
+  }
+
+  std::vector<MemorySlice> direct{};
+  for (const auto& slice : slices)
+    if (slice.buf.size() > MAX_CACHED_READ) direct.push_back(slice);
+
+  if (!m_missing.empty()) {
+    m_stats.fetches++;
+    const i32 res = fetch(m_missing);
+    for (Page* p : m_missing_pages) p->epoch = res == 0 ? m_epoch : 0;
+    if (res != 0) return res;
+  }
+
+  if (!direct.empty()) {
+    m_stats.fetches++;
+    if (fetch(direct) != 0) return -1;
+  }
+
+  for (const auto& slice : slices) {
+    if (slice.buf.empty() || slice.buf.size() > MAX_CACHED_READ) continue;
+
+    u64 addr = slice.addr;
+    size_t done = 0;
+    while (done < slice.buf.size()) {
+      const u64 page = addr & ~(PAGE_BYTES - 1);
+      const u64 offset = addr - page;
+      const size_t n =
+          std::min<size_t>(PAGE_BYTES - offset, slice.buf.size() - done);
+      memcpy(slice.buf.data() + done, m_pages.at(page)->bytes.data() + offset,
+             n);
+      done += n;
+      addr += n;
+    }
+  }
+  return 0;
+}
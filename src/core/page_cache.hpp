@@ -0,0 +1,61 @@
+#ifndef CAESAR_PAGE_CACHE_HPP
+#define CAESAR_PAGE_CACHE_HPP
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "typedefs.hpp"
+
+// One destination buffer of a scattered read, addr is a runtime address
+struct MemorySlice {
+  u64 addr;
+  std::span<std::byte> buf;
+};
+
+struct PageCacheStats {
+  u64 hits;
+  u64 misses;
+  u64 fetches;  // vectored reads issued to the target
+};
+
+// Page-granular cache of target memory. Every page is tagged with the stop
+// epoch it was read in and only counts as a hit while the epoch is unchanged,
+// so invalidating the whole cache is a single increment
+class PageCache {
+ public:
+  static constexpr u64 PAGE_BYTES = 4096;
+  // Reads larger than this bypass the cache instead of evicting everything
+  static constexpr u64 MAX_CACHED_READ = 64 * PAGE_BYTES;
+  static constexpr size_t MAX_PAGES = 4096;
+
+  using FetchFn = std::function<i32(std::span<const MemorySlice>)>;
+
+  // Fills every slice, fetching all missing pages with a single call to fetch
+  i32 read(std::span<const MemorySlice> slices, const FetchFn& fetch);
+  void invalidate();
+
+  [[nodiscard]] u64 epoch() const { return m_epoch; }
+  [[nodiscard]] const PageCacheStats& stats() const { return m_stats; }
+  void resetStats() { m_stats = {}; }
+
+ private:
+  struct Page {
+    u64 epoch;
+    std::array<std::byte, PAGE_BYTES> bytes;
+  };
+
+  std::unordered_map<u64, std::unique_ptr<Page>> m_pages;
+  std::vector<MemorySlice> m_missing;
+  std::vector<Page*> m_missing_pages;
+  u64 m_epoch = 1;
+  PageCacheStats m_stats{};
+
+  Page& slot(u64 page);
+};
+
+#endif
@@ -1,11 +1,14 @@
 #ifndef CAESAR_PLATFORM_H
 #define CAESAR_PLATFORM_H
 
+#include <array>
+#include <core/elf/types.hpp>
 #include <core/macho/types.hpp>
 #include <cstddef>
+#include <format>
 #include <typedefs.hpp>
-#include <unordered_map>
 
+#include "core/reg_table.hpp"
 #include "expected.hpp"
 
 enum class Platform : u8 { MACH, LINUX, WIN };
@@ -49,6 +52,43 @@ enum class Arm64Reg : u8 {
   SP,
   PC,
   CPSR,
+  // Low halves of the SIMD registers
+  D0,
+  D1,
+  D2,
+  D3,
+  D4,
+  D5,
+  D6,
+  D7,
+  D8,
+  D9,
+  D10,
+  D11,
+  D12,
+  D13,
+  D14,
+  D15,
+  D16,
+  D17,
+  D18,
+  D19,
+  D20,
+  D21,
+  D22,
+  D23,
+  D24,
+  D25,
+  D26,
+  D27,
+  D28,
+  D29,
+  D30,
+  D31,
+  FPSR,
+  FPCR,
+  // Debug
+  MDSCR,
   COUNT
 };
 
@@ -80,6 +120,34 @@ enum class X86Reg : u8 {
   ES,
   FS,
   GS,
+  FS_BASE,
+  GS_BASE,
+  ORIG_RAX,
+  // SSE, the low quadword of each xmm register
+  MXCSR,
+  XMM0,
+  XMM1,
+  XMM2,
+  XMM3,
+  XMM4,
+  XMM5,
+  XMM6,
+  XMM7,
+  XMM8,
+  XMM9,
+  XMM10,
+  XMM11,
+  XMM12,
+  XMM13,
+  XMM14,
+  XMM15,
+  // Debug
+  DR0,
+  DR1,
+  DR2,
+  DR3,
+  DR6,
+  DR7,
   COUNT
 };
 
@@ -88,11 +156,11 @@ constexpr static Platform getPlatform() {
 #ifdef __APPLE__
   t = Platform::MACH;
 #elif defined(__linux__)
-  t = PlatformType::LINUX;
+  t = Platform::LINUX;
 #elif defined(_WIN32)
-  t = PlatformType::WIN;
+  t = Platform::WIN;
 #else
-  static_asssert(false, "Unsupported platform!");
+  static_assert(false, "Unsupported platform!");
 #endif
   return t;
 }
@@ -121,43 +189,29 @@ constexpr Architecture getArchitecture() {
 #endif
 }
 
+// Registers are fetched and written back per group, a stop that only looks
+// at general purpose registers never touches the others
+enum class RegGroup : u8 { GPR, FP, DEBUG };
+inline constexpr size_t REG_GROUPS = 3;
+
+constexpr u8 groupBit(RegGroup group) {
+  return static_cast<u8>(1U << static_cast<u8>(group));
+}
+
 template <typename RegEnum>
 struct RegEntry {
   RegEnum reg;
-  std::ptrdiff_t offset;
+  std::ptrdiff_t offset;  // Into the state struct of its group
   u8 size;
+  RegGroup group = RegGroup::GPR;
 };
 
-template <Architecture arch, Platform platform>
-struct PlatformTraits;
-
-struct StringHash {
-  using is_transparent = void;
-  [[nodiscard]] size_t operator()(std::string_view sv) const {
-    return std::hash<std::string_view>{}(sv);
-  }
-};
-
-struct StringEqual {
-  using is_transparent = void;
-  [[nodiscard]] bool operator()(std::string_view lhs,
-                                std::string_view rhs) const {
-    return lhs == rhs;
-  }
-};
-
-template <typename RegEnum>
-using RegMap = std::unordered_map<std::string_view, RegEntry<RegEnum>,
-                                  StringHash, StringEqual>;
-
-template <>
-struct PlatformTraits<Architecture::ARM64, Platform::MACH> {
-  using ThreadState = ArmThreadState64T;
-  using RegEnum = Arm64Reg;
-  using Entry = RegEntry<RegEnum>;
-  using Map = RegMap<RegEnum>;
-
-  static inline const Map REG_MAP = {
+// Register names are declared once per architecture. The layouts of the
+// state structs differ between platforms, so the offsets are taken from
+// whichever structs the platform reads its registers into
+template <typename ThreadState, typename FloatState>
+consteval auto arm64Regs() {
+  return std::to_array<RegDesc<RegEntry<Arm64Reg>>>({
       {"x0",
        {.reg = Arm64Reg::X0,
         .offset = offsetof(ThreadState, x) + (0 * sizeof(u64)),
@@ -289,16 +343,458 @@ struct PlatformTraits<Architecture::ARM64, Platform::MACH> {
       {"cpsr",
        {.reg = Arm64Reg::CPSR,
         .offset = offsetof(ThreadState, cpsr),
-        .size = 4}},
-  };
+        .size = sizeof(ThreadState::cpsr)}},
+      {"d0",
+       {.reg = Arm64Reg::D0,
+        .offset = offsetof(FloatState, v) + (0 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d1",
+       {.reg = Arm64Reg::D1,
+        .offset = offsetof(FloatState, v) + (2 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d2",
+       {.reg = Arm64Reg::D2,
+        .offset = offsetof(FloatState, v) + (4 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d3",
+       {.reg = Arm64Reg::D3,
+        .offset = offsetof(FloatState, v) + (6 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d4",
+       {.reg = Arm64Reg::D4,
+        .offset = offsetof(FloatState, v) + (8 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d5",
+       {.reg = Arm64Reg::D5,
+        .offset = offsetof(FloatState, v) + (10 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d6",
+       {.reg = Arm64Reg::D6,
+        .offset = offsetof(FloatState, v) + (12 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d7",
+       {.reg = Arm64Reg::D7,
+        .offset = offsetof(FloatState, v) + (14 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d8",
+       {.reg = Arm64Reg::D8,
+        .offset = offsetof(FloatState, v) + (16 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d9",
+       {.reg = Arm64Reg::D9,
+        .offset = offsetof(FloatState, v) + (18 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d10",
+       {.reg = Arm64Reg::D10,
+        .offset = offsetof(FloatState, v) + (20 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d11",
+       {.reg = Arm64Reg::D11,
+        .offset = offsetof(FloatState, v) + (22 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d12",
+       {.reg = Arm64Reg::D12,
+        .offset = offsetof(FloatState, v) + (24 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d13",
+       {.reg = Arm64Reg::D13,
+        .offset = offsetof(FloatState, v) + (26 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d14",
+       {.reg = Arm64Reg::D14,
+        .offset = offsetof(FloatState, v) + (28 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d15",
+       {.reg = Arm64Reg::D15,
+        .offset = offsetof(FloatState, v) + (30 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d16",
+       {.reg = Arm64Reg::D16,
+        .offset = offsetof(FloatState, v) + (32 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d17",
+       {.reg = Arm64Reg::D17,
+        .offset = offsetof(FloatState, v) + (34 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d18",
+       {.reg = Arm64Reg::D18,
+        .offset = offsetof(FloatState, v) + (36 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d19",
+       {.reg = Arm64Reg::D19,
+        .offset = offsetof(FloatState, v) + (38 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d20",
+       {.reg = Arm64Reg::D20,
+        .offset = offsetof(FloatState, v) + (40 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d21",
+       {.reg = Arm64Reg::D21,
+        .offset = offsetof(FloatState, v) + (42 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d22",
+       {.reg = Arm64Reg::D22,
+        .offset = offsetof(FloatState, v) + (44 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d23",
+       {.reg = Arm64Reg::D23,
+        .offset = offsetof(FloatState, v) + (46 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d24",
+       {.reg = Arm64Reg::D24,
+        .offset = offsetof(FloatState, v) + (48 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d25",
+       {.reg = Arm64Reg::D25,
+        .offset = offsetof(FloatState, v) + (50 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d26",
+       {.reg = Arm64Reg::D26,
+        .offset = offsetof(FloatState, v) + (52 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d27",
+       {.reg = Arm64Reg::D27,
+        .offset = offsetof(FloatState, v) + (54 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d28",
+       {.reg = Arm64Reg::D28,
+        .offset = offsetof(FloatState, v) + (56 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d29",
+       {.reg = Arm64Reg::D29,
+        .offset = offsetof(FloatState, v) + (58 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d30",
+       {.reg = Arm64Reg::D30,
+        .offset = offsetof(FloatState, v) + (60 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"d31",
+       {.reg = Arm64Reg::D31,
+        .offset = offsetof(FloatState, v) + (62 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"fpsr",
+       {.reg = Arm64Reg::FPSR,
+        .offset = offsetof(FloatState, fpsr),
+        .size = 4,
+        .group = RegGroup::FP}},
+      {"fpcr",
+       {.reg = Arm64Reg::FPCR,
+        .offset = offsetof(FloatState, fpcr),
+        .size = 4,
+        .group = RegGroup::FP}},
+  });
+}
+
+template <typename ThreadState, typename FloatState, typename DebugState>
+consteval auto x86Regs() {
+  return std::to_array<RegDesc<RegEntry<X86Reg>>>({
+      {"rax",
+       {.reg = X86Reg::RAX, .offset = offsetof(ThreadState, rax), .size = 8}},
+      {"rbx",
+       {.reg = X86Reg::RBX, .offset = offsetof(ThreadState, rbx), .size = 8}},
+      {"rcx",
+       {.reg = X86Reg::RCX, .offset = offsetof(ThreadState, rcx), .size = 8}},
+      {"rdx",
+       {.reg = X86Reg::RDX, .offset = offsetof(ThreadState, rdx), .size = 8}},
+      {"rsi",
+       {.reg = X86Reg::RSI, .offset = offsetof(ThreadState, rsi), .size = 8}},
+      {"rdi",
+       {.reg = X86Reg::RDI, .offset = offsetof(ThreadState, rdi), .size = 8}},
+      {"rbp",
+       {.reg = X86Reg::RBP, .offset = offsetof(ThreadState, rbp), .size = 8}},
+      {"fp",
+       {.reg = X86Reg::RBP, .offset = offsetof(ThreadState, rbp), .size = 8}},
+      {"rsp",
+       {.reg = X86Reg::RSP, .offset = offsetof(ThreadState, rsp), .size = 8}},
+      {"sp",
+       {.reg = X86Reg::RSP, .offset = offsetof(ThreadState, rsp), .size = 8}},
+      {"r8",
+       {.reg = X86Reg::R8, .offset = offsetof(ThreadState, r8), .size = 8}},
+      {"r9",
+       {.reg = X86Reg::R9, .offset = offsetof(ThreadState, r9), .size = 8}},
+      {"r10",
+       {.reg = X86Reg::R10, .offset = offsetof(ThreadState, r10), .size = 8}},
+      {"r11",
+       {.reg = X86Reg::R11, .offset = offsetof(ThreadState, r11), .size = 8}},
+      {"r12",
+       {.reg = X86Reg::R12, .offset = offsetof(ThreadState, r12), .size = 8}},
+      {"r13",
+       {.reg = X86Reg::R13, .offset = offsetof(ThreadState, r13), .size = 8}},
+      {"r14",
+       {.reg = X86Reg::R14, .offset = offsetof(ThreadState, r14), .size = 8}},
+      {"r15",
+       {.reg = X86Reg::R15, .offset = offsetof(ThreadState, r15), .size = 8}},
+      {"rip",
+       {.reg = X86Reg::RIP, .offset = offsetof(ThreadState, rip), .size = 8}},
+      {"pc",
+       {.reg = X86Reg::RIP, .offset = offsetof(ThreadState, rip), .size = 8}},
+      {"rflags",
+       {.reg = X86Reg::RFLAGS,
+        .offset = offsetof(ThreadState, rflags),
+        .size = 8}},
+      {"cs",
+       {.reg = X86Reg::CS, .offset = offsetof(ThreadState, cs), .size = 8}},
+      {"fs",
+       {.reg = X86Reg::FS, .offset = offsetof(ThreadState, fs), .size = 8}},
+      {"gs",
+       {.reg = X86Reg::GS, .offset = offsetof(ThreadState, gs), .size = 8}},
+      {"mxcsr",
+       {.reg = X86Reg::MXCSR,
+        .offset = offsetof(FloatState, mxcsr),
+        .size = 4,
+        .group = RegGroup::FP}},
+      {"xmm0",
+       {.reg = X86Reg::XMM0,
+        .offset = offsetof(FloatState, xmm) + (0 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"xmm1",
+       {.reg = X86Reg::XMM1,
+        .offset = offsetof(FloatState, xmm) + (2 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"xmm2",
+       {.reg = X86Reg::XMM2,
+        .offset = offsetof(FloatState, xmm) + (4 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"xmm3",
+       {.reg = X86Reg::XMM3,
+        .offset = offsetof(FloatState, xmm) + (6 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"xmm4",
+       {.reg = X86Reg::XMM4,
+        .offset = offsetof(FloatState, xmm) + (8 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"xmm5",
+       {.reg = X86Reg::XMM5,
+        .offset = offsetof(FloatState, xmm) + (10 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"xmm6",
+       {.reg = X86Reg::XMM6,
+        .offset = offsetof(FloatState, xmm) + (12 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"xmm7",
+       {.reg = X86Reg::XMM7,
+        .offset = offsetof(FloatState, xmm) + (14 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"xmm8",
+       {.reg = X86Reg::XMM8,
+        .offset = offsetof(FloatState, xmm) + (16 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"xmm9",
+       {.reg = X86Reg::XMM9,
+        .offset = offsetof(FloatState, xmm) + (18 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"xmm10",
+       {.reg = X86Reg::XMM10,
+        .offset = offsetof(FloatState, xmm) + (20 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"xmm11",
+       {.reg = X86Reg::XMM11,
+        .offset = offsetof(FloatState, xmm) + (22 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"xmm12",
+       {.reg = X86Reg::XMM12,
+        .offset = offsetof(FloatState, xmm) + (24 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"xmm13",
+       {.reg = X86Reg::XMM13,
+        .offset = offsetof(FloatState, xmm) + (26 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"xmm14",
+       {.reg = X86Reg::XMM14,
+        .offset = offsetof(FloatState, xmm) + (28 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"xmm15",
+       {.reg = X86Reg::XMM15,
+        .offset = offsetof(FloatState, xmm) + (30 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::FP}},
+      {"dr0",
+       {.reg = X86Reg::DR0,
+        .offset = offsetof(DebugState, dr) + (0 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::DEBUG}},
+      {"dr1",
+       {.reg = X86Reg::DR1,
+        .offset = offsetof(DebugState, dr) + (1 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::DEBUG}},
+      {"dr2",
+       {.reg = X86Reg::DR2,
+        .offset = offsetof(DebugState, dr) + (2 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::DEBUG}},
+      {"dr3",
+       {.reg = X86Reg::DR3,
+        .offset = offsetof(DebugState, dr) + (3 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::DEBUG}},
+      {"dr6",
+       {.reg = X86Reg::DR6,
+        .offset = offsetof(DebugState, dr) + (6 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::DEBUG}},
+      {"dr7",
+       {.reg = X86Reg::DR7,
+        .offset = offsetof(DebugState, dr) + (7 * sizeof(u64)),
+        .size = 8,
+        .group = RegGroup::DEBUG}},
+  });
+}
+
+template <Architecture arch, Platform platform>
+struct PlatformTraits;
+
+template <>
+struct PlatformTraits<Architecture::ARM64, Platform::MACH> {
+  using ThreadState = ArmThreadState64T;
+  using FloatState = ArmNeonState64T;
+  using DebugState = ArmDebugState64T;
+  using RegEnum = Arm64Reg;
+  using Entry = RegEntry<RegEnum>;
+
+  // brk #0, little endian
+  static constexpr std::array<std::byte, 4> TRAP_INS = {
+      std::byte{0x00}, std::byte{0x00}, std::byte{0x20}, std::byte{0xD4}};
+
+  // Only the Mach debug state has it
+  static constexpr auto DEBUG_REGS = std::to_array<RegDesc<Entry>>({
+      {"mdscr_el1",
+       {.reg = Arm64Reg::MDSCR,
+        .offset = offsetof(DebugState, mdscr_el1),
+        .size = 8,
+        .group = RegGroup::DEBUG}},
+  });
+
+  static constexpr RegTable REG_TABLE{
+      concatRegs(arm64Regs<ThreadState, FloatState>(), DEBUG_REGS)};
+};
+
+template <>
+struct PlatformTraits<Architecture::ARM64, Platform::LINUX> {
+  using ThreadState = LinuxArmThreadState64T;
+  using FloatState = ArmNeonState64T;  // Same layout as user_fpsimd_state
+  // The hardware breakpoint regsets have a layout of their own and no
+  // registers are exposed from them, only here so ThreadInfo has its shape
+  using DebugState = ArmDebugState64T;
+  using RegEnum = Arm64Reg;
+  using Entry = RegEntry<RegEnum>;
+
+  static constexpr std::array<std::byte, 4> TRAP_INS =
+      PlatformTraits<Architecture::ARM64, Platform::MACH>::TRAP_INS;
+
+  static constexpr RegTable REG_TABLE{arm64Regs<ThreadState, FloatState>()};
+};
+
+template <>
+struct PlatformTraits<Architecture::X86_64, Platform::LINUX> {
+  using ThreadState = LinuxX86ThreadState64T;
+  using FloatState = X86FloatState64T;
+  using DebugState = X86DebugState64T;
+  using RegEnum = X86Reg;
+  using Entry = RegEntry<RegEnum>;
+
+  // int3
+  static constexpr std::array<std::byte, 1> TRAP_INS = {std::byte{0xCC}};
+
+  // Only in user_regs_struct
+  static constexpr auto LINUX_REGS = std::to_array<RegDesc<Entry>>({
+      {"ss",
+       {.reg = X86Reg::SS, .offset = offsetof(ThreadState, ss), .size = 8}},
+      {"ds",
+       {.reg = X86Reg::DS, .offset = offsetof(ThreadState, ds), .size = 8}},
+      {"es",
+       {.reg = X86Reg::ES, .offset = offsetof(ThreadState, es), .size = 8}},
+      {"fs_base",
+       {.reg = X86Reg::FS_BASE,
+        .offset = offsetof(ThreadState, fs_base),
+        .size = 8}},
+      {"gs_base",
+       {.reg = X86Reg::GS_BASE,
+        .offset = offsetof(ThreadState, gs_base),
+        .size = 8}},
+      {"orig_rax",
+       {.reg = X86Reg::ORIG_RAX,
+        .offset = offsetof(ThreadState, orig_rax),
+        .size = 8}},
+  });
+
+  static constexpr RegTable REG_TABLE{
+      concatRegs(x86Regs<ThreadState, FloatState, DebugState>(), LINUX_REGS)};
+};
+
+template <>
+struct PlatformTraits<Architecture::X86_64, Platform::MACH> {
+  using ThreadState = X86ThreadState64T;
+  using FloatState = MachX86FloatState64T;
+  using DebugState = X86DebugState64T;  // Same layout as x86_debug_state64_t
+  using RegEnum = X86Reg;
+  using Entry = RegEntry<RegEnum>;
+
+  static constexpr std::array<std::byte, 1> TRAP_INS =
+      PlatformTraits<Architecture::X86_64, Platform::LINUX>::TRAP_INS;
+
+  static constexpr RegTable REG_TABLE{
+      x86Regs<ThreadState, FloatState, DebugState>()};
 };
 
 using CurrentPlatform = PlatformTraits<getArchitecture(), getPlatform()>;
 using ThreadState = CurrentPlatform::ThreadState;
+using FloatState = CurrentPlatform::FloatState;
+using DebugState = CurrentPlatform::DebugState;
 using Reg = CurrentPlatform::RegEnum;
 using RegEntryT = CurrentPlatform::Entry;
-inline constexpr auto& regMap = CurrentPlatform::REG_MAP;
+inline constexpr auto& regTable = CurrentPlatform::REG_TABLE;
+inline constexpr auto& trapIns = CurrentPlatform::TRAP_INS;
 
+// General purpose registers only, the other groups are read through
+// Target::readRegister
 inline u64 readRegValue(const ThreadState& threadState,
                         const RegEntryT& regEntry) {
   const auto* ptr = reinterpret_cast<const u8*>(&threadState) + regEntry.offset;
@@ -308,9 +804,23 @@ inline u64 readRegValue(const ThreadState& threadState,
 
 inline Expected<const RegEntryT*, std::string> findRegEntry(
     std::string_view name) {
-  auto it = regMap.find(name);
-  if (it != regMap.end()) return &it->second;
+  if (const RegEntryT* entry = regTable.find(name)) return entry;
   return Unexpected{std::format("Unknown register: {}", name)};
 }
 
+// A constant reg is resolved at compile time, nullptr when the register is
+// not part of this platform's layout
+constexpr const RegEntryT* findRegEntry(Reg reg) { return regTable.find(reg); }
+
+// For code that runs on every hit and only gets the cached general purpose
+// registers, like conditions and tracepoints
+inline Expected<const RegEntryT*, std::string> findGprEntry(
+    std::string_view name) {
+  auto entry = findRegEntry(name);
+  if (entry && entry.value()->group != RegGroup::GPR)
+    return Unexpected{
+        std::format("{} is not a general purpose register", name)};
+  return entry;
+}
+
 #endif
@@ -0,0 +1,124 @@
+#include "profile.hpp"
+
+#include <algorithm>
+#include <format>
+#include <ranges>
+#include <set>
+#include <unordered_set>
+
+void Profile::addSample(std::vector<u64> pcs, i32 syscall) {
+  m_stacks[Stack{.pcs = std::move(pcs), .syscall = syscall}]++;
+  m_samples++;
+}
+
+void Profile::addPause(u64 ns) {
+  m_ticks++;
+  m_total_pause_ns += ns;
+  m_max_pause_ns = std::max(m_max_pause_ns, ns);
+}
+
+std::vector<u64> Profile::frames() const {
+  std::unordered_set<u64> seen{};
+  for (const auto& stack : m_stacks | std::views::keys)
+    seen.insert(stack.pcs.begin(), stack.pcs.end());
+  return {seen.begin(), seen.end()};
+}
+
+std::vector<i32> Profile::syscalls() const {
+  std::set<i32> seen{};
+  for (const auto& stack : m_stacks | std::views::keys)
+    if (stack.syscall >= 0) seen.insert(stack.syscall);
+  return {seen.begin(), seen.end()};
+}
+
+void Profile::nameFrame(u64 pc, std::string name) {
+  m_frame_names.insert_or_assign(pc, std::move(name));
+}
+
+void Profile::nameSyscall(i32 nr, std::string name) {
+  m_syscall_names.insert_or_assign(nr, std::move(name));
+}
+
+double Profile::avgPauseNs() const {
+  return m_ticks == 0 ? 0
+                      : static_cast<double>(m_total_pause_ns) /
+                            static_cast<double>(m_ticks);
+}
+
+std::vector<std::string> Profile::names(const Stack& stack) const {
+  std::vector<std::string> res{};
+  res.reserve(stack.pcs.size() + 1);
+  for (const u64 pc : stack.pcs | std::views::reverse) {
+    const auto it = m_frame_names.find(pc);
+    std::string name =
+        it != m_frame_names.end() ? it->second : std::format("{:#x}", pc);
+    // The separator of the folded format
+    std::ranges::replace(name, ';', ':');
+    res.push_back(std::move(name));
+  }
+  if (stack.syscall >= 0) {
+    const auto it = m_syscall_names.find(stack.syscall);
+    res.push_back(it != m_syscall_names.end()
+                      ? std::format("[{}]", it->second)
+                      : std::format("[syscall {}]", stack.syscall));
+  }
+  return res;
+}
+
+std::string Profile::folded() const {
+  // Stacks with the same names, e.g. two call sites in one function, merge
+  std::map<std::string, u64> lines{};
+  for (const auto& [stack, count] : m_stacks) {
+    std::string line{};
+    for (const auto& name : names(stack)) {
+      if (!line.empty()) line += ';';
+      line += name;
+    }
+    lines[line] += count;
+  }
+
+  std::string res{};
+  for (const auto& [line, count] : lines)
+    res += std::format("{} {}\n", line, count);
+  if (!res.empty()) res.pop_back();
+  return res;
+}
+
+std::string Profile::top(size_t n) const {
+  if (m_samples == 0) return "No samples";
+
+  struct Counts {
+    u64 self = 0;
+    u64 total = 0;
+  };
+  std::unordered_map<std::string, Counts> counts{};
+  for (const auto& [stack, count] : m_stacks) {
+    const auto frames = names(stack);
+    if (frames.empty()) continue;
+    counts[frames.back()].self += count;
+    // Recursion counts once per sample
+    std::unordered_set<std::string_view> seen{};
+    for (const auto& name : frames)
+      if (seen.insert(name).second) counts[name].total += count;
+  }
+
+  std::vector<std::pair<std::string, Counts>> sorted(counts.begin(),
+                                                     counts.end());
+  std::ranges::sort(sorted, [](const auto& a, const auto& b) {
+    return std::tie(a.second.self, a.second.total, b.first) >
+           std::tie(b.second.self, b.second.total, a.first);
+  });
+
+  const auto pct = [this](u64 count) {
+    return 100.0 * static_cast<double>(count) /
+           static_cast<double>(m_samples);
+  };
+  std::string res =
+      std::format("{:>7} {:>7} {:>7} {:>7}  {}\n", "self", "self%", "total",
+                  "total%", "function");
+  for (const auto& [name, c] : sorted | std::views::take(n))
+    res += std::format("{:>7} {:>6.1f}% {:>7} {:>6.1f}%  {}\n", c.self,
+                       pct(c.self), c.total, pct(c.total), name);
+  res.pop_back();
+  return res;
+}
@@ -0,0 +1,66 @@
+#ifndef CAESAR_PROFILE_HPP
+#define CAESAR_PROFILE_HPP
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "typedefs.hpp"
+
+// WALL stops every thread for each sample, blocked ones included. CPU only
+// samples threads while they run and never stops them
+enum class ProfileMode : u8 { WALL, CPU };
+
+// Stacks collected by a sampling profiler. Samples are kept as raw return
+// addresses while the target runs, the backend names every distinct frame
+// once collection is over
+class Profile {
+ public:
+  // Leaf first. syscall is the call the thread was blocked in, -1 if it was
+  // running user code
+  void addSample(std::vector<u64> pcs, i32 syscall = -1);
+  void addPause(u64 ns);
+  // Samples dropped because the buffer they went to was full
+  void addLost(u64 count) { m_lost += count; }
+
+  [[nodiscard]] std::vector<u64> frames() const;
+  [[nodiscard]] std::vector<i32> syscalls() const;
+  void nameFrame(u64 pc, std::string name);
+  void nameSyscall(i32 nr, std::string name);
+
+  [[nodiscard]] u64 samples() const { return m_samples; }
+  [[nodiscard]] u64 ticks() const { return m_ticks; }
+  [[nodiscard]] u64 lost() const { return m_lost; }
+  [[nodiscard]] u64 maxPauseNs() const { return m_max_pause_ns; }
+  [[nodiscard]] double avgPauseNs() const;
+
+  // One "root;...;leaf count" line per distinct stack, the input of
+  // flamegraph.pl and most other flame graph tools
+  [[nodiscard]] std::string folded() const;
+  // The n functions with the most samples on top of the stack, with the
+  // samples they are anywhere on the stack next to it
+  [[nodiscard]] std::string top(size_t n) const;
+
+ private:
+  struct Stack {
+    std::vector<u64> pcs;
+    i32 syscall;
+    auto operator<=>(const Stack&) const = default;
+  };
+
+  std::map<Stack, u64> m_stacks;
+  std::unordered_map<u64, std::string> m_frame_names;
+  std::unordered_map<i32, std::string> m_syscall_names;
+  u64 m_samples = 0;
+  u64 m_ticks = 0;
+  u64 m_lost = 0;
+  u64 m_total_pause_ns = 0;
+  u64 m_max_pause_ns = 0;
+
+  // Root first, the syscall as an extra leaf
+  [[nodiscard]] std::vector<std::string> names(const Stack& stack) const;
+};
+
+#endif  // CAESAR_PROFILE_HPP
@@ -0,0 +1,207 @@
+#include "reactor.hpp"
+
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <error.hpp>
+#include <format>
+#include <span>
+#include <utility>
+
+namespace {
+constexpr size_t MAX_EVENTS = 32;
+
+u64 eventKey(int fd, u32 generation) {
+  return (static_cast<u64>(generation) << 32) | static_cast<u32>(fd);
+}
+
+timespec toTimespec(std::chrono::nanoseconds ns) {
+  const auto secs = std::chrono::duration_cast<std::chrono::seconds>(ns);
+  return {.tv_sec = secs.count(), .tv_nsec = (ns - secs).count()};
+}
+}  // namespace
+
+Reactor::Reactor() : m_epoll(epoll_create1(EPOLL_CLOEXEC)) {
+  if (m_epoll < 0)
+    CoreError::error(std::format("epoll_create1 failed: {}", strerror(errno)));
+}
+
+Reactor::~Reactor() {
+  for (const auto& [fd, source] : m_sources)
+    if (source.kind != Kind::FD) close(fd);
+  if (m_epoll >= 0) close(m_epoll);
+}
+
+Reactor& Reactor::getInstance() {
+  // Never destroyed, a target dropped during static destruction still
+  // removes its sources
+  // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+  static auto* reactor = new Reactor();
+  return *reactor;
+}
+
+i32 Reactor::watch(int fd, Kind kind, Handler handler) {
+  if (m_epoll < 0 || m_sources.contains(fd)) return -1;
+  const u32 generation = ++m_generation;
+  epoll_event ev{.events = EPOLLIN, .data = {.u64 = eventKey(fd, generation)}};
+  if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) != 0) {
+    // Left to the caller, it may fall back to blocking reads
+    if (errno != EPERM)
+      CoreError::error(std::format("epoll_ctl failed: {}", strerror(errno)));
+    return -1;
+  }
+  m_sources.emplace(fd, Source{.handler = std::move(handler),
+                               .kind = kind,
+                               .generation = generation,
+                               .paused = false});
+  return 0;
+}
+
+i32 Reactor::add(int fd, Handler handler) {
+  return watch(fd, Kind::FD, std::move(handler));
+}
+
+int Reactor::addSignal(int sig, Handler handler) {
+  sigset_t set{};
+  sigemptyset(&set);
+  sigaddset(&set, sig);
+  // Left pending for the signalfd instead of being delivered
+  pthread_sigmask(SIG_BLOCK, &set, nullptr);
+
+  const int fd = signalfd(-1, &set, SFD_NONBLOCK | SFD_CLOEXEC);
+  if (fd < 0) {
+    CoreError::error(std::format("signalfd failed: {}", strerror(errno)));
+    return -1;
+  }
+  auto drain = [fd, handler = std::move(handler)] {
+    signalfd_siginfo info{};
+    while (read(fd, &info, sizeof(info)) == sizeof(info)) {
+    }
+    handler();
+  };
+  if (watch(fd, Kind::SIGNAL, std::move(drain)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int Reactor::addTimer(std::chrono::nanoseconds first,
+                      std::chrono::nanoseconds interval, Handler handler) {
+  const int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (fd < 0) {
+    CoreError::error(std::format("timerfd_create failed: {}", strerror(errno)));
+    return -1;
+  }
+  // A zero expiry would disarm the timer instead of firing it at once
+  const itimerspec spec{
+      .it_interval = toTimespec(interval),
+      .it_value = toTimespec(std::max(first, std::chrono::nanoseconds{1}))};
+  auto expire = [fd, handler = std::move(handler)] {
+    u64 expirations = 0;
+    if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+      return;
+    handler();
+  };
+  if (timerfd_settime(fd, 0, &spec, nullptr) != 0 ||
+      watch(fd, Kind::TIMER, std::move(expire)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int Reactor::addProcess(pid_t pid, Handler handler) {
+  const int fd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+  if (fd < 0) return -1;
+  // Readable for good once the process is gone, so it fires only once
+  auto exited = [this, fd, handler = std::move(handler)] {
+    remove(fd);
+    handler();
+  };
+  if (watch(fd, Kind::PROCESS, std::move(exited)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int Reactor::addWakeup(Handler handler) {
+  const int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (fd < 0) {
+    CoreError::error(std::format("eventfd failed: {}", strerror(errno)));
+    return -1;
+  }
+  auto woken = [fd, handler = std::move(handler)] {
+    u64 count = 0;
+    if (read(fd, &count, sizeof(count)) != sizeof(count)) return;
+    handler();
+  };
+  if (watch(fd, Kind::WAKEUP, std::move(woken)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+void Reactor::wake(int fd) {
+  const u64 one = 1;
+  // Only fails once the counter is about to overflow, it is readable then
+  [[maybe_unused]] const ssize_t n = write(fd, &one, sizeof(one));
+}
+
+void Reactor::remove(int fd) {
+  const auto it = m_sources.find(fd);
+  if (it == m_sources.end()) return;
+  if (!it->second.paused) epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+  if (it->second.kind != Kind::FD) close(fd);
+  m_sources.erase(it);
+}
+
+void Reactor::pause(int fd, bool paused) {
+  const auto it = m_sources.find(fd);
+  if (it == m_sources.end() || it->second.paused == paused) return;
+  // Taken out of the set, a hung up fd would be reported with no events
+  // asked for
+  epoll_event ev{.events = EPOLLIN,
+                 .data = {.u64 = eventKey(fd, it->second.generation)}};
+  epoll_ctl(m_epoll, paused ? EPOLL_CTL_DEL : EPOLL_CTL_ADD, fd, &ev);
+  it->second.paused = paused;
+}
+
+i32 Reactor::poll(std::chrono::milliseconds timeout) {
+  std::array<epoll_event, MAX_EVENTS> events{};
+  const int ready =
+      epoll_wait(m_epoll, events.data(), static_cast<int>(events.size()),
+                 timeout.count() < 0 ? -1 : static_cast<int>(timeout.count()));
+  if (ready < 0) {
+    if (errno == EINTR) return 0;
+    CoreError::error(std::format("epoll_wait failed: {}", strerror(errno)));
+    return -1;
+  }
+
+  i32 ran = 0;
+  for (const epoll_event& ev : std::span{events}.first(ready)) {
+    const int fd = static_cast<int>(ev.data.u64 & 0xFFFFFFFF);
+    const auto it = m_sources.find(fd);
+    // Removed, or replaced by a new source, by an earlier handler
+    if (it == m_sources.end() ||
+        it->second.generation != static_cast<u32>(ev.data.u64 >> 32))
+      continue;
+    // A copy, the handler may remove its own source
+    const Handler handler = it->second.handler;
+    handler();
+    ran++;
+  }
+  return ran;
+}
@@ -0,0 +1,72 @@
+#ifndef CAESAR_REACTOR_HPP
+#define CAESAR_REACTOR_HPP
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+
+#include "typedefs.hpp"
+
+// The one epoll instance every wait of the debugger goes through: terminal
+// input, target stops, exits and timers. Sources are level-triggered and
+// their handlers run one at a time on the thread calling poll
+class Reactor {
+ public:
+  using Handler = std::function<void()>;
+
+  Reactor();
+  ~Reactor();
+  Reactor(const Reactor&) = delete;
+  Reactor& operator=(const Reactor&) = delete;
+  Reactor(Reactor&&) = delete;
+  Reactor& operator=(Reactor&&) = delete;
+
+  static Reactor& getInstance();
+
+  // Calls handler while fd is readable. The fd stays owned by the caller,
+  // files that cannot be polled, like regular ones, give -1
+  i32 add(int fd, Handler handler);
+  // Blocks sig in the calling thread and calls handler when it arrives.
+  // Threads started afterwards inherit the mask, ones running already must
+  // block it themselves or they take the signal first. Returns the signalfd
+  int addSignal(int sig, Handler handler);
+  // Fires after first, then every interval unless that is zero. Ticks
+  // missed in between are merged into one call. Returns the timerfd
+  int addTimer(std::chrono::nanoseconds first,
+               std::chrono::nanoseconds interval, Handler handler);
+  // Calls handler once process pid has exited, -1 without pidfd support
+  int addProcess(pid_t pid, Handler handler);
+  // Calls handler after wake(fd), wake-ups arriving before it runs are
+  // merged into one call. Returns the eventfd
+  int addWakeup(Handler handler);
+  // The one call that is safe from other threads
+  static void wake(int fd);
+  // Forgets fd, closing it if the reactor created it. Safe from handlers
+  void remove(int fd);
+  // Keeps fd registered without delivering it
+  void pause(int fd, bool paused);
+
+  // Waits up to timeout for events and runs their handlers, a negative one
+  // blocks. Returns how many ran, -1 on error
+  i32 poll(std::chrono::milliseconds timeout = std::chrono::milliseconds{-1});
+  [[nodiscard]] size_t size() const { return m_sources.size(); }
+
+ private:
+  enum class Kind : u8 { FD, SIGNAL, TIMER, PROCESS, WAKEUP };
+  struct Source {
+    Handler handler;
+    Kind kind;
+    u32 generation;  // Tells a reused fd from the one an event was for
+    bool paused;
+  };
+
+  int m_epoll = -1;
+  u32 m_generation = 0;
+  std::unordered_map<int, Source> m_sources;
+
+  i32 watch(int fd, Kind kind, Handler handler);
+};
+
+#endif  // CAESAR_REACTOR_HPP
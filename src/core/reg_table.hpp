@@ -0,0 +1,122 @@
+#ifndef CAESAR_REG_TABLE_HPP
+#define CAESAR_REG_TABLE_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <string_view>
+
+#include "typedefs.hpp"
+
+template <typename Entry>
+struct RegDesc {
+  std::string_view name;
+  Entry entry;
+};
+
+// FNV-1a, the seed picks one of a family of hash functions
+constexpr u32 regHash(std::string_view name, u32 seed) {
+  u32 hash = 2166136261U ^ seed;
+  for (const char c : name) {
+    hash ^= static_cast<u8>(c);
+    hash *= 16777619U;
+  }
+  return hash;
+}
+
+// Perfect hash over a fixed register list, built at compile time by hash and
+// displace. A name picks a bucket with seed 0, the bucket's seed then picks
+// a slot that no other name maps to, so a lookup is two hashes, two loads and
+// one compare
+template <typename Entry, size_t N>
+class RegTable {
+  using RegEnum = decltype(Entry::reg);
+
+ public:
+  static constexpr size_t SLOTS = std::bit_ceil(N);
+  static constexpr size_t BUCKETS = SLOTS;
+  static constexpr u8 EMPTY = 0xFF;
+  static_assert(N < EMPTY, "Register indices have to fit in a u8");
+
+  consteval explicit RegTable(const std::array<RegDesc<Entry>, N>& regs)
+      : m_regs(regs) {
+    m_slots.fill(EMPTY);
+    m_by_reg.fill(EMPTY);
+    for (size_t i = 0; i < N; i++) {
+      auto& first = m_by_reg[static_cast<size_t>(m_regs[i].entry.reg)];
+      if (first == EMPTY) first = static_cast<u8>(i);
+    }
+
+    std::array<size_t, BUCKETS> sizes{};
+    for (const auto& reg : m_regs) sizes[bucketOf(reg.name)]++;
+    // Fullest buckets first, while most slots are still free
+    std::array<size_t, BUCKETS> order{};
+    for (size_t i = 0; i < BUCKETS; i++) {
+      size_t j = i;
+      for (; j > 0 && sizes[order[j - 1]] < sizes[i]; j--)
+        order[j] = order[j - 1];
+      order[j] = i;
+    }
+
+    for (const size_t bucket : order) {
+      if (sizes[bucket] == 0) break;
+      u32 seed = 1;
+      while (!tryPlace(bucket, seed)) seed++;
+      m_seeds[bucket] = seed;
+    }
+  }
+
+  [[nodiscard]] constexpr const Entry* find(std::string_view name) const {
+    const u32 seed = m_seeds[bucketOf(name)];
+    const u8 index = m_slots[regHash(name, seed) & (SLOTS - 1)];
+    if (index == EMPTY || m_regs[index].name != name) return nullptr;
+    return &m_regs[index].entry;
+  }
+
+  // First entry declared for reg, nullptr when this layout does not have it
+  [[nodiscard]] constexpr const Entry* find(RegEnum reg) const {
+    const u8 index = m_by_reg[static_cast<size_t>(reg)];
+    return index == EMPTY ? nullptr : &m_regs[index].entry;
+  }
+
+  [[nodiscard]] constexpr const std::array<RegDesc<Entry>, N>& regs() const {
+    return m_regs;
+  }
+
+ private:
+  std::array<RegDesc<Entry>, N> m_regs;
+  std::array<u32, BUCKETS> m_seeds{};
+  std::array<u8, SLOTS> m_slots{};
+  std::array<u8, static_cast<size_t>(RegEnum::COUNT)> m_by_reg{};
+
+  static constexpr size_t bucketOf(std::string_view name) {
+    return regHash(name, 0) & (BUCKETS - 1);
+  }
+
+  // Places every name of the bucket with seed, or nothing if two of them
+  // collide with each other or with an earlier bucket
+  constexpr bool tryPlace(size_t bucket, u32 seed) {
+    std::array<u8, SLOTS> slots = m_slots;
+    for (size_t i = 0; i < N; i++) {
+      if (bucketOf(m_regs[i].name) != bucket) continue;
+      u8& slot = slots[regHash(m_regs[i].name, seed) & (SLOTS - 1)];
+      if (slot != EMPTY) return false;
+      slot = static_cast<u8>(i);
+    }
+    m_slots = slots;
+    return true;
+  }
+};
+
+template <typename Entry, size_t N, size_t M>
+consteval std::array<RegDesc<Entry>, N + M> concatRegs(
+    const std::array<RegDesc<Entry>, N>& lhs,
+    const std::array<RegDesc<Entry>, M>& rhs) {
+  std::array<RegDesc<Entry>, N + M> out{};
+  std::ranges::copy(lhs, out.begin());
+  std::ranges::copy(rhs, out.begin() + N);
+  return out;
+}
+
+#endif  // CAESAR_REG_TABLE_HPP
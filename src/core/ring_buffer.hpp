@@ -0,0 +1,55 @@
+#ifndef CAESAR_RING_BUFFER_HPP
+#define CAESAR_RING_BUFFER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+#include "typedefs.hpp"
+
+// Fixed capacity single-producer single-consumer queue. The producer only
+// writes m_head and the consumer only writes m_tail, each on its own cache
+// line, so neither side ever takes a lock or waits on the other
+template <typename T, size_t N>
+class SpscRing {
+  static_assert((N & (N - 1)) == 0, "Capacity must be a power of two");
+
+  static constexpr size_t CACHE_LINE = 64;
+
+  alignas(CACHE_LINE) std::atomic<u64> m_head{0};
+  alignas(CACHE_LINE) std::atomic<u64> m_tail{0};
+  // Left uninitialized, a slot is only read after it was pushed. Owners of a
+  // large ring then do not fault in all of it when they are created
+  alignas(CACHE_LINE) std::array<T, N> m_slots;
+
+ public:
+  static constexpr size_t CAPACITY = N;
+
+  // Producer side, false when the consumer has fallen a full ring behind
+  bool tryPush(const T& item) {
+    const u64 head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) == N) return false;
+
+    m_slots[head & (N - 1)] = item;
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side
+  bool tryPop(T& out) {
+    const u64 tail = m_tail.load(std::memory_order_relaxed);
+    if (tail == m_head.load(std::memory_order_acquire)) return false;
+
+    out = m_slots[tail & (N - 1)];
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  [[nodiscard]] size_t size() const {
+    return static_cast<size_t>(m_head.load(std::memory_order_acquire) -
+                               m_tail.load(std::memory_order_acquire));
+  }
+  [[nodiscard]] bool empty() const { return size() == 0; }
+};
+
+#endif
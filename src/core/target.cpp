@@ -1,13 +1,78 @@
 #include "target.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <error.hpp>
+#include <filesystem>
+#include <format>
 #include <memory>
+#include <vector>
 
 #include "platform.hpp"
 
 #ifdef __APPLE__
 #include "macho/macho.hpp"
+#elif defined(__linux__)
+#include "elf/core_file.hpp"
+#include "elf/elf.hpp"
 #endif
 
+namespace {
+std::string formatThreadState(const ArmThreadState64T& threadState) {
+  std::string res{};
+  constexpr int regsPerRow = 4;
+  for (int i = 0; i < 29; i++) {
+    res += std::format(
+        " x{:<2}: {}", i,
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+        detail::toHex(threadState.x[i]));
+    if ((i + 1) % regsPerRow == 0)
+      res += '\n';
+    else
+      res += "  ";
+  }
+
+  res += std::format("\n fp: {} lr: {}\n", detail::toHex(threadState.fp),
+                     detail::toHex(threadState.lr));
+  res += std::format(" sp: {} pc: {}\n", detail::toHex(threadState.sp),
+                     detail::toHex(threadState.pc));
+  res += std::format(" cpsr: {}\n", detail::toHex(threadState.cpsr));
+  return res;
+}
+
+std::string formatThreadState(const LinuxX86ThreadState64T& threadState) {
+  std::string res{};
+  res += std::format(" rax: {}  rbx: {}  rcx: {}  rdx: {}\n",
+                     detail::toHex(threadState.rax),
+                     detail::toHex(threadState.rbx),
+                     detail::toHex(threadState.rcx),
+                     detail::toHex(threadState.rdx));
+  res += std::format(" rsi: {}  rdi: {}  rbp: {}  rsp: {}\n",
+                     detail::toHex(threadState.rsi),
+                     detail::toHex(threadState.rdi),
+                     detail::toHex(threadState.rbp),
+                     detail::toHex(threadState.rsp));
+  res += std::format(" r8:  {}  r9:  {}  r10: {}  r11: {}\n",
+                     detail::toHex(threadState.r8),
+                     detail::toHex(threadState.r9),
+                     detail::toHex(threadState.r10),
+                     detail::toHex(threadState.r11));
+  res += std::format(" r12: {}  r13: {}  r14: {}  r15: {}\n",
+                     detail::toHex(threadState.r12),
+                     detail::toHex(threadState.r13),
+                     detail::toHex(threadState.r14),
+                     detail::toHex(threadState.r15));
+  res += std::format("\n rip: {} rflags: {}\n",
+                     detail::toHex(threadState.rip),
+                     detail::toHex(threadState.rflags));
+  res += std::format(" cs: {} fs: {} gs: {}\n", detail::toHex(threadState.cs),
+                     detail::toHex(threadState.fs),
+                     detail::toHex(threadState.gs));
+  return res;
+}
+}  // namespace
+
 consteval u32 Target::byteArrayToInt(const MagicBytes& bytes) {
   return (std::to_integer<u32>(bytes[3]) << 24) |
          (std::to_integer<u32>(bytes[2]) << 16) |
@@ -18,10 +83,56 @@ consteval u32 Target::byteArrayToInt(const MagicBytes& bytes) {
 std::unique_ptr<Target> Target::create(const std::string& path) {
 #ifdef __APPLE__
   return std::make_unique<Macho>(std::ifstream(path), path);
+#elif defined(__linux__)
+  return std::make_unique<Elf>(std::ifstream(path), path);
 #endif
   return nullptr;
 }
 
+std::unique_ptr<Target> Target::createCore(const std::string& path,
+                                           const std::string& corePath) {
+#ifdef __linux__
+  auto core = std::make_unique<CoreFile>(std::ifstream(path), path);
+  if (core->load(corePath) != 0) return nullptr;
+  return core;
+#else
+#pragma unused(path, corePath)
+  CoreError::error("Core files are not supported on this platform");
+  return nullptr;
+#endif
+}
+
+std::unique_ptr<Target> Target::createAttached(i32 pid) {
+#ifdef __linux__
+  // Opened through the link, which still reaches the running binary once the
+  // file was replaced or deleted
+  const std::string exe = std::format("/proc/{}/exe", pid);
+  std::error_code ec{};
+  const std::filesystem::path path = std::filesystem::read_symlink(exe, ec);
+  if (ec) {
+    CoreError::error(std::format("Cannot read {}: {}", exe, ec.message()));
+    return nullptr;
+  }
+  if (!isFileValid(exe)) {
+    CoreError::error(std::format("{} is not an ELF binary", path.string()));
+    return nullptr;
+  }
+
+  auto elf = std::make_unique<Elf>(std::ifstream(exe), path.string());
+  if (elf->seize(pid) != 0) return nullptr;
+  if (elf->attach() != 0) {
+    elf->detach();
+    return nullptr;
+  }
+  elf->m_started = true;
+  return elf;
+#else
+#pragma unused(pid)
+  CoreError::error("Attaching is not supported on this platform");
+  return nullptr;
+#endif
+}
+
 bool Target::isFileValid(const std::string& filePath) {
   const std::unordered_map<u32, Platform> magics{
       {{byteArrayToInt(MagicBytes{std::byte{0xCF}, std::byte{0xFA},
@@ -47,14 +158,346 @@ bool Target::isFileValid(const std::string& filePath) {
   return magics.at(magicRead) == getPlatform();
 }
 
+void Target::setTargetState(TargetState s) {
+  {
+    const std::lock_guard lock{m_state_mutex};
+    m_state = s;
+  }
+  m_state_cv.notify_all();
+}
+
+void Target::waitWhileRunning() {
+  std::unique_lock lock{m_state_mutex};
+  m_state_cv.wait(lock, [this] { return m_state != TargetState::RUNNING; });
+}
+
 void Target::startEventLoop() {
   m_waiter = std::jthread(&Target::eventLoop, this);
-  while (m_state == TargetState::RUNNING)
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  waitWhileRunning();
   if (m_waiter.joinable()) m_waiter.join();
 }
 
-std::map<u64, Breakpoint>& Target::getRegisteredBreakpoints() {
+i32 Target::readMemoryv(std::span<const MemorySlice> slices) {
+  for (const auto& slice : slices)
+    if (readMemory(slice.addr, slice.buf) != 0) return -1;
+  return 0;
+}
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+i32 Target::interrupt() {
+  CoreError::error("Interrupting is not supported on this platform");
+  return -1;
+}
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+i32 Target::setWatchpoint(u64 addr, u8 len, WatchKind kind) {
+#pragma unused(addr, len, kind)
+  CoreError::error("Hardware watchpoints are not supported on this platform");
+  return -1;
+}
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+i32 Target::removeWatchpoint(u32 id) {
+#pragma unused(id)
+  CoreError::error("Hardware watchpoints are not supported on this platform");
+  return -1;
+}
+
+u64 Target::readRegister(const RegEntryT& regEntry) {
+  const auto group = registerGroup(regEntry.group);
+  if (group.empty()) return 0;
+
+  u64 val = 0;
+  memcpy(&val, group.data() + regEntry.offset, regEntry.size);
+  return val;
+}
+
+u64 Target::writeRegValue(const RegEntryT& regEntry, u64 val) {
+  ThreadInfo* thread = m_threads.selected();
+  const auto group = registerGroup(regEntry.group);
+  if (thread == nullptr || group.empty()) return -1;
+
+  m_page_cache.invalidate();
+  memcpy(group.data() + regEntry.offset, &val, regEntry.size);
+  thread->markDirty(regEntry.group);
+  return 0;
+}
+
+i32 Target::setNonStop(bool enable) {
+  if (enable) {
+    CoreError::error("Non-stop mode is not supported on this platform");
+    return -1;
+  }
+  m_non_stop = false;
+  return 0;
+}
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+i32 Target::generateCore(const std::string& path, bool referenceFiles,
+                         CoreDumpStats& stats) {
+#pragma unused(path, referenceFiles, stats)
+  CoreError::error("Core dumps are not supported on this platform");
+  return -1;
+}
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+i32 Target::checkpoint() {
+  CoreError::error("Checkpoints are not supported on this platform");
+  return -1;
+}
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+i32 Target::restoreCheckpoint(u32 id) {
+#pragma unused(id)
+  CoreError::error("Checkpoints are not supported on this platform");
+  return -1;
+}
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+i32 Target::traceSyscalls(const std::vector<std::string>& names, bool print) {
+#pragma unused(names, print)
+  CoreError::error("Syscall tracing is not supported on this platform");
+  return -1;
+}
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+i32 Target::stopSyscallTrace() {
+  CoreError::error("Syscall tracing is not supported on this platform");
+  return -1;
+}
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+std::string Target::syscallSummary() {
+  return "Syscall tracing is not supported on this platform";
+}
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+i32 Target::profile(ProfileMode mode, double seconds, u32 hz, Profile& out) {
+#pragma unused(mode, seconds, hz, out)
+  CoreError::error("Profiling is not supported on this platform");
+  return -1;
+}
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+i32 Target::backtrace(size_t maxDepth, std::vector<StackFrame>& out) {
+#pragma unused(maxDepth, out)
+  CoreError::error("Backtraces are not supported on this platform");
+  return -1;
+}
+
+i32 Target::resumeThread(i32 tid) {
+#pragma unused(tid)
+  CoreError::error("Resuming single threads is not supported on this platform");
+  return -1;
+}
+
+i32 Target::readMemoryCached(u64 addr, std::span<std::byte> out) {
+  const MemorySlice slice{.addr = addr, .buf = out};
+  return readMemoryCachedv({&slice, 1});
+}
+
+i32 Target::readMemoryCachedv(std::span<const MemorySlice> slices) {
+  // Memory of a running target changes under the cache, also when only
+  // some of its threads run
+  if (m_state == TargetState::RUNNING || m_threads.anyRunning())
+    return readMemoryv(slices);
+  return m_page_cache.read(slices, [this](std::span<const MemorySlice> s) {
+    return readMemoryv(s);
+  });
+}
+
+i32 Target::setBreakpoints(std::span<const u64> addrs) {
+  std::vector<u64> pending(addrs.begin(), addrs.end());
+  std::ranges::sort(pending);
+  const auto [first, last] = std::ranges::unique(pending);
+  pending.erase(first, last);
+  // Re-arming would save the trap itself as the original instruction
+  std::erase_if(pending, [this](u64 addr) {
+    const Breakpoint* bp = m_breakpoints.find(addr);
+    return bp != nullptr && bp->enabled;
+  });
+
+  return patchBreakpoints(pending, true);
+}
+
+i32 Target::disableBreakpoints(std::span<const u64> addrs, bool remove) {
+  std::vector<u64> pending{};
+  pending.reserve(addrs.size());
+  for (const u64 addr : addrs) {
+    const Breakpoint* bp = m_breakpoints.find(addr);
+    if (bp == nullptr) continue;
+    if (bp->enabled) {
+      pending.push_back(addr);
+    } else if (remove) {
+      m_breakpoints.erase(addr);
+      m_conditions.erase(addr);
+      m_tracepoints.erase(addr);
+    }
+  }
+  std::ranges::sort(pending);
+  const auto [first, last] = std::ranges::unique(pending);
+  pending.erase(first, last);
+
+  const i32 res = patchBreakpoints(pending, false);
+  if (res != 0 || !remove) return res;
+
+  for (const u64 addr : pending) {
+    m_breakpoints.erase(addr);
+    m_conditions.erase(addr);
+    m_tracepoints.erase(addr);
+  }
+  return 0;
+}
+
+i32 Target::setBreakpointCondition(u64 addr, ConditionProgram program) {
+  Breakpoint* bp = m_breakpoints.find(addr);
+  if (bp == nullptr) return -1;
+
+  bp->flags |= static_cast<u8>(BreakpointFlag::CONDITIONAL);
+  m_conditions.insert_or_assign(addr, std::move(program));
+  return 0;
+}
+
+const ConditionProgram* Target::getBreakpointCondition(u64 addr) const {
+  auto it = m_conditions.find(addr);
+  return it != m_conditions.end() ? &it->second : nullptr;
+}
+
+i32 Target::setTracepoint(u64 addr, TraceSpec spec) {
+  Breakpoint* bp = m_breakpoints.find(addr);
+  if (bp == nullptr) return -1;
+  if (spec.regs.size() > TraceSpec::MAX_REGS ||
+      spec.mem_len > TraceSpec::MAX_BYTES ||
+      (spec.mem_len != 0 && spec.mem_base == nullptr))
+    return -1;
+
+  bp->flags |= static_cast<u8>(BreakpointFlag::TRACE);
+  m_tracepoints.insert_or_assign(addr, m_tracer.addSpec(std::move(spec)));
+  m_tracer.start();
+  return 0;
+}
+
+const TraceSpec* Target::getTracepoint(u64 addr) const {
+  auto it = m_tracepoints.find(addr);
+  return it != m_tracepoints.end() ? &m_tracer.spec(it->second) : nullptr;
+}
+
+void Target::captureTrace(u64 addr, const Breakpoint& bp) {
+  auto it = m_tracepoints.find(addr);
+  if (it == m_tracepoints.end()) return;
+
+  const TraceSpec& spec = m_tracer.spec(it->second);
+  const ThreadState& state = getLastKnownThreadState();
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init)
+  TraceRecord rec;
+  rec.timestamp_ns = static_cast<u64>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+  rec.addr = addr;
+  rec.spec = it->second;
+  rec.bp_id = bp.id;
+  rec.mem_addr = 0;
+  rec.mem_len = 0;
+  for (size_t i = 0; i < spec.regs.size(); i++)
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+    rec.regs[i] = readRegValue(state, *spec.regs[i]);
+
+  if (spec.mem_len != 0) {
+    rec.mem_addr = readRegValue(state, *spec.mem_base) +
+                   static_cast<u64>(spec.mem_offset);
+    if (readMemory(rec.mem_addr, {rec.mem.data(), spec.mem_len}) == 0)
+      rec.mem_len = spec.mem_len;
+  }
+
+  m_tracer.record(rec);
+}
+
+bool Target::breakpointHit(u64 addr) {
+  Breakpoint* bp = m_breakpoints.find(addr);
+  if (bp == nullptr) return true;
+
+  if (bp->has(BreakpointFlag::CONDITIONAL)) {
+    const ConditionProgram* cond = getBreakpointCondition(addr);
+    if (cond != nullptr && !cond->evaluate(getLastKnownThreadState()))
+      return false;
+  }
+
+  bp->hit_count++;
+  const bool trace = bp->has(BreakpointFlag::TRACE);
+  if (trace) captureTrace(addr, *bp);
+  // Gone after the first hit that counts, the step over finds nothing to lift
+  if (bp->has(BreakpointFlag::ONE_SHOT)) disableBreakpoints({&addr, 1}, true);
+  return !trace;
+}
+
+i32 Target::patchBreakpoints(std::span<const u64> sorted, bool arm) {
+  if (sorted.empty()) return 0;
+  if (arm) m_breakpoints.reserve(m_breakpoints.size() + sorted.size());
+
+  // Consecutive addresses on the same page share one [lo, hi) window that is
+  // read once, patched locally and written back once
+  struct Window {
+    u64 lo;
+    u64 hi;
+    size_t first;
+    size_t count;
+    std::vector<std::byte> bytes;
+  };
+
+  std::vector<Window> windows{};
+  for (size_t i = 0; i < sorted.size(); i++) {
+    const u64 actual = sorted[i] + m_aslr_slide;
+    const u64 page = actual & ~(PageCache::PAGE_BYTES - 1);
+    if (windows.empty() ||
+        (windows.back().lo & ~(PageCache::PAGE_BYTES - 1)) != page) {
+      windows.push_back({.lo = actual, .hi = actual, .first = i, .count = 0});
+    }
+    windows.back().hi = actual + trapIns.size();
+    windows.back().count++;
+  }
+
+  std::vector<MemorySlice> slices{};
+  slices.reserve(windows.size());
+  for (auto& w : windows) {
+    w.bytes.resize(w.hi - w.lo);
+    slices.push_back({.addr = w.lo, .buf = w.bytes});
+  }
+  if (readMemoryv(slices) != 0) return -1;
+
+  std::vector<Breakpoint> armed{};
+  for (auto& w : windows) {
+    armed.clear();
+    for (size_t i = w.first; i < w.first + w.count; i++) {
+      std::byte* ins = w.bytes.data() + (sorted[i] + m_aslr_slide - w.lo);
+      if (arm) {
+        // Re-armed ones keep their id, hit count and flags
+        const Breakpoint* old = m_breakpoints.find(sorted[i]);
+        Breakpoint bp = old != nullptr ? *old : Breakpoint{.orig_ins = 0};
+        bp.enabled = true;
+        memcpy(&bp.orig_ins, ins, trapIns.size());
+        memcpy(ins, trapIns.data(), trapIns.size());
+        armed.push_back(bp);
+      } else {
+        memcpy(ins, &m_breakpoints.find(sorted[i])->orig_ins, trapIns.size());
+      }
+    }
+
+    // The table follows memory one window at a time, a failed write leaves
+    // the records of that window and the ones after it as they were
+    if (writeMemory(w.lo, w.bytes) != 0) return -1;
+    for (size_t i = w.first; i < w.first + w.count; i++) {
+      if (arm)
+        m_breakpoints.insert(sorted[i], armed[i - w.first]);
+      else
+        m_breakpoints.find(sorted[i])->enabled = false;
+    }
+  }
+  return 0;
+}
+
+BreakpointTable& Target::getRegisteredBreakpoints() {
   return m_breakpoints;
 }
 
@@ -69,23 +512,5 @@ std::string Target::getInfo() {
 
 // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
 std::string Target::formatRegisterOutput(ThreadState* threadState) const {
-  std::string res{};
-  constexpr int regsPerRow = 4;
-  for (int i = 0; i < 29; i++) {
-    res += std::format(
-        " x{:<2}: {}", i,
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
-        detail::toHex(threadState->x[i]));
-    if ((i + 1) % regsPerRow == 0)
-      res += '\n';
-    else
-      res += "  ";
-  }
-
-  res += std::format("\n fp: {} lr: {}\n", detail::toHex(threadState->fp),
-                     detail::toHex(threadState->lr));
-  res += std::format(" sp: {} pc: {}\n", detail::toHex(threadState->sp),
-                     detail::toHex(threadState->pc));
-  res += std::format(" cpsr: {}\n", detail::toHex(threadState->cpsr));
-  return res;
+  return formatThreadState(*threadState);
 }
@@ -2,13 +2,26 @@
 #define CAESAR_TARGET_H
 
 #include <atomic>
+#include <condition_variable>
 #include <cstddef>
 #include <fstream>
-#include <map>
 #include <memory>
+#include <mutex>
+#include <span>
+#include <string>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
+#include "core/breakpoint_table.hpp"
+#include "core/condition.hpp"
+#include "core/page_cache.hpp"
 #include "core/platform.hpp"
+#include "core/profile.hpp"
+#include "core/thread_table.hpp"
+#include "core/trace.hpp"
+#include "core/unwind.hpp"
+#include "core/watchpoint.hpp"
 #include "typedefs.hpp"
 #include "util.hpp"
 
@@ -16,10 +29,26 @@ enum class TargetState : u8 { STOPPED, RUNNING, EXITED };
 enum class BinaryType : u8 { MACHO, ELF, PE };
 enum class TargetError : u8 { FORK_FAIL };
 enum class ResumeType : u8 { RESUME };
+// How a resume gets past the breakpoint it is stopped on. INLINE briefly
+// restores the original instruction, DISPLACED runs a copy of it elsewhere so
+// the trap never leaves the text
+enum class StepMode : u8 { INLINE, DISPLACED };
 
-struct Breakpoint {
-  u32 orig_ins;
-  bool enabled;
+// Filled in by Target::generateCore, sizes in bytes
+struct CoreDumpStats {
+  u64 mapped = 0;      // Covered by the PT_LOAD segments
+  u64 read = 0;        // Requested from the target
+  u64 written = 0;     // Of what was read, the rest are zero or unreadable
+  u64 referenced = 0;  // Read-only file contents left to NT_FILE
+  double pause_ms = 0;  // Until the last read from the target returned
+  double total_ms = 0;
+};
+
+// Parked copy of the target taken by Target::checkpoint
+struct Checkpoint {
+  u32 id;
+  i32 pid;
+  ThreadState regs;  // Where the copy continues once restored
 };
 
 class Target {
@@ -30,9 +59,24 @@ class Target {
   std::ifstream m_file;
   std::string m_file_path;
   std::jthread m_waiter;
-  std::map<u64, Breakpoint> m_breakpoints;
+  BreakpointTable m_breakpoints;
+  ThreadTable m_threads;
+  std::unordered_map<u64, ConditionProgram> m_conditions;
+  std::unordered_map<u64, u32> m_tracepoints;  // Address to tracer spec
   i32 m_pid = 0;
+  u64 m_aslr_slide = 0;
   std::atomic<TargetState> m_state = TargetState::STOPPED;
+  std::mutex m_state_mutex;
+  std::condition_variable m_state_cv;
+  // Backends invalidate it on resume and on every register or memory write
+  PageCache m_page_cache;
+  Tracer m_tracer;
+  WatchpointSlots m_watchpoints{};
+  u32 m_next_watch_id = 1;
+  std::vector<Checkpoint> m_checkpoints;
+  u32 m_next_checkpoint_id = 1;
+  StepMode m_step_mode = StepMode::INLINE;
+  bool m_non_stop = false;
   bool m_is_64 = false;
 
   explicit Target(std::ifstream f, std::string filePath)
@@ -41,6 +85,11 @@ class Target {
   virtual void readMagic() = 0;
   virtual void is64() = 0;
 
+  // Writes or removes the traps at sorted unslid addresses. Records follow
+  // memory one page at a time, so they stay right when a write fails
+  i32 patchBreakpoints(std::span<const u64> sorted, bool arm);
+  void captureTrace(u64 addr, const Breakpoint& bp);
+
  public:
   bool m_started = false;
 
@@ -52,23 +101,109 @@ class Target {
   virtual i32 setBreakpoint(u64 addr) = 0;
   virtual i32 disableBreakpoint(u64 addr, bool remove) = 0;
   virtual i32 launch(detail::CStringArray& argList) = 0;
-  virtual void detach() = 0;
+  // Removes every breakpoint and watchpoint and lets all threads carry on
+  // untraced
+  virtual i32 detach() = 0;
   virtual void eventLoop() = 0;
   virtual void resume(ResumeType cond) = 0;
+  // Continues one stopped thread and leaves the others as they are
+  virtual i32 resumeThread(i32 tid);
   virtual void setThreadState(ThreadState* state) = 0;
   virtual ThreadState& getLastKnownThreadState() = 0;
-  virtual u64 writeRegValue(const RegEntryT& regEntry, u64 val) = 0;
+  // Register group of the selected thread, fetched on first use during a
+  // stop. Empty when it cannot be read
+  virtual std::span<std::byte> registerGroup(RegGroup group) = 0;
+  u64 readRegister(const RegEntryT& regEntry);
+  // Only marks the group dirty, it is written back right before resuming
+  u64 writeRegValue(const RegEntryT& regEntry, u64 val);
+  virtual i32 readMemory(u64 addr, std::span<std::byte> out) = 0;
+  virtual i32 writeMemory(u64 addr, std::span<const std::byte> in) = 0;
+  virtual i32 readMemoryv(std::span<const MemorySlice> slices);
+  // Arm or disarm many breakpoints with one read and one write per page
+  virtual i32 setBreakpoints(std::span<const u64> addrs);
+  virtual i32 disableBreakpoints(std::span<const u64> addrs, bool remove);
+  i32 setBreakpointCondition(u64 addr, ConditionProgram program);
+  const ConditionProgram* getBreakpointCondition(u64 addr) const;
+  i32 setTracepoint(u64 addr, TraceSpec spec);
+  const TraceSpec* getTracepoint(u64 addr) const;
+  Tracer& getTracer() { return m_tracer; }
+  // Called by the backends when a breakpoint traps, false means its condition
+  // does not hold or it is a tracepoint, and the target should be resumed
+  // without reporting a stop. One-shot breakpoints are removed here
+  bool breakpointHit(u64 addr);
+  // Hardware watchpoints on runtime addresses, returns the watchpoint id or -1.
+  // Unsupported unless the backend overrides them
+  virtual i32 setWatchpoint(u64 addr, u8 len, WatchKind kind);
+  virtual i32 removeWatchpoint(u32 id);
+  const WatchpointSlots& getWatchpoints() const { return m_watchpoints; }
+  // Writes an ELF core of the stopped target. With referenceFiles read-only
+  // file mappings are only named, not copied. Unsupported unless the backend
+  // overrides it
+  virtual i32 generateCore(const std::string& path, bool referenceFiles,
+                           CoreDumpStats& stats);
+  // Saves a copy-on-write copy of the stopped target and returns its id, or
+  // -1. Unsupported unless the backend overrides it
+  virtual i32 checkpoint();
+  // Replaces the target with a fresh copy of checkpoint id, which stays
+  // available to be restored again
+  virtual i32 restoreCheckpoint(u32 id);
+  const std::vector<Checkpoint>& getCheckpoints() const {
+    return m_checkpoints;
+  }
+  // Reports the syscalls in names, every one if empty, through an in-kernel
+  // filter so the others run at full speed. print shows each call as it
+  // returns, otherwise they are only counted. Unsupported unless the backend
+  // overrides them
+  virtual i32 traceSyscalls(const std::vector<std::string>& names,
+                            bool print);
+  virtual i32 stopSyscallTrace();
+  // Counts and latency histograms of the calls traced so far
+  virtual std::string syscallSummary();
+  // Lets the target run for seconds while sampling the stack of every thread
+  // hz times a second, stopped again afterwards unless it exited. Unsupported
+  // unless the backend overrides it
+  virtual i32 profile(ProfileMode mode, double seconds, u32 hz, Profile& out);
+  // Frames of the selected thread, innermost first, at most maxDepth of them.
+  // Unsupported unless the backend overrides it
+  virtual i32 backtrace(size_t maxDepth, std::vector<StackFrame>& out);
+  // In non-stop mode a stop only halts the thread that reported it, the
+  // others keep running. Unsupported unless the backend overrides it
+  virtual i32 setNonStop(bool enable);
+  bool isNonStop() const { return m_non_stop; }
+  void setStepMode(StepMode mode) { m_step_mode = mode; }
+  StepMode getStepMode() const { return m_step_mode; }
+  i32 readMemoryCached(u64 addr, std::span<std::byte> out);
+  i32 readMemoryCachedv(std::span<const MemorySlice> slices);
+  PageCache& getPageCache() { return m_page_cache; }
 
-  void setTargetState(TargetState s) { m_state = s; }
+  void setTargetState(TargetState s);
   std::atomic<TargetState>& getTargetState() { return m_state; }
+  void waitWhileRunning();
   i32 pid() const { return m_pid; }
-  void startEventLoop();
-  std::map<u64, Breakpoint>& getRegisteredBreakpoints();
+  virtual void startEventLoop();
+  // Handles what the target reported so far and returns while it runs, the
+  // backend reports later stops from the reactor. Blocks like
+  // startEventLoop unless the backend overrides it
+  virtual void startBackground() { startEventLoop(); }
+  // Stops every running thread without a signal. Unsupported unless the
+  // backend overrides it
+  virtual i32 interrupt();
+  BreakpointTable& getRegisteredBreakpoints();
+  ThreadTable& getThreads() { return m_threads; }
+  // getLastKnownThreadState and register writes act on the selected thread
+  bool selectThread(i32 tid) { return m_threads.select(tid); }
   std::string getInfo();
   std::string formatRegisterOutput(ThreadState* threadState) const;
 
   static bool isFileValid(const std::string& filePath);
   static std::unique_ptr<Target> create(const std::string& path);
+  // Post-mortem target of binary path over corePath, nullptr if the core
+  // cannot be loaded
+  static std::unique_ptr<Target> createCore(const std::string& path,
+                                            const std::string& corePath);
+  // Target of the running process pid with all of its threads stopped,
+  // nullptr if it cannot be attached to
+  static std::unique_ptr<Target> createAttached(i32 pid);
 };
 
 #endif
@@ -0,0 +1,67 @@
+#include "thread_table.hpp"
+
+#include <algorithm>
+
+std::span<std::byte> ThreadInfo::group(RegGroup group) {
+  switch (group) {
+    case RegGroup::GPR:
+      return std::as_writable_bytes(std::span{&regs, 1});
+    case RegGroup::FP:
+      return std::as_writable_bytes(std::span{&fp_regs, 1});
+    case RegGroup::DEBUG:
+      return std::as_writable_bytes(std::span{&debug_regs, 1});
+  }
+  return {};
+}
+
+ThreadInfo& ThreadTable::add(i32 tid) {
+  auto [it, inserted] = m_threads.try_emplace(tid);
+  if (inserted) it->second.tid = tid;
+  // The first thread, the process itself, starts out selected
+  if (m_selected == 0) m_selected = tid;
+  return it->second;
+}
+
+void ThreadTable::remove(i32 tid) {
+  m_threads.erase(tid);
+  if (m_selected != tid) return;
+  m_selected = m_threads.empty() ? 0 : tids().front();
+}
+
+void ThreadTable::clear() {
+  m_threads.clear();
+  m_selected = 0;
+}
+
+ThreadInfo* ThreadTable::find(i32 tid) {
+  auto it = m_threads.find(tid);
+  return it != m_threads.end() ? &it->second : nullptr;
+}
+
+const ThreadInfo* ThreadTable::find(i32 tid) const {
+  auto it = m_threads.find(tid);
+  return it != m_threads.end() ? &it->second : nullptr;
+}
+
+bool ThreadTable::select(i32 tid) {
+  if (!contains(tid)) return false;
+  m_selected = tid;
+  return true;
+}
+
+void ThreadTable::invalidate() {
+  for (auto& [tid, thread] : m_threads) thread.valid = 0;
+}
+
+bool ThreadTable::anyRunning() const {
+  return std::ranges::any_of(
+      m_threads, [](const auto& entry) { return entry.second.running; });
+}
+
+std::vector<i32> ThreadTable::tids() const {
+  std::vector<i32> res{};
+  res.reserve(m_threads.size());
+  for (const auto& [tid, thread] : m_threads) res.push_back(tid);
+  std::ranges::sort(res);
+  return res;
+}
@@ -0,0 +1,77 @@
+#ifndef CAESAR_THREAD_TABLE_HPP
+#define CAESAR_THREAD_TABLE_HPP
+
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/platform.hpp"
+#include "typedefs.hpp"
+
+struct ThreadInfo {
+  i32 tid = 0;  // Kernel tid on Linux, thread port on Mach
+  ThreadState regs{};
+  FloatState fp_regs{};
+  DebugState debug_regs{};
+  // groupBit masks, valid groups were fetched during the current stop and
+  // dirty ones are written back right before the thread is resumed
+  u8 valid = 0;
+  u8 dirty = 0;
+  bool running = false;
+  std::string stop_reason;
+  int pending_signal = 0;  // Delivered when the thread is resumed
+  // Wait status collected while stopping all threads, reported before
+  // anything is resumed again
+  std::optional<int> pending_status;
+  // Breakpoint the thread is stopped on, stepped over when it is resumed
+  std::optional<u64> step_over;
+
+  [[nodiscard]] bool has(RegGroup group) const {
+    return (valid & groupBit(group)) != 0;
+  }
+  [[nodiscard]] bool isDirty(RegGroup group) const {
+    return (dirty & groupBit(group)) != 0;
+  }
+  void markDirty(RegGroup group) { dirty |= groupBit(group); }
+  // Storage of a group, whether or not it was fetched
+  std::span<std::byte> group(RegGroup group);
+};
+
+// Threads of the target keyed by tid, kept current from clone and exit
+// events. Registers are cached per stop and only fetched for threads that
+// are looked at
+class ThreadTable {
+ public:
+  ThreadInfo& add(i32 tid);
+  void remove(i32 tid);
+  void clear();
+
+  ThreadInfo* find(i32 tid);
+  [[nodiscard]] const ThreadInfo* find(i32 tid) const;
+  [[nodiscard]] bool contains(i32 tid) const { return find(tid) != nullptr; }
+
+  bool select(i32 tid);
+  ThreadInfo* selected() { return find(m_selected); }
+  [[nodiscard]] i32 selectedTid() const { return m_selected; }
+
+  // Cached registers are stale once the threads run again
+  void invalidate();
+  [[nodiscard]] std::vector<i32> tids() const;  // Sorted
+  [[nodiscard]] size_t size() const { return m_threads.size(); }
+  [[nodiscard]] bool empty() const { return m_threads.empty(); }
+  // Some keep running while others are stopped in non-stop mode
+  [[nodiscard]] bool anyRunning() const;
+
+  auto begin() { return m_threads.begin(); }
+  auto end() { return m_threads.end(); }
+  [[nodiscard]] auto begin() const { return m_threads.begin(); }
+  [[nodiscard]] auto end() const { return m_threads.end(); }
+
+ private:
+  std::unordered_map<i32, ThreadInfo> m_threads;
+  i32 m_selected = 0;
+};
+
+#endif
@@ -0,0 +1,155 @@
+#include "trace.hpp"
+
+#include <format>
+#include <string_view>
+#include <utility>
+
+#include "util.hpp"
+
+Tracer::~Tracer() {
+  stop();
+  if (m_out != stdout) std::fclose(m_out);
+}
+
+u32 Tracer::addSpec(TraceSpec spec) {
+  const std::lock_guard lock{m_mutex};
+  m_specs.push_back(std::make_unique<TraceSpec>(std::move(spec)));
+  return static_cast<u32>(m_specs.size() - 1);
+}
+
+// Only called from the thread that adds specs, the consumer takes m_mutex
+const TraceSpec& Tracer::spec(u32 idx) const { return *m_specs[idx]; }
+
+void Tracer::record(const TraceRecord& rec) {
+  if (!m_ring.tryPush(rec)) {
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  m_recorded.fetch_add(1, std::memory_order_relaxed);
+  // Pairs with the fence in consume(), either the consumer sees the record
+  // or this sees it sleeping
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (m_sleeping.load(std::memory_order_relaxed)) wake();
+}
+
+void Tracer::wake() {
+  m_sleeping.store(false, std::memory_order_relaxed);
+  m_sleeping.notify_one();
+}
+
+i32 Tracer::setOutput(const std::string& path) {
+  std::FILE* out = stdout;
+  if (!path.empty()) {
+    out = std::fopen(path.c_str(), "w");
+    if (out == nullptr) return -1;
+  }
+
+  const std::lock_guard lock{m_mutex};
+  if (m_out != stdout) std::fclose(m_out);
+  m_out = out;
+  m_out_path = path;
+  return 0;
+}
+
+void Tracer::setStdoutNotify(std::function<void()> notify) {
+  const std::lock_guard lock{m_mutex};
+  m_stdout_notify = std::move(notify);
+}
+
+std::string Tracer::takeStdout() {
+  const std::lock_guard lock{m_mutex};
+  return std::exchange(m_stdout_pending, {});
+}
+
+std::string Tracer::outputName() const {
+  const std::lock_guard lock{m_mutex};
+  return m_out_path.empty() ? "stdout" : m_out_path;
+}
+
+TraceStats Tracer::stats() const {
+  return {.recorded = m_recorded.load(std::memory_order_relaxed),
+          .dropped = m_dropped.load(std::memory_order_relaxed),
+          .written = m_written.load(std::memory_order_relaxed)};
+}
+
+void Tracer::start() {
+  if (m_consumer.joinable()) return;
+  m_consumer =
+      std::jthread([this](const std::stop_token& token) { consume(token); });
+}
+
+void Tracer::stop() {
+  if (!m_consumer.joinable()) return;
+  m_consumer.request_stop();
+  m_consumer.join();
+}
+
+size_t Tracer::drain() {
+  size_t count = 0;
+  std::string out{};
+  TraceRecord rec{};
+
+  const std::lock_guard lock{m_mutex};
+  while (m_ring.tryPop(rec)) {
+    out += formatRecord(rec, *m_specs[rec.spec]);
+    count++;
+  }
+  if (count == 0) return 0;
+
+  if (m_out == stdout && m_stdout_notify) {
+    m_stdout_pending += out;
+    m_stdout_notify();
+  } else {
+    std::fwrite(out.data(), 1, out.size(), m_out);
+    std::fflush(m_out);
+  }
+  m_written.fetch_add(count, std::memory_order_relaxed);
+  return count;
+}
+
+void Tracer::consume(const std::stop_token& token) {
+  const std::stop_callback onStop{token, [this] { wake(); }};
+  while (!token.stop_requested()) {
+    if (drain() != 0) continue;
+    m_sleeping.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // Pushed before the flag was visible, nobody would wake us for it
+    if (!m_ring.empty() || token.stop_requested()) {
+      m_sleeping.store(false, std::memory_order_relaxed);
+      continue;
+    }
+    m_sleeping.wait(true, std::memory_order_relaxed);
+  }
+  drain();
+}
+
+std::string Tracer::formatRecord(const TraceRecord& rec,
+                                 const TraceSpec& spec) {
+  constexpr u64 nsPerUs = 1000;
+  constexpr u64 usPerSec = 1000000;
+  const u64 us = rec.timestamp_ns / nsPerUs;
+
+  std::string res = std::format("[{}.{:06}] #{} @ {}", us / usPerSec,
+                                us % usPerSec, rec.bp_id,
+                                detail::toHex(rec.addr));
+  for (size_t i = 0; i < spec.regs.size(); i++)
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+    res += std::format(" {}={:#x}", spec.reg_names[i], rec.regs[i]);
+
+  if (spec.mem_len != 0) {
+    res += std::format(" [{}{:+}]", spec.mem_base_name, spec.mem_offset);
+    if (rec.mem_len == 0) res += " <unreadable>";
+    // One std::format per byte would dominate the whole record
+    constexpr std::string_view digits = "0123456789abcdef";
+    for (size_t i = 0; i < rec.mem_len; i++) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+      const auto b = std::to_integer<u8>(rec.mem[i]);
+      res += ' ';
+      res += digits[b >> 4];
+      res += digits[b & 0xF];
+    }
+  }
+
+  res += '\n';
+  return res;
+}
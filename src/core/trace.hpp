@@ -0,0 +1,113 @@
+#ifndef CAESAR_TRACE_HPP
+#define CAESAR_TRACE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/platform.hpp"
+#include "core/ring_buffer.hpp"
+#include "typedefs.hpp"
+
+// What a tracepoint captures on every hit, immutable once registered
+struct TraceSpec {
+  static constexpr size_t MAX_REGS = 8;
+  static constexpr size_t MAX_BYTES = 128;
+
+  std::vector<std::string> reg_names;
+  std::vector<const RegEntryT*> regs;
+  // Optional memory capture of mem_len bytes at mem_base + mem_offset
+  const RegEntryT* mem_base = nullptr;
+  std::string mem_base_name;
+  i64 mem_offset = 0;
+  u32 mem_len = 0;
+};
+
+// Raw capture of one hit, formatted later by the consumer thread
+struct TraceRecord {
+  u64 timestamp_ns;
+  u64 addr;
+  u64 mem_addr;
+  u32 spec;
+  u32 bp_id;
+  u32 mem_len;  // 0 when nothing was requested or the read failed
+  std::array<u64, TraceSpec::MAX_REGS> regs;
+  std::array<std::byte, TraceSpec::MAX_BYTES> mem;
+};
+
+struct TraceStats {
+  u64 recorded;
+  u64 dropped;  // Hits lost because the ring was full
+  u64 written;
+};
+
+// Owns the tracepoint ring. The event loop is the only producer, a consumer
+// thread started with the first tracepoint drains it to the output file, so
+// nothing is formatted or printed on the trapping path
+class Tracer {
+ public:
+  static constexpr size_t RING_SIZE = 4096;
+  using Ring = SpscRing<TraceRecord, RING_SIZE>;
+
+  Tracer() = default;
+  ~Tracer();
+  Tracer(const Tracer&) = delete;
+  Tracer& operator=(const Tracer&) = delete;
+  Tracer(Tracer&&) = delete;
+  Tracer& operator=(Tracer&&) = delete;
+
+  // Specs are never removed so records still in flight stay printable
+  u32 addSpec(TraceSpec spec);
+  [[nodiscard]] const TraceSpec& spec(u32 idx) const;
+
+  // Producer side, counts a drop instead of blocking when the ring is full
+  void record(const TraceRecord& rec);
+
+  // Empty path means stdout
+  i32 setOutput(const std::string& path);
+  // Hands stdout records to the thread owning the terminal: the consumer
+  // queues them and calls notify, that thread prints takeStdout(). Without
+  // one the consumer writes stdout itself
+  void setStdoutNotify(std::function<void()> notify);
+  std::string takeStdout();
+  [[nodiscard]] std::string outputName() const;
+  [[nodiscard]] TraceStats stats() const;
+  [[nodiscard]] size_t pending() const { return m_ring.size(); }
+
+  void start();
+  // Drains whatever is left and joins the consumer
+  void stop();
+  // Formats and writes all queued records, returns how many were written
+  size_t drain();
+
+  static std::string formatRecord(const TraceRecord& rec,
+                                  const TraceSpec& spec);
+
+ private:
+  Ring m_ring;
+  std::vector<std::unique_ptr<TraceSpec>> m_specs;
+  mutable std::mutex m_mutex;  // Guards m_specs growth and the output
+  std::FILE* m_out = stdout;
+  std::string m_out_path;
+  std::function<void()> m_stdout_notify;
+  std::string m_stdout_pending;  // Queued for the notified thread
+  std::jthread m_consumer;
+  // Set while the consumer waits for records, only then does record() pay
+  // for a wake-up
+  std::atomic<bool> m_sleeping{false};
+  std::atomic<u64> m_recorded{0};
+  std::atomic<u64> m_dropped{0};
+  std::atomic<u64> m_written{0};
+
+  void consume(const std::stop_token& token);
+  void wake();
+};
+
+#endif
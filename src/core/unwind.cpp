@@ -0,0 +1,143 @@
+#include "unwind.hpp"
+
+#include <cstring>
+
+#include "core/dwarf/cfi.hpp"
+
+bool StackSnapshot::read(u64 addr, u64& out) const {
+  if (addr < base || addr - base > bytes.size() ||
+      bytes.size() - (addr - base) < sizeof(u64))
+    return false;
+  std::memcpy(&out, bytes.data() + (addr - base), sizeof(u64));
+  return true;
+}
+
+std::vector<u64> walkFramePointers(u64 pc, u64 rbp,
+                                   const StackSnapshot& stack,
+                                   size_t maxDepth) {
+  std::vector<u64> pcs{};
+  if (maxDepth == 0) return pcs;
+  pcs.push_back(pc);
+
+  // [rbp] is the caller's rbp and [rbp + 8] the return address
+  u64 frame = rbp;
+  while (pcs.size() < maxDepth) {
+    u64 next = 0;
+    u64 ret = 0;
+    if (!stack.read(frame, next) || !stack.read(frame + sizeof(u64), ret) ||
+        ret == 0)
+      break;
+    pcs.push_back(ret);
+    // Frames only ever move towards the stack's base
+    if (next <= frame) break;
+    frame = next;
+  }
+  return pcs;
+}
+
+UnwindStop walkCallFrames(UnwindRegs regs, const StackSnapshot& stack,
+                          FrameSource& frames, size_t maxDepth,
+                          std::vector<u64>& pcs) {
+  using R = UnwindRegs;
+  pcs.clear();
+  // A read past the snapshot may succeed on a larger one
+  const auto missing = [&stack](u64 addr) {
+    return addr >= stack.base + stack.bytes.size() ? UnwindStop::STACK_END
+                                                   : UnwindStop::LOST;
+  };
+
+  // The innermost pc is where the thread is, not a return address
+  bool interrupted = true;
+  while (true) {
+    if (pcs.size() == maxDepth) return UnwindStop::DEPTH;
+    const u64 pc = regs.values[R::RIP];
+    pcs.push_back(pc);
+
+    // A call can be the last instruction of a function, its return address
+    // is already the next one's
+    const CallFrameInfo* cfi = nullptr;
+    const UnwindRow* row = frames.unwindRow(interrupted ? pc : pc - 1, cfi);
+    UnwindRegs caller{};
+
+    if (row == nullptr) {
+      // [rbp] is the caller's rbp and [rbp + 8] the return address
+      if (!regs.has(R::RBP)) return UnwindStop::LOST;
+      const u64 frame = regs.values[R::RBP];
+      u64 next = 0;
+      u64 ret = 0;
+      if (!stack.read(frame, next)) return missing(frame);
+      if (!stack.read(frame + sizeof(u64), ret))
+        return missing(frame + sizeof(u64));
+      caller.set(R::RBP, next);
+      caller.set(R::RSP, frame + (2 * sizeof(u64)));
+      caller.set(R::RIP, ret);
+      interrupted = false;
+    } else {
+      u64 cfa = 0;
+      if (row->cfa.kind == CfiRuleKind::REGISTER && regs.has(row->cfa.reg)) {
+        cfa = regs.values[row->cfa.reg] + static_cast<u64>(row->cfa.offset);
+      } else if (row->cfa.kind == CfiRuleKind::VAL_EXPRESSION) {
+        const auto value = evalCfiExpression(cfi->expression(row->cfa), regs,
+                                             stack, std::nullopt);
+        if (!value) return UnwindStop::LOST;
+        cfa = *value;
+      } else {
+        return UnwindStop::LOST;
+      }
+
+      const CfiRule& ra = row->regs[R::RIP];
+      if (ra.kind == CfiRuleKind::UNDEFINED) return UnwindStop::OUTERMOST;
+      for (size_t reg = 0; reg < R::COUNT; reg++) {
+        const CfiRule& rule = row->regs[reg];
+        u64 value = 0;
+        switch (rule.kind) {
+          case CfiRuleKind::SAME:
+            // Without a rule the caller's rsp is the CFA, registers calls
+            // clobber are only known from a signal frame's rules
+            if (reg == R::RSP)
+              caller.set(reg, cfa);
+            else if (R::calleeSaved(reg) && regs.has(reg))
+              caller.set(reg, regs.values[reg]);
+            break;
+          case CfiRuleKind::UNDEFINED:
+            break;
+          case CfiRuleKind::OFFSET: {
+            const u64 addr = cfa + static_cast<u64>(rule.offset);
+            if (stack.read(addr, value))
+              caller.set(reg, value);
+            else if (reg == R::RIP)
+              return missing(addr);
+            break;
+          }
+          case CfiRuleKind::VAL_OFFSET:
+            caller.set(reg, cfa + static_cast<u64>(rule.offset));
+            break;
+          case CfiRuleKind::REGISTER:
+            if (regs.has(rule.reg)) caller.set(reg, regs.values[rule.reg]);
+            break;
+          case CfiRuleKind::EXPRESSION:
+          case CfiRuleKind::VAL_EXPRESSION: {
+            const auto result =
+                evalCfiExpression(cfi->expression(rule), regs, stack, cfa);
+            if (!result) break;
+            if (rule.kind == CfiRuleKind::VAL_EXPRESSION)
+              caller.set(reg, *result);
+            else if (stack.read(*result, value))
+              caller.set(reg, value);
+            break;
+          }
+        }
+      }
+      if (!caller.has(R::RIP)) return UnwindStop::LOST;
+      interrupted = row->signal;
+    }
+
+    if (caller.values[R::RIP] == 0) return UnwindStop::OUTERMOST;
+    // Frames only ever move towards the stack's base, but a signal handler
+    // can run on a stack of its own
+    if (!interrupted &&
+        (!caller.has(R::RSP) || caller.values[R::RSP] <= regs.values[R::RSP]))
+      return UnwindStop::LOST;
+    regs = caller;
+  }
+}
@@ -0,0 +1,88 @@
+#ifndef CAESAR_UNWIND_HPP
+#define CAESAR_UNWIND_HPP
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "typedefs.hpp"
+
+class CallFrameInfo;
+struct UnwindRow;
+
+// Copy of the top of a thread's stack, taken while it was stopped
+struct StackSnapshot {
+  u64 base;  // Address of bytes[0], the stack pointer at the time
+  std::span<const std::byte> bytes;
+
+  // Word at addr if all of it was copied
+  [[nodiscard]] bool read(u64 addr, u64& out) const;
+};
+
+// Registers of one frame in DWARF numbering, rax to r15 then the return
+// address. Only some of them are known above the innermost frame
+struct UnwindRegs {
+  static constexpr size_t COUNT = 17;
+  static constexpr size_t RBX = 3;
+  static constexpr size_t RBP = 6;
+  static constexpr size_t RSP = 7;
+  static constexpr size_t R12 = 12;
+  static constexpr size_t R15 = 15;
+  static constexpr size_t RIP = 16;
+
+  std::array<u64, COUNT> values{};
+  u32 known = 0;  // One bit per register
+
+  [[nodiscard]] bool has(size_t reg) const {
+    return reg < COUNT && (known & (u32{1} << reg)) != 0;
+  }
+  void set(size_t reg, u64 value) {
+    values[reg] = value;
+    known |= u32{1} << reg;
+  }
+  // rbx, rbp, rsp and r12 to r15 survive calls, the others do not
+  [[nodiscard]] static bool calleeSaved(size_t reg) {
+    return reg == RBX || reg == RBP || reg == RSP || (reg >= R12 && reg <= R15);
+  }
+};
+
+// Where the unwinder finds the CFI of the code at a run-time address
+class FrameSource {
+ public:
+  virtual ~FrameSource() = default;
+  // Row covering the run-time address pc, nullptr without CFI there. cfi gets
+  // the table it came from, the row stays valid until the next call
+  virtual const UnwindRow* unwindRow(u64 pc, const CallFrameInfo*& cfi) = 0;
+};
+
+enum class UnwindStop : u8 {
+  OUTERMOST,  // The return address is undefined, or the chain ends in 0
+  DEPTH,      // maxDepth frames
+  STACK_END,  // A frame is saved beyond the snapshot
+  LOST,       // No CFI and no usable frame pointer, or a frame that does not
+              // move up the stack
+};
+
+struct StackFrame {
+  u64 pc;  // Return address in every frame but the innermost
+  std::string function;
+};
+
+// Return addresses along the rbp chain, leaf pc first, at most maxDepth of
+// them. Stops at the first frame pointer that leaves the snapshot or does
+// not move up the stack, code built without frame pointers ends the walk
+// early
+std::vector<u64> walkFramePointers(u64 pc, u64 rbp,
+                                   const StackSnapshot& stack,
+                                   size_t maxDepth);
+
+// Return addresses of the frames from regs outwards, leaf pc first, at most
+// maxDepth of them. Each frame is unwound with its CFI, frames without any
+// fall back to the rbp chain
+UnwindStop walkCallFrames(UnwindRegs regs, const StackSnapshot& stack,
+                          FrameSource& frames, size_t maxDepth,
+                          std::vector<u64>& pcs);
+
+#endif  // CAESAR_UNWIND_HPP
@@ -0,0 +1,39 @@
+#ifndef CAESAR_WATCHPOINT_HPP
+#define CAESAR_WATCHPOINT_HPP
+
+#include <array>
+#include <string_view>
+
+#include "typedefs.hpp"
+
+enum class WatchKind : u8 { READ, WRITE, READ_WRITE };
+
+// Hardware watchpoint on a runtime address, held in one debug register slot
+struct Watchpoint {
+  u64 addr = 0;
+  u8 len = 0;
+  WatchKind kind = WatchKind::WRITE;
+  u32 id = 0;  // 0 marks a free slot
+  u64 hit_count = 0;
+  u64 old_value = 0;  // Last value seen, reported next to the new one
+
+  [[nodiscard]] bool active() const { return id != 0; }
+};
+
+// x86-64 has four address registers, DR0-DR3
+inline constexpr size_t MAX_WATCHPOINTS = 4;
+using WatchpointSlots = std::array<Watchpoint, MAX_WATCHPOINTS>;
+
+inline std::string_view watchKindName(WatchKind kind) {
+  switch (kind) {
+    case WatchKind::READ:
+      return "r";
+    case WatchKind::WRITE:
+      return "w";
+    case WatchKind::READ_WRITE:
+      return "rw";
+  }
+  return "?";
+}
+
+#endif
@@ -83,6 +83,7 @@ struct formatter<TokenType> {
       INSERT_ELEM(TokenType::BOOL_TRUE);
       INSERT_ELEM(TokenType::BOOL_FALSE);
       INSERT_ELEM(TokenType::VAR);
+      INSERT_ELEM(TokenType::IF);
       INSERT_ELEM(TokenType::END);
 #undef INSERT_ELEM
       return res;
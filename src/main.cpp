@@ -1,9 +1,7 @@
-#include <cmd/interpreter.hpp>
-#include <cmd/object.hpp>
-#include <cmd/parser.hpp>
-#include <cmd/scanner.hpp>
-#include <cmd/stmnt.hpp>
-#include <cmd/token.hpp>
+#include <unistd.h>
+
+#include <charconv>
+#include <cmd/batch.hpp>
 #include <core/context.hpp>
 #include <core/target.hpp>
 #include <cstdlib>
@@ -18,43 +16,25 @@
 #include <readline/readline.h>
 // clang-format on
 #include <string>
-#include <variant>
 #include <vector>
 
+#ifdef __linux__
+#include <core/reactor.hpp>
+#include <csignal>
+#include <streambuf>
+#endif
+
 namespace {
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
 CmdError& cmdError = CmdError::getInstance();
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
 Context& ctx = Context::getInstance();
 
-void run(const std::string& src) {
-  auto s = Scanner(src);
-  const std::vector<Token> tokens = s.scanTokens();
-  if (cmdError.m_had_error) {
-    return;  // Stop if scan errors occurred
-  }
-
-  Parser p = Parser(tokens);
-  std::unique_ptr<Stmnt> const statement = p.parse();
-  if (cmdError.m_had_error) {
-    return;
-  }
-
-  Interpreter interpreter = Interpreter();
-  Object const result = interpreter.interpret(statement);
-  if (cmdError.m_had_error) {
-    return;
-  }
-  if (!std::holds_alternative<std::monostate>(result)) {
-    std::cout << Interpreter::stringify(result) << '\n';
-  }
-}
-
 bool shouldExit(char** buf) {
   return *buf == nullptr || std::strcmp(*buf, "(null)") == 0;
 }
 
-void runPrompt() {
+void runBlockingPrompt() {
   char* lineBuf = nullptr;
   const char* prompt = "> ";
   std::string line;
@@ -68,35 +48,210 @@ void runPrompt() {
     if (*lineBuf != 0) add_history(lineBuf);
     line = lineBuf;
     free(lineBuf);  // NOLINT(cppcoreguidelines-no-malloc)
-    run(line);
+    runCommand(line);
     cmdError.m_had_error = false;
   }
 }
 
-void runWithFile(const std::string& filePath) {
+#ifdef __linux__
+// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+bool promptDone = false;
+bool promptShowing = false;  // Drawn by readline and waiting for input
+bool promptCleared = false;  // Taken off the screen by background output
+// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
+
+// Stops of a target running in the background are printed from the
+// reactor, this takes the prompt and the half-typed line off the screen
+// before the first write so they do not run into each other
+class PromptGuard : public std::streambuf {
+ public:
+  explicit PromptGuard(std::streambuf* out) : m_out(out) {}
+  [[nodiscard]] std::streambuf* target() const { return m_out; }
+
+ protected:
+  int overflow(int c) override {
+    hide();
+    if (traits_type::eq_int_type(c, traits_type::eof()))
+      return traits_type::not_eof(c);
+    return m_out->sputc(traits_type::to_char_type(c));
+  }
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    hide();
+    return m_out->sputn(s, n);
+  }
+  int sync() override { return m_out->pubsync(); }
+
+ private:
+  std::streambuf* m_out;
+
+  static void hide() {
+    if (!promptShowing || promptCleared) return;
+    rl_clear_visible_line();
+    promptCleared = true;
+  }
+};
+
+void redrawPrompt() {
+  if (!promptCleared) return;
+  promptCleared = false;
+  std::cout.flush();
+  rl_on_new_line();
+  rl_redisplay();
+}
+
+void onLine(char* lineBuf) {
+  if (lineBuf == nullptr) {
+    // Removed right away, readline would draw the prompt once more
+    rl_callback_handler_remove();
+    promptDone = true;
+    return;
+  }
+  if (*lineBuf != 0) add_history(lineBuf);
+  const std::string line = lineBuf;
+  free(lineBuf);  // NOLINT(cppcoreguidelines-no-malloc)
+
+  // Commands wait on the target through the same reactor, input typed
+  // meanwhile stays in the terminal until the prompt is back
+  Reactor& reactor = Reactor::getInstance();
+  promptShowing = false;
+  reactor.pause(STDIN_FILENO, true);
+  runCommand(line);
+  reactor.pause(STDIN_FILENO, false);
+  cmdError.m_had_error = false;
+  promptShowing = true;
+}
+
+// Ctrl-C interrupts a target running in the background, at the prompt it
+// drops the line being typed
+void onInterrupt() {
+  const auto& target = Context::getTarget();
+  if (target != nullptr && target->m_started &&
+      target->getTargetState() == TargetState::RUNNING) {
+    runCommand("interrupt");
+    cmdError.m_had_error = false;
+    return;
+  }
+  rl_replace_line("", 0);
+  rl_crlf();
+  rl_on_new_line();
+  rl_redisplay();
+}
+
+// Readline is fed a character at a time whenever the reactor finds the
+// terminal readable, so an idle prompt sleeps in epoll_wait. run and resume
+// return right away and stops are printed as they happen
+void runPrompt() {
+  Reactor& reactor = Reactor::getInstance();
+  if (reactor.add(STDIN_FILENO, [] { rl_callback_read_char(); }) != 0) {
+    runBlockingPrompt();
+    return;
+  }
+
+  PromptGuard outGuard{std::cout.rdbuf()};
+  PromptGuard errGuard{std::cerr.rdbuf()};
+  std::cout.rdbuf(&outGuard);
+  std::cerr.rdbuf(&errGuard);
+  const int interruptFd = reactor.addSignal(SIGINT, onInterrupt);
+  Context::setAsync(true);
+
+  promptDone = false;
+  promptShowing = true;
+  rl_callback_handler_install("> ", onLine);
+  while (!promptDone && reactor.poll() >= 0) redrawPrompt();
+  if (!promptDone) rl_callback_handler_remove();
+  clear_history();
+
+  Context::setAsync(false);
+  reactor.remove(interruptFd);
+  reactor.remove(STDIN_FILENO);
+  std::cout.rdbuf(outGuard.target());
+  std::cerr.rdbuf(errGuard.target());
+}
+#else
+void runPrompt() { runBlockingPrompt(); }
+#endif
+
+bool loadFile(const std::string& filePath) {
   if (!std::filesystem::exists(filePath)) {
     std::cout << "Target does not exist!\n";
-    runPrompt();
-  } else {
-    if (Target::isFileValid(filePath)) {
-      std::cout << std::format("Target set to {}\n", filePath);
-      Context::setTarget(Target::create(filePath));
-    } else
-      // TODO: Add Mach-O FAT binary magic to Target::isFileValid
-      std::cout << "Target is valid but cannot be ran on current platform!\n";
-    runPrompt();
+    return false;
+  }
+  if (!Target::isFileValid(filePath)) {
+    // TODO: Add Mach-O FAT binary magic to Target::isFileValid
+    std::cout << "Target is valid but cannot be ran on current platform!\n";
+    return false;
   }
+  std::cout << std::format("Target set to {}\n", filePath);
+  Context::setTarget(Target::create(filePath));
+  return true;
 }
+
+bool loadCore(const std::string& filePath, const std::string& corePath) {
+  if (!std::filesystem::exists(filePath) ||
+      !std::filesystem::exists(corePath)) {
+    std::cout << "Target or core does not exist!\n";
+    return false;
+  }
+  auto target = Target::createCore(filePath, corePath);
+  if (!target) return false;
+  std::cout << std::format("Target set to {} with core {}\n", filePath,
+                           corePath);
+  Context::setTarget(std::move(target));
+  return true;
+}
+
+bool loadAttached(const std::string& pidArg) {
+  i32 pid = 0;
+  const auto [end, ec] =
+      std::from_chars(pidArg.data(), pidArg.data() + pidArg.size(), pid);
+  if (ec != std::errc{} || end != pidArg.data() + pidArg.size()) {
+    std::cout << std::format("{} is not a pid\n", pidArg);
+    return false;
+  }
+  auto target = Target::createAttached(pid);
+  if (!target) return false;
+  std::cout << std::format("Attached to {} with {} threads\n", pid,
+                           target->getThreads().size());
+  Context::setTarget(std::move(target));
+  return true;
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
-  if (argc > 2) {
-    std::cout << std::format("Usage: {} [file]\n", argv[0]);
-    return 64;
-  } else if (argc == 2) {
-    runWithFile(argv[1]);
-  } else {
-    runPrompt();
+  const std::vector<std::string> args(argv + 1, argv + argc);
+  std::vector<BatchStep> steps{};
+  std::vector<std::string> positional{};
+  bool usage = false;
+  for (size_t i = 0; i < args.size(); i++) {
+    if (args[i] != "-x" && args[i] != "-ex") {
+      positional.push_back(args[i]);
+    } else if (i + 1 < args.size()) {
+      steps.push_back({.script = args[i] == "-x", .arg = args[i + 1]});
+      i++;
+    } else {
+      usage = true;
+    }
   }
+  if (usage || positional.size() > 2) {
+    std::cout << std::format(
+        "Usage: {} [-x script]... [-ex command]... [file [core] | -p pid]\n",
+        argv[0]);
+    return EXIT_USAGE;
+  }
+
+  bool loaded = true;
+  if (positional.size() == 2 && positional[0] == "-p")
+    loaded = loadAttached(positional[1]);
+  else if (positional.size() == 2)
+    loaded = loadCore(positional[0], positional[1]);
+  else if (positional.size() == 1)
+    loaded = loadFile(positional[0]);
+
+  // Scripts run without readline, stdin that is not a terminal is one too
+  if (!steps.empty()) return loaded ? runBatch(steps) : 1;
+  if (isatty(STDIN_FILENO) == 0)
+    return loaded ? runScript(std::cin, "stdin") : 1;
+  runPrompt();
   return 0;
 }
@@ -6,6 +6,7 @@
 #include <cstdint>
 #include <functional>
 
+using u16 = std::uint16_t;
 using u32 = std::uint32_t;
 using i32 = std::int32_t;
 using i64 = std::int64_t;
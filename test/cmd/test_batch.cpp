@@ -0,0 +1,84 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmd/batch.hpp>
+#include <cmd/environment.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "test_helpers.hpp"
+
+namespace {
+double number(const std::string& name) {
+  return std::get<double>(
+      Environment::getInstance().get(helpers::makeToken(name)));
+}
+
+// Swaps std::cerr for a string while in scope
+class CaptureErr {
+ public:
+  CaptureErr() : m_old(std::cerr.rdbuf(m_out.rdbuf())) {}
+  ~CaptureErr() { std::cerr.rdbuf(m_old); }
+  CaptureErr(const CaptureErr&) = delete;
+  CaptureErr& operator=(const CaptureErr&) = delete;
+  CaptureErr(CaptureErr&&) = delete;
+  CaptureErr& operator=(CaptureErr&&) = delete;
+
+  [[nodiscard]] std::string str() const { return m_out.str(); }
+
+ private:
+  std::ostringstream m_out;
+  std::streambuf* m_old;
+};
+}  // namespace
+
+TEST_CASE("Test batch steps run in order", "[batch]") {
+  const auto path =
+      std::filesystem::temp_directory_path() / "caesar_test_batch.cae";
+  {
+    std::ofstream script{path};
+    script << "# Comments and blank lines are skipped\n\n  \t\n"
+           << "batchOrder = batchOrder * 10\n";
+  }
+
+  const std::vector<BatchStep> steps = {
+      {.script = false, .arg = "var batchOrder = 1"},
+      {.script = true, .arg = path.string()},
+      {.script = false, .arg = "batchOrder = batchOrder + 2"}};
+  REQUIRE(runBatch(steps) == 0);
+  REQUIRE(number("batchOrder") == 12);
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Test batch runs stop at the first failure", "[batch]") {
+  SECTION("Scripts name the failing line") {
+    std::istringstream script{
+        "var batchStop = 1\n# bogus\nbogus\nbatchStop = 2\n"};
+    const CaptureErr err{};
+    REQUIRE(runScript(script, "triage.cae") == 1);
+    REQUIRE(err.str().ends_with("triage.cae:3: bogus failed\n"));
+    REQUIRE(number("batchStop") == 1);
+  }
+
+  SECTION("Commands") {
+    const std::vector<BatchStep> steps = {
+        {.script = false, .arg = "var batchStop = 1"},
+        {.script = false, .arg = "bogus"},
+        {.script = false, .arg = "batchStop = 2"}};
+    REQUIRE(runBatch(steps) == 1);
+    REQUIRE(number("batchStop") == 1);
+  }
+
+  SECTION("Unreadable scripts") {
+    const std::vector<BatchStep> steps = {
+        {.script = true, .arg = "/nonexistent/caesar.cae"},
+        {.script = false, .arg = "var batchStop = 2"}};
+    const CaptureErr err{};
+    REQUIRE(runBatch(steps) == EXIT_NO_INPUT);
+    REQUIRE(err.str() == "Cannot read /nonexistent/caesar.cae\n");
+  }
+
+  CmdError::getInstance().m_had_error = false;
+}
@@ -0,0 +1,112 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <cmd/condition_compiler.hpp>
+#include <cmd/parser.hpp>
+#include <cmd/scanner.hpp>
+#include <error.hpp>
+#include <format>
+
+#include "test_helpers.hpp"
+
+namespace {
+ThreadState stateWith(u64 pcVal, u64 argVal) {
+  ThreadState state{};
+#ifdef __APPLE__
+  state.pc = pcVal;
+  state.x[0] = argVal;
+#else
+  state.rip = pcVal;
+  state.rdi = argVal;
+#endif
+  return state;
+}
+
+#ifdef __APPLE__
+constexpr const char* ARG_REG = "$x0";
+constexpr const char* FP_REG = "$d0";
+#else
+constexpr const char* ARG_REG = "$rdi";
+constexpr const char* FP_REG = "$xmm0";
+#endif
+
+// Conditions below are written with {} for the argument register
+std::string withArgReg(std::string src) {
+  const auto pos = src.find("{}");
+  if (pos != std::string::npos) src.replace(pos, 2, ARG_REG);
+  return src;
+}
+}  // namespace
+
+TEST_CASE("Test condition compilation", "[condition]") {
+  CmdError::getInstance().m_had_error = false;
+
+  auto [src, arg, expected] = GENERATE(table<std::string, u64, bool>({
+      {"{} == 0x10", 0x10, true},
+      {"{} == 0x10", 0x11, false},
+      {"{} != 0", 0, false},
+      {"{} > 5 == true", 6, true},
+      {"({} + 2) * 3 == 36", 10, true},
+      {"{} / 0 == 0", 7, true},
+      {"-{} < 0", 3, true},
+      {"!({} == 1)", 1, false},
+      {"{} >= 0", 0xFFFFFFFFFFFFFFFF, false},
+      {"{} == 0x8000000000000000", 0x8000000000000000, true},
+  }));
+
+  DYNAMIC_SECTION(std::format("{} with arg {}", src, arg)) {
+    const std::string cond = withArgReg(src);
+    auto program = ConditionCompiler::compile(cond);
+    REQUIRE(program);
+    REQUIRE(program->source() == cond);
+    REQUIRE(program->evaluate(stateWith(0x1000, arg)) == expected);
+  }
+}
+
+TEST_CASE("Test condition compilation errors", "[condition]") {
+  auto src = GENERATE(as<std::string>{}, "$notareg == 1", "\"str\" == 1",
+                      "1.5 == 1", "x = 1", "undefinedvar == 1",
+                      "0xffffffffffffffff == 1",
+                      std::format("{} == 1", FP_REG));
+
+  DYNAMIC_SECTION(src) {
+    CmdError::getInstance().m_had_error = false;
+    REQUIRE_FALSE(ConditionCompiler::compile(src));
+    CmdError::getInstance().m_had_error = false;
+  }
+}
+
+TEST_CASE("Test parser passes conditions through as source",
+          "[parser][condition]") {
+  CmdError::getInstance().m_had_error = false;
+  Scanner scanner{"breakpoint set 0x1000 if $rdi == 0x10"};
+  Parser parser{scanner.scanTokens()};
+  auto stmnt = parser.parse();
+  REQUIRE(stmnt);
+
+  auto* call = dynamic_cast<CallStmnt*>(stmnt.get());
+  REQUIRE(call != nullptr);
+  REQUIRE(call->m_args.size() == 4);
+
+  auto* keyword = dynamic_cast<Literal*>(call->m_args[2].get());
+  auto* cond = dynamic_cast<Literal*>(call->m_args[3].get());
+  REQUIRE(keyword != nullptr);
+  REQUIRE(cond != nullptr);
+  REQUIRE(std::get<std::string>(keyword->m_value) == "if");
+  REQUIRE(std::get<std::string>(cond->m_value) == "$rdi == 0x10");
+}
+
+TEST_CASE("Test parser keeps conditions as typed", "[parser][condition]") {
+  CmdError::getInstance().m_had_error = false;
+  const std::string src = "breakpoint set 0x1000 if ($rdi+8)==0x10 ";
+  Scanner scanner{src};
+  Parser parser{scanner.scanTokens(), src};
+  auto stmnt = parser.parse();
+  REQUIRE(stmnt);
+
+  auto* call = dynamic_cast<CallStmnt*>(stmnt.get());
+  REQUIRE(call != nullptr);
+  REQUIRE(call->m_args.size() == 4);
+  auto* cond = dynamic_cast<Literal*>(call->m_args[3].get());
+  REQUIRE(cond != nullptr);
+  REQUIRE(std::get<std::string>(cond->m_value) == "($rdi+8)==0x10");
+}
@@ -280,6 +280,16 @@ TEST_CASE("Test expression str() methods", "[expr][str]") {
     Token tok(TokenType::IDENTIFIER, "myvar", std::monostate{});
     Variable var(tok);
     REQUIRE(var.str().find("myvar") != std::string::npos);
+    REQUIRE(var.m_reg == nullptr);
+  }
+
+  SECTION("Variable resolves registers while parsing") {
+    Variable reg(Token(TokenType::IDENTIFIER, "$sp", std::monostate{}));
+    REQUIRE(reg.m_reg == findRegEntry("sp").value());
+
+    Variable unknown(
+        Token(TokenType::IDENTIFIER, "$notareg", std::monostate{}));
+    REQUIRE(unknown.m_reg == nullptr);
   }
 
   SECTION("Unary str()") {
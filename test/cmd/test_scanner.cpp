@@ -92,3 +92,13 @@ TEST_CASE("Test register variable in expression", "[scanner]") {
   REQUIRE(tokens[1].m_type == TokenType::PLUS);
   REQUIRE(tokens[2].m_type == TokenType::NUMBER);
 }
+
+TEST_CASE("Test token offsets into the source", "[scanner]") {
+  auto tokens = helpers::scan("x  == \"a b\"");
+  REQUIRE(helpers::checkTokensSize(tokens.size(), 3));
+  REQUIRE(tokens[0].m_offset == 0);
+  REQUIRE(tokens[1].m_offset == 3);
+  REQUIRE(tokens[2].m_offset == 6);
+  REQUIRE(tokens[2].m_lexeme == "\"a b\"");
+  REQUIRE(tokens[3].m_offset == 11);
+}
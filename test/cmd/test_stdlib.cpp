@@ -40,6 +40,14 @@ TEST_CASE("Test BreakpointFn without target", "[stdlib][breakpoint]") {
     REQUIRE(std::get<std::string>(result).find("Target is not running") !=
             std::string::npos);
   }
+
+  SECTION("stepping when target is null produces error") {
+    std::vector<Object> args = {std::string("stepping"),
+                                std::string("displaced")};
+    Object result = bp.call(args);
+    REQUIRE(std::holds_alternative<std::string>(result));
+    REQUIRE(std::get<std::string>(result) == "Target not set!");
+  }
 }
 
 TEST_CASE("Test RunFn without target", "[stdlib][run]") {
@@ -67,4 +75,209 @@ TEST_CASE("Test ContinueFn properties", "[stdlib][continue]") {
     REQUIRE(cont.arity() == 0);
     REQUIRE(cont.str() == "<native fn: continue>");
   }
+
+  SECTION("resuming a thread needs a target") {
+    Object result = cont.call({1234.0});
+    REQUIRE(std::holds_alternative<std::string>(result));
+    REQUIRE(std::get<std::string>(result).find("Target is not running") !=
+            std::string::npos);
+  }
+}
+
+TEST_CASE("Test MemoryFn without target", "[stdlib][memory]") {
+  MemoryFn mem;
+
+  SECTION("arity and str") {
+    REQUIRE(mem.arity() == 1);
+    REQUIRE(mem.str() == "<native fn: memory>");
+  }
+
+  SECTION("call when target is null produces error") {
+    std::vector<Object> args = {std::string("read"), std::string("0x1000"),
+                                16.0};
+    Object result = mem.call(args);
+    REQUIRE(std::holds_alternative<std::string>(result));
+    REQUIRE(std::get<std::string>(result).find("Target is not running") !=
+            std::string::npos);
+  }
+}
+
+TEST_CASE("Test TraceFn without target", "[stdlib][trace]") {
+  TraceFn trace;
+
+  SECTION("arity and str") {
+    REQUIRE(trace.arity() == 1);
+    REQUIRE(trace.str() == "<native fn: trace>");
+  }
+
+  SECTION("set when target is null produces error") {
+    std::vector<Object> args = {std::string("set"), std::string("0x1000"),
+                                std::string("rdi")};
+    Object result = trace.call(args);
+    REQUIRE(std::holds_alternative<std::string>(result));
+    REQUIRE(std::get<std::string>(result).find("Target is not running") !=
+            std::string::npos);
+  }
+
+  SECTION("stats when target is null produces error") {
+    std::vector<Object> args = {std::string("stats")};
+    Object result = trace.call(args);
+    REQUIRE(std::holds_alternative<std::string>(result));
+    REQUIRE(std::get<std::string>(result) == "Target not set!");
+  }
+}
+
+TEST_CASE("Test WatchFn without target", "[stdlib][watch]") {
+  WatchFn watch;
+
+  SECTION("arity and str") {
+    REQUIRE(watch.arity() == 1);
+    REQUIRE(watch.str() == "<native fn: watch>");
+  }
+
+  SECTION("address shorthand and subcommands need a running target") {
+    for (const auto& args : {std::vector<Object>{4096.0, 8.0},
+                             std::vector<Object>{std::string("0x1000"), 4.0,
+                                                 std::string("rw")},
+                             std::vector<Object>{std::string("list")}}) {
+      Object result = watch.call(args);
+      REQUIRE(std::holds_alternative<std::string>(result));
+      REQUIRE(std::get<std::string>(result).find("Target is not running") !=
+              std::string::npos);
+    }
+  }
+}
+
+TEST_CASE("Test ThreadFn without target", "[stdlib][thread]") {
+  ThreadFn thread;
+
+  SECTION("arity and str") {
+    REQUIRE(thread.arity() == 1);
+    REQUIRE(thread.str() == "<native fn: thread>");
+  }
+
+  SECTION("subcommands need a running target") {
+    for (const auto& args :
+         {std::vector<Object>{std::string("list")},
+          std::vector<Object>{std::string("select"), 1.0},
+          std::vector<Object>{std::string("mode"), std::string("nonstop")}}) {
+      Object result = thread.call(args);
+      REQUIRE(std::holds_alternative<std::string>(result));
+      REQUIRE(std::get<std::string>(result).find("Target is not running") !=
+              std::string::npos);
+    }
+  }
+}
+
+TEST_CASE("Test AttachFn and DetachFn", "[stdlib][attach]") {
+  AttachFn attach;
+  DetachFn detach;
+
+  SECTION("arity and str") {
+    REQUIRE(attach.arity() == 1);
+    REQUIRE(attach.str() == "<native fn: attach>");
+    REQUIRE(detach.arity() == 0);
+    REQUIRE(detach.str() == "<native fn: detach>");
+  }
+
+  SECTION("detaching needs a running target") {
+    Object result = detach.call({});
+    REQUIRE(std::holds_alternative<std::string>(result));
+    REQUIRE(std::get<std::string>(result).find("Target is not running") !=
+            std::string::npos);
+  }
+
+  SECTION("attaching to a process that does not exist") {
+    Object result = attach.call({static_cast<double>(1 << 23)});
+    REQUIRE(std::holds_alternative<std::string>(result));
+    REQUIRE(std::get<std::string>(result).find("Could not attach") !=
+            std::string::npos);
+  }
+}
+
+TEST_CASE("Test InterruptFn without target", "[stdlib][interrupt]") {
+  InterruptFn interrupt;
+
+  SECTION("arity and str") {
+    REQUIRE(interrupt.arity() == 0);
+    REQUIRE(interrupt.str() == "<native fn: interrupt>");
+  }
+
+  SECTION("interrupting needs a running target") {
+    Object result = interrupt.call({});
+    REQUIRE(std::holds_alternative<std::string>(result));
+    REQUIRE(std::get<std::string>(result).find("Target is not running") !=
+            std::string::npos);
+  }
+}
+
+TEST_CASE("Test GcoreFn without target", "[stdlib][gcore]") {
+  GcoreFn gcore;
+
+  SECTION("arity and str") {
+    REQUIRE(gcore.arity() == 1);
+    REQUIRE(gcore.str() == "<native fn: gcore>");
+  }
+
+  SECTION("writing a core needs a running target") {
+    Object result = gcore.call({std::string("core.out")});
+    REQUIRE(std::holds_alternative<std::string>(result));
+    REQUIRE(std::get<std::string>(result).find("Target is not running") !=
+            std::string::npos);
+  }
+}
+
+TEST_CASE("Test CheckpointFn and RestoreFn without target",
+          "[stdlib][checkpoint]") {
+  CheckpointFn checkpoint;
+  RestoreFn restore;
+
+  SECTION("arity and str") {
+    REQUIRE(checkpoint.arity() == 0);
+    REQUIRE(checkpoint.str() == "<native fn: checkpoint>");
+    REQUIRE(restore.arity() == 1);
+    REQUIRE(restore.str() == "<native fn: restore>");
+  }
+
+  SECTION("both need a running target") {
+    for (Object result :
+         {checkpoint.call({}), checkpoint.call({std::string("list")}),
+          restore.call({1.0})}) {
+      REQUIRE(std::holds_alternative<std::string>(result));
+      REQUIRE(std::get<std::string>(result).find("Target is not running") !=
+              std::string::npos);
+    }
+  }
+}
+
+TEST_CASE("Test SyscallsFn without target", "[stdlib][syscalls]") {
+  SyscallsFn syscalls;
+
+  SECTION("arity and str") {
+    REQUIRE(syscalls.arity() == 1);
+    REQUIRE(syscalls.str() == "<native fn: syscalls>");
+  }
+
+  SECTION("every subcommand needs a running target") {
+    for (const char* sub : {"log", "trace", "count", "stats", "stop"}) {
+      Object result = syscalls.call({std::string(sub)});
+      REQUIRE(std::holds_alternative<std::string>(result));
+      REQUIRE(std::get<std::string>(result).find("Target is not running") !=
+              std::string::npos);
+    }
+  }
+}
+
+TEST_CASE("Test ProfileFn without target", "[stdlib][profile]") {
+  ProfileFn profile;
+
+  REQUIRE(profile.arity() == 2);
+  REQUIRE(profile.str() == "<native fn: profile>");
+
+  for (Object result : {profile.call({1.0, 100.0}),
+                        profile.call({std::string("cpu"), 1.0, 100.0})}) {
+    REQUIRE(std::holds_alternative<std::string>(result));
+    REQUIRE(std::get<std::string>(result).find("Target is not running") !=
+            std::string::npos);
+  }
 }
@@ -0,0 +1,316 @@
+#include <elf.h>
+#include <pthread.h>
+#include <sys/auxv.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <array>
+#include <bit>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cmd/condition_compiler.hpp>
+#include <core/reactor.hpp>
+#include <core/target.hpp>
+#include <csignal>
+#include <error.hpp>
+#include <format>
+#include <fstream>
+#include <span>
+#include <string>
+
+namespace {
+constexpr size_t THREADS = 16;
+// Only the child writes it, the debugger has to read the child's copy
+volatile u32 attachMarker = 0;
+
+void* parked(void* /*arg*/) {
+  while (true) pause();
+  return nullptr;
+}
+
+// Child with THREADS more threads, all of them parked once it returns
+pid_t spawnChild() {
+  std::array<int, 2> ready{};
+  if (pipe(ready.data()) != 0) return -1;
+  const pid_t pid = fork();
+  if (pid == 0) {
+    close(ready[0]);
+    for (size_t i = 0; i < THREADS; i++) {
+      pthread_t thread{};
+      pthread_create(&thread, nullptr, parked, nullptr);
+    }
+    attachMarker = 0xCAE5A4;
+    const char go = 1;
+    write(ready[1], &go, 1);
+    parked(nullptr);
+  }
+  close(ready[1]);
+  char go = 0;
+  const bool started = read(ready[0], &go, 1) == 1;
+  close(ready[0]);
+  return started ? pid : -1;
+}
+
+i32 tracerOf(pid_t pid) {
+  std::ifstream status{std::format("/proc/{}/status", pid)};
+  std::string line{};
+  while (std::getline(status, line))
+    if (line.starts_with("TracerPid:")) return std::stoi(line.substr(10));
+  return -1;
+}
+
+bool alive(pid_t pid) { return waitpid(pid, nullptr, WNOHANG) == 0; }
+
+// Unslid, the child never runs it again
+u64 entryPoint() {
+  std::ifstream exe{"/proc/self/exe", std::ios::binary};
+  Elf64_Ehdr header{};
+  exe.read(reinterpret_cast<char*>(&header), sizeof(header));
+  return header.e_entry;
+}
+
+constexpr size_t HITTERS = 4;
+constexpr u64 HITS = 200;  // Calls to hitMe per thread
+
+// Where every thread stops, rdi is the call's index
+__attribute__((noinline)) void hitMe(u64 i) {
+  asm volatile("" : : "r"(i) : "memory");
+}
+
+void* hitter(void* gate) {
+  char go = 0;
+  if (read(*static_cast<int*>(gate), &go, 1) == 1)
+    for (u64 i = 0; i < HITS; i++) hitMe(i);
+  return parked(nullptr);
+}
+
+// Child with HITTERS threads that call hitMe once a byte is written to
+// gate for each of them
+pid_t spawnHitters(int& gate) {
+  std::array<int, 2> ready{};
+  std::array<int, 2> start{};
+  if (pipe(ready.data()) != 0 || pipe(start.data()) != 0) return -1;
+  const pid_t pid = fork();
+  if (pid == 0) {
+    close(ready[0]);
+    close(start[1]);
+    for (size_t i = 0; i < HITTERS; i++) {
+      pthread_t thread{};
+      pthread_create(&thread, nullptr, hitter, &start[0]);
+    }
+    const char go = 1;
+    write(ready[1], &go, 1);
+    parked(nullptr);
+  }
+  close(ready[1]);
+  close(start[0]);
+  gate = start[1];
+  char go = 0;
+  const bool started = read(ready[0], &go, 1) == 1;
+  close(ready[0]);
+  return started ? pid : -1;
+}
+
+// Unslid address of hitMe, the child is a fork with the same slide
+u64 hitMeAddr() {
+  return std::bit_cast<u64>(&hitMe) - (getauxval(AT_ENTRY) - entryPoint());
+}
+
+// Resumes the target whenever it stops until done() or a timeout
+template <typename Done>
+void runUntil(Target& target, Done done) {
+  for (i32 i = 0; i < 1000 && !done(); i++) {
+    if (target.getTargetState() == TargetState::STOPPED) {
+      target.resume(ResumeType::RESUME);
+      target.startBackground();
+    }
+    Reactor::getInstance().poll(std::chrono::milliseconds{10});
+  }
+}
+}  // namespace
+
+TEST_CASE("Test attaching to a running process", "[attach]") {
+  const pid_t pid = spawnChild();
+  REQUIRE(pid > 0);
+
+  SECTION("Every thread is stopped and released again") {
+    auto target = Target::createAttached(pid);
+    REQUIRE(target != nullptr);
+    REQUIRE(target->pid() == pid);
+    REQUIRE(target->m_started);
+    REQUIRE(target->getThreads().size() == THREADS + 1);
+    for (const auto& [tid, thread] : target->getThreads())
+      REQUIRE(!thread.running);
+    REQUIRE(tracerOf(pid) == getpid());
+
+    u32 marker = 0;
+    REQUIRE(target->readMemory(
+                std::bit_cast<u64>(&attachMarker),
+                {std::bit_cast<std::byte*>(&marker), sizeof(marker)}) == 0);
+    REQUIRE(marker == 0xCAE5A4);
+
+    REQUIRE(target->detach() == 0);
+    REQUIRE(!target->m_started);
+    REQUIRE(tracerOf(pid) == 0);
+    REQUIRE(alive(pid));
+  }
+
+  SECTION("Running in the background until interrupted") {
+    auto target = Target::createAttached(pid);
+    REQUIRE(target != nullptr);
+    target->resume(ResumeType::RESUME);
+    target->startBackground();
+    REQUIRE(target->getTargetState() == TargetState::RUNNING);
+    REQUIRE(Reactor::getInstance().poll(std::chrono::milliseconds{5}) >= 0);
+    REQUIRE(target->getTargetState() == TargetState::RUNNING);
+
+    REQUIRE(target->interrupt() == 0);
+    REQUIRE(target->getTargetState() == TargetState::STOPPED);
+    for (const auto& [tid, thread] : target->getThreads())
+      REQUIRE(!thread.running);
+    REQUIRE(target->interrupt() == -1);
+    REQUIRE(target->detach() == 0);
+    REQUIRE(alive(pid));
+  }
+
+  SECTION("SIGINT stops the target without being passed on") {
+    auto target = Target::createAttached(pid);
+    REQUIRE(target != nullptr);
+    target->resume(ResumeType::RESUME);
+    target->startBackground();
+    // Ctrl-C sends it to the whole foreground group
+    REQUIRE(kill(pid, SIGINT) == 0);
+    for (i32 i = 0;
+         i < 100 && target->getTargetState() == TargetState::RUNNING; i++)
+      Reactor::getInstance().poll(std::chrono::milliseconds{10});
+    REQUIRE(target->getTargetState() == TargetState::STOPPED);
+
+    target->resume(ResumeType::RESUME);
+    target->startBackground();
+    REQUIRE(Reactor::getInstance().poll(std::chrono::milliseconds{5}) >= 0);
+    REQUIRE(target->getTargetState() == TargetState::RUNNING);
+    REQUIRE(target->interrupt() == 0);
+    REQUIRE(target->detach() == 0);
+    REQUIRE(alive(pid));
+  }
+
+  SECTION("Re-armed breakpoints keep their records") {
+    auto target = Target::createAttached(pid);
+    REQUIRE(target != nullptr);
+    const u64 entry = entryPoint();
+    const std::span addrs{&entry, 1};
+    BreakpointTable& table = target->getRegisteredBreakpoints();
+
+    REQUIRE(target->setBreakpoints(addrs) == 0);
+    Breakpoint* bp = table.find(entry);
+    REQUIRE(bp != nullptr);
+    const u32 id = bp->id;
+    bp->hit_count = 3;
+    bp->flags |= static_cast<u8>(BreakpointFlag::ONE_SHOT);
+
+    REQUIRE(target->disableBreakpoints(addrs, false) == 0);
+    REQUIRE_FALSE(table.find(entry)->enabled);
+    REQUIRE(target->setBreakpoints(addrs) == 0);
+    bp = table.find(entry);
+    REQUIRE(bp->enabled);
+    REQUIRE(bp->id == id);
+    REQUIRE(bp->hit_count == 3);
+    REQUIRE(bp->has(BreakpointFlag::ONE_SHOT));
+
+    REQUIRE(target->disableBreakpoints(addrs, true) == 0);
+    REQUIRE(table.empty());
+    REQUIRE(target->detach() == 0);
+  }
+
+  SECTION("Dropping the target detaches") {
+    REQUIRE(Target::createAttached(pid) != nullptr);
+    REQUIRE(tracerOf(pid) == 0);
+    REQUIRE(alive(pid));
+  }
+
+  kill(pid, SIGKILL);
+  waitpid(pid, nullptr, 0);
+}
+
+TEST_CASE("Test attaching to a process that does not exist", "[attach]") {
+  // Above the largest pid_max Linux allows
+  REQUIRE(Target::createAttached(1 << 23) == nullptr);
+}
+
+TEST_CASE("Test breakpoints hit by many threads", "[attach]") {
+  int gate = -1;
+  const pid_t pid = spawnHitters(gate);
+  REQUIRE(pid > 0);
+  auto target = Target::createAttached(pid);
+  REQUIRE(target != nullptr);
+  const u64 addr = hitMeAddr();
+  REQUIRE(target->setBreakpoint(addr) == 0);
+
+  // False conditions and tracepoints are stepped over while the other
+  // threads keep running, none of them may get past the lifted trap
+  SECTION("Conditional breakpoints") {
+    CmdError::getInstance().m_had_error = false;
+    auto cond = ConditionCompiler::compile(std::format("$rdi >= {}", HITS - 5));
+    REQUIRE(cond);
+    REQUIRE(target->setBreakpointCondition(addr, std::move(*cond)) == 0);
+    const Breakpoint* bp = target->getRegisteredBreakpoints().find(addr);
+
+    target->resume(ResumeType::RESUME);
+    target->startBackground();
+    const std::array<char, HITTERS> go{};
+    REQUIRE(write(gate, go.data(), go.size()) == HITTERS);
+    runUntil(*target, [bp] { return bp->hit_count == HITTERS * 5; });
+    REQUIRE(bp->hit_count == HITTERS * 5);
+  }
+
+  SECTION("Tracepoints") {
+    auto rdi = findRegEntry("rdi");
+    REQUIRE(rdi);
+    TraceSpec spec{};
+    spec.regs.push_back(*rdi);
+    spec.reg_names.emplace_back("rdi");
+    REQUIRE(target->setTracepoint(addr, std::move(spec)) == 0);
+    REQUIRE(target->getTracer().setOutput("/dev/null") == 0);
+
+    target->resume(ResumeType::RESUME);
+    target->startBackground();
+    const std::array<char, HITTERS> go{};
+    REQUIRE(write(gate, go.data(), go.size()) == HITTERS);
+    const Tracer& tracer = target->getTracer();
+    runUntil(*target,
+             [&tracer] { return tracer.stats().recorded == HITTERS * HITS; });
+    REQUIRE(tracer.stats().recorded == HITTERS * HITS);
+    REQUIRE(tracer.stats().dropped == 0);
+  }
+
+  SECTION("One-shot breakpoints") {
+    BreakpointTable& table = target->getRegisteredBreakpoints();
+    table.find(addr)->flags |= static_cast<u8>(BreakpointFlag::ONE_SHOT);
+
+    target->resume(ResumeType::RESUME);
+    target->startBackground();
+    const char go = 0;
+    REQUIRE(write(gate, &go, 1) == 1);
+    for (i32 i = 0;
+         i < 1000 && target->getTargetState() != TargetState::STOPPED; i++)
+      Reactor::getInstance().poll(std::chrono::milliseconds{10});
+    REQUIRE(target->getTargetState() == TargetState::STOPPED);
+    REQUIRE_FALSE(table.contains(addr));
+
+    // The original instruction is back, nobody stops there again
+    target->resume(ResumeType::RESUME);
+    target->startBackground();
+    const std::array<char, HITTERS - 1> rest{};
+    REQUIRE(write(gate, rest.data(), rest.size()) == HITTERS - 1);
+    for (i32 i = 0; i < 50; i++)
+      Reactor::getInstance().poll(std::chrono::milliseconds{10});
+    REQUIRE(target->getTargetState() == TargetState::RUNNING);
+  }
+
+  if (target->getTargetState() == TargetState::RUNNING)
+    REQUIRE(target->interrupt() == 0);
+  target.reset();
+  close(gate);
+  kill(pid, SIGKILL);
+  waitpid(pid, nullptr, 0);
+}
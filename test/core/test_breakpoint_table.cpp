@@ -0,0 +1,108 @@
+#include <catch2/catch_test_macros.hpp>
+#include <core/breakpoint_table.hpp>
+#include <map>
+#include <random>
+
+TEST_CASE("Test BreakpointTable basic operations", "[core][breakpoint_table]") {
+  BreakpointTable table;
+
+  SECTION("empty table") {
+    REQUIRE(table.empty());
+    REQUIRE(table.find(0x1000) == nullptr);
+    REQUIRE_FALSE(table.contains(0x1000));
+  }
+
+  SECTION("lookups never insert") {
+    REQUIRE(table.find(0x1000) == nullptr);
+    REQUIRE(table.find(0x2000) == nullptr);
+    REQUIRE(table.size() == 0);
+    REQUIRE(table.begin() == table.end());
+  }
+
+  SECTION("insert assigns increasing ids") {
+    auto& a = table.insert(0x1000, {.orig_ins = 0x90, .enabled = true});
+    auto& b = table.insert(0x2000, {.orig_ins = 0x55, .enabled = true});
+    REQUIRE(a.id == 1);
+    REQUIRE(b.id == 2);
+    REQUIRE(table.size() == 2);
+    REQUIRE(table.find(0x1000)->orig_ins == 0x90);
+    REQUIRE(table.findById(2) == table.find(0x2000));
+    REQUIRE(table.findById(0) == nullptr);
+  }
+
+  SECTION("replacing keeps id and hit count") {
+    table.insert(0x1000, {.orig_ins = 0x90, .enabled = true});
+    table.find(0x1000)->hit_count = 3;
+    auto& bp = table.insert(0x1000, {.orig_ins = 0xCC, .enabled = false});
+    REQUIRE(table.size() == 1);
+    REQUIRE(bp.id == 1);
+    REQUIRE(bp.hit_count == 3);
+    REQUIRE(bp.orig_ins == 0xCC);
+  }
+
+  SECTION("erase") {
+    table.insert(0x1000, {.orig_ins = 0, .enabled = true});
+    REQUIRE(table.erase(0x1000));
+    REQUIRE_FALSE(table.erase(0x1000));
+    REQUIRE(table.empty());
+  }
+
+  SECTION("flags") {
+    auto& bp = table.insert(
+        0x1000, {.orig_ins = 0,
+                 .enabled = true,
+                 .flags = static_cast<u8>(BreakpointFlag::ONE_SHOT)});
+    REQUIRE(bp.has(BreakpointFlag::ONE_SHOT));
+    REQUIRE_FALSE(bp.has(BreakpointFlag::INTERNAL));
+  }
+}
+
+TEST_CASE("Test BreakpointTable against std::map", "[core][breakpoint_table]") {
+  BreakpointTable table;
+  std::map<u64, u32> reference;
+  std::mt19937_64 rng{42};
+
+  // Dense addresses force long probe clusters, which is where backward-shift
+  // deletion can go wrong
+  for (int i = 0; i < 20000; i++) {
+    const u64 addr = 0x400000 + (rng() % 4096);
+    if (rng() % 3 == 0) {
+      REQUIRE(table.erase(addr) == (reference.erase(addr) == 1));
+    } else {
+      const auto ins = static_cast<u32>(rng());
+      table.insert(addr, {.orig_ins = ins, .enabled = true});
+      reference[addr] = ins;
+    }
+  }
+
+  REQUIRE(table.size() == reference.size());
+  for (const auto& [addr, ins] : reference) {
+    const Breakpoint* bp = table.find(addr);
+    REQUIRE(bp != nullptr);
+    REQUIRE(bp->orig_ins == ins);
+  }
+
+  size_t iterated = 0;
+  for (const auto& [addr, bp] : table) {
+    REQUIRE(reference.contains(addr));
+    iterated++;
+  }
+  REQUIRE(iterated == reference.size());
+
+  table.clear();
+  REQUIRE(table.empty());
+  REQUIRE(table.find(reference.begin()->first) == nullptr);
+}
+
+TEST_CASE("Test BreakpointTable growth", "[core][breakpoint_table]") {
+  BreakpointTable table;
+  table.reserve(1000);
+  const size_t reserved = table.capacity();
+  REQUIRE(reserved >= 2000);
+
+  for (u64 i = 0; i < 1000; i++)
+    table.insert(0x1000 + (i * 4), {.orig_ins = 0, .enabled = true});
+  REQUIRE(table.capacity() == reserved);
+
+  for (u64 i = 0; i < 1000; i++) REQUIRE(table.contains(0x1000 + (i * 4)));
+}
@@ -0,0 +1,217 @@
+#include <catch2/catch_test_macros.hpp>
+#include <core/dwarf/cfi.hpp>
+#include <cstring>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr u64 SECTION = 0x1000;
+constexpr u64 FUNC = 0x400000;
+constexpr u32 FUNC_SIZE = 0x20;
+
+void put(std::vector<std::byte>& out, std::initializer_list<u8> bytes) {
+  for (const u8 b : bytes) out.push_back(std::byte{b});
+}
+
+void put32(std::vector<std::byte>& out, u32 value) {
+  const size_t at = out.size();
+  out.resize(at + sizeof(value));
+  std::memcpy(out.data() + at, &value, sizeof(value));
+}
+
+void patch32(std::vector<std::byte>& out, size_t at, u32 value) {
+  std::memcpy(out.data() + at, &value, sizeof(value));
+}
+
+// One CIE and the FDE of a function that sets up rbp as frame pointer:
+//   +0 push rbp, +1 mov rbp, rsp, +4 body, +0xe leave, +0xf ret
+std::vector<std::byte> ehFrame() {
+  std::vector<std::byte> out{};
+  put32(out, 0);  // Length, patched
+  put32(out, 0);  // CIE id
+  // Version 1, "zR", code align 1, data align -8, return address r16
+  put(out, {1, 'z', 'R', 0, 1, 0x78, 16});
+  // One byte of augmentation data, pc-relative sdata4 pointers
+  put(out, {1, 0x1b});
+  // CFA is rsp + 8, return address at CFA - 8
+  put(out, {0x0c, 7, 8, 0x90, 1});
+  patch32(out, 0, static_cast<u32>(out.size() - sizeof(u32)));
+
+  const size_t fde = out.size();
+  put32(out, 0);
+  put32(out, static_cast<u32>(out.size()));  // Back to the CIE at 0
+  put32(out, static_cast<u32>(FUNC - (SECTION + out.size())));
+  put32(out, FUNC_SIZE);
+  put(out, {0});  // No augmentation data
+  // advance 1, CFA offset 16, rbp at CFA - 16
+  put(out, {0x41, 0x0e, 16, 0x86, 2});
+  // advance 3, CFA is rbp + 16
+  put(out, {0x43, 0x0d, 6});
+  // advance 10, CFA is rsp + 8 again
+  put(out, {0x4a, 0x0c, 7, 8});
+  patch32(out, fde, static_cast<u32>(out.size() - fde - sizeof(u32)));
+  put32(out, 0);  // Terminator
+  return out;
+}
+
+class TableSource : public FrameSource {
+ public:
+  explicit TableSource(CallFrameInfo& cfi) : m_cfi(cfi) {}
+  const UnwindRow* unwindRow(u64 pc, const CallFrameInfo*& cfi) override {
+    cfi = &m_cfi;
+    return m_cfi.find(pc);
+  }
+
+ private:
+  CallFrameInfo& m_cfi;
+};
+
+class NoSource : public FrameSource {
+ public:
+  const UnwindRow* unwindRow(u64 /*pc*/,
+                             const CallFrameInfo*& /*cfi*/) override {
+    return nullptr;
+  }
+};
+}  // namespace
+
+TEST_CASE("Test compiling CFI rows", "[cfi]") {
+  const auto section = ehFrame();
+  CallFrameInfo cfi{};
+  REQUIRE(cfi.load(section, SECTION, true) == 0);
+  REQUIRE(cfi.fdes() == 1);
+
+  REQUIRE(cfi.find(FUNC - 1) == nullptr);
+  REQUIRE(cfi.find(FUNC + FUNC_SIZE) == nullptr);
+
+  const UnwindRow* entry = cfi.find(FUNC);
+  REQUIRE(entry != nullptr);
+  REQUIRE(entry->cfa.kind == CfiRuleKind::REGISTER);
+  REQUIRE(entry->cfa.reg == UnwindRegs::RSP);
+  REQUIRE(entry->cfa.offset == 8);
+  REQUIRE(entry->regs[UnwindRegs::RIP].kind == CfiRuleKind::OFFSET);
+  REQUIRE(entry->regs[UnwindRegs::RIP].offset == -8);
+  REQUIRE(entry->regs[UnwindRegs::RBP].kind == CfiRuleKind::SAME);
+
+  const UnwindRow* pushed = cfi.find(FUNC + 1);
+  REQUIRE(pushed->cfa.offset == 16);
+  REQUIRE(pushed->regs[UnwindRegs::RBP].kind == CfiRuleKind::OFFSET);
+  REQUIRE(pushed->regs[UnwindRegs::RBP].offset == -16);
+
+  for (const u64 pc : {FUNC + 4, FUNC + 0xd}) {
+    const UnwindRow* body = cfi.find(pc);
+    REQUIRE(body->cfa.reg == UnwindRegs::RBP);
+    REQUIRE(body->cfa.offset == 16);
+  }
+
+  const UnwindRow* left = cfi.find(FUNC + 0xe);
+  REQUIRE(left->cfa.reg == UnwindRegs::RSP);
+  REQUIRE(left->cfa.offset == 8);
+  // Lookups after the first one are served from the compiled rows
+  REQUIRE(cfi.find(FUNC + 2) == pushed);
+}
+
+TEST_CASE("Test rejecting broken CFI", "[cfi]") {
+  auto section = ehFrame();
+  CallFrameInfo cfi{};
+
+  SECTION("Truncated") {
+    section.resize(section.size() - 12);
+    REQUIRE(cfi.load(section, SECTION, true) == 0);
+    REQUIRE(cfi.fdes() == 0);
+  }
+  SECTION("Unknown CIE version") {
+    section[8] = std::byte{9};
+    REQUIRE(cfi.load(section, SECTION, true) == 0);
+    REQUIRE(cfi.fdes() == 0);
+  }
+  SECTION("Empty") {
+    REQUIRE(cfi.load({}, SECTION, true) == 0);
+    REQUIRE(cfi.find(FUNC) == nullptr);
+  }
+}
+
+TEST_CASE("Test evaluating CFI expressions", "[cfi]") {
+  std::vector<u64> words{0x1111, 0x2222, 0x3333};
+  const StackSnapshot stack{.base = 0x7000,
+                            .bytes = std::as_bytes(std::span{words})};
+  UnwindRegs regs{};
+  regs.set(UnwindRegs::RSP, 0x7000);
+
+  const auto eval = [&](std::initializer_list<u8> ops,
+                        std::optional<u64> push = std::nullopt) {
+    std::vector<std::byte> expr{};
+    put(expr, ops);
+    return evalCfiExpression(expr, regs, stack, push);
+  };
+
+  // DW_OP_breg7 8, DW_OP_deref
+  REQUIRE(eval({0x77, 8, 0x06}) == 0x2222);
+  // The CFA pushed first, DW_OP_lit16, DW_OP_plus
+  REQUIRE(eval({0x40, 0x22}, 0x7000) == 0x7010);
+  // Memory and registers the snapshot does not have
+  REQUIRE(!eval({0x77, 0x18, 0x06}));
+  REQUIRE(!eval({0x76, 0}));
+  // DW_OP_skip over a DW_OP_lit1, DW_OP_lit2
+  REQUIRE(eval({0x2f, 1, 0, 0x31, 0x32}) == 2);
+  // DW_OP_bra back to itself forever
+  REQUIRE(!eval({0x31, 0x12, 0x28, 0xfc, 0xff}));
+  REQUIRE(!eval({0x22}));
+
+  // The CFA of a PLT entry: rsp + 8, 8 more past the push in the entry
+  for (const auto& [rip, cfa] : {std::pair<u64, u64>{0x401020, 0x7008},
+                                 std::pair<u64, u64>{0x40102b, 0x7010}}) {
+    regs.set(UnwindRegs::RIP, rip);
+    REQUIRE(eval({0x77, 8, 0x80, 0, 0x3f, 0x1a, 0x3b, 0x2a, 0x33, 0x24,
+                  0x22}) == cfa);
+  }
+}
+
+TEST_CASE("Test walking call frames", "[cfi]") {
+  const auto section = ehFrame();
+  CallFrameInfo cfi{};
+  REQUIRE(cfi.load(section, SECTION, true) == 0);
+  TableSource frames{cfi};
+
+  // Two frames of the function above in its body, the outer one called
+  // from code without CFI that keeps a frame pointer, then the end
+  const u64 base = 0x7ff000;
+  std::vector<u64> words(16);
+  words[2] = base + 0x30;  // Saved rbp of the inner frame
+  words[3] = FUNC + 9;     // Its return address
+  words[6] = base + 0x50;
+  words[7] = 0x500000;
+  words[10] = 0;
+  words[11] = 0;
+  const StackSnapshot stack{.base = base,
+                            .bytes = std::as_bytes(std::span{words})};
+
+  UnwindRegs regs{};
+  regs.set(UnwindRegs::RIP, FUNC + 5);
+  regs.set(UnwindRegs::RSP, base);
+  regs.set(UnwindRegs::RBP, base + 0x10);
+
+  std::vector<u64> pcs{};
+  REQUIRE(walkCallFrames(regs, stack, frames, 64, pcs) ==
+          UnwindStop::OUTERMOST);
+  REQUIRE(pcs == std::vector<u64>{FUNC + 5, FUNC + 9, 0x500000});
+  REQUIRE(walkCallFrames(regs, stack, frames, 2, pcs) == UnwindStop::DEPTH);
+  REQUIRE(pcs.size() == 2);
+
+  // The rbp chain alone gets as far
+  NoSource none{};
+  REQUIRE(walkCallFrames(regs, stack, none, 64, pcs) ==
+          UnwindStop::OUTERMOST);
+  REQUIRE(pcs.size() == 3);
+
+  // Cut off before the outer frame's return address
+  const StackSnapshot cut{.base = base, .bytes = stack.bytes.first(0x30)};
+  REQUIRE(walkCallFrames(regs, cut, frames, 64, pcs) ==
+          UnwindStop::STACK_END);
+  REQUIRE(pcs.size() == 2);
+
+  // A frame that does not move up the stack
+  words[2] = base + 0x10;
+  REQUIRE(walkCallFrames(regs, stack, frames, 64, pcs) == UnwindStop::LOST);
+}
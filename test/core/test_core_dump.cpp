@@ -0,0 +1,154 @@
+#include <elf.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include <core/elf/core_dump.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace {
+template <typename T>
+T readAt(std::ifstream& file, u64 offset) {
+  T value{};
+  file.seekg(static_cast<std::streamoff>(offset));
+  file.read(std::bit_cast<char*>(&value), sizeof(T));
+  return value;
+}
+}  // namespace
+
+TEST_CASE("Test parsing /proc/pid/maps lines", "[core_dump]") {
+  SECTION("file mapping") {
+    auto mapping = parseMapsLine(
+        "7f2a1c000000-7f2a1c021000 r-xp 00002000 08:01 1234    "
+        "/usr/lib/libc.so.6\n");
+    REQUIRE(mapping);
+    REQUIRE(mapping->start == 0x7f2a1c000000);
+    REQUIRE(mapping->end == 0x7f2a1c021000);
+    REQUIRE(mapping->offset == 0x2000);
+    REQUIRE(mapping->read);
+    REQUIRE_FALSE(mapping->write);
+    REQUIRE(mapping->exec);
+    REQUIRE_FALSE(mapping->shared);
+    REQUIRE(mapping->path == "/usr/lib/libc.so.6");
+    REQUIRE(mapping->fileBacked());
+  }
+
+  SECTION("anonymous and special mappings") {
+    auto anon = parseMapsLine("1000-3000 rw-s 00000000 00:00 0");
+    REQUIRE(anon);
+    REQUIRE(anon->size() == 0x2000);
+    REQUIRE(anon->shared);
+    REQUIRE(anon->path.empty());
+
+    auto stack = parseMapsLine("1000-2000 rw-p 00000000 00:00 0  [stack]");
+    REQUIRE(stack);
+    REQUIRE(stack->path == "[stack]");
+    REQUIRE_FALSE(stack->fileBacked());
+  }
+
+  SECTION("paths keep their spaces") {
+    auto mapping =
+        parseMapsLine("1000-2000 r--p 00000000 08:01 42 /tmp/a b (deleted)");
+    REQUIRE(mapping);
+    REQUIRE(mapping->path == "/tmp/a b (deleted)");
+  }
+
+  SECTION("malformed lines") {
+    for (const char* line :
+         {"", "garbage", "1000 r--p 0 08:01 1", "2000-1000 r--p 0 08:01 1",
+          "1000-2000 r-p 0 08:01 1", "1000-2000 r--p zz 08:01 1",
+          "1000-2000 r--p 0 08:01"}) {
+      INFO(line);
+      REQUIRE_FALSE(parseMapsLine(line));
+    }
+  }
+}
+
+TEST_CASE("Test finding non-zero pages", "[core_dump]") {
+  constexpr size_t page = 16;
+  std::vector<std::byte> buf(page * 6);
+
+  REQUIRE(nonZeroRuns(buf, page).empty());
+
+  buf[page * 1] = std::byte{1};
+  buf[(page * 2) + 5] = std::byte{1};
+  buf[(page * 5) + 15] = std::byte{1};
+  const auto runs = nonZeroRuns(buf, page);
+  REQUIRE(runs.size() == 2);
+  REQUIRE(runs[0] == std::pair<size_t, size_t>{page, page * 2});
+  REQUIRE(runs[1] == std::pair<size_t, size_t>{page * 5, page});
+
+  // A short last page is still covered
+  REQUIRE(nonZeroRuns(std::span{buf}.first((page * 5) + 3), page).size() ==
+          1);
+}
+
+TEST_CASE("Test writing a core of this process", "[core_dump]") {
+  const pid_t pid = getpid();
+  // Large enough to span several pages and batches' worth of zero pages
+  std::vector<u8> pattern(CoreDump::PAGE * 4);
+  for (size_t i = 0; i < pattern.size(); i++)
+    pattern[i] = static_cast<u8>((i * 7) + 1);
+  const std::vector<u8> zeros(CoreDump::PAGE * 64);
+  const auto patternAddr = std::bit_cast<u64>(pattern.data());
+
+  CoreThread thread{};
+  thread.tid = pid;
+  thread.regs.rip = 0x1234;
+  CoreDump dump{pid, true};
+  dump.addThread(thread);
+  dump.addPatch(patternAddr + 3, std::byte{0xAB});
+
+  const std::string path =
+      std::format("/tmp/caesar_test_core_{}.core", pid);
+  REQUIRE(dump.write(path) == 0);
+  const CoreDumpStats& stats = dump.stats();
+  REQUIRE(stats.read > 0);
+  REQUIRE(stats.written < stats.read);
+  REQUIRE(stats.written >= pattern.size());
+  REQUIRE(stats.mapped >= stats.read + stats.referenced);
+
+  std::ifstream core{path, std::ios::binary};
+  const auto header = readAt<Elf64_Ehdr>(core, 0);
+  REQUIRE(memcmp(header.e_ident, ELFMAG, SELFMAG) == 0);
+  REQUIRE(header.e_type == ET_CORE);
+  REQUIRE(header.e_machine == EM_X86_64);
+  REQUIRE(header.e_phnum > 1);
+
+  const auto note = readAt<Elf64_Phdr>(core, header.e_phoff);
+  REQUIRE(note.p_type == PT_NOTE);
+  const auto first = readAt<Elf64_Nhdr>(core, note.p_offset);
+  REQUIRE(first.n_type == NT_PRSTATUS);
+
+  bool found = false;
+  for (size_t i = 1; i < header.e_phnum; i++) {
+    const auto load =
+        readAt<Elf64_Phdr>(core, header.e_phoff + (i * sizeof(Elf64_Phdr)));
+    REQUIRE(load.p_type == PT_LOAD);
+    REQUIRE(load.p_offset % CoreDump::PAGE == 0);
+    if (patternAddr < load.p_vaddr ||
+        patternAddr + pattern.size() > load.p_vaddr + load.p_filesz)
+      continue;
+
+    found = true;
+    std::vector<u8> copy(pattern.size());
+    core.seekg(static_cast<std::streamoff>(load.p_offset + patternAddr -
+                                           load.p_vaddr));
+    core.read(std::bit_cast<char*>(copy.data()),
+              static_cast<std::streamsize>(copy.size()));
+    REQUIRE(copy[3] == 0xAB);
+    copy[3] = pattern[3];
+    REQUIRE(copy == pattern);
+  }
+  REQUIRE(found);
+
+  // Zero pages are holes, the file takes less space than it spans
+  struct stat st {};
+  REQUIRE(stat(path.c_str(), &st) == 0);
+  REQUIRE(static_cast<u64>(st.st_blocks) * 512 <
+          static_cast<u64>(st.st_size));
+  std::remove(path.c_str());
+}
@@ -0,0 +1,101 @@
+#include <unistd.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include <core/elf/core_dump.hpp>
+#include <core/elf/core_file.hpp>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <vector>
+
+namespace {
+// Its text is read back from the binary, not from the core
+[[gnu::noinline]] int textProbe(int x) { return (x * 3) + 1; }
+
+std::unique_ptr<CoreFile> openCore(const std::string& corePath) {
+  const std::string exe = std::filesystem::read_symlink("/proc/self/exe");
+  auto core = std::make_unique<CoreFile>(std::ifstream{exe}, exe);
+  if (core->load(corePath) != 0) return nullptr;
+  return core;
+}
+}  // namespace
+
+TEST_CASE("Test loading a core of this process", "[core_file]") {
+  const pid_t pid = getpid();
+  std::vector<u8> pattern(CoreDump::PAGE * 2);
+  for (size_t i = 0; i < pattern.size(); i++)
+    pattern[i] = static_cast<u8>((i * 5) + 3);
+  const auto patternAddr = std::bit_cast<u64>(pattern.data());
+
+  CoreThread thread{};
+  thread.tid = pid;
+  thread.signal = 11;
+  thread.regs.rip = 0x1234;
+  thread.fp_regs.mxcsr = 0x1F80;
+  CoreDump dump{pid, true};
+  dump.addThread(thread);
+  dump.addPatch(patternAddr, std::byte{0xCC});
+  const std::string path = std::format("/tmp/caesar_test_load_{}.core", pid);
+  REQUIRE(dump.write(path) == 0);
+
+  auto core = openCore(path);
+  REQUIRE(core);
+
+  SECTION("threads and registers") {
+    REQUIRE(core->m_started);
+    REQUIRE(core->pid() == pid);
+    REQUIRE(core->getThreads().size() == 1);
+    REQUIRE(core->getThreads().selectedTid() == pid);
+    REQUIRE(core->getThreads().selected()->stop_reason == "signal SIGSEGV");
+    REQUIRE(core->getLastKnownThreadState().rip == 0x1234);
+    REQUIRE_FALSE(core->registerGroup(RegGroup::FP).empty());
+    REQUIRE(core->registerGroup(RegGroup::DEBUG).empty());
+  }
+
+  SECTION("memory comes from the core") {
+    std::vector<u8> copy(pattern.size());
+    REQUIRE(core->readMemory(patternAddr, std::as_writable_bytes(
+                                              std::span{copy})) == 0);
+    REQUIRE(copy[0] == 0xCC);
+    copy[0] = pattern[0];
+    REQUIRE(copy == pattern);
+
+    const auto view = core->memoryView(patternAddr + 1, 16);
+    REQUIRE(view.size() == 16);
+    REQUIRE(memcmp(view.data(), pattern.data() + 1, 16) == 0);
+  }
+
+  SECTION("file contents come from the binary") {
+    const auto probe = std::bit_cast<u64>(&textProbe);
+    std::array<std::byte, 16> text{};
+    REQUIRE(core->readMemory(probe, text) == 0);
+    REQUIRE(memcmp(text.data(), std::bit_cast<const void*>(probe),
+                   text.size()) == 0);
+
+    // Breakpoints take unslid addresses and stay disabled
+    REQUIRE(core->setBreakpoint(probe - core->getAslrSlide()) == 0);
+    const Breakpoint* bp =
+        core->getRegisteredBreakpoints().find(probe - core->getAslrSlide());
+    REQUIRE(bp != nullptr);
+    REQUIRE_FALSE(bp->enabled);
+    REQUIRE((bp->orig_ins & 0xFF) == std::to_integer<u32>(text[0]));
+    REQUIRE(textProbe(1) == 4);
+  }
+
+  SECTION("nothing runs or changes") {
+    const std::byte b{};
+    REQUIRE(core->writeMemory(patternAddr, {&b, 1}) != 0);
+    REQUIRE(core->attach() != 0);
+    std::array<std::byte, 1> out{};
+    REQUIRE(core->readMemory(0, out) != 0);
+    REQUIRE(core->memoryView(0, 1).empty());
+  }
+
+  std::remove(path.c_str());
+}
+
+TEST_CASE("Test loading something that is not a core", "[core_file]") {
+  REQUIRE_FALSE(openCore("/proc/self/exe"));
+  REQUIRE_FALSE(openCore("/nonexistent/core"));
+}
@@ -0,0 +1,131 @@
+#include <catch2/catch_test_macros.hpp>
+#include <core/page_cache.hpp>
+#include <cstring>
+#include <vector>
+
+namespace {
+// Fake target memory starting at BASE, counting the vectored reads made
+struct FakeMemory {
+  static constexpr u64 BASE = 0x10000;
+  std::vector<std::byte> bytes = std::vector<std::byte>(16 * 4096);
+  int calls = 0;
+  size_t slices = 0;
+
+  FakeMemory() {
+    for (size_t i = 0; i < bytes.size(); i++)
+      bytes[i] = static_cast<std::byte>(i * 7);
+  }
+
+  PageCache::FetchFn fetch() {
+    return [this](std::span<const MemorySlice> s) -> i32 {
+      calls++;
+      slices += s.size();
+      for (const auto& slice : s) {
+        if (slice.addr < BASE ||
+            slice.addr + slice.buf.size() > BASE + bytes.size())
+          return -1;
+        memcpy(slice.buf.data(), bytes.data() + (slice.addr - BASE),
+               slice.buf.size());
+      }
+      return 0;
+    };
+  }
+};
+
+std::vector<std::byte> readOne(PageCache& cache, FakeMemory& mem, u64 addr,
+                               size_t len, i32* res = nullptr) {
+  std::vector<std::byte> out(len);
+  const MemorySlice slice{.addr = addr, .buf = out};
+  const i32 r = cache.read({&slice, 1}, mem.fetch());
+  if (res != nullptr) *res = r;
+  return out;
+}
+}  // namespace
+
+TEST_CASE("Test PageCache hits within an epoch", "[core][page_cache]") {
+  PageCache cache;
+  FakeMemory mem;
+
+  SECTION("repeated reads of a page fetch it once") {
+    for (int i = 0; i < 10; i++) readOne(cache, mem, FakeMemory::BASE + 8, 16);
+    REQUIRE(mem.calls == 1);
+    REQUIRE(cache.stats().misses == 1);
+    REQUIRE(cache.stats().hits == 9);
+  }
+
+  SECTION("returned bytes match target memory") {
+    const auto out = readOne(cache, mem, FakeMemory::BASE + 4000, 200);
+    REQUIRE(std::memcmp(out.data(), mem.bytes.data() + 4000, 200) == 0);
+  }
+
+  SECTION("a read spanning pages fetches all of them in one call") {
+    readOne(cache, mem, FakeMemory::BASE + 100, 3 * 4096);
+    REQUIRE(mem.calls == 1);
+    REQUIRE(mem.slices == 4);
+    REQUIRE(cache.stats().fetches == 1);
+  }
+}
+
+TEST_CASE("Test PageCache coalesces misses", "[core][page_cache]") {
+  PageCache cache;
+  FakeMemory mem;
+
+  std::vector<std::vector<std::byte>> bufs(8, std::vector<std::byte>(16));
+  std::vector<MemorySlice> slices{};
+  for (size_t i = 0; i < bufs.size(); i++)
+    slices.push_back({.addr = FakeMemory::BASE + (i * 2048), .buf = bufs[i]});
+
+  REQUIRE(cache.read(slices, mem.fetch()) == 0);
+  REQUIRE(mem.calls == 1);
+  // Two slices per page, each page requested once
+  REQUIRE(mem.slices == 4);
+
+  for (size_t i = 0; i < bufs.size(); i++)
+    REQUIRE(std::memcmp(bufs[i].data(), mem.bytes.data() + (i * 2048), 16) ==
+            0);
+}
+
+TEST_CASE("Test PageCache invalidation", "[core][page_cache]") {
+  PageCache cache;
+  FakeMemory mem;
+
+  readOne(cache, mem, FakeMemory::BASE, 8);
+  mem.bytes[0] = std::byte{0xAA};
+
+  SECTION("same epoch keeps the old bytes") {
+    REQUIRE(readOne(cache, mem, FakeMemory::BASE, 8)[0] != std::byte{0xAA});
+  }
+
+  SECTION("new epoch refetches") {
+    const u64 before = cache.epoch();
+    cache.invalidate();
+    REQUIRE(cache.epoch() == before + 1);
+    REQUIRE(readOne(cache, mem, FakeMemory::BASE, 8)[0] == std::byte{0xAA});
+    REQUIRE(mem.calls == 2);
+  }
+}
+
+TEST_CASE("Test PageCache failures and large reads", "[core][page_cache]") {
+  PageCache cache;
+  FakeMemory mem;
+
+  SECTION("failed fetch is reported and not cached") {
+    i32 res = 0;
+    readOne(cache, mem, 0x1000, 8, &res);
+    REQUIRE(res != 0);
+    readOne(cache, mem, 0x1000, 8, &res);
+    REQUIRE(res != 0);
+    REQUIRE(mem.calls == 2);
+    REQUIRE(cache.stats().hits == 0);
+  }
+
+  SECTION("reads above MAX_CACHED_READ go straight to the target") {
+    FakeMemory big{};
+    big.bytes.resize(PageCache::MAX_CACHED_READ + 4096);
+    i32 res = -1;
+    readOne(cache, big, FakeMemory::BASE, PageCache::MAX_CACHED_READ + 1, &res);
+    REQUIRE(res == 0);
+    REQUIRE(big.slices == 1);
+    REQUIRE(cache.stats().misses == 0);
+  }
+}
@@ -0,0 +1,95 @@
+#include <catch2/catch_test_macros.hpp>
+#include <core/profile.hpp>
+#include <core/unwind.hpp>
+#include <cstring>
+#include <vector>
+
+namespace {
+// Stack image whose rbp chain is given as (frame offset, return address)
+std::vector<std::byte> buildStack(
+    u64 base, size_t size,
+    const std::vector<std::pair<size_t, u64>>& frames) {
+  std::vector<std::byte> bytes(size);
+  for (size_t i = 0; i < frames.size(); i++) {
+    const auto [offset, ret] = frames[i];
+    const u64 next = i + 1 < frames.size() ? base + frames[i + 1].first : 0;
+    std::memcpy(bytes.data() + offset, &next, sizeof(next));
+    std::memcpy(bytes.data() + offset + 8, &ret, sizeof(ret));
+  }
+  return bytes;
+}
+}  // namespace
+
+TEST_CASE("Test walking frame pointers", "[unwind]") {
+  constexpr u64 base = 0x7ffd0000;
+  const auto bytes =
+      buildStack(base, 512, {{0x20, 0x401010}, {0x80, 0x402020}, {0x100, 0}});
+  const StackSnapshot stack{.base = base, .bytes = bytes};
+
+  SECTION("the chain ends at a zero return address") {
+    const auto pcs = walkFramePointers(0x400500, base + 0x20, stack, 64);
+    REQUIRE(pcs == std::vector<u64>{0x400500, 0x401010, 0x402020});
+  }
+
+  SECTION("depth is capped") {
+    REQUIRE(walkFramePointers(0x400500, base + 0x20, stack, 2).size() == 2);
+    REQUIRE(walkFramePointers(0x400500, base + 0x20, stack, 0).empty());
+  }
+
+  SECTION("frame pointers outside the copy end the walk") {
+    REQUIRE(walkFramePointers(0x400500, 0x1234, stack, 64).size() == 1);
+    REQUIRE(walkFramePointers(0x400500, base + 510, stack, 64).size() == 1);
+  }
+
+  SECTION("a chain that does not move up the stack ends the walk") {
+    auto looping = buildStack(base, 512, {{0x40, 0x401010}});
+    const u64 self = base + 0x40;
+    std::memcpy(looping.data() + 0x40, &self, sizeof(self));
+    const StackSnapshot loop{.base = base, .bytes = looping};
+    REQUIRE(walkFramePointers(0x400500, self, loop, 64) ==
+            std::vector<u64>{0x400500, 0x401010});
+  }
+}
+
+TEST_CASE("Test profile aggregation", "[profile]") {
+  Profile profile{};
+  profile.addSample({0x10, 0x20, 0x30});
+  profile.addSample({0x10, 0x20, 0x30});
+  profile.addSample({0x11, 0x20, 0x30});
+  profile.addSample({0x40, 0x30}, 7);
+  profile.addPause(1000);
+  profile.addPause(3000);
+
+  REQUIRE(profile.samples() == 4);
+  REQUIRE(profile.ticks() == 2);
+  REQUIRE(profile.maxPauseNs() == 3000);
+  REQUIRE(profile.avgPauseNs() == 2000);
+  REQUIRE(profile.frames().size() == 5);
+  REQUIRE(profile.syscalls() == std::vector<i32>{7});
+
+  SECTION("unnamed frames show as addresses") {
+    REQUIRE(profile.folded() ==
+            "0x30;0x20;0x10 2\n0x30;0x20;0x11 1\n0x30;0x40;[syscall 7] 1");
+  }
+
+  SECTION("frames in the same function merge") {
+    profile.nameFrame(0x10, "leaf");
+    profile.nameFrame(0x11, "leaf");
+    profile.nameFrame(0x20, "mid;dle");
+    profile.nameFrame(0x30, "main");
+    profile.nameFrame(0x40, "wait");
+    profile.nameSyscall(7, "poll");
+    REQUIRE(profile.folded() == "main;mid:dle;leaf 3\nmain;wait;[poll] 1");
+
+    const std::string top = profile.top(2);
+    REQUIRE(top.find("leaf") != std::string::npos);
+    REQUIRE(top.find("[poll]") != std::string::npos);
+    REQUIRE(top.find("main") == std::string::npos);
+    REQUIRE(top.find("75.0%") < top.find("leaf"));
+  }
+
+  SECTION("nothing sampled") {
+    REQUIRE(Profile{}.top(10) == "No samples");
+    REQUIRE(Profile{}.folded().empty());
+  }
+}
@@ -0,0 +1,144 @@
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <array>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <core/reactor.hpp>
+#include <csignal>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("Test reactor file descriptors", "[reactor]") {
+  Reactor reactor{};
+  std::array<int, 2> fds{};
+  REQUIRE(pipe(fds.data()) == 0);
+
+  i32 calls = 0;
+  REQUIRE(reactor.add(fds[0], [&calls] { calls++; }) == 0);
+  REQUIRE(reactor.add(fds[0], [] {}) == -1);
+
+  SECTION("Nothing runs until the fd is readable") {
+    REQUIRE(reactor.poll(0ms) == 0);
+    const char c = 'x';
+    REQUIRE(write(fds[1], &c, 1) == 1);
+    REQUIRE(reactor.poll(0ms) == 1);
+    REQUIRE(calls == 1);
+  }
+
+  SECTION("Paused fds are not delivered") {
+    const char c = 'x';
+    REQUIRE(write(fds[1], &c, 1) == 1);
+    reactor.pause(fds[0], true);
+    REQUIRE(reactor.poll(0ms) == 0);
+    reactor.pause(fds[0], false);
+    REQUIRE(reactor.poll(0ms) == 1);
+  }
+
+  SECTION("Removed fds stay open") {
+    reactor.remove(fds[0]);
+    REQUIRE(reactor.size() == 0);
+    const char c = 'x';
+    REQUIRE(write(fds[1], &c, 1) == 1);
+    REQUIRE(reactor.poll(0ms) == 0);
+    char out = 0;
+    REQUIRE(read(fds[0], &out, 1) == 1);
+  }
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST_CASE("Test reactor timers", "[reactor]") {
+  Reactor reactor{};
+
+  SECTION("One-shot timers fire once") {
+    i32 calls = 0;
+    const int fd = reactor.addTimer(1ms, 0ns, [&calls] { calls++; });
+    REQUIRE(fd >= 0);
+    REQUIRE(reactor.poll() == 1);
+    REQUIRE(calls == 1);
+    REQUIRE(reactor.poll(5ms) == 0);
+    reactor.remove(fd);
+  }
+
+  SECTION("Periodic timers merge missed ticks") {
+    i32 calls = 0;
+    const int fd = reactor.addTimer(1ms, 1ms, [&calls] { calls++; });
+    REQUIRE(fd >= 0);
+    std::this_thread::sleep_for(10ms);
+    REQUIRE(reactor.poll() == 1);
+    REQUIRE(calls == 1);
+    REQUIRE(reactor.poll() == 1);
+    REQUIRE(calls == 2);
+    reactor.remove(fd);
+  }
+
+  SECTION("Handlers can remove their own source") {
+    int fd = -1;
+    fd = reactor.addTimer(0ns, 1ms, [&] { reactor.remove(fd); });
+    REQUIRE(fd >= 0);
+    REQUIRE(reactor.poll() == 1);
+    REQUIRE(reactor.size() == 0);
+  }
+}
+
+TEST_CASE("Test reactor signals", "[reactor]") {
+  Reactor reactor{};
+  i32 calls = 0;
+  const int fd = reactor.addSignal(SIGUSR2, [&calls] { calls++; });
+  REQUIRE(fd >= 0);
+
+  // Pending for the signalfd, twice counts as one like any standard signal
+  REQUIRE(raise(SIGUSR2) == 0);
+  REQUIRE(raise(SIGUSR2) == 0);
+  REQUIRE(reactor.poll(0ms) == 1);
+  REQUIRE(calls == 1);
+  REQUIRE(reactor.poll(0ms) == 0);
+  reactor.remove(fd);
+}
+
+TEST_CASE("Test reactor wake-ups", "[reactor]") {
+  Reactor reactor{};
+  i32 calls = 0;
+  const int fd = reactor.addWakeup([&calls] { calls++; });
+  REQUIRE(fd >= 0);
+  REQUIRE(reactor.poll(0ms) == 0);
+
+  std::thread other{[fd] {
+    Reactor::wake(fd);
+    Reactor::wake(fd);
+  }};
+  other.join();
+  REQUIRE(reactor.poll(0ms) == 1);
+  REQUIRE(calls == 1);
+  REQUIRE(reactor.poll(0ms) == 0);
+  reactor.remove(fd);
+}
+
+TEST_CASE("Test reactor process exits", "[reactor]") {
+  Reactor reactor{};
+  std::array<int, 2> gate{};
+  REQUIRE(pipe(gate.data()) == 0);
+  const pid_t pid = fork();
+  if (pid == 0) {
+    close(gate[1]);
+    char go = 0;
+    read(gate[0], &go, 1);
+    _exit(0);
+  }
+  close(gate[0]);
+
+  bool exited = false;
+  const int fd = reactor.addProcess(pid, [&exited] { exited = true; });
+  REQUIRE(fd >= 0);
+  REQUIRE(reactor.poll(0ms) == 0);
+
+  close(gate[1]);
+  REQUIRE(reactor.poll() == 1);
+  REQUIRE(exited);
+  // Gone once it fired, the zombie is still there to reap
+  REQUIRE(reactor.size() == 0);
+  REQUIRE(waitpid(pid, nullptr, 0) == pid);
+}
@@ -0,0 +1,69 @@
+#include <catch2/catch_test_macros.hpp>
+#include <core/platform.hpp>
+#include <string>
+
+namespace {
+using ArmMach = PlatformTraits<Architecture::ARM64, Platform::MACH>;
+using ArmLinux = PlatformTraits<Architecture::ARM64, Platform::LINUX>;
+using X86Linux = PlatformTraits<Architecture::X86_64, Platform::LINUX>;
+using X86Mach = PlatformTraits<Architecture::X86_64, Platform::MACH>;
+
+// Every declared name has to land on its own entry
+template <typename Traits>
+void checkAllNames() {
+  for (const auto& reg : Traits::REG_TABLE.regs()) {
+    INFO(std::string{reg.name});
+    REQUIRE(Traits::REG_TABLE.find(reg.name) == &reg.entry);
+  }
+}
+
+// Lookups are usable in constant expressions
+static_assert(X86Linux::REG_TABLE.find("rip")->offset ==
+              offsetof(LinuxX86ThreadState64T, rip));
+static_assert(X86Mach::REG_TABLE.find("rip")->offset ==
+              offsetof(X86ThreadState64T, rip));
+static_assert(ArmMach::REG_TABLE.find("x29")->reg == Arm64Reg::FP);
+static_assert(ArmLinux::REG_TABLE.find("cpsr")->size == 8);
+static_assert(ArmMach::REG_TABLE.find("cpsr")->size == 4);
+static_assert(X86Mach::REG_TABLE.find(X86Reg::SS) == nullptr);
+}  // namespace
+
+TEST_CASE("Register tables resolve every declared name", "[registers]") {
+  checkAllNames<ArmMach>();
+  checkAllNames<ArmLinux>();
+  checkAllNames<X86Linux>();
+  checkAllNames<X86Mach>();
+}
+
+TEST_CASE("Register tables reject unknown names", "[registers]") {
+  for (const char* name : {"", "r", "rax ", "RAX", "x31", "xmm16", "dr4",
+                           "mdscr_el2", "notareg"}) {
+    INFO(name);
+    REQUIRE(X86Linux::REG_TABLE.find(name) == nullptr);
+    REQUIRE(ArmMach::REG_TABLE.find(name) == nullptr);
+  }
+
+  SECTION("Layouts only have their own registers") {
+    REQUIRE(X86Mach::REG_TABLE.find("orig_rax") == nullptr);
+    REQUIRE(X86Mach::REG_TABLE.find(X86Reg::ORIG_RAX) == nullptr);
+    REQUIRE(ArmLinux::REG_TABLE.find("mdscr_el1") == nullptr);
+  }
+}
+
+TEST_CASE("Register tables look up by enum", "[registers]") {
+  SECTION("Aliases resolve to the first declared name") {
+    REQUIRE(ArmMach::REG_TABLE.find(Arm64Reg::FP) ==
+            ArmMach::REG_TABLE.find("fp"));
+    REQUIRE(X86Linux::REG_TABLE.find(X86Reg::RIP) ==
+            X86Linux::REG_TABLE.find("rip"));
+  }
+
+  SECTION("Groups and offsets come from the platform layout") {
+    const auto* xmm1 = X86Linux::REG_TABLE.find(X86Reg::XMM1);
+    REQUIRE(xmm1 != nullptr);
+    REQUIRE(xmm1->group == RegGroup::FP);
+    REQUIRE(xmm1->offset == offsetof(X86FloatState64T, xmm) + 16);
+    REQUIRE(X86Mach::REG_TABLE.find(X86Reg::XMM1)->offset ==
+            offsetof(MachX86FloatState64T, xmm) + 16);
+  }
+}
@@ -0,0 +1,102 @@
+#include <pthread.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include <array>
+#include <bit>
+#include <catch2/catch_test_macros.hpp>
+#include <core/elf/symbols.hpp>
+#include <filesystem>
+#include <vector>
+
+// Outside any namespace so the symbol keeps a plain name
+extern "C" [[gnu::noinline]] int caesarSymbolProbe(int x) {
+  return (x * 7) + 2;
+}
+
+TEST_CASE("Test loading a symbol table", "[symbols]") {
+  SymbolTable table{};
+  REQUIRE(table.load("/nonexistent") != 0);
+  REQUIRE(table.load(std::filesystem::read_symlink("/proc/self/exe")) == 0);
+  REQUIRE(table.size() > 0);
+  REQUIRE(table.find(0) == nullptr);
+}
+
+TEST_CASE("Test naming addresses of this process", "[symbols]") {
+  ProcessSymbols symbols{getpid()};
+  const auto probe = std::bit_cast<u64>(&caesarSymbolProbe);
+
+  REQUIRE(symbols.function(probe) == "caesarSymbolProbe");
+  REQUIRE(symbols.function(probe + 1) == "caesarSymbolProbe");
+  // Library code is named too, demangled
+  REQUIRE(symbols.function(std::bit_cast<u64>(&getpid)) != "");
+  REQUIRE(symbols.function(8) == "0x8");
+  REQUIRE(caesarSymbolProbe(1) == 9);
+}
+
+namespace {
+// Registers and stack of the innermost probe frame, copied before it returns
+struct CapturedStack {
+  UnwindRegs regs;
+  u64 base;
+  std::vector<std::byte> bytes;
+};
+}  // namespace
+
+extern "C" [[gnu::noinline]] int caesarUnwindProbe(int depth,
+                                                  CapturedStack& out) {
+  if (depth > 0) {
+    const int inner = caesarUnwindProbe(depth - 1, out);
+    // Keeps the call from becoming a jump
+    asm volatile("" ::: "memory");
+    return inner + 1;
+  }
+
+  ucontext_t ctx{};
+  getcontext(&ctx);
+  const auto* gregs = ctx.uc_mcontext.gregs;
+  const std::array<greg_t, UnwindRegs::COUNT> order{
+      gregs[REG_RAX], gregs[REG_RDX], gregs[REG_RCX], gregs[REG_RBX],
+      gregs[REG_RSI], gregs[REG_RDI], gregs[REG_RBP], gregs[REG_RSP],
+      gregs[REG_R8],  gregs[REG_R9],  gregs[REG_R10], gregs[REG_R11],
+      gregs[REG_R12], gregs[REG_R13], gregs[REG_R14], gregs[REG_R15],
+      gregs[REG_RIP]};
+  for (size_t i = 0; i < order.size(); i++)
+    out.regs.set(i, static_cast<u64>(order[i]));
+
+  pthread_attr_t attr{};
+  void* low = nullptr;
+  size_t size = 0;
+  pthread_getattr_np(pthread_self(), &attr);
+  pthread_attr_getstack(&attr, &low, &size);
+  pthread_attr_destroy(&attr);
+  out.base = out.regs.values[UnwindRegs::RSP];
+  const auto* sp = std::bit_cast<const std::byte*>(out.base);
+  out.bytes.assign(sp, static_cast<const std::byte*>(low) + size);
+  return 0;
+}
+
+TEST_CASE("Test unwinding this process with its CFI", "[symbols][cfi]") {
+  constexpr int DEPTH = 600;
+  CapturedStack captured{};
+  REQUIRE(caesarUnwindProbe(DEPTH, captured) == DEPTH);
+
+  ProcessSymbols symbols{getpid()};
+  const StackSnapshot stack{.base = captured.base, .bytes = captured.bytes};
+  std::vector<u64> pcs{};
+  const UnwindStop stop =
+      walkCallFrames(captured.regs, stack, symbols, 4096, pcs);
+  REQUIRE((stop == UnwindStop::OUTERMOST || stop == UnwindStop::LOST));
+
+  // The capturing frame and every level of the recursion, then this test
+  REQUIRE(pcs.size() > DEPTH + 2);
+  for (size_t i = 0; i <= DEPTH; i++)
+    REQUIRE(symbols.function(i == 0 ? pcs[i] : pcs[i] - 1) ==
+            "caesarUnwindProbe");
+  REQUIRE(symbols.function(pcs[DEPTH + 1] - 1) != "caesarUnwindProbe");
+
+  // The CFI rows are cached, a second walk finds the same frames
+  std::vector<u64> again{};
+  walkCallFrames(captured.regs, stack, symbols, 4096, again);
+  REQUIRE(again == pcs);
+}
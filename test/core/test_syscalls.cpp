@@ -0,0 +1,109 @@
+#include <linux/seccomp.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include <cerrno>
+#include <core/elf/syscalls.hpp>
+#include <vector>
+
+TEST_CASE("Test the syscall table", "[syscalls]") {
+  const SyscallDesc* write = findSyscall("write");
+  REQUIRE(write != nullptr);
+  REQUIRE(write->nr == SYS_write);
+  REQUIRE(write->argc == 3);
+  REQUIRE(write->args[1] == ArgKind::BUF);
+  REQUIRE(findSyscall(SYS_openat)->name == "openat");
+  REQUIRE(findSyscall("no_such_call") == nullptr);
+
+  // Numbers and names are unique
+  for (const auto& desc : syscallTable()) {
+    REQUIRE(findSyscall(desc.name) == &desc);
+    REQUIRE(findSyscall(desc.nr) == &desc);
+  }
+}
+
+TEST_CASE("Test formatting syscall returns", "[syscalls]") {
+  REQUIRE(formatReturn(findSyscall("read"), 12) == "= 12");
+  REQUIRE(formatReturn(findSyscall("openat"), -ENOENT) == "= -1 ENOENT");
+  REQUIRE(formatReturn(findSyscall("mmap"), 0x7f0000001000) ==
+          "= 0x7f0000001000");
+  REQUIRE(formatReturn(nullptr, 0) == "= 0");
+}
+
+TEST_CASE("Test syscall statistics", "[syscalls]") {
+  SyscallStats stats{};
+  stats.add(500, false);
+  stats.add(1500, true);
+  stats.add(3000, false);
+  stats.add(u64{1} << 62, false);
+
+  REQUIRE(stats.count == 4);
+  REQUIRE(stats.errors == 1);
+  REQUIRE(stats.max_ns == u64{1} << 62);
+  REQUIRE(stats.histogram[0] == 1);
+  REQUIRE(stats.histogram[1] == 1);
+  REQUIRE(stats.histogram[2] == 1);
+  REQUIRE(stats.histogram[SyscallStats::BUCKETS - 1] == 1);
+}
+
+TEST_CASE("Test pairing syscall entries and exits", "[syscalls]") {
+  SyscallTracer tracer;
+  REQUIRE_FALSE(tracer.active());
+  REQUIRE_FALSE(tracer.covered(std::vector<u32>{SYS_write}));
+
+  tracer.installed(std::vector<u32>{SYS_write, SYS_read});
+  REQUIRE(tracer.covered(std::vector<u32>{SYS_read}));
+  REQUIRE_FALSE(tracer.covered(std::vector<u32>{SYS_close}));
+  REQUIRE_FALSE(tracer.covered({}));
+
+  tracer.start({SYS_write}, true);
+  REQUIRE(tracer.active());
+  REQUIRE(tracer.selected(SYS_write));
+  REQUIRE_FALSE(tracer.selected(SYS_read));
+
+  REQUIRE_FALSE(tracer.exit(1, 0));
+  tracer.enter(1, SYS_write, R"(1, "hi\n", 3)");
+  REQUIRE(tracer.inFlight(1));
+  REQUIRE_FALSE(tracer.inFlight(2));
+  auto line = tracer.exit(1, 3);
+  REQUIRE(line);
+  REQUIRE(line->starts_with(R"(write(1, "hi\n", 3) = 3 <)"));
+  REQUIRE_FALSE(tracer.inFlight(1));
+
+  tracer.enter(2, SYS_write, "");
+  tracer.forget(2);
+  REQUIRE_FALSE(tracer.exit(2, 0));
+  REQUIRE(tracer.summary().starts_with("syscall"));
+  REQUIRE(tracer.summary().find("write") != std::string::npos);
+
+  // A filter for everything covers any list
+  tracer.installed({});
+  REQUIRE(tracer.covered(std::vector<u32>{SYS_close}));
+}
+
+TEST_CASE("Test a generated seccomp filter", "[syscalls]") {
+  const std::vector<u32> nrs{SYS_getppid};
+  const auto filter = buildSyscallFilter(nrs, SECCOMP_RET_ERRNO | EPERM);
+
+  // The child reports through its exit code, the filter stays with it
+  const pid_t child = fork();
+  REQUIRE(child >= 0);
+  if (child == 0) {
+    const sock_fprog prog{.len = static_cast<u16>(filter.size()),
+                          .filter = const_cast<sock_filter*>(filter.data())};
+    if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) != 0 ||
+        syscall(SYS_seccomp, SECCOMP_SET_MODE_FILTER, 0, &prog) != 0)
+      _exit(1);
+    if (syscall(SYS_getppid) != -1 || errno != EPERM) _exit(2);
+    if (syscall(SYS_getpid) <= 0) _exit(3);
+    _exit(0);
+  }
+
+  int status = 0;
+  REQUIRE(waitpid(child, &status, 0) == child);
+  REQUIRE(WIFEXITED(status));
+  REQUIRE(WEXITSTATUS(status) == 0);
+}
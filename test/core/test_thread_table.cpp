@@ -0,0 +1,95 @@
+#include <catch2/catch_test_macros.hpp>
+#include <core/thread_table.hpp>
+#include <vector>
+
+TEST_CASE("Test ThreadTable", "[core][thread_table]") {
+  ThreadTable table;
+
+  SECTION("empty table") {
+    REQUIRE(table.empty());
+    REQUIRE(table.selected() == nullptr);
+    REQUIRE(table.selectedTid() == 0);
+    REQUIRE_FALSE(table.select(100));
+  }
+
+  SECTION("first thread is selected") {
+    table.add(100);
+    table.add(101);
+    REQUIRE(table.size() == 2);
+    REQUIRE(table.selectedTid() == 100);
+    REQUIRE(table.selected()->tid == 100);
+  }
+
+  SECTION("add returns the existing entry") {
+    table.add(100).pending_signal = 11;
+    REQUIRE(table.add(100).pending_signal == 11);
+    REQUIRE(table.size() == 1);
+  }
+
+  SECTION("select only known threads") {
+    table.add(100);
+    table.add(102);
+    REQUIRE(table.select(102));
+    REQUIRE(table.selectedTid() == 102);
+    REQUIRE_FALSE(table.select(103));
+    REQUIRE(table.selectedTid() == 102);
+  }
+
+  SECTION("removing the selected thread selects the lowest tid") {
+    table.add(300);
+    table.add(200);
+    table.add(100);
+    REQUIRE(table.select(200));
+    table.remove(200);
+    REQUIRE(table.selectedTid() == 100);
+    REQUIRE_FALSE(table.contains(200));
+    table.remove(100);
+    table.remove(300);
+    REQUIRE(table.empty());
+    REQUIRE(table.selectedTid() == 0);
+  }
+
+  SECTION("tids are sorted") {
+    for (const i32 tid : {7, 3, 5, 1}) table.add(tid);
+    REQUIRE(table.tids() == std::vector<i32>{1, 3, 5, 7});
+  }
+
+  SECTION("invalidate drops cached registers only") {
+    auto& thread = table.add(100);
+    thread.valid = groupBit(RegGroup::GPR) | groupBit(RegGroup::FP);
+    thread.step_over = 0x1000;
+    table.invalidate();
+    REQUIRE_FALSE(table.find(100)->has(RegGroup::GPR));
+    REQUIRE_FALSE(table.find(100)->has(RegGroup::FP));
+    REQUIRE(table.find(100)->step_over == 0x1000);
+  }
+
+  SECTION("register groups are tracked separately") {
+    auto& thread = table.add(100);
+    thread.valid = groupBit(RegGroup::FP);
+    thread.dirty = groupBit(RegGroup::FP);
+    REQUIRE(thread.has(RegGroup::FP));
+    REQUIRE_FALSE(thread.has(RegGroup::GPR));
+    REQUIRE(thread.isDirty(RegGroup::FP));
+    REQUIRE_FALSE(thread.isDirty(RegGroup::DEBUG));
+    REQUIRE(thread.group(RegGroup::GPR).size() == sizeof(ThreadState));
+    REQUIRE(thread.group(RegGroup::FP).size() == sizeof(FloatState));
+    REQUIRE(thread.group(RegGroup::DEBUG).size() == sizeof(DebugState));
+  }
+
+  SECTION("any running thread counts") {
+    table.add(100);
+    table.add(101);
+    REQUIRE_FALSE(table.anyRunning());
+    table.find(101)->running = true;
+    REQUIRE(table.anyRunning());
+  }
+
+  SECTION("clear resets the selection") {
+    table.add(100);
+    table.clear();
+    REQUIRE(table.empty());
+    table.add(200);
+    REQUIRE(table.selectedTid() == 200);
+  }
+}
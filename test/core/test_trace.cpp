@@ -0,0 +1,121 @@
+#include <catch2/catch_test_macros.hpp>
+#include <core/ring_buffer.hpp>
+#include <core/trace.hpp>
+#include <thread>
+
+TEST_CASE("SpscRing single threaded", "[trace][ring]") {
+  SpscRing<u64, 8> ring;
+  u64 out = 0;
+
+  REQUIRE(ring.empty());
+  REQUIRE_FALSE(ring.tryPop(out));
+
+  SECTION("fills up to capacity") {
+    for (u64 i = 0; i < 8; i++) REQUIRE(ring.tryPush(i));
+    REQUIRE(ring.size() == 8);
+    REQUIRE_FALSE(ring.tryPush(8));
+  }
+
+  SECTION("pops in order across the wrap") {
+    for (u64 round = 0; round < 5; round++) {
+      for (u64 i = 0; i < 6; i++) REQUIRE(ring.tryPush(round * 10 + i));
+      for (u64 i = 0; i < 6; i++) {
+        REQUIRE(ring.tryPop(out));
+        REQUIRE(out == round * 10 + i);
+      }
+    }
+    REQUIRE(ring.empty());
+  }
+}
+
+TEST_CASE("SpscRing across threads", "[trace][ring]") {
+  constexpr u64 count = 200000;
+  SpscRing<u64, 64> ring;
+
+  std::jthread producer([&ring] {
+    for (u64 i = 0; i < count; i++)
+      while (!ring.tryPush(i)) std::this_thread::yield();
+  });
+
+  u64 expected = 0;
+  u64 out = 0;
+  bool ordered = true;
+  while (expected < count) {
+    if (!ring.tryPop(out)) continue;
+    ordered = ordered && out == expected;
+    expected++;
+  }
+  producer.join();
+
+  REQUIRE(ordered);
+  REQUIRE(ring.empty());
+}
+
+TEST_CASE("Tracer formats and counts records", "[trace]") {
+  auto sp = findRegEntry("sp");
+  REQUIRE(sp);
+
+  TraceSpec spec{};
+  spec.regs.push_back(*sp);
+  spec.reg_names.emplace_back("sp");
+  spec.mem_base = *sp;
+  spec.mem_base_name = "sp";
+  spec.mem_offset = -8;
+  spec.mem_len = 2;
+
+  TraceRecord rec{};
+  rec.timestamp_ns = 1500002000;
+  rec.addr = 0x1139;
+  rec.bp_id = 3;
+  rec.regs[0] = 0x2a;
+  rec.mem_len = 2;
+  rec.mem[0] = std::byte{0xde};
+  rec.mem[1] = std::byte{0xad};
+
+  REQUIRE(Tracer::formatRecord(rec, spec) ==
+          "[1.500002] #3 @ 0x0000000000001139 sp=0x2a [sp-8] de ad\n");
+
+  rec.mem_len = 0;
+  REQUIRE(Tracer::formatRecord(rec, spec).ends_with("<unreadable>\n"));
+
+  Tracer tracer;
+  rec.spec = tracer.addSpec(spec);
+  REQUIRE(tracer.setOutput("/dev/null") == 0);
+  for (size_t i = 0; i < Tracer::RING_SIZE + 5; i++) tracer.record(rec);
+
+  TraceStats stats = tracer.stats();
+  REQUIRE(stats.recorded == Tracer::RING_SIZE);
+  REQUIRE(stats.dropped == 5);
+  REQUIRE(tracer.drain() == Tracer::RING_SIZE);
+  REQUIRE(tracer.stats().written == Tracer::RING_SIZE);
+  REQUIRE(tracer.pending() == 0);
+}
+
+TEST_CASE("Tracer hands stdout records to the notified thread", "[trace]") {
+  auto sp = findRegEntry("sp");
+  REQUIRE(sp);
+  TraceSpec spec{};
+  spec.regs.push_back(*sp);
+  spec.reg_names.emplace_back("sp");
+
+  Tracer tracer;
+  TraceRecord rec{};
+  rec.spec = tracer.addSpec(spec);
+  i32 notified = 0;
+  tracer.setStdoutNotify([&notified] { notified++; });
+
+  tracer.record(rec);
+  tracer.record(rec);
+  REQUIRE(tracer.drain() == 2);
+  REQUIRE(notified == 1);
+  const std::string line = Tracer::formatRecord(rec, spec);
+  REQUIRE(tracer.takeStdout() == line + line);
+  REQUIRE(tracer.takeStdout().empty());
+
+  // Files are still written by the consumer
+  REQUIRE(tracer.setOutput("/dev/null") == 0);
+  tracer.record(rec);
+  REQUIRE(tracer.drain() == 1);
+  REQUIRE(notified == 1);
+  REQUIRE(tracer.takeStdout().empty());
+}